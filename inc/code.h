@@ -4,6 +4,7 @@
 #include <Windows.h>
 
 #include <cassert>
+#include <cstring>
 #include <initializer_list>
 #include <iostream>
 #include <vector>
@@ -36,6 +37,9 @@ class Code
 
     void asm_init();
 
+    // 已生成的代码长度
+    unsigned int asm_length();
+
     void asm_add_byte(unsigned char);
     void asm_add_word(unsigned short);
     void asm_add_dword(unsigned int);
@@ -62,8 +66,7 @@ class Code
     void asm_code_inject(HANDLE);
 
   protected:
-    unsigned char *code;
-    unsigned int length;
+    std::vector<unsigned char> code;
     std::vector<unsigned int> calls_pos;
 };
 
@@ -6,6 +6,8 @@
 #include <utility>
 #include <vector>
 
+#include "layout.h"
+
 namespace Pt
 {
 
@@ -59,7 +61,13 @@ struct PVZ_DATA
     uintptr_t zombie;
     uintptr_t zombie_status;
     uintptr_t zombie_dead;
+    uintptr_t zombie_row;
+    uintptr_t zombie_type;
+    uintptr_t zombie_x;
+    uintptr_t zombie_y;
+    uintptr_t zombie_hp;
     uintptr_t zombie_count_max;
+    uintptr_t zombie_struct_size;
 
     uintptr_t plant;
     uintptr_t plant_row;
@@ -69,13 +77,16 @@ struct PVZ_DATA
     uintptr_t plant_dead;
     uintptr_t plant_squished;
     uintptr_t plant_asleep;
+    uintptr_t plant_hp;
     uintptr_t plant_count_max;
     uintptr_t plant_next_pos;
+    uintptr_t plant_struct_size;
 
     uintptr_t lawn_mower;
     uintptr_t lawn_mower_dead;
     uintptr_t lawn_mower_count_max;
     uintptr_t lawn_mower_count;
+    uintptr_t lawn_mower_struct_size;
 
     uintptr_t grid_item;
     uintptr_t grid_item_type;
@@ -83,6 +94,7 @@ struct PVZ_DATA
     uintptr_t grid_item_row;
     uintptr_t grid_item_dead;
     uintptr_t grid_item_count_max;
+    uintptr_t grid_item_struct_size;
 
     uintptr_t cursor;
     uintptr_t cursor_grab;
@@ -93,6 +105,7 @@ struct PVZ_DATA
     uintptr_t slot_seed_cd_total;
     uintptr_t slot_seed_type;
     uintptr_t slot_seed_type_im;
+    uintptr_t slot_seed_struct_size;
 
     uintptr_t cut_scene;
 
@@ -109,6 +122,7 @@ struct PVZ_DATA
     uintptr_t adventure_level;
     uintptr_t sun;
     uintptr_t game_clock;
+    uintptr_t current_wave;
     uintptr_t debug_mode;
     uintptr_t particle_systems_addr;
 
@@ -127,6 +141,7 @@ struct PVZ_DATA
     uintptr_t particle_system_type;
     uintptr_t particle_system_dead;
     uintptr_t particle_system_count_max;
+    uintptr_t particle_system_struct_size;
 
     uintptr_t user_data;
     uintptr_t level;
@@ -265,6 +280,9 @@ class Data
     // 根据版本号获取数据
     PVZ_DATA data();
 
+    // 当前版本的结构体布局, 不复制整个版本数据
+    LAYOUTS layouts();
+
   protected:
     // 查找结果
     int find_result;
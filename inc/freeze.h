@@ -0,0 +1,132 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "process.h"
+
+namespace Pt
+{
+
+// 锁定方式
+#define FREEZE_EXACT 0 // 保持等于
+#define FREEZE_MIN 1   // 不低于
+#define FREEZE_MAX 2   // 不高于
+
+// 数值类型
+#define FREEZE_INT8 1
+#define FREEZE_INT16 2
+#define FREEZE_INT32 3
+#define FREEZE_FLOAT 4
+
+// 一个锁定项, 指针链的含义和 ReadMemory 相同
+// source 不为空时锁定值为每次检查时从 source 读到的值(类型相同), 忽略 value
+struct FreezeEntry
+{
+    std::vector<uintptr_t> chain;
+    int type;
+    int mode;
+    double value;
+    std::vector<uintptr_t> source = {};
+};
+
+// 数值锁定
+// 后台线程每次把所有锁定的地址连同指针链的中间指针合并成少数几段整块读取,
+// 只写回偏离的值; 中间指针变化时(比如换关)重新解析地址
+class FreezeTable
+{
+  public:
+    FreezeTable(Process *);
+    ~FreezeTable();
+
+    FreezeTable(const FreezeTable &) = delete;
+    FreezeTable &operator=(const FreezeTable &) = delete;
+
+    // 添加锁定项, 返回编号, 第一次添加时启动后台线程
+    // 列表为空时线程停在事件上不再读写, 再次添加时唤醒
+    int Add(const FreezeEntry &);
+
+    // 修改锁定值
+    bool Set(int, double);
+
+    void Remove(int);
+    void Clear();
+    size_t Count();
+
+    // 检查间隔, 单位毫秒, 数值没有变化时逐渐放宽到最大值
+    void SetInterval(int, int);
+
+    bool Start();
+    void Stop();
+    bool Running();
+
+    // 上一次检查用掉的读写次数
+    size_t Syscalls();
+
+  protected:
+    // 合并读取时允许的最大空隙
+    static const uintptr_t MERGE_GAP = 4096;
+
+    // 每隔多少次检查重新解析一次失效的锁定项
+    static const int RETRY_TICKS = 16;
+
+    struct Item
+    {
+        FreezeEntry entry;
+        uintptr_t address = 0; // 解析后的地址, 0 为暂时无效
+        uintptr_t source = 0;  // 解析后的锁定值来源地址
+    };
+
+    // 中间指针所在的地址和解析时读到的值
+    struct Cell
+    {
+        uintptr_t address;
+        uintptr_t value;
+    };
+
+    // 一段连续读取
+    struct Range
+    {
+        uintptr_t begin;
+        uintptr_t end;
+    };
+
+    static DWORD WINAPI thread_proc(LPVOID);
+    void run();
+
+    // 检查一次, 返回写入次数
+    size_t tick();
+
+    // 解析所有锁定项的地址并重新规划读取的区间
+    void resolve();
+
+    // 清空解析结果, 下次从头解析
+    void reset();
+
+    Process *process;
+    std::map<int, Item> items;
+    int next_id;
+
+    std::vector<Cell> cells;
+    std::vector<Range> ranges;
+    bool dirty; // 需要重新解析
+    int ticks;
+    uintptr_t gap; // 当前允许的合并空隙
+
+    int interval_min;
+    int interval_max;
+
+    CRITICAL_SECTION lock;
+    HANDLE thread;
+    HANDLE stop_event;
+    HANDLE wake_event; // 自动重置
+    std::atomic<bool> running;
+    std::atomic<size_t> syscalls;
+};
+
+} // namespace Pt
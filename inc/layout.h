@@ -0,0 +1,242 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Pt
+{
+
+// 游戏结构体在当前版本中的大小和字段偏移, 由版本数据生成
+// 配合下面的视图直接在整块读取的内存上按字段取值
+
+struct PlantLayout
+{
+    uint32_t size;
+    uintptr_t row;
+    uintptr_t type;
+    uintptr_t col;
+    uintptr_t imitater;
+    uintptr_t dead;
+    uintptr_t squished;
+    uintptr_t asleep;
+    uintptr_t hp;
+};
+
+struct ZombieLayout
+{
+    uint32_t size;
+    uintptr_t status;
+    uintptr_t dead;
+    uintptr_t row;
+    uintptr_t type;
+    uintptr_t x;
+    uintptr_t y;
+    uintptr_t hp;
+};
+
+struct GridItemLayout
+{
+    uint32_t size;
+    uintptr_t type;
+    uintptr_t col;
+    uintptr_t row;
+    uintptr_t dead;
+};
+
+// 卡槽的字段偏移从卡槽对象开始算, 包含卡片数组之前的部分
+struct SeedSlotLayout
+{
+    uint32_t size;
+    uintptr_t cd_past;
+    uintptr_t cd_total;
+    uintptr_t type;
+    uintptr_t type_im;
+};
+
+struct LawnMowerLayout
+{
+    uint32_t size;
+    uintptr_t dead;
+};
+
+struct ParticleSystemLayout
+{
+    uint32_t size;
+    uintptr_t type;
+    uintptr_t dead;
+};
+
+struct LAYOUTS
+{
+    PlantLayout plant;
+    ZombieLayout zombie;
+    GridItemLayout grid_item;
+    SeedSlotLayout seed_slot;
+    LawnMowerLayout lawn_mower;
+    ParticleSystemLayout particle_system;
+};
+
+// 原始内存中的一条记录
+template <typename L>
+class RecordView
+{
+  public:
+    typedef L Layout;
+
+    RecordView(const uint8_t *p, const L *layout) : p(p), layout(layout) {}
+
+    template <typename T>
+    T get(uintptr_t offset) const
+    {
+        T value;
+        memcpy(&value, p + offset, sizeof(T));
+        return value;
+    }
+
+    // 对象 ID, 位于结构体末尾, 高 16 位为槽位复用次数
+    uint32_t id() const
+    {
+        return get<uint32_t>(layout->size - 4);
+    }
+
+  protected:
+    const uint8_t *p;
+    const L *layout;
+};
+
+class PlantView : public RecordView<PlantLayout>
+{
+  public:
+    using RecordView::RecordView;
+
+    int32_t row() const { return get<int32_t>(layout->row); }
+    int32_t type() const { return get<int32_t>(layout->type); }
+    int32_t col() const { return get<int32_t>(layout->col); }
+    bool imitater() const { return get<int32_t>(layout->imitater) == 48; }
+    bool dead() const { return get<bool>(layout->dead); }
+    bool squished() const { return get<bool>(layout->squished); }
+    bool asleep() const { return get<bool>(layout->asleep); }
+    int32_t hp() const { return get<int32_t>(layout->hp); }
+
+    // 未消失且未被压扁
+    bool alive() const { return !dead() && !squished(); }
+};
+
+class ZombieView : public RecordView<ZombieLayout>
+{
+  public:
+    using RecordView::RecordView;
+
+    int32_t status() const { return get<int32_t>(layout->status); }
+    bool dead() const { return get<bool>(layout->dead); }
+    int32_t row() const { return get<int32_t>(layout->row); }
+    int32_t type() const { return get<int32_t>(layout->type); }
+    float x() const { return get<float>(layout->x); }
+    float y() const { return get<float>(layout->y); }
+    int32_t hp() const { return get<int32_t>(layout->hp); }
+
+    bool alive() const { return !dead(); }
+};
+
+class GridItemView : public RecordView<GridItemLayout>
+{
+  public:
+    using RecordView::RecordView;
+
+    int32_t type() const { return get<int32_t>(layout->type); }
+    int32_t col() const { return get<int32_t>(layout->col); }
+    int32_t row() const { return get<int32_t>(layout->row); }
+    bool dead() const { return get<bool>(layout->dead); }
+
+    bool alive() const { return !dead(); }
+};
+
+class SeedSlotView : public RecordView<SeedSlotLayout>
+{
+  public:
+    using RecordView::RecordView;
+
+    int32_t cd_past() const { return get<int32_t>(layout->cd_past); }
+    int32_t cd_total() const { return get<int32_t>(layout->cd_total); }
+    int32_t type() const { return get<int32_t>(layout->type); }
+    int32_t type_im() const { return get<int32_t>(layout->type_im); }
+};
+
+class LawnMowerView : public RecordView<LawnMowerLayout>
+{
+  public:
+    using RecordView::RecordView;
+
+    bool dead() const { return get<bool>(layout->dead); }
+
+    bool alive() const { return !dead(); }
+};
+
+class ParticleSystemView : public RecordView<ParticleSystemLayout>
+{
+  public:
+    using RecordView::RecordView;
+
+    int32_t type() const { return get<int32_t>(layout->type); }
+    bool dead() const { return get<bool>(layout->dead); }
+
+    bool alive() const { return !dead(); }
+};
+
+// 整块读取的对象池, 按记录访问
+template <typename View>
+class PoolView
+{
+  public:
+    typedef typename View::Layout Layout;
+
+    PoolView(const uint8_t *raw, size_t count, const Layout &layout)
+        : raw(raw), count(count), layout(&layout) {}
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    View operator[](size_t i) const
+    {
+        return View(raw + layout->size * i, layout);
+    }
+
+    class iterator
+    {
+      public:
+        iterator(const PoolView *pool, size_t i) : pool(pool), i(i) {}
+        View operator*() const { return (*pool)[i]; }
+        iterator &operator++()
+        {
+            i++;
+            return *this;
+        }
+        bool operator!=(const iterator &other) const { return i != other.i; }
+        size_t index() const { return i; }
+
+      protected:
+        const PoolView *pool;
+        size_t i;
+    };
+
+    iterator begin() const
+    {
+        return iterator(this, 0);
+    }
+
+    iterator end() const
+    {
+        return iterator(this, count);
+    }
+
+  protected:
+    const uint8_t *raw;
+    size_t count;
+    const Layout *layout;
+};
+
+} // namespace Pt
@@ -1,14 +1,29 @@
 
 #pragma once
 
+#include <Windows.h>
+
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
-#include <regex>
+#include <iterator>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define LINEUP_SSE2
+#endif
+
 #include <FL/images/zlib.h>
 
+#include "parallel.h"
 #include "utils.h"
 
 namespace Pt
@@ -20,21 +35,27 @@ class Lineup
 {
   public:
     Lineup();
-    Lineup(const std::string &);
-    Lineup(const std::string &, const std::string &);
+    Lineup(std::string_view);
+    Lineup(std::string_view, std::string_view);
     ~Lineup();
 
-    bool may_sleep[48] = {false, false, false, false, false, false, false, false, //
-                          true, true, true, false, true, true, true, true,        //
-                          false, false, false, false, false, false, false, false, //
-                          true, false, false, false, false, false, false, true,   //
-                          false, false, false, false, false, false, false, false, //
-                          false, false, true, false, false, false, false, false}; //
+    static const bool may_sleep[48]; // 会睡觉的植物
 
-    void Init(const std::string &); // 阵型字符串/代码 -> 数据
+    void Init(std::string_view);    // 阵型字符串/代码 -> 数据
     bool OK();                      //
     std::string Generate();         // 填充数据 -> 阵型代码
 
+    void Pack(uint16_t (&)[GRID]); // 数据 -> 压缩的数组
+    // 从压缩的数组恢复, 参数为名称, 场景, 钉耙行, 压缩的数组, 权重
+    void Restore(std::string_view, uint8_t, uint8_t, const uint16_t (&)[GRID], long long);
+
+    // 压缩的数组 -> 阵型代码, 参数为压缩的数组, 场景, 钉耙行
+    static std::string Encode(const uint16_t (&)[GRID], uint8_t, uint8_t);
+    // 阵型代码 -> 压缩的数组, 场景, 钉耙行, 不创建阵型对象
+    static bool Decode(std::string_view, uint16_t (&)[GRID], uint8_t &, uint8_t &);
+    // 排序用的权重, 参数为压缩的数组, 场景
+    static long long Weight(const uint16_t (&)[GRID], uint8_t);
+
     std::string lineup_name;   // 阵型名称
     std::string lineup_string; // 阵型字符串
     std::string lineup_code;   // 阵型代码
@@ -61,8 +82,8 @@ class Lineup
     bool ok;
     uint16_t items[GRID]; // 压缩的
 
-    std::vector<std::string> split(const std::string &, char);
-    long hex2dec(const std::string &);
+    static bool is_lineup_string(std::string_view); // 校验阵型字符串格式
+    static bool is_lineup_code(std::string_view);   // 校验阵型代码格式
 
     bool lineup_string_to_data();  // 阵型字符串 -> 数据
     bool lineup_code_to_data();    // 阵型代码 -> 数据
@@ -71,4 +92,169 @@ class Lineup
     inline void decompress_data(); // 解压数组
 };
 
+// 紧凑的阵型, 网格只保存压缩的数组, 名称在所属 LineupLibrary 的字符串区
+// 阵型代码需要时由压缩的数组生成, 不保存
+struct PackedLineup
+{
+    long long weight;
+    uint32_t name; // 名称在字符串区的位置
+    uint16_t name_len;
+    uint16_t padding; // 菜单里名称后面补的空格数, 区分重名的阵型
+    uint16_t items[GRID];
+    uint8_t scene;
+    uint8_t rake_row;
+};
+
+// 相似阵型的查找结果, 距离为不同的格子数, 场景不同的再加 GRID, 钉耙行不同的加 1
+struct LineupMatch
+{
+    uint32_t distance;
+    uint32_t index;
+};
+
+// 阵型列表
+// 阵型连续存放在一个数组里, 名称追加到同一块字符串区, 相同的名称只存一份, 遍历时不用跳到堆上的各个对象
+class LineupLibrary
+{
+  public:
+    size_t Size() const;
+    bool Empty() const;
+    void Clear();
+    void Reserve(size_t);
+
+    // 添加阵型, 返回序号
+    size_t Add(Lineup &);
+    // 参数为名称, 场景, 钉耙行, 压缩的数组, 权重
+    size_t Add(std::string_view, uint8_t, uint8_t, const uint16_t (&)[GRID], long long);
+
+    // 追加另一个列表的全部阵型
+    void Append(const LineupLibrary &);
+
+    const PackedLineup &operator[](size_t) const;
+    std::string_view Name(size_t) const;
+    std::string Code(size_t) const;    // 由压缩的数组生成
+    std::string Display(size_t) const; // 菜单里显示的名称
+    void SetPadding(size_t, uint16_t);
+
+    // 解压成完整的阵型
+    void Get(size_t, Lineup &) const;
+
+    // 按权重排序, 权重相同的保持原来的顺序
+    void Sort();
+
+    // 阵型内容的哈希, 只看网格, 场景和钉耙行, 不看名称和权重
+    static uint64_t Hash(const uint16_t (&)[GRID], uint8_t, uint8_t);
+    uint64_t Hash(size_t) const;
+
+    // 去掉内容相同的阵型, 保留最先出现的, 返回去掉的个数
+    size_t Dedup();
+
+    // 和给定阵型最相似的若干个, 按距离从小到大, 参数为压缩的数组, 场景, 钉耙行, 个数
+    std::vector<LineupMatch> Nearest(const uint16_t (&)[GRID], uint8_t, uint8_t, size_t) const;
+
+  protected:
+    // 名称放进字符串区, 已经有的直接返回位置
+    uint32_t intern(std::string_view, uint16_t &);
+
+    std::vector<PackedLineup> lineups;
+    std::string strings;
+    std::unordered_multimap<uint64_t, uint32_t> names; // 名称的哈希 -> 在字符串区的位置
+};
+
+// 解析阵型列表文件内容, 第一行必须是 "#! pvztoolkit"
+// 其余每行为 "名称": 阵型代码, 空行和 # 开头的行忽略
+// 内容较多时按行切分成多块并行解析, 结果按文件中的顺序合并
+// 格式错误的行以 (行号, 内容) 加入错误列表, 第一行不对时返回假
+bool ParseLineupList(std::string_view, LineupLibrary &, std::vector<std::tuple<int, std::string>> &);
+
+// 阵型列表缓存文件结构
+// [文件头] [源文件] [阵型] [字符串]
+// 阵型已经按菜单顺序排好, 带着菜单里名称补的空格数, 启动时映射到内存直接填充菜单
+
+#define LINEUP_CACHE_MAGIC 0x4350554c // LUPC
+#define LINEUP_CACHE_VERSION 3
+#define LINEUP_CACHE_FILE L"lineup.cache"
+
+struct LINEUP_CACHE_HEADER
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sources_count;
+    uint32_t entries_count;
+    uint32_t strings_offset;
+    uint32_t strings_size;
+};
+
+struct LINEUP_CACHE_SOURCE
+{
+    uint64_t size;     // 文件大小
+    uint64_t mtime;    // 修改时间 FILETIME
+    uint32_t crc;      // 文件内容的 CRC32
+    uint32_t path;     // 路径在字符串区的位置, UTF-16
+    uint32_t path_len; // 路径的字符数
+    uint32_t reserved;
+};
+
+struct LINEUP_CACHE_ENTRY
+{
+    long long weight;
+    uint32_t name; // 名称在字符串区的位置
+    uint32_t name_len;
+    uint32_t padding; // 菜单里名称后面补的空格数
+    uint16_t items[GRID];
+    uint8_t scene;
+    uint8_t rake_row;
+    uint8_t reserved[2];
+};
+
+// 自动导入的阵型列表的源文件
+struct LineupSource
+{
+    std::wstring path;
+    uint64_t size;
+    uint64_t mtime;
+    uint32_t crc;
+};
+
+// 文件内容的 CRC32, 读取失败返回假
+bool LineupFileCrc(const std::wstring &, uint32_t &);
+
+// 阵型列表缓存
+// 以每个源文件的路径, 大小, 修改时间和内容校验为键, 任何一个源文件变化都整体重建
+class LineupCache
+{
+  public:
+    LineupCache();
+    ~LineupCache();
+
+    LineupCache(const LineupCache &) = delete;
+    LineupCache &operator=(const LineupCache &) = delete;
+
+    bool Open(const std::wstring &);
+    void Close();
+
+    // 源文件列表是否和缓存一致, 大小相同但修改时间不同时比较内容校验
+    bool Match(const std::vector<LineupSource> &) const;
+
+    uint32_t Count() const;
+
+    // 把缓存的阵型连同菜单名称追加到列表
+    void Load(LineupLibrary &) const;
+
+    // 写入缓存, 参数为路径, 源文件, 排好序并设置了菜单名称的阵型
+    static bool Write(const std::wstring &, const std::vector<LineupSource> &, const LineupLibrary &);
+
+  protected:
+    std::string_view string_at(uint32_t, uint32_t) const;
+
+    HANDLE file;
+    HANDLE mapping;
+    const uint8_t *view;
+    uint64_t size;
+
+    LINEUP_CACHE_HEADER header;
+    const LINEUP_CACHE_SOURCE *sources;
+    const LINEUP_CACHE_ENTRY *entries;
+};
+
 } // namespace Pt
@@ -0,0 +1,87 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "lineup.h"
+
+namespace Pt
+{
+
+// 统计列, 每列是每个阵型里某种东西的个数
+// 0-47 为各种植物, 按游戏里的植物编号
+#define LINEUP_COL_IMITATER 48         // 模仿者植物
+#define LINEUP_COL_ASLEEP 49           // 睡着的植物
+#define LINEUP_COL_LILY_PAD 50         // 睡莲
+#define LINEUP_COL_FLOWER_POT 51       // 花盆
+#define LINEUP_COL_GRAVE 52            // 墓碑
+#define LINEUP_COL_PUMPKIN 53          // 南瓜
+#define LINEUP_COL_IMITATER_PUMPKIN 54 // 模仿者南瓜
+#define LINEUP_COL_COFFEE 55           // 咖啡豆
+#define LINEUP_COL_LADDER 56           // 梯子
+#define LINEUP_COLUMNS 57
+
+// 某一列的个数在 [min, max] 之间
+struct LineupCondition
+{
+    int column;
+    int min;
+    int max;
+};
+
+// 阵型筛选, 场景满足掩码并且所有条件都满足
+struct LineupFilter
+{
+    uint32_t scenes = 0x3f; // 第 i 位为场景 i
+    std::vector<LineupCondition> conditions;
+    int sort_column = -1; // 排序列, -1 为列表原来的顺序
+    bool descending = true;
+};
+
+// 解析筛选条件, 空格分开的若干项:
+//   scene=2 或 scene=0,2    场景
+//   列名>=8 列名<=1 列名=0  个数, 也可以用 > <
+//   sort=列名 asc|desc      排序
+// 列名为 cob gloom twin melon imitater asleep lily pot grave pumpkin im_pumpkin coffee ladder,
+// 或者 p 加植物编号, 例如 p47. 例如 "scene=2 cob>=8 ladder=0 im_pumpkin>=1 sort=cob"
+bool ParseLineupFilter(const std::string &, LineupFilter &);
+
+// 阵型列表的查询索引
+// 每个场景和每一列各有一个位图, 记录哪些阵型在这个场景或者这一列不为 0,
+// 另外按列保存个数, 查询先用位图按 64 位一组做与运算, 再只对剩下的阵型比较个数
+class LineupIndex
+{
+  public:
+    LineupIndex();
+
+    void Build(const LineupLibrary &);
+
+    size_t Size() const;
+    uint8_t Count(size_t, int) const;
+
+    // 满足条件的阵型序号, 按排序列排好
+    std::vector<uint32_t> Select(const LineupFilter &) const;
+
+  protected:
+    typedef std::vector<uint64_t> Bitset;
+
+    size_t count;
+    size_t words;
+    Bitset scenes[6];
+    Bitset present[LINEUP_COLUMNS];
+    std::vector<uint8_t> columns[LINEUP_COLUMNS];
+};
+
+// 命令行查询阵型列表文件, 参数为 列表文件 筛选条件
+int LineupQuery(int, char **);
+
+} // namespace Pt
@@ -0,0 +1,68 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "lineup.h"
+
+namespace Pt
+{
+
+// 阵型名称搜索
+// 名称转小写后拼成一块, 每个名称里连续的一到三个字节(三字组等)建倒排表, 按键排序后连续存放,
+// 不超过三个字节的查询直接取倒排表, 更长的取各个三字组的倒排表求交集, 再逐个确认包含查询,
+// 不区分 ASCII 大小写
+// 输入时查询一般是上一次加长一个字, 记住前面几次的结果, 只在上一次的结果里筛选
+class LineupNameIndex
+{
+  public:
+    LineupNameIndex();
+    ~LineupNameIndex();
+
+    LineupNameIndex(const LineupNameIndex &) = delete;
+    LineupNameIndex &operator=(const LineupNameIndex &) = delete;
+
+    // 复制菜单名称, 在后台线程建倒排表, 建好之前查询逐个比较名称
+    void Build(const LineupLibrary &);
+    void Clear();
+
+    bool Ready() const;
+    size_t Size() const;
+
+    // 名称包含查询的阵型序号, 从小到大, 空查询返回全部
+    const std::vector<uint32_t> &Search(std::string_view);
+
+  protected:
+    static DWORD WINAPI build_proc(LPVOID);
+    void build_postings();
+    void wait();
+
+    std::string_view name(uint32_t) const;
+    void scan(std::string_view, std::vector<uint32_t> &) const;
+    const uint32_t *postings_of(std::string_view, const uint32_t *&) const;
+    // 用倒排表查找, 参数为查询, 已知满足的查询, 已知满足的结果(空指针为全部), 结果
+    void lookup(std::string_view, std::string_view, const std::vector<uint32_t> *, std::vector<uint32_t> &) const;
+
+    std::string names;             // 小写的名称, 每个后面有一个 '\0'
+    std::vector<uint32_t> offsets; // 每个名称的开始位置, 最后多一个结尾
+
+    std::vector<uint32_t> keys;     // 一到三个字节, 最高字节为长度, 从小到大
+    std::vector<uint32_t> starts;   // 每个键的倒排表开始位置, 最后多一个结尾
+    std::vector<uint32_t> postings; // 倒排表, 阵型序号从小到大
+
+    HANDLE thread;
+    std::atomic<bool> ready;
+
+    // 最近几次的查询和结果, 每一个都包含前一个查询
+    std::vector<std::pair<std::string, std::vector<uint32_t>>> history;
+};
+
+} // namespace Pt
@@ -0,0 +1,136 @@
+
+#pragma once
+
+#include <Windows.h>
+
+namespace Pt
+{
+
+// 读写锁, 读共享写独占
+// XP 没有 SRWLOCK, 退化为临界区, 读也互斥
+class RwLock
+{
+  public:
+    RwLock()
+    {
+#if _WIN32_WINNT >= _WIN32_WINNT_VISTA
+        InitializeSRWLock(&lock);
+#else
+        InitializeCriticalSection(&lock);
+#endif
+    }
+
+    ~RwLock()
+    {
+#if _WIN32_WINNT < _WIN32_WINNT_VISTA
+        DeleteCriticalSection(&lock);
+#endif
+    }
+
+    RwLock(const RwLock &) = delete;
+    RwLock &operator=(const RwLock &) = delete;
+
+    void LockShared()
+    {
+#if _WIN32_WINNT >= _WIN32_WINNT_VISTA
+        AcquireSRWLockShared(&lock);
+#else
+        EnterCriticalSection(&lock);
+#endif
+    }
+
+    void UnlockShared()
+    {
+#if _WIN32_WINNT >= _WIN32_WINNT_VISTA
+        ReleaseSRWLockShared(&lock);
+#else
+        LeaveCriticalSection(&lock);
+#endif
+    }
+
+    void LockExclusive()
+    {
+#if _WIN32_WINNT >= _WIN32_WINNT_VISTA
+        AcquireSRWLockExclusive(&lock);
+#else
+        EnterCriticalSection(&lock);
+#endif
+    }
+
+    void UnlockExclusive()
+    {
+#if _WIN32_WINNT >= _WIN32_WINNT_VISTA
+        ReleaseSRWLockExclusive(&lock);
+#else
+        LeaveCriticalSection(&lock);
+#endif
+    }
+
+  protected:
+#if _WIN32_WINNT >= _WIN32_WINNT_VISTA
+    SRWLOCK lock;
+#else
+    CRITICAL_SECTION lock;
+#endif
+};
+
+// 可重入的互斥锁, 同一线程可以多次加锁
+class Mutex
+{
+  public:
+    Mutex() { InitializeCriticalSection(&lock); }
+    ~Mutex() { DeleteCriticalSection(&lock); }
+
+    Mutex(const Mutex &) = delete;
+    Mutex &operator=(const Mutex &) = delete;
+
+    void Lock() { EnterCriticalSection(&lock); }
+    void Unlock() { LeaveCriticalSection(&lock); }
+
+  protected:
+    CRITICAL_SECTION lock;
+};
+
+// 作用域内持有互斥锁
+class MutexLock
+{
+  public:
+    explicit MutexLock(Mutex &lock) : lock(lock) { lock.Lock(); }
+    ~MutexLock() { lock.Unlock(); }
+
+    MutexLock(const MutexLock &) = delete;
+    MutexLock &operator=(const MutexLock &) = delete;
+
+  protected:
+    Mutex &lock;
+};
+
+// 作用域内持有共享锁
+class SharedLock
+{
+  public:
+    explicit SharedLock(RwLock &lock) : lock(lock) { lock.LockShared(); }
+    ~SharedLock() { lock.UnlockShared(); }
+
+    SharedLock(const SharedLock &) = delete;
+    SharedLock &operator=(const SharedLock &) = delete;
+
+  protected:
+    RwLock &lock;
+};
+
+// 作用域内持有独占锁
+class ExclusiveLock
+{
+  public:
+    explicit ExclusiveLock(RwLock &lock) : lock(lock) { lock.LockExclusive(); }
+    ~ExclusiveLock() { lock.UnlockExclusive(); }
+
+    ExclusiveLock(const ExclusiveLock &) = delete;
+    ExclusiveLock &operator=(const ExclusiveLock &) = delete;
+
+  protected:
+    RwLock &lock;
+};
+
+} // namespace Pt
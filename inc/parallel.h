@@ -0,0 +1,25 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Pt
+{
+
+// 实际使用的线程数, 参数为任务数和线程数(不大于 0 时为处理器个数)
+// 调用者按这个数预先分配每个线程自己的统计
+size_t parallel_threads(uint32_t, int = 0);
+
+// 在多个线程上执行编号为 [0, count) 的任务, 调用线程也参与
+// 任务按编号平均分给每个线程, 自己的做完后从其他线程的队尾偷
+// 回调参数为任务编号和线程序号(小于 parallel_threads 的返回值)
+void parallel_for(uint32_t, const std::function<void(uint32_t, size_t)> &, int = 0);
+
+} // namespace Pt
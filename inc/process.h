@@ -10,6 +10,8 @@
 #include <sstream>
 #include <string>
 
+#include "lock.h"
+
 namespace Pt
 {
 
@@ -25,9 +27,20 @@ class Process
     // 根据窗口类名和标题打开进程
     bool OpenByWindow(const wchar_t *, const wchar_t *);
 
+    // 打开指定窗口所属的进程, 成功返回真
+    bool OpenByHwnd(HWND);
+
+    // 进程标识
+    DWORD Pid();
+
     // 进程可用性
     bool IsValid();
 
+    // 多步修改(读指针链后写入, 先改代码再注入等)期间持有, 可重入
+    // 纯读取只靠读内存时的共享锁, 不拿这个锁, 等待注入完成时也不拿
+    // 先拿这个锁再读写内存, 顺序不能反
+    Mutex &OperationLock();
+
     // 读内存
     template <typename T>
     T ReadMemory(std::initializer_list<uintptr_t>);
@@ -48,11 +61,25 @@ class Process
     template <typename T, size_t size>
     void WriteMemory(std::array<T, size>, std::initializer_list<uintptr_t>);
 
+    // 读连续内存块, 一次系统调用读完, 成功返回真
+    bool ReadMemoryBlock(void *, size_t, std::initializer_list<uintptr_t>);
+
+    // 写连续内存块
+    bool WriteMemoryBlock(const void *, size_t, std::initializer_list<uintptr_t>);
+
   protected:
     HWND hwnd;     // 窗口句柄
     DWORD pid;     // 进程标识
     HANDLE handle; // 进程句柄
 
+    // 已经持有 memory_lock 时检查进程可用性
+    bool is_valid();
+
+    // 读内存共享, 写内存, 注入和切换进程句柄独占, 注入代码运行时不会读到改了一半的数据
+    RwLock memory_lock;
+
+    Mutex operation_lock;
+
 #if (defined _DEBUG) && (defined _PZTK_MEMORY_OUTPUT)
   private:
     std::string int_to_hex_string(unsigned int num)
@@ -81,7 +108,9 @@ T Process::ReadMemory(std::initializer_list<uintptr_t> addr)
 {
     T result = T();
 
-    if (!IsValid())
+    SharedLock guard(memory_lock);
+
+    if (!is_valid())
         return result;
 
     uintptr_t offset = 0;
@@ -115,7 +144,9 @@ inline std::string Process::ReadMemory<std::string>(std::initializer_list<uintpt
 {
     std::string result = std::string();
 
-    if (!IsValid())
+    SharedLock guard(memory_lock);
+
+    if (!is_valid())
         return result;
 
     uintptr_t offset = 0;
@@ -155,7 +186,9 @@ inline std::string Process::ReadMemory<std::string>(std::initializer_list<uintpt
 template <typename T>
 void Process::WriteMemory(T value, std::initializer_list<uintptr_t> addr)
 {
-    if (!IsValid())
+    ExclusiveLock guard(memory_lock);
+
+    if (!is_valid())
         return;
 
     uintptr_t offset = 0;
@@ -189,7 +222,9 @@ std::array<T, size> Process::ReadMemory(std::initializer_list<uintptr_t> addr)
 {
     std::array<T, size> result = {T()};
 
-    if (!IsValid())
+    SharedLock guard(memory_lock);
+
+    if (!is_valid())
         return result;
 
     T buff[size] = {0};
@@ -227,7 +262,9 @@ std::array<T, size> Process::ReadMemory(std::initializer_list<uintptr_t> addr)
 template <typename T, size_t size>
 void Process::WriteMemory(std::array<T, size> value, std::initializer_list<uintptr_t> addr)
 {
-    if (!IsValid())
+    ExclusiveLock guard(memory_lock);
+
+    if (!is_valid())
         return;
 
     T buff[size] = {0};
@@ -0,0 +1,82 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Pt
+{
+
+// 单次注入造成的游戏卡顿
+struct StallSample
+{
+    double park_ms;         // 暂停主循环到恢复的耗时
+    int clock_before;       // 暂停前游戏时钟
+    int clock_after;        // 恢复后游戏时钟
+    int frames_lost;        // 损失的帧数
+    unsigned int code_size; // 注入代码长度
+};
+
+// 某个功能的卡顿统计
+struct StallStats
+{
+    size_t count; // 总次数
+    double park_ms_p50;
+    double park_ms_p90;
+    double park_ms_p99;
+    double park_ms_max;
+    int frames_lost_p50;
+    int frames_lost_p90;
+    int frames_lost_p99;
+    int frames_lost_max;
+    unsigned int code_size_max;
+};
+
+// 主循环卡顿统计
+// 按功能名分别保存最近若干次的采样, 用于计算滚动分位数
+class StallProfiler
+{
+  public:
+    StallProfiler();
+    ~StallProfiler();
+
+    StallProfiler(const StallProfiler &) = delete;
+    StallProfiler &operator=(const StallProfiler &) = delete;
+
+    // 计时, 单位毫秒
+    static double Now();
+
+    // 记录一次采样
+    void Record(const char *, const StallSample &);
+
+    // 获取某个功能的统计, 没有采样时返回假
+    bool Stats(const char *, StallStats &);
+
+    // 按 p99 耗时从高到低输出统计表
+    std::string Report();
+
+    // 清空
+    void Reset();
+
+  protected:
+    // 每个功能保留的采样数
+    static const size_t WINDOW = 256;
+
+    struct Ring
+    {
+        std::vector<StallSample> samples;
+        size_t next = 0;  // 下一个写入位置
+        size_t count = 0; // 总次数
+    };
+
+    bool stats(const Ring &, StallStats &);
+
+    std::map<std::string, Ring> rings;
+    CRITICAL_SECTION lock;
+};
+
+} // namespace Pt
@@ -3,9 +3,12 @@
 
 #include <Windows.h>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <deque>
 #include <iostream>
 #include <random>
 #include <string>
@@ -13,22 +16,45 @@
 
 #include "code.h"
 #include "data.h"
+#include "freeze.h"
 #include "lineup.h"
 #include "process.h"
+#include "profiler.h"
+#include "snapshot.h"
+#include "spawnsearch.h"
+#include "wavegen.h"
 
 namespace Pt
 {
 
 typedef void (*cb_func)(void *, int);
 
-class PvZ : public Process, public Code, public Data
+class PvZ : public Process, public Data
 {
   public:
     PvZ();
     ~PvZ();
 
-    // 安全地注入
-    void asm_code_inject();
+    // 把调用者生成的代码交给注入线程排队执行, 执行完后返回
+    // 每次调用各用一份局部 Code, 等待期间不持有 OperationLock
+    // 参数为调用者名称, 用于统计卡顿
+    void asm_code_inject(Code &, const char *);
+
+    // 等待游戏时钟到达指定值, 剩余时间较长时休眠, 临近时自旋
+    // 离开场地, stop 事件或 StopWaiting 触发, 或者超过 timeout 毫秒时返回假
+    bool WaitGameClock(int, HANDLE = nullptr, DWORD = INFINITE);
+
+    // 让所有正在等待游戏时钟的线程返回, 退出程序前调用
+    void StopWaiting();
+
+    // 暂停或继续, 和按空格键相同, 不检查 GameOn 以便后台线程调用
+    void SetGamePaused(bool);
+
+    // 注入卡顿统计
+    std::string StallReport();
+
+    // 读取场地快照
+    BoardSnapshot GetSnapshot(unsigned int);
 
     // 应用 hack
     template <typename T, size_t size>
@@ -54,10 +80,17 @@ class PvZ : public Process, public Code, public Data
     // 查找植物大战僵尸, 找到了支持的版本返回真
     bool FindPvZ();
 
+    // 绑定指定窗口的游戏, 不回调界面, 游戏退出后 GameOn 不会再去查找其他窗口
+    bool AttachPvZ(HWND);
+
     // 游戏是否正常开启
     // 每次修改前都要检查
     bool GameOn();
 
+    // 标记当前线程为后台线程, 在这个线程上 GameOn 找不到游戏时直接返回假,
+    // 不重新查找也不回调界面, 后台线程可以直接调用修改功能
+    static void BackgroundThread();
+
     // 游戏路径
     std::string GamePath();
 
@@ -75,10 +108,58 @@ class PvZ : public Process, public Code, public Data
     int GetRowCount();
 
   protected:
+    // 根据文件头判断游戏版本
+    void detect_version();
+
+    void clear_freeze();
+
     // 回调函数指针和窗口指针
     cb_func cb_find_result;
     void *window;
 
+    // 由 AttachPvZ 绑定
+    bool attached;
+
+    // 注入卡顿统计
+    StallProfiler profiler;
+
+    // 注入队列, 所有注入都在同一个线程上依次执行
+    struct InjectJob
+    {
+        Code *code;
+        const char *name;
+        HANDLE done;
+    };
+
+    static DWORD WINAPI inject_proc(LPVOID);
+
+    // 暂停主循环后注入, 在注入线程上执行
+    void inject(Code &, const char *);
+
+    // 挡住/放开游戏主循环, 可以嵌套和跨线程调用, 最后一个放开时才恢复
+    // 第一次挡住时等待两帧, 返回后游戏不会再修改内存
+    void park_main_loop();
+    void resume_main_loop();
+
+    CRITICAL_SECTION park_lock;
+    int park_count;
+
+    // StopWaiting 触发的事件, 手动重置
+    HANDLE stop_waiting;
+
+    HANDLE inject_thread;
+    HANDLE inject_event;
+    std::atomic<bool> inject_quit;
+    CRITICAL_SECTION inject_lock;
+    std::deque<InjectJob *> inject_jobs;
+
+    // 数值锁定
+    FreezeTable freezer;
+    int freeze_sun_id;
+    int freeze_money_id;
+    int freeze_endless_rounds_id;
+    std::vector<int> freeze_slot_ids;
+
   public:
     // 以下是修改功能
 
@@ -97,6 +178,14 @@ class PvZ : public Process, public Code, public Data
     // 修改金币
     void SetMoney(int);
 
+    // 锁定阳光/金币/无尽轮数, 值为锁定的数值
+    void FreezeSun(bool, int);
+    void FreezeMoney(bool, int);
+    void FreezeEndlessRounds(bool, int);
+
+    // 锁定卡槽冷却完成
+    void FreezeSlotCooldowns(bool);
+
     // 自动收集
     void AutoCollected(bool);
 
@@ -137,19 +226,19 @@ class PvZ : public Process, public Code, public Data
     void EndlessRounds(int);
 
     // 生成植物
-    void asm_put_plant(int, int, int, bool, bool);
+    void asm_put_plant(Code &, int, int, int, bool, bool);
     void PutPlant(int, int, int, bool);
 
     // 生成僵尸
-    void asm_put_zombie(int, int, int);
+    void asm_put_zombie(Code &, int, int, int);
     void PutZombie(int, int, int);
 
     // 生成墓碑
-    void asm_put_grave(int, int);
+    void asm_put_grave(Code &, int, int);
     void PutGrave(int, int);
 
     // 生成梯子和智能搭梯
-    void asm_put_ladder(int, int);
+    void asm_put_ladder(Code &, int, int);
     void PutLadder(int, int);
     void AutoLadder(bool);
 
@@ -166,6 +255,9 @@ class PvZ : public Process, public Code, public Data
     // 杀死所有僵尸
     void KillAllZombies();
 
+    // 杀死符合条件的僵尸, 返回数量
+    size_t KillZombies(const EntityFilter &);
+
     // 清理场地物品
     void ClearGridItems(std::vector<int>);
 
@@ -241,8 +333,23 @@ class PvZ : public Process, public Code, public Data
     // 内置函数生成出怪列表
     void InternalSpawn(std::array<bool, 33>);
 
-    // 自定义填充出怪列表
-    void CustomizeSpawn(std::array<bool, 33>, bool, bool, int);
+    // 自定义填充出怪列表, 参数为出怪种类, 限制红眼, 模拟自然出怪, 红眼权重, 随机数种子,
+    // 候选序号(同一个种子连续生成的第几个列表), 种子和序号相同时结果相同
+    void CustomizeSpawn(std::array<bool, 33>, bool, bool, int, uint32_t, size_t = 0);
+
+    // 当前关卡的出怪规则(出怪种类和无尽轮数)
+    WaveRules GetSpawnRules();
+
+    // 按当前出怪规则在本地生成出怪列表, 不修改游戏, 参数为随机数种子
+    std::array<int, 1000> PredictSpawnList(uint32_t);
+
+    // 检查游戏的出怪列表是否符合出怪规则, 返回第一个不符合的波数, 全部符合返回 -1
+    int CheckSpawnList();
+
+    // 在本地搜索满足约束的出怪列表并写入游戏, 生成规则和约束在搜索里设置
+    // 参数为搜索, 最多尝试的候选数, 随机数种子, 写入列表的违反量
+    // 都不满足时写入同一遍搜索里违反量最小的, 不在选卡或者战斗界面时返回假
+    bool SearchSpawnList(SpawnSearch &, uint32_t, uint32_t, int &);
 
     // 修改背景音乐
     void SetMusic(int);
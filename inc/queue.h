@@ -0,0 +1,81 @@
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Pt
+{
+
+// 单生产者单消费者无锁环形队列
+// 容量向上取整到 2 的幂, 满时 Push 失败而不是阻塞
+template <typename T>
+class SpscQueue
+{
+  public:
+    explicit SpscQueue(size_t capacity)
+    {
+        size_t n = 2;
+        while (n < capacity)
+            n <<= 1;
+        buffer.resize(n);
+        mask = n - 1;
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // 生产者调用
+    bool Push(const T &value)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) > mask)
+            return false;
+        buffer[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Push(T &&value)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) > mask)
+            return false;
+        buffer[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者调用
+    bool Pop(T &value)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        value = std::move(buffer[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t Size() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    size_t Capacity() const
+    {
+        return mask + 1;
+    }
+
+  protected:
+    std::vector<T> buffer;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head; // 消费者位置
+    alignas(64) std::atomic<size_t> tail; // 生产者位置
+};
+
+} // namespace Pt
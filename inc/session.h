@@ -0,0 +1,76 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "pvz.h"
+
+namespace Pt
+{
+
+// 多开管理
+// 每个游戏进程一个会话, 会话有自己的 PvZ 对象(进程句柄/版本数据/代码缓冲区)
+// 和工作线程, 广播的操作在各会话的线程上同时执行
+class SessionManager
+{
+  public:
+    SessionManager();
+    ~SessionManager();
+
+    SessionManager(const SessionManager &) = delete;
+    SessionManager &operator=(const SessionManager &) = delete;
+
+    // 查找所有游戏窗口, 为新的进程建立会话并移除已经退出的, 返回会话数
+    // 和 Broadcast 在同一个线程调用
+    size_t Discover();
+
+    size_t Count();
+
+    // 会话的游戏对象, 只应在该会话的工作线程上修改
+    PvZ *Get(size_t);
+
+    DWORD Pid(size_t);
+
+    // 在所选会话的工作线程上并行执行, 全部完成后返回, 空列表表示全部会话
+    void Broadcast(const std::function<void(PvZ &)> &, const std::vector<size_t> & = {});
+
+  protected:
+    struct Job
+    {
+        std::function<void(PvZ &)> func;
+        HANDLE done;
+    };
+
+    struct Session
+    {
+        PvZ pvz;
+        DWORD pid;
+
+        HANDLE thread;
+        HANDLE wake_event;
+        std::atomic<bool> quit;
+
+        CRITICAL_SECTION lock;
+        std::deque<Job *> jobs;
+    };
+
+    static BOOL CALLBACK enum_proc(HWND, LPARAM);
+    static DWORD WINAPI worker_proc(LPVOID);
+
+    // 建立会话并启动工作线程
+    bool open(HWND, DWORD);
+
+    // 停止工作线程
+    void close(Session *);
+
+    std::vector<std::unique_ptr<Session>> sessions;
+    std::vector<HWND> found; // Discover 过程中找到的窗口
+};
+
+} // namespace Pt
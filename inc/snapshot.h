@@ -0,0 +1,207 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "data.h"
+#include "layout.h"
+#include "process.h"
+
+namespace Pt
+{
+
+// 需要读取的对象池
+#define SNAPSHOT_PLANT 0x01
+#define SNAPSHOT_ZOMBIE 0x02
+#define SNAPSHOT_GRID_ITEM 0x04
+#define SNAPSHOT_LAWN_MOWER 0x08
+#define SNAPSHOT_PARTICLE_SYSTEM 0x10
+#define SNAPSHOT_ALL 0x1f
+
+// 对象池原始内存
+struct PoolImage
+{
+    uintptr_t base = 0;     // 对象池在游戏中的地址
+    uint32_t count_max = 0; // 对象池容量
+    uint32_t stride = 0;    // 结构体大小
+    std::vector<uint8_t> raw;
+
+    // 第 i 个对象在游戏中的地址
+    uintptr_t address(size_t i) const
+    {
+        return base + stride * i;
+    }
+
+    // 第 i 个对象的 ID, 位于结构体末尾, 高 16 位为槽位复用次数
+    uint32_t id(size_t i) const
+    {
+        return get<uint32_t>(i, stride - 4);
+    }
+
+    // 按记录访问
+    template <typename View>
+    PoolView<View> view(const typename View::Layout &layout) const
+    {
+        return PoolView<View>(raw.data(), count_max, layout);
+    }
+
+    // 第 i 个对象某个字段的值
+    template <typename T>
+    T get(size_t i, uintptr_t offset) const
+    {
+        T value;
+        memcpy(&value, raw.data() + stride * i + offset, sizeof(T));
+        return value;
+    }
+
+    // 修改第 i 个对象某个字段, 只改本地内存并记录修改区间, 调用 commit 写回
+    template <typename T>
+    void set(size_t i, uintptr_t offset, T value)
+    {
+        size_t begin = stride * i + offset;
+        memcpy(raw.data() + begin, &value, sizeof(T));
+        dirty.push_back({uint32_t(begin), uint32_t(begin + sizeof(T))});
+    }
+
+    // 把修改过的区间写回游戏
+    // 默认只合并相接或者重叠的区间, 不碰没改过的字节, 游戏运行时也不会写回旧值
+    // max_gap 大于 0 时间隔不超过它的区间也合并成一次写入, 夹在中间的未修改字节
+    // 在写入前重新读取, 只适合游戏暂停(主循环被挡住)的时候
+    bool commit(Process &, uint32_t max_gap = 0);
+
+    // 修改过的字节区间 [begin, end), 相对 raw
+    std::vector<std::pair<uint32_t, uint32_t>> dirty;
+};
+
+// 按列筛选对象的条件, 范围为闭区间
+struct EntityFilter
+{
+    std::vector<int> types; // 为空时不限类型
+    int row_min = 0;
+    int row_max = 0x7fffffff;
+    int col_min = 0; // 僵尸按 x 换算成列
+    int col_max = 0x7fffffff;
+    int hp_min = -0x7fffffff - 1;
+    int hp_max = 0x7fffffff;
+    bool alive = true; // 只选择存活的对象
+
+    bool match(bool is_alive, int type, int row, int col, int hp) const
+    {
+        if (alive && !is_alive)
+            return false;
+        if (!types.empty() && std::find(types.begin(), types.end(), type) == types.end())
+            return false;
+        return row >= row_min && row <= row_max  //
+               && col >= col_min && col <= col_max //
+               && hp >= hp_min && hp <= hp_max;
+    }
+};
+
+// 字段修改, size 为 1 或 4 字节
+struct FieldWrite
+{
+    uintptr_t offset;
+    uint32_t size;
+    int32_t value;
+};
+
+// 以下按列保存各对象池, 下标和对象池槽位一一对应
+
+struct PlantColumns
+{
+    std::vector<uint32_t> id;
+    std::vector<uint8_t> alive; // 未消失且未被压扁
+    std::vector<int32_t> type;
+    std::vector<int32_t> row;
+    std::vector<int32_t> col;
+    std::vector<uint8_t> imitater;
+    std::vector<uint8_t> asleep;
+    std::vector<int32_t> hp;
+};
+
+struct ZombieColumns
+{
+    std::vector<uint32_t> id;
+    std::vector<uint8_t> alive;
+    std::vector<int32_t> status;
+    std::vector<int32_t> type;
+    std::vector<int32_t> row;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<int32_t> hp;
+};
+
+struct GridItemColumns
+{
+    std::vector<uint32_t> id;
+    std::vector<uint8_t> alive;
+    std::vector<int32_t> type;
+    std::vector<int32_t> row;
+    std::vector<int32_t> col;
+};
+
+struct LawnMowerColumns
+{
+    std::vector<uint8_t> alive;
+};
+
+struct ParticleSystemColumns
+{
+    std::vector<uint8_t> alive;
+    std::vector<int32_t> type;
+};
+
+// 场地快照
+// 每个对象池整块读取一次, 再按字段解码成列
+class BoardSnapshot
+{
+  public:
+    BoardSnapshot();
+    ~BoardSnapshot();
+
+    // 读取指定的对象池, 全部读取成功返回真
+    bool Capture(Process &, const PVZ_DATA &, const LAYOUTS &, unsigned int);
+
+    // 已读取的对象池
+    unsigned int pools;
+
+    PoolImage plant_pool;
+    PoolImage zombie_pool;
+    PoolImage grid_item_pool;
+    PoolImage lawn_mower_pool;
+    PoolImage particle_system_pool;
+
+    PlantColumns plants;
+    ZombieColumns zombies;
+    GridItemColumns grid_items;
+    LawnMowerColumns lawn_mowers;
+    ParticleSystemColumns particle_systems;
+
+  protected:
+    // 根据所属对象地址读取对象池基址和容量, 然后整块读取
+    bool read_pool(Process &, PoolImage &, uint32_t, uintptr_t, uintptr_t, uintptr_t);
+
+    void decode_plants(const LAYOUTS &);
+    void decode_zombies(const LAYOUTS &);
+    void decode_grid_items(const LAYOUTS &);
+    void decode_lawn_mowers(const LAYOUTS &);
+    void decode_particle_systems(const LAYOUTS &);
+};
+
+// 主循环暂停时合并修改区间的最大间隔, 一次读写一页比多次系统调用便宜
+#define SNAPSHOT_PARKED_GAP 0x1000
+
+// 修改对象池中符合条件的对象, 写回后返回修改的对象数
+// 植物/僵尸/场地物品分别按对应的列筛选, 最后的参数为写回时的 max_gap
+size_t MutatePlants(Process &, BoardSnapshot &, const EntityFilter &, const std::vector<FieldWrite> &, uint32_t = 0);
+size_t MutateZombies(Process &, BoardSnapshot &, const EntityFilter &, const std::vector<FieldWrite> &, uint32_t = 0);
+size_t MutateGridItems(Process &, BoardSnapshot &, const EntityFilter &, const std::vector<FieldWrite> &, uint32_t = 0);
+
+} // namespace Pt
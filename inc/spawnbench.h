@@ -0,0 +1,21 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "wavegen.h"
+
+namespace Pt
+{
+
+// 命令行对比自定义出怪新旧实现的速度, 参数为 [次数]
+int SpawnBenchmark(int, char **);
+
+} // namespace Pt
@@ -0,0 +1,30 @@
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <FL/images/zlib.h>
+
+#include "utils.h"
+#include "wavegen.h"
+
+namespace Pt
+{
+
+// 出怪代码, 用于分享出怪列表
+// [版本] [波数] [位流] [CRC32], 整体 Base64 编码
+// 位流每波先写 6 位个数, 再逐个写 6 位符号, 0-32 为僵尸种类, 33 为空位(-1),
+// 63 表示重复上一个符号, 后跟 6 位的 (重复次数 - 2), 每波末尾的空位和末尾的空波不保存
+
+#define SPAWN_CODE_VERSION 1
+
+// 生成出怪代码
+std::string EncodeSpawnList(const std::array<int, 1000> &);
+
+// 解析出怪代码, 同时接受 Base64Url 和省略末尾 '=' 的写法, 格式或校验不对返回假
+bool DecodeSpawnList(const std::string &, std::array<int, 1000> &);
+
+} // namespace Pt
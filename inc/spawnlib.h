@@ -0,0 +1,119 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <FL/images/zlib.h>
+
+#include "wavegen.h"
+
+namespace Pt
+{
+
+// 出怪列表库文件结构
+// [文件头] [索引块] [列表数据 | 索引块]...
+// 索引块容量固定, 满了在文件末尾追加新的索引块并链接, 第 i 条在第 i / 容量 块,
+// 打开时读一遍索引块链表, 之后按序号访问都是 O(1)
+// 追加时先写列表数据, 再写索引项, 最后更新文件头的条数, 中途中断不会损坏已有内容
+// 列表数据每波先写个数, 再逐个写种类, 各占一字节, 每波末尾的 -1 不保存
+
+#define SPAWN_LIB_MAGIC 0x424c5053 // SPLB
+#define SPAWN_LIB_VERSION 1
+#define SPAWN_LIB_BLOCK_CAPACITY 256
+
+// 旧的单个出怪列表文件 .zbl
+#define ZBL_MAGIC 0x58434c52
+#define ZBL_VERSION 1
+#define ZBL_LENGTH 1000
+
+struct SPAWN_LIB_HEADER
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;       // 条数
+    uint32_t first_block; // 第一个索引块的位置
+};
+
+struct SPAWN_LIB_ENTRY
+{
+    uint32_t offset; // 列表数据的位置
+    uint32_t size;   // 列表数据的字节数
+    uint32_t crc;    // 列表数据的校验
+    uint32_t time;   // 保存时间, Unix 时间戳
+    char name[44];   // UTF-8, 以 0 结尾
+    char tags[32];   // 以空格分隔
+    uint16_t counts[33]; // 每种僵尸的总数
+    uint16_t reserved;
+};
+
+struct SPAWN_LIB_BLOCK
+{
+    uint32_t next; // 下一个索引块的位置, 0 为没有
+    uint32_t reserved;
+    SPAWN_LIB_ENTRY entries[SPAWN_LIB_BLOCK_CAPACITY];
+};
+
+// 读取 .zbl 文件, 格式或校验不对返回假
+bool ReadZbl(const std::wstring &, std::array<int, 1000> &);
+
+// 出怪列表库
+// 文件映射到内存, 按序号直接读取索引项和列表, 追加时通过文件句柄写入后重新映射
+// 不追加时可以在多个线程里同时读取
+class SpawnLibrary
+{
+  public:
+    SpawnLibrary();
+    ~SpawnLibrary();
+
+    SpawnLibrary(const SpawnLibrary &) = delete;
+    SpawnLibrary &operator=(const SpawnLibrary &) = delete;
+
+    // 打开, 文件不存在时创建
+    bool Open(const std::wstring &);
+    void Close();
+
+    uint32_t Count() const;
+
+    // 第 i 条的索引项, 指向映射的内存, 追加后失效
+    const SPAWN_LIB_ENTRY *Entry(uint32_t) const;
+
+    // 第 i 条的列表, 校验不对返回假
+    bool List(uint32_t, std::array<int, 1000> &) const;
+
+    // 追加一条, 参数为名称, 标签, 列表, 保存时间
+    bool Append(const std::string &, const std::string &, const std::array<int, 1000> &, uint32_t);
+
+    // 导入目录下所有 .zbl 文件, 名称为文件名, 时间为文件修改时间, 返回导入的条数
+    uint32_t Import(const std::wstring &, const std::string & = "zbl");
+
+  protected:
+    // 追加一条但不重新映射, 批量导入时最后统一映射一次
+    bool append(const std::string &, const std::string &, const std::array<int, 1000> &, uint32_t);
+
+    // 重新映射整个文件并读取索引块链表
+    bool remap();
+
+    bool write_at(uint64_t, const void *, uint32_t);
+
+    HANDLE file;
+    HANDLE mapping;
+    const uint8_t *view;
+    uint64_t size;
+
+    SPAWN_LIB_HEADER header;
+    std::vector<uint32_t> blocks; // 各索引块的位置
+};
+
+} // namespace Pt
@@ -0,0 +1,129 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "parallel.h"
+#include "wavegen.h"
+
+namespace Pt
+{
+
+// 约束比较方式
+#define SPAWN_AT_LEAST 1 // 至少
+#define SPAWN_AT_MOST 2  // 至多
+
+// 界面里搜索时最多尝试的候选数
+#define SPAWN_SEARCH_CANDIDATES 200000
+
+// 出怪约束: 某种僵尸在若干波里的数量
+struct SpawnConstraint
+{
+    int type;       // 僵尸种类
+    uint32_t waves; // 波数集合, 第 w 波(从 1 开始)对应第 w-1 位
+    bool each;      // 每波分别计数, 否则合计
+    int op;         // SPAWN_AT_LEAST / SPAWN_AT_MOST
+    int value;
+};
+
+// 解析一条文本约束, 格式为 "种类 波数 each|total min|max 数量"
+// 波数为 all, flag, a-b 或者 a, 例如:
+//   32 1-10 total max 0    前 10 波没有红眼
+//   20 flag each min 4     每个旗帜波都有蹦极
+//   7 all total max 3      橄榄一共不超过 3 只
+// 格式错误或者生成器不可能满足时返回假, 例如旗帜波最多 4 只蹦极, 雪人最多 1 只
+bool ParseSpawnConstraint(const std::string &, SpawnConstraint &);
+
+// 搜索到的出怪列表
+struct SpawnCandidate
+{
+    std::array<int, 1000> list;
+    int violation;  // 违反约束的总量, 0 为全部满足
+    uint32_t index; // 候选编号, 用 种子+编号 作为生成器的种子可以复现
+};
+
+// 出怪列表搜索
+// 多线程用生成器逐个生成候选列表, 每生成完一波就检查约束,
+// 已经确定的违反量超过要求时立即放弃这个候选
+class SpawnSearch
+{
+  public:
+    // 自然出怪规则
+    explicit SpawnSearch(const WaveRules &);
+
+    // 自定义出怪, 参数同 CustomSpawner
+    SpawnSearch(const std::array<bool, 33> &, bool, bool, int);
+
+    SpawnSearch(const SpawnSearch &) = delete;
+    SpawnSearch &operator=(const SpawnSearch &) = delete;
+
+    void AddConstraint(const SpawnConstraint &);
+    void ClearConstraints();
+
+    // 找到编号最小的满足全部约束的列表, 参数为最多尝试的候选数, 种子, 个数, 结果
+    // 找到时返回真, 结果只有这一个; 否则结果为同一遍搜索里违反量最小的若干个,
+    // 按违反量和编号排序, 不需要为了找最接近的再搜索一遍
+    bool FindFirst(uint32_t, uint32_t, size_t, std::vector<SpawnCandidate> &);
+
+    // 上一次搜索生成的候选数和其中中途放弃的个数
+    uint32_t Tried();
+    uint32_t Pruned();
+
+  protected:
+    // 每次领取的候选数
+    static const uint32_t CHUNK_SIZE = 64;
+
+    // 一个候选的约束检查进度
+    struct Progress
+    {
+        std::vector<int> totals; // 每条合计约束目前的数量
+        int settled;             // 已经确定的违反量
+    };
+
+    // 一个线程的结果
+    struct Worker
+    {
+        bool found;                       // 找到了满足全部约束的
+        SpawnCandidate first;             // 其中编号最小的
+        std::vector<SpawnCandidate> best; // 不满足的里违反量最小的, 按违反量和编号排序
+        uint32_t tried;
+        uint32_t pruned;
+    };
+
+    // 搜索一块候选
+    void work(Worker &, uint32_t);
+
+    // 检查刚生成完的一波, 返回违反量的下界
+    int check_wave(const std::array<int, 1000> &, int, Progress &) const;
+
+    bool generate(std::mt19937 &, std::array<int, 1000> &, const std::function<bool(int)> &) const;
+
+    // 在所有线程上搜索
+    void run(uint32_t, uint32_t, size_t);
+
+    std::unique_ptr<WaveGenerator> natural;
+    std::unique_ptr<CustomSpawner> custom;
+    int waves_count; // 生成器的波数
+    std::vector<SpawnConstraint> constraints;
+    std::vector<int> last_wave; // 每条约束涉及的最后一波, 合计约束到这一波时结算
+    int base_violation;         // 涉及的波数都不存在的约束的违反量
+
+    // 本次搜索的参数和共享状态
+    uint32_t count;
+    uint32_t seed;
+    size_t keep;                       // 每个线程保留的个数
+    std::atomic<uint32_t> first_found; // 已经找到的满足全部约束的最小编号
+    std::vector<Worker> workers;
+};
+
+} // namespace Pt
@@ -0,0 +1,79 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "parallel.h"
+#include "wavegen.h"
+
+namespace Pt
+{
+
+#define SPAWN_STAT_TYPES 33
+#define SPAWN_STAT_COLS (20 + 1) // 20 波 + 总数
+
+// 出怪窗口里分析一次的样本数
+#define SPAWN_ANALYZE_SAMPLES 1000000
+
+// 出怪分布统计结果, 最后一列为整轮
+struct SpawnStats
+{
+    uint32_t samples = 0;
+    double mean[SPAWN_STAT_TYPES][SPAWN_STAT_COLS] = {{0}};   // 平均数量
+    double appear[SPAWN_STAT_TYPES][SPAWN_STAT_COLS] = {{0}}; // 至少出现一只的概率
+    int p10[SPAWN_STAT_TYPES][SPAWN_STAT_COLS] = {{0}};       // 数量的分位数
+    int p50[SPAWN_STAT_TYPES][SPAWN_STAT_COLS] = {{0}};
+    int p90[SPAWN_STAT_TYPES][SPAWN_STAT_COLS] = {{0}};
+    double giga_late = 0; // 第 10-19 波出现红眼的概率
+    double elapsed_ms = 0;
+};
+
+// 出怪分布分析
+// 用 WaveGenerator 大量生成出怪列表, 统计每波每种僵尸数量的分布,
+// 每块样本的种子固定, 结果和线程数无关
+// 样本分成小块平均分给每个处理器一个线程, 做完自己的再从其他线程的队尾偷
+class SpawnAnalyzer
+{
+  public:
+    SpawnAnalyzer(const WaveRules &);
+
+    SpawnAnalyzer(const SpawnAnalyzer &) = delete;
+    SpawnAnalyzer &operator=(const SpawnAnalyzer &) = delete;
+
+    // 样本数, 起始种子, 线程数(0 为处理器个数)
+    SpawnStats Run(uint32_t, uint32_t = 0, int = 0);
+
+  protected:
+    // 每块样本数
+    static const uint32_t CHUNK_SIZE = 1024;
+
+    // 整轮数量的直方图上限
+    static const int TOTAL_MAX = 1000;
+
+    // 一个线程的统计
+    struct Worker
+    {
+        std::vector<uint32_t> hist; // [类型][波数][数量]
+        std::vector<uint32_t> hist_total;
+        uint32_t giga_late;
+    };
+
+    // 生成并统计一块样本
+    void work(Worker &, uint32_t);
+
+    // 统计一个样本
+    void sample(Worker &, const std::array<int, 1000> &);
+
+    WaveGenerator generator;
+    std::vector<int> types; // 可能出现的种类, 只统计这些
+
+    uint32_t samples;
+    uint32_t seed;
+};
+
+} // namespace Pt
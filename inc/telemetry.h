@@ -0,0 +1,254 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <FL/images/zlib.h>
+
+#include "parallel.h"
+#include "pvz.h"
+#include "queue.h"
+#include "snapshot.h"
+
+namespace Pt
+{
+
+// 录像文件结构
+// [文件头] [数据块头 压缩数据]... [索引] [文件尾]
+// 每个数据块的第一帧都相对空白帧编码, 可以单独解码
+// 没有文件尾时(录制中断)可以顺序扫描数据块重建索引
+
+#define TELEMETRY_MAGIC 0x544b5450       // PTKT
+#define TELEMETRY_CHUNK_MAGIC 0x4b4e4843 // CHNK
+#define TELEMETRY_INDEX_MAGIC 0x58444e49 // INDX
+#define TELEMETRY_VERSION 1
+
+// 实体字段
+#define TELEMETRY_FIELD_ID 0
+#define TELEMETRY_FIELD_ALIVE 1
+#define TELEMETRY_FIELD_TYPE 2
+#define TELEMETRY_FIELD_ROW 3
+#define TELEMETRY_FIELD_POS 4
+#define TELEMETRY_FIELD_HP 5
+#define TELEMETRY_FIELD_COUNT 6
+
+struct TELEMETRY_HEADER
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t interval; // 采样间隔帧数
+    uint32_t reserved;
+};
+
+struct TELEMETRY_CHUNK
+{
+    uint32_t magic;
+    uint32_t first_frame; // 第一帧的序号
+    uint32_t frame_count;
+    int32_t first_clock; // 第一帧的游戏时钟
+    int32_t last_clock;
+    uint32_t raw_size;
+    uint32_t comp_size;
+    uint32_t crc; // 压缩数据的校验
+};
+
+struct TELEMETRY_INDEX
+{
+    uint64_t offset; // 数据块头在文件中的位置
+    uint32_t first_frame;
+    uint32_t frame_count;
+    int32_t first_clock;
+    int32_t last_clock;
+};
+
+struct TELEMETRY_FOOTER
+{
+    uint64_t index_offset;
+    uint32_t count;
+    uint32_t magic;
+};
+
+// 单个实体, 按对象池槽位保存
+// 植物的位置为列, 僵尸的位置为横坐标取整
+struct TelemetryEntity
+{
+    int32_t field[TELEMETRY_FIELD_COUNT];
+};
+
+// 一帧的场地状态
+struct TelemetryFrame
+{
+    int32_t clock = 0;
+    int32_t sun = 0;
+    int32_t wave = 0;
+    std::vector<TelemetryEntity> plants;
+    std::vector<TelemetryEntity> zombies;
+};
+
+// 植物和僵尸名称, 定义在 window.cpp
+extern const char *plants[];
+extern const char *zombies[];
+
+// 编码 curr 相对 prev 的差异
+void TelemetryEncode(const TelemetryFrame &prev, const TelemetryFrame &curr, std::vector<uint8_t> &out);
+
+// 在 state 上应用一帧差异, 数据有误返回假
+bool TelemetryDecode(const uint8_t *&p, const uint8_t *end, TelemetryFrame &state);
+
+// 场地录像
+// 采样线程每隔若干帧读取一次快照并做差分编码,
+// 攒满一个数据块后交给写入线程压缩并追加到文件
+class TelemetryRecorder
+{
+  public:
+    TelemetryRecorder(PvZ *);
+    ~TelemetryRecorder();
+
+    TelemetryRecorder(const TelemetryRecorder &) = delete;
+    TelemetryRecorder &operator=(const TelemetryRecorder &) = delete;
+
+    // 采样间隔帧数, 录制前设置
+    void SetInterval(int);
+
+    bool Start(const std::wstring &);
+    void Stop();
+    bool Recording();
+
+    // 已经写入的帧数
+    size_t FramesWritten();
+
+    // 写入线程跟不上时丢弃的帧数
+    size_t FramesDropped();
+
+  protected:
+    // 一个数据块最多的帧数和未压缩大小
+    static const uint32_t CHUNK_FRAMES = 256;
+    static const size_t CHUNK_BYTES = 512 * 1024;
+
+    // 等待写入的数据块上限, 用来限制内存
+    static const size_t QUEUE_CHUNKS = 8;
+
+    struct Chunk
+    {
+        TELEMETRY_CHUNK header;
+        std::vector<uint8_t> raw;
+    };
+
+    static DWORD WINAPI sample_thread(LPVOID);
+    static DWORD WINAPI write_thread(LPVOID);
+    void sample();
+    void write();
+
+    // 从快照取出这一帧
+    void capture(const BoardSnapshot &, TelemetryFrame &);
+
+    // 把当前数据块交给写入线程
+    void flush();
+
+    PvZ *pvz;
+    int interval;
+
+    std::ofstream file;
+    std::vector<TELEMETRY_INDEX> index;
+
+    std::unique_ptr<Chunk> chunk; // 采样线程正在填充的数据块
+    TelemetryFrame prev_frame;
+    uint32_t frame_count;
+
+    SpscQueue<std::unique_ptr<Chunk>> queue;
+    HANDLE queue_event;
+
+    HANDLE sampler;
+    HANDLE writer;
+    std::atomic<bool> stopping; // 通知采样线程退出
+    std::atomic<bool> draining; // 通知写入线程写完剩余数据后退出
+    std::atomic<bool> recording;
+    std::atomic<size_t> frames_written;
+    std::atomic<size_t> frames_dropped;
+};
+
+// 按帧区间汇总的统计
+struct TelemetryBucket
+{
+    uint32_t first_frame; // 区间内第一帧的序号
+    int32_t clock;        // 区间内第一帧的游戏时钟
+    uint32_t frames;      // 区间内的帧数
+    double zombies[6];    // 每行平均僵尸数
+    double sun;           // 平均阳光
+};
+
+// 植物损失
+struct TelemetryLoss
+{
+    int32_t wave;
+    int32_t type; // 模仿者加 48
+    uint32_t count;
+};
+
+struct TelemetryStats
+{
+    uint32_t frames;
+    std::vector<TelemetryBucket> buckets;
+    std::vector<TelemetryLoss> losses;
+};
+
+// 录像读取
+// 整个文件映射到内存, 通过数据块索引跳转, 只解压用到的数据块
+class TelemetryReader
+{
+  public:
+    TelemetryReader();
+    ~TelemetryReader();
+
+    TelemetryReader(const TelemetryReader &) = delete;
+    TelemetryReader &operator=(const TelemetryReader &) = delete;
+
+    bool Open(const std::wstring &);
+    void Close();
+
+    // 采样间隔帧数
+    uint32_t Interval();
+
+    // 总帧数, 包括录制时丢弃的帧
+    uint32_t FrameCount();
+
+    const std::vector<TELEMETRY_INDEX> &Index();
+
+    // 读取指定序号的帧
+    bool FrameAt(uint32_t, TelemetryFrame &);
+
+    // 依次解码一个数据块内的所有帧
+    bool ForEachFrame(size_t, const std::function<void(uint32_t, const TelemetryFrame &)> &);
+
+    // 各数据块并行统计: 每行僵尸数和阳光按帧区间汇总, 植物损失按波次汇总
+    bool Analyze(uint32_t, TelemetryStats &);
+
+  protected:
+    // 文件尾损坏时顺序扫描重建索引
+    bool load_index();
+
+    // 解压数据块
+    bool inflate(size_t, std::vector<uint8_t> &);
+
+    HANDLE file;
+    HANDLE mapping;
+    const uint8_t *view;
+    uint64_t size;
+
+    TELEMETRY_HEADER header;
+    std::vector<TELEMETRY_INDEX> index;
+};
+
+// 命令行查询, 参数为 录像文件 查询名称 [帧区间]
+int TelemetryQuery(int, char **);
+
+} // namespace Pt
@@ -0,0 +1,139 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define THREAT_SSE2
+#endif
+
+#include "parallel.h"
+#include "spawnlib.h"
+
+namespace Pt
+{
+
+// 威胁向量的分量
+#define THREAT_HP 0      // 血量, 以普僵为 1
+#define THREAT_FAST 1    // 移动快
+#define THREAT_LADDER 2  // 搭梯
+#define THREAT_VAULT 3   // 跳过植物
+#define THREAT_AIR 4     // 飞行
+#define THREAT_DIG 5     // 地下
+#define THREAT_CRUSH 6   // 碾压或砸植物
+#define THREAT_EXPLODE 7 // 爆炸
+#define THREAT_FEATURES 8
+
+// 僵尸移动速度分类
+#define THREAT_SPEED_SLOW 0
+#define THREAT_SPEED_NORMAL 1
+#define THREAT_SPEED_FAST 2
+
+// 僵尸特性
+#define THREAT_FLAG_LADDER 0x01
+#define THREAT_FLAG_VAULT 0x02
+#define THREAT_FLAG_AIR 0x04
+#define THREAT_FLAG_DIG 0x08
+#define THREAT_FLAG_CRUSH 0x10
+#define THREAT_FLAG_EXPLODE 0x20
+
+// 僵尸的威胁属性
+struct ZombieThreat
+{
+    int hp;    // 本体和护具的总血量
+    int speed; // THREAT_SPEED_*
+    int flags; // THREAT_FLAG_*
+};
+
+// 一波或整轮的威胁, 每种僵尸的属性乘以数量累加
+struct ThreatVector
+{
+    alignas(16) float v[THREAT_FEATURES];
+};
+
+// 排名指标, 得分为各分量的加权和
+struct ThreatMetric
+{
+    float weights[THREAT_FEATURES] = {1, 1, 2, 1, 2, 2, 4, 3};
+    bool peak = false; // 取得分最高的一波, 否则为整轮合计
+};
+
+// 解析指标, 格式为 "[total|peak] 分量=权重 ...", 写出的分量替换默认权重, 其余为 0
+// 分量为 hp fast ladder vault air dig crush explode, 例如:
+//   peak hp=1 crush=5     单波血量和巨人类最多的
+//   ladder=1 air=1        梯子和气球最多的
+bool ParseThreatMetric(const std::string &, ThreatMetric &);
+
+// 排名结果
+struct ThreatRank
+{
+    float score;
+    uint32_t index;
+};
+
+// 出怪威胁分析
+// 每种僵尸的属性预先展开成一行威胁向量, 一波的威胁就是按种类取行累加,
+// 排名时权重先折算到每种僵尸上, 每只僵尸只需要查一次表
+class ThreatAnalyzer
+{
+  public:
+    explicit ThreatAnalyzer(const ThreatMetric & = ThreatMetric());
+
+    // 每波的威胁向量
+    void Waves(const std::array<int, 1000> &, ThreatVector (&)[20]) const;
+
+    // 按每种僵尸的总数计算整轮的威胁向量
+    ThreatVector Total(const uint16_t (&)[33]) const;
+
+    float Score(const std::array<int, 1000> &) const;
+    float Score(const uint16_t (&)[33]) const;
+
+    // 按指标的权重把一个威胁向量折算成得分
+    float Score(const ThreatVector &) const;
+
+    // 给库里的所有列表打分, 返回得分最高的若干个, 参数为个数, 线程数(0 为处理器个数)
+    // 整轮合计只需要索引里的数量, 不用解码列表
+    std::vector<ThreatRank> Rank(const SpawnLibrary &, size_t, int = 0) const;
+    std::vector<ThreatRank> Rank(const std::vector<std::array<int, 1000>> &, size_t, int = 0) const;
+
+    static const ZombieThreat ZOMBIES[33];
+
+  protected:
+    // 每次领取的列表数
+    static const uint32_t CHUNK_SIZE = 256;
+
+    // 一次排名的共享状态
+    struct Job
+    {
+        const SpawnLibrary *library;
+        const std::vector<std::array<int, 1000>> *lists;
+        uint32_t count;
+        std::vector<float> scores;
+    };
+
+    // 给一块列表打分
+    void work(Job &, uint32_t) const;
+
+    std::vector<ThreatRank> rank(Job &, size_t, int) const;
+
+    ThreatMetric metric;
+    ThreatVector rows[34]; // 每种僵尸一行, 最后一行为空位
+    float weighted[34];    // 每种僵尸的加权得分
+};
+
+// 命令行按指标给出怪列表库排名, 参数为 库文件 [指标]
+int ThreatQuery(int, char **);
+
+} // namespace Pt
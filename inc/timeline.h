@@ -0,0 +1,99 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pvz.h"
+
+namespace Pt
+{
+
+// 动作类型
+#define TIMELINE_PLANT 1   // 种植物 行 列 类型 [模仿者]
+#define TIMELINE_ZOMBIE 2  // 放僵尸 行 列 类型
+#define TIMELINE_HACK 3    // 开关功能 名称 0/1
+#define TIMELINE_WRITE 4   // 修改数值 名称 数值
+#define TIMELINE_PAUSE 5   // 暂停
+#define TIMELINE_UNPAUSE 6 // 继续
+
+// 时间轴上的一个动作
+struct TimelineAction
+{
+    int clock;         // 游戏时钟
+    bool relative;     // clock 是否相对上一个动作
+    int kind;          // TIMELINE_*
+    int args[4];       // 行列从 0 开始
+    std::string name;  // 功能或数值名称
+};
+
+// 时间轴
+// 动作按游戏时钟排列, 后台线程等待时钟到达后执行,
+// 同一帧到期的开关功能和数值修改先执行, 种植物和放僵尸合并成一次注入
+// 修改数值只能通过已知的指针链, 名称为 sun money rounds tree speed
+//
+// 文件每行一个动作, # 开头为注释, 行列从 1 开始:
+//   1200 plant 3 1 47
+//   +75 zombie 1 9 32
+//   +0 hack AutoCollected 1
+//   +10 write sun 100
+//   +100 pause
+class Timeline
+{
+  public:
+    Timeline(PvZ *);
+    ~Timeline();
+
+    Timeline(const Timeline &) = delete;
+    Timeline &operator=(const Timeline &) = delete;
+
+    void Clear();
+    void Add(const TimelineAction &);
+
+    // 读取文件, 成功返回 0, 失败返回出错的行号
+    int Load(const std::wstring &);
+
+    // 开始执行, 相对时刻从当前游戏时钟算起
+    bool Start();
+    void Stop();
+    bool Running();
+
+    // 已执行的动作数
+    size_t Executed();
+
+    // 动作实际执行的时钟比计划晚的最大帧数
+    int MaxLate();
+
+    // 功能名称是否有效
+    static bool HackExists(const std::string &);
+
+    // 数值名称是否有效
+    static bool WriteExists(const std::string &);
+
+  protected:
+    static DWORD WINAPI thread_proc(LPVOID);
+    void run();
+
+    // 执行同一帧到期的动作
+    void execute(size_t, size_t);
+
+    // 根据开始时的游戏时钟计算每个动作的绝对时刻
+    void resolve(int);
+
+    PvZ *pvz;
+    std::vector<TimelineAction> actions;
+    std::vector<int> schedule; // 每个动作的绝对时刻, 和 actions 一一对应
+    std::vector<size_t> order; // 按时刻排序后的下标
+
+    HANDLE thread;
+    HANDLE stop_event;
+    std::atomic<bool> running;
+    std::atomic<size_t> executed;
+    std::atomic<int> max_late;
+};
+
+} // namespace Pt
@@ -19,6 +19,12 @@
 
 #include "pak.h"
 #include "pvz.h"
+#include "session.h"
+#include "spawncode.h"
+#include "spawnlib.h"
+#include "telemetry.h"
+#include "timeline.h"
+#include "watcher.h"
 #include "window.h"
 
 namespace Pt
@@ -52,6 +58,52 @@ class Toolkit : public Window
     static void cb_on_hide_spawn_details(Fl_Widget *, void *);
     inline void cb_on_hide_spawn_details();
 
+    // 出怪分布分析在后台线程上进行, 完成后通过 Fl::awake 回到界面线程显示
+    HANDLE analyze_thread = nullptr;
+    WaveRules analyze_rules;
+    SpawnStats analyze_stats;
+
+    static DWORD WINAPI cb_analyze_spawn_thread(void *);
+    inline void cb_analyze_spawn_thread();
+
+    static void cb_analyze_spawn_done(void *);
+    inline void cb_analyze_spawn_done();
+
+    // 按约束搜索出怪列表, 和分析共用后台线程
+    // 自然出怪按当前关卡的规则搜索, 极限和模拟出怪按勾选的种类搜索
+    SpawnSearch *spawn_search = nullptr;
+    bool search_done = false;
+    int search_violation = 0;
+
+    static DWORD WINAPI cb_search_spawn_thread(void *);
+    inline void cb_search_spawn_thread();
+
+    static void cb_search_spawn_done(void *);
+    inline void cb_search_spawn_done();
+
+  public:
+    LineupWindow *window_lineup;
+
+    static void cb_show_lineup_search(Fl_Widget *, void *);
+    inline void cb_show_lineup_search();
+
+    static void cb_search_lineup(Fl_Widget *, void *);
+    inline void cb_search_lineup();
+
+    static void cb_pick_lineup(Fl_Widget *, void *);
+    inline void cb_pick_lineup();
+
+  public:
+    // 加载 .spl 时列出其中的条目, 窗口关闭时关闭文件
+    SpawnLibraryWindow *window_library;
+    SpawnLibrary spawn_library;
+
+    static void cb_pick_spawn_library(Fl_Widget *, void *);
+    inline void cb_pick_spawn_library();
+
+    static void cb_on_hide_spawn_library(Fl_Widget *, void *);
+    inline void cb_on_hide_spawn_library();
+
   public:
     PvZ *pvz;
     PAK *pak;
@@ -71,6 +123,12 @@ class Toolkit : public Window
     static void cb_set_money(Fl_Widget *, void *);
     inline void cb_set_money();
 
+    static void cb_freeze_sun(Fl_Widget *, void *);
+    inline void cb_freeze_sun();
+
+    static void cb_freeze_money(Fl_Widget *, void *);
+    inline void cb_freeze_money();
+
     static void cb_auto_collected(Fl_Widget *, void *);
     inline void cb_auto_collected();
 
@@ -95,6 +153,9 @@ class Toolkit : public Window
     static void cb_free_planting(Fl_Widget *, void *);
     inline void cb_free_planting();
 
+    static void cb_freeze_cooldown(Fl_Widget *, void *);
+    inline void cb_freeze_cooldown();
+
     static void cb_placed_anywhere(Fl_Widget *, void *);
     inline void cb_placed_anywhere();
 
@@ -110,6 +171,9 @@ class Toolkit : public Window
     static void cb_endless_rounds(Fl_Widget *, void *);
     inline void cb_endless_rounds();
 
+    static void cb_freeze_level(Fl_Widget *, void *);
+    inline void cb_freeze_level();
+
     static void cb_unlock(Fl_Widget *, void *);
     inline void cb_unlock();
 
@@ -213,6 +277,9 @@ class Toolkit : public Window
     static void cb_set_spawn(Fl_Widget *, void *);
     inline void cb_set_spawn();
 
+    static void cb_spawn_seed(Fl_Widget *, void *);
+    inline void cb_spawn_seed();
+
     static void cb_music(Fl_Widget *, void *);
     inline void cb_music();
 
@@ -249,6 +316,48 @@ class Toolkit : public Window
 
     static void cb_limbo_page(Fl_Widget *, void *);
     inline void cb_limbo_page();
+
+    // 杂项页右键菜单
+    static void cb_others_extra(Fl_Widget *, void *);
+    inline void cb_others_extra();
+
+    // 显示并保存注入卡顿统计
+    void show_stall_report();
+
+    // 场地监视, 界面自己是一个订阅者, 定时取出事件追加到 watch.log
+    // 其他订阅者在 Start 之前调用 watcher->Subscribe
+    BoardWatcher *watcher;
+    int watch_subscriber;
+    std::ofstream watch_log;
+
+    void board_watcher(bool);
+
+    static void cb_watch_poll(void *);
+    inline void cb_watch_poll();
+
+    // 场地录像, 保存到 telemetry 文件夹, 用 /T 命令行查询
+    TelemetryRecorder *recorder;
+    std::filesystem::path record_file;
+
+    void telemetry_record(bool);
+
+    // 时间轴, 选择文件后从当前游戏时钟开始执行
+    Timeline *timeline;
+
+    void timeline_run(bool);
+
+    // 多开同步, 布置阵型和导入出怪列表同时修改选中的游戏
+    // 没有选中时只修改当前游戏, 按进程标识保存选择, 会话增减后仍然有效
+    SessionManager *sessions;
+    std::vector<DWORD> selected_pids;
+
+    void select_sessions();
+    void for_each_game(const std::function<void(PvZ &)> &);
+
+    // 极限和模拟出怪的种子, 固定时每次应用同一个种子生成的下一个候选列表
+    uint32_t spawn_seed = 0;
+    bool spawn_seed_fixed = false;
+    size_t spawn_seed_index = 0;
 };
 
 } // namespace Pt
@@ -21,4 +21,7 @@ bool VerifySignature(LPCWSTR, const char *);
 
 bool VerifyFileHash(LPCWSTR, const char *);
 
+// 命令行查询的输出接到父进程的控制台
+void AttachParentConsole();
+
 } // namespace Pt
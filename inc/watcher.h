@@ -0,0 +1,107 @@
+
+#pragma once
+
+#include <Windows.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "pvz.h"
+#include "queue.h"
+#include "snapshot.h"
+
+namespace Pt
+{
+
+// 事件类型
+#define WATCH_ADD 1
+#define WATCH_REMOVE 2
+#define WATCH_CHANGE 3
+
+// 变化的字段
+#define WATCH_FIELD_NONE 0
+#define WATCH_FIELD_HP 1
+#define WATCH_FIELD_ROW 2
+#define WATCH_FIELD_COL 3
+#define WATCH_FIELD_ASLEEP 4
+#define WATCH_FIELD_STATUS 5
+
+// 场地对象变化事件
+struct WatchEvent
+{
+    uint8_t action;  // WATCH_ADD/REMOVE/CHANGE
+    uint8_t entity;  // SNAPSHOT_PLANT/ZOMBIE/GRID_ITEM
+    uint16_t field;  // WATCH_FIELD_*
+    uint32_t id;     // 对象 ID
+    int32_t clock;   // 游戏时钟
+    int32_t type;    // 对象类型
+    int32_t value;   // 变化后的值, 增加事件为所在行
+    int32_t old;     // 变化前的值, 增加事件为所在列
+};
+
+// 场地监视器
+// 后台线程每隔若干帧读取一次快照, 按槽位 ID 比较前后两次的差异,
+// 生成的事件推入每个订阅者各自的无锁队列
+class BoardWatcher
+{
+  public:
+    BoardWatcher(PvZ *);
+    ~BoardWatcher();
+
+    BoardWatcher(const BoardWatcher &) = delete;
+    BoardWatcher &operator=(const BoardWatcher &) = delete;
+
+    // 轮询间隔, 单位为帧, 场地平静时间隔逐渐放宽到最大值
+    void SetInterval(int, int);
+
+    // CPU 占用上限, 监视线程工作时间占比, 0~1
+    void SetBudget(double);
+
+    // 监视的对象池, SNAPSHOT_PLANT/ZOMBIE/GRID_ITEM 组合
+    void SetPools(unsigned int);
+
+    // 订阅, 返回订阅编号, 只能在 Start 之前调用
+    int Subscribe(size_t);
+
+    // 取出一个事件, 队列空时返回假
+    bool Poll(int, WatchEvent &);
+
+    // 队列满而丢弃的事件数
+    size_t Dropped(int);
+
+    bool Start();
+    void Stop();
+    bool Running();
+
+  protected:
+    static DWORD WINAPI thread_proc(LPVOID);
+    void run();
+
+    // 比较快照, 返回事件数
+    size_t diff(const BoardSnapshot &, const BoardSnapshot &, int);
+
+    void publish(const WatchEvent &);
+
+    struct Subscriber
+    {
+        Subscriber(size_t capacity) : queue(capacity), dropped(0) {}
+        SpscQueue<WatchEvent> queue;
+        std::atomic<size_t> dropped;
+    };
+
+    PvZ *pvz;
+    std::vector<std::unique_ptr<Subscriber>> subscribers;
+
+    int interval_min;
+    int interval_max;
+    double budget;
+    unsigned int pools;
+
+    HANDLE thread;
+    HANDLE stop_event;
+    std::atomic<bool> running;
+};
+
+} // namespace Pt
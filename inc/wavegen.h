@@ -0,0 +1,158 @@
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace Pt
+{
+
+// 僵尸种类
+#define ZOMBIE_NORMAL 0
+#define ZOMBIE_FLAG 1
+#define ZOMBIE_CONE 2
+#define ZOMBIE_YETI 19
+#define ZOMBIE_BUNGEE 20
+#define ZOMBIE_GIGA 32
+
+// 旗帜波的预设部分
+#define FLAG_NORMAL_MAX 8
+#define FLAG_BUNGEE_COUNT 4
+
+// 出怪列表每波个数和波数
+#define WAVE_SIZE 50
+#define WAVE_COUNT 20
+
+// 僵尸定义, 和游戏内置的表一致
+struct ZombieDefinition
+{
+    int value;      // 占用的出怪点数
+    int first_wave; // 最早出现的波数(从 0 开始, 无尽模式按累计波数算)
+    int weight;     // 抽取权重
+};
+
+// 出怪规则
+struct WaveRules
+{
+    std::array<bool, 33> zombies; // 出怪种类, 同 spawn_type
+    int stage = 0;                // 无尽轮数
+    int waves = 20;               // 每轮波数
+    int flag_interval = 10;       // 每隔多少波一个旗帜波
+    bool limit_giga = true;       // 红眼只在每轮的第 1-10 和 20 波出现
+    int max_yeti = 1;             // 每轮雪人最多个数
+};
+
+// 出怪列表生成器
+// 在本地按游戏选取出怪的规则生成出怪列表, 不需要注入, 可以大量生成用于预览
+// 随机数用种子确定, 相同的规则和种子总是生成相同的列表,
+// 但和游戏自己的随机数序列不同, 不能复现游戏实际生成的列表
+class WaveGenerator
+{
+  public:
+    explicit WaveGenerator(const WaveRules &);
+
+    // 生成出怪列表, 格式同 GetSpawnList, 每波 50 个, 不足的填 -1
+    std::array<int, 1000> Generate(uint32_t) const;
+
+    // 同上, 接着使用已有的随机数引擎, 连续生成时省去每次初始化引擎
+    void Generate(std::mt19937 &, std::array<int, 1000> &) const;
+
+    // 同上, 每生成完一波回调一次, 参数为波数(从 0 开始), 回调返回假时中止并返回假
+    bool Generate(std::mt19937 &, std::array<int, 1000> &, const std::function<bool(int)> &) const;
+
+    // 检查出怪列表是否可能由当前规则生成, 返回第一个不符合的波数, 全部符合返回 -1
+    int Check(const std::array<int, 1000> &) const;
+
+    // 某一波的出怪点数
+    int WavePoints(int) const;
+
+    bool IsFlagWave(int) const;
+
+    static const ZombieDefinition DEFINITIONS[33];
+
+  protected:
+    // 某一波可以抽到的僵尸种类和权重
+    struct Candidate
+    {
+        int type;
+        int value;
+        int weight;
+    };
+
+    // 某一波的预设部分(旗帜波的旗帜/普僵/蹦极), 返回剩余点数
+    int prefix(int, std::vector<int> &) const;
+
+    // 当前点数下的候选项的权重总和
+    int total_weight(int, int) const;
+
+    // 单只僵尸最多占用的点数
+    static const int VALUE_MAX = 10;
+
+    WaveRules rules;
+    std::vector<std::vector<Candidate>> candidates; // 每波一组, 按点数从小到大
+    std::vector<std::array<int, VALUE_MAX + 1>> affordable; // 每波剩余点数下点数够用的候选项个数
+    std::vector<std::vector<int>> cumulative;               // 每波候选项的累计权重
+};
+
+// Walker 别名表, 预处理后按权重抽取只需要两个随机数
+class AliasTable
+{
+  public:
+    AliasTable();
+
+    // 权重全为 0 时各项等概率
+    explicit AliasTable(const std::vector<double> &);
+
+    size_t size() const;
+
+    // 抽取, 返回权重的下标, 表为空时不可调用
+    size_t Sample(std::mt19937 &) const;
+
+  protected:
+    std::vector<double> prob;
+    std::vector<uint32_t> alias;
+};
+
+// 自定义出怪列表生成器, 规则同 CustomizeSpawn
+// 模拟模式下每类波次只在允许的种类上建一张别名表, 不再拒绝采样
+// 没有可抽取的种类时对应位置留空(-1)
+class CustomSpawner
+{
+  public:
+    // 出怪种类, 限制红眼, 模拟自然出怪, 红眼权重
+    CustomSpawner(const std::array<bool, 33> &, bool, bool, int);
+
+    std::array<int, 1000> Generate(uint32_t) const;
+    void Generate(std::mt19937 &, std::array<int, 1000> &) const;
+
+    // 每生成完一波回调一次, 同 WaveGenerator
+    bool Generate(std::mt19937 &, std::array<int, 1000> &, const std::function<bool(int)> &) const;
+
+    // 用同一个种子连续生成多个候选列表, 第一个和 Generate(种子) 相同
+    std::vector<std::array<int, 1000>> Batch(size_t, uint32_t) const;
+
+  protected:
+    // 波次类型
+    enum
+    {
+        KIND_FLAG = 0,    // 旗帜波
+        KIND_NORMAL = 1,  // 普通波
+        KIND_LIMITED = 2, // 不出红眼的普通波
+    };
+
+    int wave_kind(int) const;
+
+    std::array<bool, 33> zombies;
+    bool limit_giga;
+    bool simulate;
+    bool empty; // 没有选择任何种类
+
+    std::vector<int> types[3]; // 每类波次可以出现的种类
+    AliasTable tables[3];
+};
+
+} // namespace Pt
@@ -18,6 +18,7 @@
 #include <regex>
 #include <string>
 #include <tuple>
+#include <unordered_set>
 #include <vector>
 
 #include <FL/Fl_Button.H>
@@ -28,6 +29,7 @@
 #include <FL/Fl_Menu_Button.H>
 #include <FL/Fl_Round_Button.H>
 #include <FL/Fl_Table.H>
+#include <FL/Fl_Table_Row.H>
 #include <FL/Fl_Tabs.H>
 #include <FL/Fl_Text_Editor.H>
 #include <FL/Fl_Value_Input.H>
@@ -37,7 +39,12 @@
 #include <Fl/Fl_Box.H>
 
 #include "lineup.h"
+#include "lineupindex.h"
+#include "lineupsearch.h"
 #include "pvz.h"
+#include "spawnlib.h"
+#include "spawnstat.h"
+#include "threat.h"
 #include "utils.h"
 #include "version.h"
 
@@ -75,14 +82,43 @@ class SpawnTable : public Fl_Table
   public:
     SpawnTable(int, int, int, int, const char *);
     ~SpawnTable();
-    void UpdateData(std::array<int, 1000>);
+
+    // 列表和上次相同时什么都不做, 只有数量变化的格子重画
+    // 返回显示的种类是否变化, 变化时需要调整窗口大小
+    bool UpdateData(const std::array<int, 1000> &);
+
+    // 显示分析结果, 默认显示平均数量
+    void UpdateStats(const SpawnStats &);
+
+    // 分析结果显示的统计量, 依次为平均数, 10%/50%/90% 分位数, 出现概率
+    void SetStatMode(int);
 
   public:
     static const int ROWS = 33;     // 33 种僵尸
     static const int COLS = 20 + 1; // 20 波 + 总数
+    static const int THREAT_ROW = ROWS; // 最后一行为每波的威胁得分
     int data[ROWS][COLS] = {{0}};
     int total = 0;
+    bool analyzed = false; // 显示的是分析结果
+    int stat_mode = 0;
+    SpawnStats stats;
     void draw_cell(TableContext, int, int, int, int, int, int);
+
+  protected:
+    // 数据变化后重新计算纵向偏移和要画的文字
+    void update_layout();
+
+    std::array<int, 1000> last_list = {0}; // 上次显示的列表
+    bool list_valid = false;               // last_list 对应当前显示的列表
+    int offset[ROWS + 1] = {0};            // 因为不画缺少的种类造成的纵向偏移
+    std::string row_labels[ROWS];          // 行表头
+    std::string col_labels[COLS];          // 列表头
+    char cells[ROWS][COLS][12] = {{{0}}};  // 格子里的文字
+
+    // 按默认指标计算的每波和整轮的威胁, 分析结果不显示
+    ThreatAnalyzer threat;
+    ThreatVector threat_waves[20] = {};
+    char threat_cells[COLS][12] = {{0}};
 };
 
 class SpawnWindow : public Fl_Double_Window
@@ -91,10 +127,15 @@ class SpawnWindow : public Fl_Double_Window
     SpawnWindow(int, int, const char *);
     ~SpawnWindow();
     void UpdateData(std::array<int, 1000>);
+    void UpdateStats(const SpawnStats &);
     void resize(int, int, int, int);
     int ww = 0;
     int hh = 0;
 
+  protected:
+    // 按表格里出现的种类调整窗口大小
+    void fit_rows();
+
   public:
     SpawnTable *table_spawn;
     Fl_Button *button_update_details;
@@ -109,6 +150,73 @@ class SpawnWindow : public Fl_Double_Window
     bool on = false;
 };
 
+// 阵型搜索结果的表格, 只画看得见的行
+class LineupBrowser : public Fl_Table_Row
+{
+  public:
+    LineupBrowser(int, int, int, int, const char *);
+    ~LineupBrowser();
+
+    // 显示阵型列表里的这些阵型, 没有选中的行
+    void SetRows(const LineupLibrary *, const std::vector<uint32_t> &);
+
+    // 选中的行对应的阵型序号, 没有选中时为第一行, 没有结果时为 -1
+    int Selected();
+
+    void draw_cell(TableContext, int, int, int, int, int, int);
+    void resize(int, int, int, int);
+
+  protected:
+    const LineupLibrary *library = nullptr;
+    std::vector<uint32_t> indices; // 每一行的阵型序号
+};
+
+class LineupWindow : public Fl_Double_Window
+{
+  public:
+    LineupWindow(int, int, const char *);
+    ~LineupWindow();
+
+    // 显示结果数量
+    void UpdateCount(size_t, size_t);
+
+  public:
+    Fl_Input *input_search;
+    LineupBrowser *table_lineup;
+    Fl_Box *box_count;
+};
+
+// 出怪列表库的表格, 新保存的在前, 只画看得见的行
+class SpawnLibraryBrowser : public Fl_Table_Row
+{
+  public:
+    SpawnLibraryBrowser(int, int, int, int, const char *);
+    ~SpawnLibraryBrowser();
+
+    // 显示出怪列表库的全部条目, 没有选中的行
+    void SetLibrary(const SpawnLibrary *);
+
+    // 选中的行对应的条目序号, 没有选中时为第一行, 没有条目时为 -1
+    int Selected();
+
+    void draw_cell(TableContext, int, int, int, int, int, int);
+    void resize(int, int, int, int);
+
+  protected:
+    const SpawnLibrary *library = nullptr;
+    uint32_t count = 0;
+};
+
+class SpawnLibraryWindow : public Fl_Double_Window
+{
+  public:
+    SpawnLibraryWindow(int, int, const char *);
+    ~SpawnLibraryWindow();
+
+  public:
+    SpawnLibraryBrowser *table_library;
+};
+
 class Window : public Fl_Double_Window
 {
   public:
@@ -131,9 +239,11 @@ class Window : public Fl_Double_Window
 #endif
     Fl_Value_Input *input_sun;
     Fl_Button *button_sun;
+    Fl_Check_Button *check_freeze_sun;
     Fl_Box *box_money;
     Fl_Value_Input *input_money;
     Fl_Button *button_money;
+    Fl_Check_Button *check_freeze_money;
     Fl_Check_Button *check_auto_collected;
     Fl_Check_Button *check_not_drop_loot;
     Fl_Check_Button *check_fertilizer;
@@ -144,12 +254,14 @@ class Window : public Fl_Double_Window
     Fl_Value_Input *input_wisdom_tree;
     Fl_Button *button_wisdom_tree;
     Fl_Check_Button *check_free_planting;
+    Fl_Check_Button *check_freeze_cooldown;
     Fl_Check_Button *check_placed_anywhere;
     Fl_Check_Button *check_fast_belt;
     Fl_Check_Button *check_lock_shovel;
     Fl_Choice_ *choice_mode;
     Fl_Choice_ *choice_adventure;
     Fl_Button *button_mix;
+    Fl_Check_Button *check_freeze_level;
     Fl_Value_Input *input_level;
     Fl_Button *button_level;
     Fl_Button *button_unlock;
@@ -201,10 +313,13 @@ class Window : public Fl_Double_Window
     Fl_Menu_Button *button_put_flower_pot;
     Fl_Button *button_reset;
     Fl_Choice_ *choice_scene;
-    std::vector<Lineup> lineups;
+    LineupLibrary lineups;
     unsigned int lineup_count[6] = {0};
     Fl_Button *button_load_lineup;
     Fl_Choice_ *choice_lineup_name[6];
+    Fl_Button *button_search_lineup;
+    LineupNameIndex lineup_names;
+    LineupIndex lineup_index; // 按植物个数筛选
     Fl_Text_Buffer *buffer_lineup_string;
     Fl_Text_Editor *editor_lineup_string;
     Fl_Button *button_get_lineup;
@@ -229,6 +344,7 @@ class Window : public Fl_Double_Window
     Fl_Menu_Button *button_spawn_mode;
 
     Fl_Group *group_others;
+    Fl_Menu_Button *button_others_extra;
     Fl_Choice_ *choice_music;
     Fl_Button *button_music;
     Fl_Button *button_userdata;
@@ -301,7 +417,7 @@ class Window : public Fl_Double_Window
     inline void cb_load_lineup();
 
     inline void import_lineup_list(bool);
-    inline void import_lineup_list_file(std::wstring);
+    inline bool import_lineup_list_file(std::wstring, uint32_t * = nullptr);
 
     static void cb_switch_lineup_scene(Fl_Widget *, void *);
     inline void cb_switch_lineup_scene();
@@ -6,39 +6,42 @@ namespace Pt
 
 Code::Code()
 {
-    unsigned int page = 256; // 1MB
-    code = new unsigned char[4096 * page];
-    length = 0;
+    code.reserve(4096);
     calls_pos.clear();
 }
 
 Code::~Code()
 {
-    delete[] code;
 }
 
 void Code::asm_init()
 {
-    length = 0;
+    code.clear();
     calls_pos.clear();
 }
 
+unsigned int Code::asm_length()
+{
+    return static_cast<unsigned int>(code.size());
+}
+
 void Code::asm_add_byte(unsigned char value)
 {
-    code[length] = value;
-    length += 1;
+    code.push_back(value);
 }
 
 void Code::asm_add_word(unsigned short value)
 {
-    (unsigned short &)code[length] = value;
-    length += 2;
+    size_t pos = code.size();
+    code.resize(pos + sizeof(value));
+    memcpy(&code[pos], &value, sizeof(value));
 }
 
 void Code::asm_add_dword(unsigned int value)
 {
-    (unsigned int &)code[length] = value;
-    length += 4;
+    size_t pos = code.size();
+    code.resize(pos + sizeof(value));
+    memcpy(&code[pos], &value, sizeof(value));
 }
 
 void Code::asm_add_list(std::initializer_list<unsigned char> value)
@@ -100,7 +103,7 @@ void Code::asm_mov_exx_exx(Reg reg_to, Reg reg_from)
 void Code::asm_call(unsigned int addr)
 {
     asm_add_byte(0xe8);
-    calls_pos.push_back(length);
+    calls_pos.push_back(static_cast<unsigned int>(code.size()));
     asm_add_dword(addr);
 }
 
@@ -111,7 +114,7 @@ void Code::asm_ret()
 
 void Code::asm_code_inject(HANDLE handle)
 {
-    LPVOID addr = VirtualAllocEx(handle, nullptr, this->length, //
+    LPVOID addr = VirtualAllocEx(handle, nullptr, this->code.size(), //
                                  MEM_COMMIT, PAGE_EXECUTE_READWRITE);
     if (addr == nullptr)
         return;
@@ -119,13 +122,15 @@ void Code::asm_code_inject(HANDLE handle)
     for (size_t i = 0; i < this->calls_pos.size(); i++)
     {
         unsigned int pos = this->calls_pos[i];
-        int &call_addr = (int &)(this->code[pos]);
+        int call_addr;
+        memcpy(&call_addr, &this->code[pos], sizeof(call_addr));
         call_addr = call_addr - ((int)addr + pos + 4);
+        memcpy(&this->code[pos], &call_addr, sizeof(call_addr));
     }
 
     DWORD write_size = 0;
-    BOOL ret = WriteProcessMemory(handle, addr, this->code, this->length, &write_size);
-    if (ret == 0 || write_size != this->length)
+    BOOL ret = WriteProcessMemory(handle, addr, this->code.data(), this->code.size(), &write_size);
+    if (ret == 0 || write_size != this->code.size())
     {
         VirtualFreeEx(handle, addr, 0, MEM_RELEASE);
         return;
@@ -145,10 +150,10 @@ void Code::asm_code_inject(HANDLE handle)
 
 #ifdef _DEBUG
     std::wcout << L"等待状态: " << wait_status << std::endl;
-    assert(this->length > 0);
-    assert(this->length < 4096 * 16);
+    assert(this->code.size() > 0);
+    assert(this->code.size() < 4096 * 16);
     std::wcout << L"注入汇编码: ";
-    for (size_t i = 0; i < this->length; i++)
+    for (size_t i = 0; i < this->code.size(); i++)
         std::cout << std::hex << int(this->code[i]) << " ";
     std::cout << std::endl;
 #endif
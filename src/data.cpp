@@ -22,7 +22,13 @@ Data::Data()
             0x90,     // zombie
             0x28,     //   zombie_status
             0xf0 + 0, //   zombie_dead
+            0x1c,     //   zombie_row
+            0x24,     //   zombie_type
+            0x2c,     //   zombie_x
+            0x30,     //   zombie_y
+            0xcc,     //   zombie_hp
             0x94,     // zombie_count_max
+            0x160,    // zombie_struct_size
 
             0xac,      // plant
             0x1c,      //   plant_row
@@ -32,13 +38,16 @@ Data::Data()
             0x44 + 0,  //   plant_dead
             0x45 + 0,  //   plant_squished
             0x13c + 0, //   plant_asleep
+            0x48,      //   plant_hp
             0xb0,      // plant_count_max
             0xb8,      // plant_next_pos
+            0x14c,     // plant_struct_size
 
             0x100, // lawn_mower
             0x30,  //   lawn_mower_dead
             0x104, // lawn_mower_count_max
             0x110, // lawn_mower_count
+            0x48,  // lawn_mower_struct_size
 
             0x11c, // grid_item
             0x08,  //   grid_item_type
@@ -46,6 +55,7 @@ Data::Data()
             0x14,  //   grid_item_row
             0x20,  //   grid_item_dead
             0x120, // grid_item_count_max
+            0x8c,  // grid_item_struct_size
 
             0x138, // cursor
             0x30,  //   cursor_grab
@@ -56,6 +66,7 @@ Data::Data()
             0x50,  //   slot_seed_cd_total
             0x5c,  //   slot_seed_type
             0x60,  //   slot_seed_type_im
+            0x50,  //   slot_seed_struct_size
 
             0x15c, // cut_scene
 
@@ -72,6 +83,7 @@ Data::Data()
             0x5550, // adventure_level
             0x5560, // sun
             0x5568, // game_clock
+            0x557c, // current_wave
             0x55f8, // debug_mode
             0x5620, // particle_systems_addr
 
@@ -90,6 +102,7 @@ Data::Data()
             0x00,  //       particle_system_type
             0x1c,  //       particle_system_dead
             0x04,  //     particle_system_count_max
+            0x2c,  //     particle_system_struct_size
 
             0x82c,     // user_data
             0x24,      //   level
@@ -223,7 +236,13 @@ Data::Data()
             0x90,     // zombie
             0x28,     //   zombie_status
             0xf0 + 0, //   zombie_dead
+            0x1c,     //   zombie_row
+            0x24,     //   zombie_type
+            0x2c,     //   zombie_x
+            0x30,     //   zombie_y
+            0xcc,     //   zombie_hp
             0x94,     // zombie_count_max
+            0x15c,    // zombie_struct_size
 
             0xac,      // plant
             0x1c,      //   plant_row
@@ -233,13 +252,16 @@ Data::Data()
             0x44 + 0,  //   plant_dead
             0x45 + 0,  //   plant_squished
             0x13c + 0, //   plant_asleep
+            0x48,      //   plant_hp
             0xb0,      // plant_count_max
             0xb8,      // plant_next_pos
+            0x14c,     // plant_struct_size
 
             0x100, // lawn_mower
             0x30,  //   lawn_mower_dead
             0x104, // lawn_mower_count_max
             0x110, // lawn_mower_count
+            0x48,  // lawn_mower_struct_size
 
             0x11c, // grid_item
             0x08,  //   grid_item_type
@@ -247,6 +269,7 @@ Data::Data()
             0x14,  //   grid_item_row
             0x20,  //   grid_item_dead
             0x120, // grid_item_count_max
+            0xec,  // grid_item_struct_size
 
             0x138, // cursor
             0x30,  //   cursor_grab
@@ -257,6 +280,7 @@ Data::Data()
             0x50,  //   slot_seed_cd_total
             0x5c,  //   slot_seed_type
             0x60,  //   slot_seed_type_im
+            0x50,  //   slot_seed_struct_size
 
             0x15c, // cut_scene
 
@@ -273,6 +297,7 @@ Data::Data()
             0x5550, // adventure_level
             0x5560, // sun
             0x5568, // game_clock
+            0x557c, // current_wave
             0x55f8, // debug_mode
             0x5620, // particle_systems_addr
 
@@ -291,6 +316,7 @@ Data::Data()
             0x00,  //       particle_system_type
             0x1c,  //       particle_system_dead
             0x04,  //     particle_system_count_max
+            0x2c,  //     particle_system_struct_size
 
             0x82c, // user_data
             0x24,  //   level
@@ -426,7 +452,13 @@ Data::Data()
             0x90, // zombie
             0x28, //   zombie_status
             0xec, //   zombie_dead
+            0x1c, //   zombie_row
+            0x24, //   zombie_type
+            0x2c, //   zombie_x
+            0x30, //   zombie_y
+            0xc8, //   zombie_hp
             0x94, // zombie_count_max
+            0x15c, // zombie_struct_size
 
             0xac,  // plant
             0x1c,  //   plant_row
@@ -436,13 +468,16 @@ Data::Data()
             0x141, //   plant_dead
             0x142, //   plant_squished
             0x143, //   plant_asleep
+            0x40,  //   plant_hp
             0xb0,  // plant_count_max
             0xb8,  // plant_next_pos
+            0x14c, // plant_struct_size
 
             0x100, // lawn_mower
             0x30,  //   lawn_mower_dead
             0x104, // lawn_mower_count_max
             0x110, // lawn_mower_count
+            0x48,  // lawn_mower_struct_size
 
             0x11c, // grid_item
             0x08,  //   grid_item_type
@@ -450,6 +485,7 @@ Data::Data()
             0x14,  //   grid_item_row
             0x20,  //   grid_item_dead
             0x120, // grid_item_count_max
+            0xec,  // grid_item_struct_size
 
             0x138, // cursor
             0x30,  //   cursor_grab
@@ -460,6 +496,7 @@ Data::Data()
             0x50,  //   slot_seed_cd_total
             0x5c,  //   slot_seed_type
             0x60,  //   slot_seed_type_im
+            0x50,  //   slot_seed_struct_size
 
             0x15c, // cut_scene
 
@@ -476,6 +513,7 @@ Data::Data()
             0x5550, // adventure_level
             0x5560, // sun
             0x5568, // game_clock
+            0x557c, // current_wave
             0x55f8, // debug_mode
             0x5620, // particle_systems_addr
 
@@ -494,6 +532,7 @@ Data::Data()
             0x00,  //       particle_system_type
             0x1c,  //       particle_system_dead
             0x04,  //     particle_system_count_max
+            0x2c,  //     particle_system_struct_size
 
             0x82c, // user_data
             0x24,  //   level
@@ -627,7 +666,13 @@ Data::Data()
             0x90, // zombie
             0x28, //   zombie_status
             0xec, //   zombie_dead
+            0x1c, //   zombie_row
+            0x24, //   zombie_type
+            0x2c, //   zombie_x
+            0x30, //   zombie_y
+            0xc8, //   zombie_hp
             0x94, // zombie_count_max
+            0x15c, // zombie_struct_size
 
             0xac,  // plant
             0x1c,  //   plant_row
@@ -637,13 +682,16 @@ Data::Data()
             0x141, //   plant_dead
             0x142, //   plant_squished
             0x143, //   plant_asleep
+            0x40,  //   plant_hp
             0xb0,  // plant_count_max
             0xb8,  // plant_next_pos
+            0x14c, // plant_struct_size
 
             0x100, // lawn_mower
             0x30,  //   lawn_mower_dead
             0x104, // lawn_mower_count_max
             0x110, // lawn_mower_count
+            0x48,  // lawn_mower_struct_size
 
             0x11c, // grid_item
             0x08,  //   grid_item_type
@@ -651,6 +699,7 @@ Data::Data()
             0x14,  //   grid_item_row
             0x20,  //   grid_item_dead
             0x120, // grid_item_count_max
+            0xec,  // grid_item_struct_size
 
             0x138, // cursor
             0x30,  //   cursor_grab
@@ -661,6 +710,7 @@ Data::Data()
             0x50,  //   slot_seed_cd_total
             0x5c,  //   slot_seed_type
             0x60,  //   slot_seed_type_im
+            0x50,  //   slot_seed_struct_size
 
             0x15c, // cut_scene
 
@@ -677,6 +727,7 @@ Data::Data()
             0x5550, // adventure_level
             0x5560, // sun
             0x5568, // game_clock
+            0x557c, // current_wave
             0x55f8, // debug_mode
             0x5620, // particle_systems_addr
 
@@ -695,6 +746,7 @@ Data::Data()
             0x00,  //       particle_system_type
             0x1c,  //       particle_system_dead
             0x04,  //     particle_system_count_max
+            0x2c,  //     particle_system_struct_size
 
             0x82c, // user_data
             0x24,  //   level
@@ -828,7 +880,13 @@ Data::Data()
             0x90, // zombie
             0x28, //   zombie_status
             0xec, //   zombie_dead
+            0x1c, //   zombie_row
+            0x24, //   zombie_type
+            0x2c, //   zombie_x
+            0x30, //   zombie_y
+            0xc8, //   zombie_hp
             0x94, // zombie_count_max
+            0x15c, // zombie_struct_size
 
             0xac,  // plant
             0x1c,  //   plant_row
@@ -838,13 +896,16 @@ Data::Data()
             0x141, //   plant_dead
             0x142, //   plant_squished
             0x143, //   plant_asleep
+            0x40,  //   plant_hp
             0xb0,  // plant_count_max
             0xb8,  // plant_next_pos
+            0x14c, // plant_struct_size
 
             0x100, // lawn_mower
             0x30,  //   lawn_mower_dead
             0x104, // lawn_mower_count_max
             0x110, // lawn_mower_count
+            0x48,  // lawn_mower_struct_size
 
             0x11c, // grid_item
             0x08,  //   grid_item_type
@@ -852,6 +913,7 @@ Data::Data()
             0x14,  //   grid_item_row
             0x20,  //   grid_item_dead
             0x120, // grid_item_count_max
+            0xec,  // grid_item_struct_size
 
             0x138, // cursor
             0x30,  //   cursor_grab
@@ -862,6 +924,7 @@ Data::Data()
             0x50,  //   slot_seed_cd_total
             0x5c,  //   slot_seed_type
             0x60,  //   slot_seed_type_im
+            0x50,  //   slot_seed_struct_size
 
             0x15c, // cut_scene
 
@@ -878,6 +941,7 @@ Data::Data()
             0x5550, // adventure_level
             0x5560, // sun
             0x5568, // game_clock
+            0x557c, // current_wave
             0x55f8, // debug_mode
             0x5620, // particle_systems_addr
 
@@ -896,6 +960,7 @@ Data::Data()
             0x00,  //       particle_system_type
             0x1c,  //       particle_system_dead
             0x04,  //     particle_system_count_max
+            0x2c,  //     particle_system_struct_size
 
             0x82c, // user_data
             0x24,  //   level
@@ -1029,7 +1094,13 @@ Data::Data()
             0x90, // zombie
             0x28, //   zombie_status
             0xec, //   zombie_dead
+            0x1c, //   zombie_row
+            0x24, //   zombie_type
+            0x2c, //   zombie_x
+            0x30, //   zombie_y
+            0xc8, //   zombie_hp
             0x94, // zombie_count_max
+            0x15c, // zombie_struct_size
 
             0xac,  // plant
             0x1c,  //   plant_row
@@ -1039,13 +1110,16 @@ Data::Data()
             0x141, //   plant_dead
             0x142, //   plant_squished
             0x143, //   plant_asleep
+            0x40,  //   plant_hp
             0xb0,  // plant_count_max
             0xb8,  // plant_next_pos
+            0x14c, // plant_struct_size
 
             0x100, // lawn_mower
             0x30,  //   lawn_mower_dead
             0x104, // lawn_mower_count_max
             0x110, // lawn_mower_count
+            0x48,  // lawn_mower_struct_size
 
             0x11c, // grid_item
             0x08,  //   grid_item_type
@@ -1053,6 +1127,7 @@ Data::Data()
             0x14,  //   grid_item_row
             0x20,  //   grid_item_dead
             0x120, // grid_item_count_max
+            0xec,  // grid_item_struct_size
 
             0x138, // cursor
             0x30,  //   cursor_grab
@@ -1063,6 +1138,7 @@ Data::Data()
             0x50,  //   slot_seed_cd_total
             0x5c,  //   slot_seed_type
             0x60,  //   slot_seed_type_im
+            0x50,  //   slot_seed_struct_size
 
             0x15c, // cut_scene
 
@@ -1079,6 +1155,7 @@ Data::Data()
             0x5550, // adventure_level
             0x5560, // sun
             0x5568, // game_clock
+            0x557c, // current_wave
             0x55f8, // debug_mode
             0x5620, // particle_systems_addr
 
@@ -1097,6 +1174,7 @@ Data::Data()
             0x00,  //       particle_system_type
             0x1c,  //       particle_system_dead
             0x04,  //     particle_system_count_max
+            0x2c,  //     particle_system_struct_size
 
             0x82c, // user_data
             0x24,  //   level
@@ -1230,7 +1308,13 @@ Data::Data()
             0x90, // zombie
             0x28, //   zombie_status
             0xec, //   zombie_dead
+            0x1c, //   zombie_row
+            0x24, //   zombie_type
+            0x2c, //   zombie_x
+            0x30, //   zombie_y
+            0xc8, //   zombie_hp
             0x94, // zombie_count_max
+            0x15c, // zombie_struct_size
 
             0xac,  // plant
             0x1c,  //   plant_row
@@ -1240,13 +1324,16 @@ Data::Data()
             0x141, //   plant_dead
             0x142, //   plant_squished
             0x143, //   plant_asleep
+            0x40,  //   plant_hp
             0xb0,  // plant_count_max
             0xb8,  // plant_next_pos
+            0x14c, // plant_struct_size
 
             0x100, // lawn_mower
             0x30,  //   lawn_mower_dead
             0x104, // lawn_mower_count_max
             0x110, // lawn_mower_count
+            0x48,  // lawn_mower_struct_size
 
             0x11c, // grid_item
             0x08,  //   grid_item_type
@@ -1254,6 +1341,7 @@ Data::Data()
             0x14,  //   grid_item_row
             0x20,  //   grid_item_dead
             0x120, // grid_item_count_max
+            0xec,  // grid_item_struct_size
 
             0x138, // cursor
             0x30,  //   cursor_grab
@@ -1264,6 +1352,7 @@ Data::Data()
             0x50,  //   slot_seed_cd_total
             0x5c,  //   slot_seed_type
             0x60,  //   slot_seed_type_im
+            0x50,  //   slot_seed_struct_size
 
             0x15c, // cut_scene
 
@@ -1280,6 +1369,7 @@ Data::Data()
             0x5550, // adventure_level
             0x5560, // sun
             0x5568, // game_clock
+            0x557c, // current_wave
             0x55f8, // debug_mode
             0x5620, // particle_systems_addr
 
@@ -1298,6 +1388,7 @@ Data::Data()
             0x00,  //       particle_system_type
             0x1c,  //       particle_system_dead
             0x04,  //     particle_system_count_max
+            0x2c,  //     particle_system_struct_size
 
             0x82c, // user_data
             0x24,  //   level
@@ -1431,7 +1522,13 @@ Data::Data()
             0x90 + 0x18, // zombie
             0x28,        //   zombie_status
             0xec,        //   zombie_dead
+            0x1c,        //   zombie_row
+            0x24,        //   zombie_type
+            0x2c,        //   zombie_x
+            0x30,        //   zombie_y
+            0xc8,        //   zombie_hp
             0x94 + 0x18, // zombie_count_max
+            0x168,       // zombie_struct_size
 
             0xac + 0x18, // plant
             0x1c,        //   plant_row
@@ -1441,13 +1538,16 @@ Data::Data()
             0x141,       //   plant_dead
             0x142,       //   plant_squished
             0x143,       //   plant_asleep
+            0x40,        //   plant_hp
             0xb0 + 0x18, // plant_count_max
             0xb8 + 0x18, // plant_next_pos
+            0x14c,       // plant_struct_size
 
             0x100 + 0x18, // lawn_mower
             0x30,         //   lawn_mower_dead
             0x104 + 0x18, // lawn_mower_count_max
             0x110 + 0x18, // lawn_mower_count
+            0x48,         // lawn_mower_struct_size
 
             0x11c + 0x18, // grid_item
             0x08,         //   grid_item_type
@@ -1455,6 +1555,7 @@ Data::Data()
             0x14,         //   grid_item_row
             0x20,         //   grid_item_dead
             0x120 + 0x18, // grid_item_count_max
+            0xec,         // grid_item_struct_size
 
             0x138 + 0x18, // cursor
             0x30,         //   cursor_grab
@@ -1465,6 +1566,7 @@ Data::Data()
             0x50,         //   slot_seed_cd_total
             0x5c,         //   slot_seed_type
             0x60,         //   slot_seed_type_im
+            0x50,         //   slot_seed_struct_size
 
             0x15c + 0x18, // cut_scene
 
@@ -1481,6 +1583,7 @@ Data::Data()
             0x5550 + 0x18, // adventure_level
             0x5560 + 0x18, // sun
             0x5568 + 0x18, // game_clock
+            0x557c + 0x18, // current_wave
             0x55f8 + 0x18, // debug_mode
             0x5620 + 0x18, // particle_systems_addr
 
@@ -1499,6 +1602,7 @@ Data::Data()
             0x00,          //       particle_system_type
             0x1c,          //       particle_system_dead
             0x04,          //     particle_system_count_max
+            0x2c,          //     particle_system_struct_size
 
             0x82c + 0x120, // user_data
             0x24 + 0x28,   //   level
@@ -1632,7 +1736,13 @@ Data::Data()
             0x90 + 0x18, // zombie
             0x28,        //   zombie_status
             0xec,        //   zombie_dead
+            0x1c,        //   zombie_row
+            0x24,        //   zombie_type
+            0x2c,        //   zombie_x
+            0x30,        //   zombie_y
+            0xc8,        //   zombie_hp
             0x94 + 0x18, // zombie_count_max
+            0x168,       // zombie_struct_size
 
             0xac + 0x18, // plant
             0x1c,        //   plant_row
@@ -1642,13 +1752,16 @@ Data::Data()
             0x141,       //   plant_dead
             0x142,       //   plant_squished
             0x143,       //   plant_asleep
+            0x40,        //   plant_hp
             0xb0 + 0x18, // plant_count_max
             0xb8 + 0x18, // plant_next_pos
+            0x14c,       // plant_struct_size
 
             0x100 + 0x18, // lawn_mower
             0x30,         //   lawn_mower_dead
             0x104 + 0x18, // lawn_mower_count_max
             0x110 + 0x18, // lawn_mower_count
+            0x48,         // lawn_mower_struct_size
 
             0x11c + 0x18, // grid_item
             0x08,         //   grid_item_type
@@ -1656,6 +1769,7 @@ Data::Data()
             0x14,         //   grid_item_row
             0x20,         //   grid_item_dead
             0x120 + 0x18, // grid_item_count_max
+            0xec,         // grid_item_struct_size
 
             0x138 + 0x18, // cursor
             0x30,         //   cursor_grab
@@ -1666,6 +1780,7 @@ Data::Data()
             0x50,         //   slot_seed_cd_total
             0x5c,         //   slot_seed_type
             0x60,         //   slot_seed_type_im
+            0x50,         //   slot_seed_struct_size
 
             0x15c + 0x18, // cut_scene
 
@@ -1682,6 +1797,7 @@ Data::Data()
             0x5550 + 0x18, // adventure_level
             0x5560 + 0x18, // sun
             0x5568 + 0x18, // game_clock
+            0x557c + 0x18, // current_wave
             0x55f8 + 0x18, // debug_mode
             0x5620 + 0x18, // particle_systems_addr
 
@@ -1700,6 +1816,7 @@ Data::Data()
             0x00,          //       particle_system_type
             0x1c,          //       particle_system_dead
             0x04,          //     particle_system_count_max
+            0x2c,          //     particle_system_struct_size
 
             0x82c + 0x120,    // user_data
             0x24 + 0x28 + 4,  //   level
@@ -1833,7 +1950,13 @@ Data::Data()
             0x90 + 0x18, // zombie
             0x28,        //   zombie_status
             0xec,        //   zombie_dead
+            0x1c,        //   zombie_row
+            0x24,        //   zombie_type
+            0x2c,        //   zombie_x
+            0x30,        //   zombie_y
+            0xc8,        //   zombie_hp
             0x94 + 0x18, // zombie_count_max
+            0x168,       // zombie_struct_size
 
             0xac + 0x18, // plant
             0x1c,        //   plant_row
@@ -1843,13 +1966,16 @@ Data::Data()
             0x141,       //   plant_dead
             0x142,       //   plant_squished
             0x143,       //   plant_asleep
+            0x40,        //   plant_hp
             0xb0 + 0x18, // plant_count_max
             0xb8 + 0x18, // plant_next_pos
+            0x14c,       // plant_struct_size
 
             0x100 + 0x18, // lawn_mower
             0x30,         //   lawn_mower_dead
             0x104 + 0x18, // lawn_mower_count_max
             0x110 + 0x18, // lawn_mower_count
+            0x48,         // lawn_mower_struct_size
 
             0x11c + 0x18, // grid_item
             0x08,         //   grid_item_type
@@ -1857,6 +1983,7 @@ Data::Data()
             0x14,         //   grid_item_row
             0x20,         //   grid_item_dead
             0x120 + 0x18, // grid_item_count_max
+            0xec,         // grid_item_struct_size
 
             0x138 + 0x18, // cursor
             0x30,         //   cursor_grab
@@ -1867,6 +1994,7 @@ Data::Data()
             0x50,         //   slot_seed_cd_total
             0x5c,         //   slot_seed_type
             0x60,         //   slot_seed_type_im
+            0x50,         //   slot_seed_struct_size
 
             0x15c + 0x18, // cut_scene
 
@@ -1883,6 +2011,7 @@ Data::Data()
             0x5550 + 0x18, // adventure_level
             0x5560 + 0x18, // sun
             0x5568 + 0x18, // game_clock
+            0x557c + 0x18, // current_wave
             0x55f8 + 0x18, // debug_mode
             0x5620 + 0x18, // particle_systems_addr
 
@@ -1901,6 +2030,7 @@ Data::Data()
             0x00,          //       particle_system_type
             0x1c,          //       particle_system_dead
             0x04,          //     particle_system_count_max
+            0x2c,          //     particle_system_struct_size
 
             0x82c + 0x120, // user_data
             0x24 + 0x28,   //   level
@@ -2034,7 +2164,13 @@ Data::Data()
             0x90 + 0x18, // zombie
             0x28,        //   zombie_status
             0xec,        //   zombie_dead
+            0x1c,        //   zombie_row
+            0x24,        //   zombie_type
+            0x2c,        //   zombie_x
+            0x30,        //   zombie_y
+            0xc8,        //   zombie_hp
             0x94 + 0x18, // zombie_count_max
+            0x168,       // zombie_struct_size
 
             0xac + 0x18, // plant
             0x1c,        //   plant_row
@@ -2044,13 +2180,16 @@ Data::Data()
             0x141,       //   plant_dead
             0x142,       //   plant_squished
             0x143,       //   plant_asleep
+            0x40,        //   plant_hp
             0xb0 + 0x18, // plant_count_max
             0xb8 + 0x18, // plant_next_pos
+            0x14c,       // plant_struct_size
 
             0x100 + 0x18, // lawn_mower
             0x30,         //   lawn_mower_dead
             0x104 + 0x18, // lawn_mower_count_max
             0x110 + 0x18, // lawn_mower_count
+            0x48,         // lawn_mower_struct_size
 
             0x11c + 0x18, // grid_item
             0x08,         //   grid_item_type
@@ -2058,6 +2197,7 @@ Data::Data()
             0x14,         //   grid_item_row
             0x20,         //   grid_item_dead
             0x120 + 0x18, // grid_item_count_max
+            0xec,         // grid_item_struct_size
 
             0x138 + 0x18, // cursor
             0x30,         //   cursor_grab
@@ -2068,6 +2208,7 @@ Data::Data()
             0x50,         //   slot_seed_cd_total
             0x5c,         //   slot_seed_type
             0x60,         //   slot_seed_type_im
+            0x50,         //   slot_seed_struct_size
 
             0x15c + 0x18, // cut_scene
 
@@ -2084,6 +2225,7 @@ Data::Data()
             0x5550 + 0x18, // adventure_level
             0x5560 + 0x18, // sun
             0x5568 + 0x18, // game_clock
+            0x557c + 0x18, // current_wave
             0x55f8 + 0x18, // debug_mode
             0x5620 + 0x18, // particle_systems_addr
 
@@ -2102,6 +2244,7 @@ Data::Data()
             0x00,              //       particle_system_type
             0x1c,              //       particle_system_dead
             0x04,              //     particle_system_count_max
+            0x2c,              //     particle_system_struct_size
 
             0x82c + 0x120 + 4, // user_data
             0x24 + 0x28,       //   level
@@ -2235,7 +2378,13 @@ Data::Data()
             0x90 + 0x18, // zombie
             0x28,        //   zombie_status
             0xec,        //   zombie_dead
+            0x1c,        //   zombie_row
+            0x24,        //   zombie_type
+            0x2c,        //   zombie_x
+            0x30,        //   zombie_y
+            0xc8,        //   zombie_hp
             0x94 + 0x18, // zombie_count_max
+            0x168,       // zombie_struct_size
 
             0xac + 0x18, // plant
             0x1c,        //   plant_row
@@ -2245,13 +2394,16 @@ Data::Data()
             0x141,       //   plant_dead
             0x142,       //   plant_squished
             0x143,       //   plant_asleep
+            0x40,        //   plant_hp
             0xb0 + 0x18, // plant_count_max
             0xb8 + 0x18, // plant_next_pos
+            0x14c,       // plant_struct_size
 
             0x100 + 0x18, // lawn_mower
             0x30,         //   lawn_mower_dead
             0x104 + 0x18, // lawn_mower_count_max
             0x110 + 0x18, // lawn_mower_count
+            0x48,         // lawn_mower_struct_size
 
             0x11c + 0x18, // grid_item
             0x08,         //   grid_item_type
@@ -2259,6 +2411,7 @@ Data::Data()
             0x14,         //   grid_item_row
             0x20,         //   grid_item_dead
             0x120 + 0x18, // grid_item_count_max
+            0xec,         // grid_item_struct_size
 
             0x138 + 0x18, // cursor
             0x30,         //   cursor_grab
@@ -2269,6 +2422,7 @@ Data::Data()
             0x50,         //   slot_seed_cd_total
             0x5c,         //   slot_seed_type
             0x60,         //   slot_seed_type_im
+            0x50,         //   slot_seed_struct_size
 
             0x15c + 0x18, // cut_scene
 
@@ -2285,6 +2439,7 @@ Data::Data()
             0x5550 + 0x18, // adventure_level
             0x5560 + 0x18, // sun
             0x5568 + 0x18, // game_clock
+            0x557c + 0x18, // current_wave
             0x55f8 + 0x18, // debug_mode
             0x5620 + 0x18, // particle_systems_addr
 
@@ -2303,6 +2458,7 @@ Data::Data()
             0x00,          //       particle_system_type
             0x1c,          //       particle_system_dead
             0x04,          //     particle_system_count_max
+            0x2c,          //     particle_system_struct_size
 
             0x82c + 0x120, // user_data
             0x24 + 0x28,   //   level
@@ -2436,7 +2592,13 @@ Data::Data()
             0x90 + 0x18, // zombie
             0x28,        //   zombie_status
             0xec,        //   zombie_dead
+            0x1c,        //   zombie_row
+            0x24,        //   zombie_type
+            0x2c,        //   zombie_x
+            0x30,        //   zombie_y
+            0xc8,        //   zombie_hp
             0x94 + 0x18, // zombie_count_max
+            0x168,       // zombie_struct_size
 
             0xac + 0x18, // plant
             0x1c,        //   plant_row
@@ -2446,13 +2608,16 @@ Data::Data()
             0x141,       //   plant_dead
             0x142,       //   plant_squished
             0x143,       //   plant_asleep
+            0x40,        //   plant_hp
             0xb0 + 0x18, // plant_count_max
             0xb8 + 0x18, // plant_next_pos
+            0x14c,       // plant_struct_size
 
             0x100 + 0x18, // lawn_mower
             0x30,         //   lawn_mower_dead
             0x104 + 0x18, // lawn_mower_count_max
             0x110 + 0x18, // lawn_mower_count
+            0x48,         // lawn_mower_struct_size
 
             0x11c + 0x18, // grid_item
             0x08,         //   grid_item_type
@@ -2460,6 +2625,7 @@ Data::Data()
             0x14,         //   grid_item_row
             0x20,         //   grid_item_dead
             0x120 + 0x18, // grid_item_count_max
+            0xec,         // grid_item_struct_size
 
             0x138 + 0x18, // cursor
             0x30,         //   cursor_grab
@@ -2470,6 +2636,7 @@ Data::Data()
             0x50,         //   slot_seed_cd_total
             0x5c,         //   slot_seed_type
             0x60,         //   slot_seed_type_im
+            0x50,         //   slot_seed_struct_size
 
             0x15c + 0x18, // cut_scene
 
@@ -2486,6 +2653,7 @@ Data::Data()
             0x5550 + 0x18, // adventure_level
             0x5560 + 0x18, // sun
             0x5568 + 0x18, // game_clock
+            0x557c + 0x18, // current_wave
             0x55f8 + 0x18, // debug_mode
             0x5620 + 0x18, // particle_systems_addr
 
@@ -2504,6 +2672,7 @@ Data::Data()
             0x00,              //       particle_system_type
             0x1c,              //       particle_system_dead
             0x04,              //     particle_system_count_max
+            0x2c,              //     particle_system_struct_size
 
             0x82c + 0x120 + 4, // user_data
             0x24 + 0x28,       //   level
@@ -2637,7 +2806,13 @@ Data::Data()
             0x90 + 0x18, // zombie
             0x28,        //   zombie_status
             0xec,        //   zombie_dead
+            0x1c,        //   zombie_row
+            0x24,        //   zombie_type
+            0x2c,        //   zombie_x
+            0x30,        //   zombie_y
+            0xc8,        //   zombie_hp
             0x94 + 0x18, // zombie_count_max
+            0x168,       // zombie_struct_size
 
             0xac + 0x18, // plant
             0x1c,        //   plant_row
@@ -2647,13 +2822,16 @@ Data::Data()
             0x141,       //   plant_dead
             0x142,       //   plant_squished
             0x143,       //   plant_asleep
+            0x40,        //   plant_hp
             0xb0 + 0x18, // plant_count_max
             0xb8 + 0x18, // plant_next_pos
+            0x14c,       // plant_struct_size
 
             0x100 + 0x18, // lawn_mower
             0x30,         //   lawn_mower_dead
             0x104 + 0x18, // lawn_mower_count_max
             0x110 + 0x18, // lawn_mower_count
+            0x48,         // lawn_mower_struct_size
 
             0x11c + 0x18, // grid_item
             0x08,         //   grid_item_type
@@ -2661,6 +2839,7 @@ Data::Data()
             0x14,         //   grid_item_row
             0x20,         //   grid_item_dead
             0x120 + 0x18, // grid_item_count_max
+            0xec,         // grid_item_struct_size
 
             0x138 + 0x18, // cursor
             0x30,         //   cursor_grab
@@ -2671,6 +2850,7 @@ Data::Data()
             0x50,         //   slot_seed_cd_total
             0x5c,         //   slot_seed_type
             0x60,         //   slot_seed_type_im
+            0x50,         //   slot_seed_struct_size
 
             0x15c + 0x18, // cut_scene
 
@@ -2687,6 +2867,7 @@ Data::Data()
             0x5550 + 0x18, // adventure_level
             0x5560 + 0x18, // sun
             0x5568 + 0x18, // game_clock
+            0x557c + 0x18, // current_wave
             0x55f8 + 0x18, // debug_mode
             0x5620 + 0x18, // particle_systems_addr
 
@@ -2705,6 +2886,7 @@ Data::Data()
             0x00,              //       particle_system_type
             0x1c,              //       particle_system_dead
             0x04,              //     particle_system_count_max
+            0x2c,              //     particle_system_struct_size
 
             0x82c + 0x120 + 4, // user_data
             0x24 + 0x28,       //   level
@@ -2880,4 +3062,20 @@ PVZ_DATA Data::data()
     return this->ver_map[this->find_result];
 }
 
+LAYOUTS Data::layouts()
+{
+    const PVZ_DATA &d = this->ver_map[this->find_result];
+
+    LAYOUTS l;
+    l.plant = {uint32_t(d.plant_struct_size), d.plant_row, d.plant_type, d.plant_col, d.plant_imitater,
+               d.plant_dead, d.plant_squished, d.plant_asleep, d.plant_hp};
+    l.zombie = {uint32_t(d.zombie_struct_size), d.zombie_status, d.zombie_dead, d.zombie_row, d.zombie_type,
+                d.zombie_x, d.zombie_y, d.zombie_hp};
+    l.grid_item = {uint32_t(d.grid_item_struct_size), d.grid_item_type, d.grid_item_col, d.grid_item_row, d.grid_item_dead};
+    l.seed_slot = {uint32_t(d.slot_seed_struct_size), d.slot_seed_cd_past, d.slot_seed_cd_total, d.slot_seed_type, d.slot_seed_type_im};
+    l.lawn_mower = {uint32_t(d.lawn_mower_struct_size), d.lawn_mower_dead};
+    l.particle_system = {uint32_t(d.particle_system_struct_size), d.particle_system_type, d.particle_system_dead};
+    return l;
+}
+
 } // namespace Pt
@@ -0,0 +1,374 @@
+
+#include "../inc/freeze.h"
+
+#include <algorithm>
+
+namespace Pt
+{
+
+static size_t freeze_size(int type)
+{
+    switch (type)
+    {
+    case FREEZE_INT8:
+        return 1;
+    case FREEZE_INT16:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+static double freeze_load(int type, const uint8_t *p)
+{
+    switch (type)
+    {
+    case FREEZE_INT8:
+        return double(*(const int8_t *)p);
+    case FREEZE_INT16:
+    {
+        int16_t v;
+        memcpy(&v, p, sizeof(v));
+        return double(v);
+    }
+    case FREEZE_FLOAT:
+    {
+        float v;
+        memcpy(&v, p, sizeof(v));
+        return double(v);
+    }
+    default:
+    {
+        int32_t v;
+        memcpy(&v, p, sizeof(v));
+        return double(v);
+    }
+    }
+}
+
+FreezeTable::FreezeTable(Process *process)
+{
+    this->process = process;
+    this->next_id = 1;
+    this->dirty = true;
+    this->ticks = 0;
+    this->gap = MERGE_GAP;
+    this->interval_min = 10;
+    this->interval_max = 100;
+    InitializeCriticalSection(&this->lock);
+    this->thread = nullptr;
+    this->stop_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    this->wake_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    this->running = false;
+    this->syscalls = 0;
+}
+
+FreezeTable::~FreezeTable()
+{
+    Stop();
+    CloseHandle(stop_event);
+    CloseHandle(wake_event);
+    DeleteCriticalSection(&lock);
+}
+
+int FreezeTable::Add(const FreezeEntry &entry)
+{
+    if (entry.chain.empty())
+        return 0;
+
+    EnterCriticalSection(&lock);
+    int id = next_id++;
+    items[id].entry = entry;
+    dirty = true;
+    LeaveCriticalSection(&lock);
+
+    // 线程在列表为空时停在 wake_event 上
+    if (running)
+        SetEvent(wake_event);
+    else
+        Start();
+    return id;
+}
+
+bool FreezeTable::Set(int id, double value)
+{
+    EnterCriticalSection(&lock);
+    auto it = items.find(id);
+    bool found = it != items.end();
+    if (found)
+        it->second.entry.value = value;
+    LeaveCriticalSection(&lock);
+    return found;
+}
+
+void FreezeTable::Remove(int id)
+{
+    EnterCriticalSection(&lock);
+    if (items.erase(id) > 0)
+        dirty = true;
+    if (items.empty())
+        reset();
+    LeaveCriticalSection(&lock);
+}
+
+void FreezeTable::Clear()
+{
+    EnterCriticalSection(&lock);
+    items.clear();
+    reset();
+    LeaveCriticalSection(&lock);
+}
+
+void FreezeTable::reset()
+{
+    cells.clear();
+    ranges.clear();
+    dirty = true;
+    gap = MERGE_GAP;
+}
+
+size_t FreezeTable::Count()
+{
+    EnterCriticalSection(&lock);
+    size_t count = items.size();
+    LeaveCriticalSection(&lock);
+    return count;
+}
+
+void FreezeTable::SetInterval(int ms_min, int ms_max)
+{
+    interval_min = (std::max)(ms_min, 1);
+    interval_max = (std::max)(ms_max, interval_min);
+}
+
+bool FreezeTable::Start()
+{
+    if (running)
+        return true;
+
+    ResetEvent(stop_event);
+    running = true;
+    thread = CreateThread(nullptr, 0, thread_proc, this, 0, nullptr);
+    if (thread == nullptr)
+        running = false;
+
+    return running;
+}
+
+void FreezeTable::Stop()
+{
+    if (!running)
+        return;
+
+    SetEvent(stop_event);
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+    thread = nullptr;
+    running = false;
+}
+
+bool FreezeTable::Running()
+{
+    return running;
+}
+
+size_t FreezeTable::Syscalls()
+{
+    return syscalls;
+}
+
+DWORD WINAPI FreezeTable::thread_proc(LPVOID lpParam)
+{
+    FreezeTable *table = (FreezeTable *)lpParam;
+    table->run();
+    return 0;
+}
+
+void FreezeTable::resolve()
+{
+    dirty = false;
+    cells.clear();
+    ranges.clear();
+
+    // 相同的中间指针只读一次
+    std::map<uintptr_t, uintptr_t> pointers;
+    std::vector<Range> locations;
+
+    // 解析指针链, 失败返回 0
+    auto walk = [&](const std::vector<uintptr_t> &chain) -> uintptr_t
+    {
+        uintptr_t offset = 0;
+        for (size_t k = 0; k + 1 < chain.size(); k++)
+        {
+            uintptr_t cell = offset + chain[k];
+            auto it = pointers.find(cell);
+            if (it == pointers.end())
+                it = pointers.insert({cell, process->ReadMemory<uintptr_t>({cell})}).first;
+            offset = it->second;
+            if (offset == 0)
+                return 0;
+        }
+        return offset + chain.back();
+    };
+
+    for (auto &kv : items)
+    {
+        Item &item = kv.second;
+        size_t size = freeze_size(item.entry.type);
+
+        item.address = walk(item.entry.chain);
+        item.source = item.entry.source.empty() ? 0 : walk(item.entry.source);
+        if (!item.entry.source.empty() && item.source == 0)
+            item.address = 0; // 来源无效时整项视为无效
+        if (item.address != 0)
+            locations.push_back({item.address, item.address + size});
+        if (item.source != 0)
+            locations.push_back({item.source, item.source + size});
+    }
+
+    for (auto &kv : pointers)
+    {
+        if (kv.second == 0)
+            continue;
+        cells.push_back({kv.first, kv.second});
+        locations.push_back({kv.first, kv.first + sizeof(uintptr_t)});
+    }
+
+    // 相近的地址合并成一段
+    std::sort(locations.begin(), locations.end(),
+              [](const Range &a, const Range &b)
+              { return a.begin < b.begin; });
+    for (auto &loc : locations)
+    {
+        if (!ranges.empty() && loc.begin <= ranges.back().end + gap)
+            ranges.back().end = (std::max)(ranges.back().end, loc.end);
+        else
+            ranges.push_back(loc);
+    }
+}
+
+size_t FreezeTable::tick()
+{
+    // 和界面线程的修改以及切换进程句柄互斥, 顺序为先操作锁后表锁
+    MutexLock operation(process->OperationLock());
+    EnterCriticalSection(&lock);
+
+    size_t calls = 0;
+    size_t writes = 0;
+
+    bool inactive = false;
+    for (auto &kv : items)
+        inactive |= kv.second.address == 0;
+
+    if (!items.empty() && (dirty || (inactive && ticks % RETRY_TICKS == 0)))
+        resolve();
+    ticks++;
+
+    // 整段读取
+    std::vector<std::vector<uint8_t>> buffers(ranges.size());
+    bool ok = true;
+    for (size_t i = 0; i < ranges.size() && ok; i++)
+    {
+        buffers[i].resize(ranges[i].end - ranges[i].begin);
+        calls++;
+        if (!process->ReadMemoryBlock(buffers[i].data(), buffers[i].size(), {ranges[i].begin}))
+        {
+            // 合并的空隙里可能有不可读的页, 以后只合并相邻的地址
+            ok = false;
+            gap = 0;
+        }
+    }
+
+    auto at = [&](uintptr_t address) -> const uint8_t *
+    {
+        auto it = std::upper_bound(ranges.begin(), ranges.end(), address,
+                                   [](uintptr_t a, const Range &r)
+                                   { return a < r.begin; });
+        size_t i = (it - ranges.begin()) - 1;
+        return buffers[i].data() + (address - ranges[i].begin);
+    };
+
+    // 中间指针变了, 下次重新解析
+    for (size_t i = 0; i < cells.size() && ok; i++)
+    {
+        uintptr_t value;
+        memcpy(&value, at(cells[i].address), sizeof(value));
+        ok = value == cells[i].value;
+    }
+
+    if (ok)
+    {
+        for (auto &kv : items)
+        {
+            Item &item = kv.second;
+            if (item.address == 0)
+                continue;
+
+            const FreezeEntry &e = item.entry;
+            double value = item.source != 0 ? freeze_load(e.type, at(item.source)) : e.value;
+            double current = freeze_load(e.type, at(item.address));
+            bool drifted = (e.mode == FREEZE_EXACT && current != value) //
+                           || (e.mode == FREEZE_MIN && current < value) //
+                           || (e.mode == FREEZE_MAX && current > value);
+            if (!drifted)
+                continue;
+
+            switch (e.type)
+            {
+            case FREEZE_INT8:
+                process->WriteMemory<int8_t>(int8_t(value), {item.address});
+                break;
+            case FREEZE_INT16:
+                process->WriteMemory<int16_t>(int16_t(value), {item.address});
+                break;
+            case FREEZE_FLOAT:
+                process->WriteMemory<float>(float(value), {item.address});
+                break;
+            default:
+                process->WriteMemory<int32_t>(int32_t(value), {item.address});
+                break;
+            }
+            calls++;
+            writes++;
+        }
+    }
+    else
+    {
+        dirty = true;
+    }
+
+    LeaveCriticalSection(&lock);
+
+    syscalls = calls;
+    return writes;
+}
+
+void FreezeTable::run()
+{
+    double interval = interval_min;
+    DWORD sleep_ms = 0;
+
+    while (WaitForSingleObject(stop_event, sleep_ms) == WAIT_TIMEOUT)
+    {
+        // 没有锁定项时停下, 直到 Add 或 Stop
+        if (Count() == 0)
+        {
+            HANDLE events[2] = {stop_event, wake_event};
+            if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0 + 1)
+                break;
+            interval = interval_min;
+        }
+
+        size_t writes = process->IsValid() ? tick() : 0;
+
+        // 有写入时恢复最短间隔, 平静时逐渐放宽
+        if (writes > 0)
+            interval = interval_min;
+        else
+            interval = (std::min)(interval * 1.5, double(interval_max));
+
+        sleep_ms = DWORD(interval + 0.5);
+    }
+}
+
+} // namespace Pt
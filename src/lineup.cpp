@@ -4,18 +4,25 @@
 namespace Pt
 {
 
+const bool Lineup::may_sleep[48] = {false, false, false, false, false, false, false, false, //
+                                    true, true, true, false, true, true, true, true,        //
+                                    false, false, false, false, false, false, false, false, //
+                                    true, false, false, false, false, false, false, true,   //
+                                    false, false, false, false, false, false, false, false, //
+                                    false, false, true, false, false, false, false, false}; //
+
 Lineup::Lineup()
 {
     reset_data();
 }
 
-Lineup::Lineup(const std::string &string)
+Lineup::Lineup(std::string_view string)
 {
     reset_data();
     Init(string);
 }
 
-Lineup::Lineup(const std::string &name, const std::string &string)
+Lineup::Lineup(std::string_view name, std::string_view string)
 {
     reset_data();
     Init(string);
@@ -53,12 +60,91 @@ void Lineup::reset_data()
     this->lineup_code.clear();
 }
 
-void Lineup::Init(const std::string &string)
+static inline bool is_hex(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static inline bool is_alnum(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static inline int hex_value(char c)
+{
+    return (c >= '0' && c <= '9') ? c - '0' : ((c >= 'a' && c <= 'f') ? c - 'a' + 10 : c - 'A' + 10);
+}
+
+// 阵型字符串 [0-5](,[a-fA-F0-9]{1,2} [1-6] [1-9] [0-2] [0-4]( [a-zA-Z0-9]{1,}){0,}){0,}
+bool Lineup::is_lineup_string(std::string_view string)
+{
+    static const char ranges[4][2] = {{'1', '6'}, {'1', '9'}, {'0', '2'}, {'0', '4'}}; // 行 列 状态 第五项
+
+    size_t size = string.size();
+    if (size == 0 || string[0] < '0' || string[0] > '5')
+        return false;
+
+    size_t i = 1;
+    while (i < size)
+    {
+        if (string[i++] != ',')
+            return false;
+
+        size_t n = 0;
+        while (i < size && n < 2 && is_hex(string[i]))
+            i++, n++;
+        if (n == 0)
+            return false;
+
+        for (auto &range : ranges)
+        {
+            if (i + 2 > size || string[i] != ' ' || string[i + 1] < range[0] || string[i + 1] > range[1])
+                return false;
+            i += 2;
+        }
+
+        // 其余的字段
+        while (i < size && string[i] == ' ')
+        {
+            i++;
+            n = 0;
+            while (i < size && is_alnum(string[i]))
+                i++, n++;
+            if (n == 0)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// 阵型代码 [a-zA-Z0-9+/=]{18,164} 或者 [a-zA-Z0-9-_=]{18,164}, 长度是 4 的倍数, 最多两个 '='
+bool Lineup::is_lineup_code(std::string_view string)
 {
-    std::regex regex_string("[0-5](,[a-fA-F0-9]{1,2} [1-6] [1-9] [0-2] [0-4]( [a-zA-Z0-9]{1,}){0,}){0,}");
-    std::regex regex_code("([a-zA-Z0-9+/=]{18,164}|[a-zA-Z0-9-_=]{18,164})");
+    size_t size = string.size();
+    if (size < 18 || size > 164 || size % 4 != 0)
+        return false;
 
-    if (std::regex_match(string, regex_string))
+    bool standard = false, url = false;
+    int padding = 0;
+    for (char c : string)
+    {
+        if (c == '=')
+            padding++;
+        else if (c == '+' || c == '/')
+            standard = true;
+        else if (c == '-' || c == '_')
+            url = true;
+        else if (!is_alnum(c))
+            return false;
+    }
+
+    return padding <= 2 && !(standard && url);
+}
+
+void Lineup::Init(std::string_view string)
+{
+    if (is_lineup_string(string))
     {
         this->lineup_string = string;
         if (lineup_string_to_data())
@@ -66,9 +152,7 @@ void Lineup::Init(const std::string &string)
             this->ok = true;
         }
     }
-    else if (std::regex_match(string, regex_code) //
-             && string.size() % 4 == 0            //
-             && std::count(string.begin(), string.end(), '=') <= 2)
+    else if (is_lineup_code(string))
     {
         this->lineup_code = string;
         if (lineup_code_to_data())
@@ -78,26 +162,39 @@ void Lineup::Init(const std::string &string)
         }
     }
 
-    this->weight += this->scene * 10000000000000000;
+    compress_data();
+    this->weight = Weight(this->items, this->scene);
+}
+
+// 依次为场景和几种主要植物的个数, 每项占 6 位, 个数最多为 GRID 不会进到上一项
+long long Lineup::Weight(const uint16_t (&items)[GRID], uint8_t scene)
+{
+    long long counts[8] = {0};
     for (int i = 0; i < GRID; i++)
     {
-        if (plant[i] == 48)
-            this->weight += 100000000000000; // 春哥
-        if (plant[i] == 43)
-            this->weight += 1000000000000; // 曾哥
-        if (plant[i] == 42)
-            this->weight += 10000000000; // 双子
-        if (plant[i] == 45)
-            this->weight += 100000000; // 冰瓜
-        if (pumpkin[i] == 1)
-            this->weight += 1000000; // 南瓜
-        if (base[i] == 1)
-            this->weight += 10000; // 睡莲
-        if (base[i] == 2)
-            this->weight += 100; // 花盆
-        if (ladder[i] == 1)
-            this->weight += 1; // 梯子
+        uint16_t plant = (items[i] & 0b1111110000000000) >> 10;
+        uint16_t base = (items[i] & 0b0000000011000000) >> 6;
+        if (plant == 48)
+            counts[0]++; // 春哥
+        if (plant == 43)
+            counts[1]++; // 曾哥
+        if (plant == 42)
+            counts[2]++; // 双子
+        if (plant == 45)
+            counts[3]++; // 冰瓜
+        if (items[i] & 0b0000000000010000)
+            counts[4]++; // 南瓜
+        if (base == 1)
+            counts[5]++; // 睡莲
+        if (base == 2)
+            counts[6]++; // 花盆
+        if (items[i] & 0b0000000000000001)
+            counts[7]++; // 梯子
     }
+    long long weight = (long long)(scene) << 48;
+    for (int k = 0; k < 8; k++)
+        weight |= counts[k] << (42 - 6 * k);
+    return weight;
 }
 
 bool Lineup::OK()
@@ -113,26 +210,23 @@ std::string Lineup::Generate()
     return this->lineup_code;
 }
 
-std::vector<std::string> Lineup::split(const std::string &string, char seperator)
+void Lineup::Pack(uint16_t (&packed)[GRID])
 {
-    std::vector<std::string> result;
-    std::string::size_type prev = 0, pos = 0;
-    while ((pos = string.find(seperator, pos)) != std::string::npos)
-    {
-        std::string sub_string(string.substr(prev, pos - prev));
-        result.push_back(sub_string);
-        prev = ++pos;
-    }
-    result.push_back(string.substr(prev, pos - prev));
-    return result;
+    compress_data();
+    memcpy(packed, this->items, sizeof(this->items));
 }
 
-long Lineup::hex2dec(const std::string &string)
+void Lineup::Restore(std::string_view name, uint8_t scene, uint8_t rake_row, const uint16_t (&packed)[GRID], long long weight)
 {
-    char *ptr;
-    long num;
-    num = strtol(string.c_str(), &ptr, 16);
-    return num;
+    reset_data();
+    this->lineup_name = name;
+    this->scene = scene;
+    this->rake_row = rake_row;
+    this->weight = weight;
+    memcpy(this->items, packed, sizeof(this->items));
+    decompress_data();
+    data_to_lineup_code();
+    this->ok = true;
 }
 
 bool Lineup::lineup_string_to_data()
@@ -140,79 +234,86 @@ bool Lineup::lineup_string_to_data()
     if (this->lineup_string.empty())
         return false;
 
-    std::vector<std::string> str_list = split(this->lineup_string, ',');
-    size_t count = str_list.size() - 1;
+    // 已经校验过格式, 直接按位置取值
+    std::string_view string = this->lineup_string;
 
-    std::string str_scene = str_list[0];
-    if (str_scene == "0") // pool
+    char str_scene = string[0];
+    if (str_scene == '0') // pool
         this->scene = 2;
-    else if (str_scene == "1") // fog
+    else if (str_scene == '1') // fog
         this->scene = 3;
-    else if (str_scene == "2") // day
+    else if (str_scene == '2') // day
         this->scene = 0;
-    else if (str_scene == "3") // night
+    else if (str_scene == '3') // night
         this->scene = 1;
-    else if (str_scene == "4") // roof
+    else if (str_scene == '4') // roof
         this->scene = 4;
-    else if (str_scene == "5") // moon
+    else if (str_scene == '5') // moon
         this->scene = 5;
 
-    for (size_t i = 0; i < count; i++)
+    size_t pos = 1;
+    while (pos < string.size())
     {
-        std::vector<std::string> item_str = split(str_list[i + 1], ' ');
-        int item_type = hex2dec(item_str[0]);
+        size_t end = string.find(',', pos + 1);
+        if (end == std::string_view::npos)
+            end = string.size();
+        std::string_view item = string.substr(pos + 1, end - pos - 1);
+        pos = end;
+
+        // 种类 行 列 状态 第五项 模仿者 ...
+        std::string_view item_str[6];
+        size_t fields = 0;
+        for (size_t p = 0; p <= item.size() && fields < 6;)
+        {
+            size_t q = item.find(' ', p);
+            if (q == std::string_view::npos)
+                q = item.size();
+            item_str[fields++] = item.substr(p, q - p);
+            p = q + 1;
+        }
+
+        int item_type = 0;
+        for (char c : item_str[0])
+            item_type = item_type * 16 + hex_value(c);
 
         if (item_type < 0 || item_type > 0x32)
             continue;
 
+        int item_row = item_str[1][0] - '0' - 1;
+        int item_col = item_str[2][0] - '0' - 1;
+        int item_state_row = item_str[3][0] - '0';
+        bool item_imitater = item_str[5] == "1";
+
         if (item_type == 16 || item_type == 33) // 睡莲 花盆
         {
-            int item_row = atoi(item_str[1].c_str()) - 1;
-            int item_col = atoi(item_str[2].c_str()) - 1;
-            bool item_imitater = item_str[5] == "1";
             this->base[item_row * 9 + item_col] = (item_type == 16) ? 1 : 2;
             this->base_im[item_row * 9 + item_col] = item_imitater ? 1 : 0;
         }
         else if (item_type == 50) // 墓碑
         {
-            int item_row = atoi(item_str[1].c_str()) - 1;
-            int item_col = atoi(item_str[2].c_str()) - 1;
             this->base[item_row * 9 + item_col] = 3;
             this->base_im[item_row * 9 + item_col] = 0;
         }
         else if (item_type == 30) // 南瓜
         {
-            int item_row = atoi(item_str[1].c_str()) - 1;
-            int item_col = atoi(item_str[2].c_str()) - 1;
-            bool item_imitater = item_str[5] == "1";
             this->pumpkin[item_row * 9 + item_col] = 1;
             this->pumpkin_im[item_row * 9 + item_col] = item_imitater ? 1 : 0;
         }
         else if (item_type == 35) // 咖啡
         {
-            int item_row = atoi(item_str[1].c_str()) - 1;
-            int item_col = atoi(item_str[2].c_str()) - 1;
-            bool item_imitater = item_str[5] == "1";
             this->coffee[item_row * 9 + item_col] = 1;
             this->coffee_im[item_row * 9 + item_col] = item_imitater ? 1 : 0;
         }
         else if (item_type == 48) // 梯子 0x30
         {
-            int item_row = atoi(item_str[1].c_str()) - 1;
-            int item_col = atoi(item_str[2].c_str()) - 1;
             this->ladder[item_row * 9 + item_col] = 1;
         }
         else if (item_type == 49) // 钉耙 0x31
         {
-            int item_row = atoi(item_str[1].c_str()) - 1;
             this->rake_row = item_row + 1;
         }
         else // 主要植物
         {
-            int item_row = atoi(item_str[1].c_str()) - 1;
-            int item_col = atoi(item_str[2].c_str()) - 1;
-            int item_state_row = atoi(item_str[3].c_str());
-            bool item_imitater = item_str[5] == "1";
             this->plant[item_row * 9 + item_col] = item_type + 1;
             this->plant_im[item_row * 9 + item_col] = item_imitater ? 1 : 0;
             this->plant_awake[item_row * 9 + item_col] = ((scene == 0 || scene == 2 || scene == 4) //
@@ -230,28 +331,37 @@ bool Lineup::lineup_code_to_data()
     if (this->lineup_code.empty())
         return false;
 
+    return Decode(this->lineup_code, this->items, this->scene, this->rake_row);
+}
+
+bool Lineup::Decode(std::string_view code, uint16_t (&items)[GRID], uint8_t &scene, uint8_t &rake_row)
+{
+    if (!is_lineup_code(code))
+        return false;
+
     unsigned long size = 128;
     unsigned char buffer[128] = {0};
 
-    size_t len = this->lineup_code.length();
-    auto written = base64_decode(buffer, this->lineup_code.c_str(), len);
-    // TODO 检测失败
+    auto written = base64_decode(buffer, code.data(), code.size());
+    if (written == 0)
+        return false;
     size = written;
 
     for (size_t i = 0; i < size; i++)
         buffer[i] = buffer[i] ^ (unsigned char)0x54;
 
-    this->rake_row = buffer[size - 1] >> 4;
-    this->scene = buffer[size - 1] & 0b00001111;
-    if (this->scene >= 6)
+    rake_row = buffer[size - 1] >> 4;
+    scene = buffer[size - 1] & 0b00001111;
+    if (scene >= 6)
         return false;
-    if (this->rake_row != 0 && this->rake_row > ((this->scene == 2 || this->scene == 3) ? 6 : 5))
+    if (rake_row != 0 && rake_row > ((scene == 2 || scene == 3) ? 6 : 5))
         return false;
-    if ((this->scene == 2 || this->scene == 3) && (this->rake_row == 3 || this->rake_row == 4))
+    if ((scene == 2 || scene == 3) && (rake_row == 3 || rake_row == 4))
         return false;
 
+    memset(items, 0, sizeof(items));
     unsigned long cut_size = 6 * 9 * sizeof(uint16_t);
-    int ret_decomp = uncompress((unsigned char *)this->items, &cut_size, buffer, size - 1);
+    int ret_decomp = uncompress((unsigned char *)items, &cut_size, buffer, size - 1);
     if (ret_decomp != Z_OK)
         return false;
     if (cut_size != ((scene == 2 || scene == 3) ? 6 : 5) * 9 * sizeof(uint16_t))
@@ -260,13 +370,13 @@ bool Lineup::lineup_code_to_data()
     return true;
 }
 
-void Lineup::data_to_lineup_code()
+std::string Lineup::Encode(const uint16_t (&items)[GRID], uint8_t scene, uint8_t rake_row)
 {
     unsigned long size = 121; // compressBound(6*9*2)
     unsigned char buffer[128] = {0};
-    unsigned long cut_size = ((this->scene == 2 || this->scene == 3) ? 6 : 5) * 9 * sizeof(uint16_t);
-    compress2(buffer, &size, (unsigned char *)this->items, cut_size, Z_BEST_COMPRESSION);
-    buffer[size - 1 + 1] = (this->rake_row << 4) | (this->scene & 0b00001111);
+    unsigned long cut_size = ((scene == 2 || scene == 3) ? 6 : 5) * 9 * sizeof(uint16_t);
+    compress2(buffer, &size, (const unsigned char *)items, cut_size, Z_BEST_COMPRESSION);
+    buffer[size - 1 + 1] = (rake_row << 4) | (scene & 0b00001111);
 
     for (size_t i = 0; i < size + 1; i++)
         buffer[i] = buffer[i] ^ (unsigned char)0x54;
@@ -275,14 +385,16 @@ void Lineup::data_to_lineup_code()
     size_t len = size + 1;
     auto written = base64_encode(str, buffer, len);
 
-    std::string code(str);
-
     // CryptBinaryToStringA
     // code.erase(std::remove(code.begin(), code.end(), '\r'), code.end());
     // code.erase(std::remove(code.begin(), code.end(), '\n'), code.end());
 
-    // std::cout << lineup << " " << lineup.size() << std::endl;
-    lineup_code = code;
+    return std::string(str, written);
+}
+
+void Lineup::data_to_lineup_code()
+{
+    lineup_code = Encode(this->items, this->scene, this->rake_row);
 }
 
 void Lineup::compress_data()
@@ -328,4 +440,601 @@ void Lineup::decompress_data()
     }
 }
 
+size_t LineupLibrary::Size() const
+{
+    return this->lineups.size();
+}
+
+bool LineupLibrary::Empty() const
+{
+    return this->lineups.empty();
+}
+
+void LineupLibrary::Clear()
+{
+    this->lineups.clear();
+    this->strings.clear();
+    this->names.clear();
+}
+
+void LineupLibrary::Reserve(size_t count)
+{
+    this->lineups.reserve(count);
+}
+
+// FNV-1a
+static uint64_t name_hash(std::string_view str)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : str)
+    {
+        hash ^= uint8_t(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint32_t LineupLibrary::intern(std::string_view str, uint16_t &length)
+{
+    str = str.substr(0, UINT16_MAX);
+    length = uint16_t(str.size());
+
+    uint64_t hash = name_hash(str);
+    auto range = this->names.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+        if (this->strings.compare(it->second, str.size(), str) == 0)
+            return it->second;
+
+    uint32_t offset = uint32_t(this->strings.size());
+    this->strings.append(str.data(), str.size());
+    this->names.emplace(hash, offset);
+    return offset;
+}
+
+size_t LineupLibrary::Add(Lineup &lineup)
+{
+    uint16_t items[GRID];
+    lineup.Pack(items);
+    return Add(lineup.lineup_name, lineup.scene, lineup.rake_row, items, lineup.weight);
+}
+
+size_t LineupLibrary::Add(std::string_view name, uint8_t scene, uint8_t rake_row, const uint16_t (&items)[GRID], long long weight)
+{
+    PackedLineup packed;
+    packed.weight = weight;
+    packed.name = intern(name, packed.name_len);
+    packed.padding = 0;
+    memcpy(packed.items, items, sizeof(packed.items));
+    packed.scene = scene;
+    packed.rake_row = rake_row;
+
+    this->lineups.push_back(packed);
+    return this->lineups.size() - 1;
+}
+
+void LineupLibrary::Append(const LineupLibrary &other)
+{
+    this->lineups.reserve(this->lineups.size() + other.lineups.size());
+    for (size_t i = 0; i < other.lineups.size(); i++)
+    {
+        PackedLineup packed = other.lineups[i];
+        packed.name = intern(other.Name(i), packed.name_len);
+        this->lineups.push_back(packed);
+    }
+}
+
+const PackedLineup &LineupLibrary::operator[](size_t index) const
+{
+    return this->lineups[index];
+}
+
+std::string_view LineupLibrary::Name(size_t index) const
+{
+    const PackedLineup &packed = this->lineups[index];
+    return std::string_view(this->strings.data() + packed.name, packed.name_len);
+}
+
+std::string LineupLibrary::Code(size_t index) const
+{
+    const PackedLineup &packed = this->lineups[index];
+    return Lineup::Encode(packed.items, packed.scene, packed.rake_row);
+}
+
+std::string LineupLibrary::Display(size_t index) const
+{
+    std::string display(Name(index));
+    display.append(this->lineups[index].padding, ' ');
+    return display;
+}
+
+void LineupLibrary::SetPadding(size_t index, uint16_t padding)
+{
+    this->lineups[index].padding = padding;
+}
+
+void LineupLibrary::Get(size_t index, Lineup &lineup) const
+{
+    const PackedLineup &packed = this->lineups[index];
+    lineup.Restore(Name(index), packed.scene, packed.rake_row, packed.items, packed.weight);
+}
+
+void LineupLibrary::Sort()
+{
+    auto LessThan = [](const PackedLineup &l1, const PackedLineup &l2)
+    {
+        return l1.weight < l2.weight;
+    };
+    std::stable_sort(this->lineups.begin(), this->lineups.end(), LessThan);
+}
+
+uint64_t LineupLibrary::Hash(const uint16_t (&items)[GRID], uint8_t scene, uint8_t rake_row)
+{
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&hash](uint8_t byte)
+    {
+        hash ^= byte;
+        hash *= 0x100000001b3ULL;
+    };
+    for (size_t i = 0; i < GRID; i++)
+    {
+        mix(uint8_t(items[i]));
+        mix(uint8_t(items[i] >> 8));
+    }
+    mix(scene);
+    mix(rake_row);
+    return hash;
+}
+
+uint64_t LineupLibrary::Hash(size_t index) const
+{
+    const PackedLineup &packed = this->lineups[index];
+    return Hash(packed.items, packed.scene, packed.rake_row);
+}
+
+static bool same_content(const PackedLineup &l1, const PackedLineup &l2)
+{
+    return l1.scene == l2.scene && l1.rake_row == l2.rake_row && memcmp(l1.items, l2.items, sizeof(l1.items)) == 0;
+}
+
+size_t LineupLibrary::Dedup()
+{
+    size_t count = this->lineups.size();
+
+    // 按哈希排序, 哈希相同的再逐个比较内容, 序号小的在前
+    std::vector<std::pair<uint64_t, uint32_t>> keys(count);
+    for (size_t i = 0; i < count; i++)
+        keys[i] = {Hash(i), uint32_t(i)};
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<bool> removed(count, false);
+    for (size_t begin = 0; begin < count;)
+    {
+        size_t end = begin + 1;
+        while (end < count && keys[end].first == keys[begin].first)
+            end++;
+
+        for (size_t i = begin + 1; i < end; i++)
+        {
+            for (size_t j = begin; j < i; j++)
+            {
+                if (!removed[keys[j].second] && same_content(this->lineups[keys[i].second], this->lineups[keys[j].second]))
+                {
+                    removed[keys[i].second] = true;
+                    break;
+                }
+            }
+        }
+        begin = end;
+    }
+
+    // 去掉的阵型的字符串留在字符串区里, 不再整理
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++)
+        if (!removed[i])
+            this->lineups[kept++] = this->lineups[i];
+    this->lineups.resize(kept);
+
+    return count - kept;
+}
+
+static inline uint32_t popcount16(uint32_t x)
+{
+    x = x - ((x >> 1) & 0x5555);
+    x = (x & 0x3333) + ((x >> 2) & 0x3333);
+    x = (x + (x >> 4)) & 0x0f0f;
+    return (x + (x >> 8)) & 0x1f;
+}
+
+// 不同的格子数
+static inline uint32_t grid_distance(const uint16_t *a, const uint16_t *b)
+{
+#ifdef LINEUP_SSE2
+    // 每次比较 8 格, 相同的格子在字节掩码里占两位, 最后一组往前错开 2 格, 去掉重复的部分
+    uint32_t same = 0;
+    for (size_t i = 0; i < 48; i += 8)
+    {
+        __m128i eq = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i)));
+        same += popcount16(uint32_t(_mm_movemask_epi8(eq)));
+    }
+    __m128i eq = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(a + GRID - 8)), _mm_loadu_si128((const __m128i *)(b + GRID - 8)));
+    same += popcount16(uint32_t(_mm_movemask_epi8(eq)) & 0xfff0);
+    return GRID - same / 2;
+#else
+    uint32_t distance = 0;
+    for (size_t i = 0; i < GRID; i++)
+        distance += a[i] != b[i] ? 1 : 0;
+    return distance;
+#endif
+}
+
+std::vector<LineupMatch> LineupLibrary::Nearest(const uint16_t (&items)[GRID], uint8_t scene, uint8_t rake_row, size_t k) const
+{
+    std::vector<LineupMatch> heap;
+    if (k == 0)
+        return heap;
+    heap.reserve(k);
+
+    // 大顶堆, 堆顶是目前最不像的
+    auto LessThan = [](const LineupMatch &m1, const LineupMatch &m2)
+    {
+        return m1.distance < m2.distance || (m1.distance == m2.distance && m1.index < m2.index);
+    };
+
+    for (size_t i = 0; i < this->lineups.size(); i++)
+    {
+        const PackedLineup &packed = this->lineups[i];
+        uint32_t penalty = (packed.scene != scene ? GRID : 0) + (packed.rake_row != rake_row ? 1 : 0);
+        if (heap.size() == k && penalty > heap.front().distance)
+            continue;
+
+        LineupMatch match = {penalty + grid_distance(packed.items, items), uint32_t(i)};
+        if (heap.size() < k)
+        {
+            heap.push_back(match);
+            std::push_heap(heap.begin(), heap.end(), LessThan);
+        }
+        else if (LessThan(match, heap.front()))
+        {
+            std::pop_heap(heap.begin(), heap.end(), LessThan);
+            heap.back() = match;
+            std::push_heap(heap.begin(), heap.end(), LessThan);
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), LessThan);
+    return heap;
+}
+
+// 每个线程至少解析的字节数
+#define LINEUP_CHUNK_MIN (64 * 1024)
+
+// 一块连续的行
+struct LineupChunk
+{
+    std::string_view text;
+    LineupLibrary lineups;
+    std::vector<std::tuple<int, std::string>> errors; // 行号为块内的
+    int lines;
+};
+
+// "名称": 阵型代码
+static bool parse_lineup_line(std::string_view line, std::string_view &name, std::string_view &code)
+{
+    size_t p = line.rfind(' ');
+    if (line.empty() || line[0] != '"' || p == std::string_view::npos || p < 3 || p + 1 >= line.size() //
+        || line[p - 1] != ':' || line[p - 2] != '"')
+        return false;
+
+    code = line.substr(p + 1);
+    bool standard = false, url = false;
+    for (char c : code)
+    {
+        if (c == '+' || c == '/')
+            standard = true;
+        else if (c == '-' || c == '_')
+            url = true;
+        else if (c != '=' && !is_alnum(c))
+            return false;
+    }
+    if (standard && url)
+        return false;
+
+    name = line.substr(1, p - 3);
+    return true;
+}
+
+static void parse_lineup_chunk(LineupChunk &chunk)
+{
+    std::string_view text = chunk.text;
+    chunk.lines = 0;
+
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t end = text.find('\n', pos);
+        if (end == std::string_view::npos)
+            end = text.size();
+        std::string_view line = text.substr(pos, end - pos);
+        pos = end + 1;
+        chunk.lines++;
+
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        if (line.empty() || line[0] == '#') // 空行或者注释
+            continue;
+
+        // 名称和代码都指向文件内容, 直接解码成压缩的数组
+        std::string_view name, code;
+        uint16_t items[GRID];
+        uint8_t scene, rake_row;
+        if (parse_lineup_line(line, name, code) && Lineup::Decode(code, items, scene, rake_row))
+        {
+            chunk.lineups.Add(name, scene, rake_row, items, Lineup::Weight(items, scene));
+            continue;
+        }
+        chunk.errors.emplace_back(chunk.lines, std::string(line));
+    }
+}
+
+bool ParseLineupList(std::string_view content, LineupLibrary &lineups, std::vector<std::tuple<int, std::string>> &errors)
+{
+    size_t first = content.find('\n');
+    std::string_view header = content.substr(0, first);
+    if (!header.empty() && header.back() == '\r')
+        header.remove_suffix(1);
+    if (header != "#! pvztoolkit")
+        return false;
+    if (first == std::string_view::npos)
+        return true;
+
+    // 在换行处切分
+    std::string_view body = content.substr(first + 1);
+    // 每个线程一块
+    size_t threads_count = parallel_threads(uint32_t(body.size() / LINEUP_CHUNK_MIN + 1));
+
+    std::vector<LineupChunk> chunks(threads_count);
+    size_t begin = 0;
+    for (size_t t = 0; t < threads_count; t++)
+    {
+        size_t end = body.size() * (t + 1) / threads_count;
+        if (t + 1 < threads_count)
+        {
+            end = body.find('\n', (std::max)(end, begin));
+            end = (end == std::string_view::npos) ? body.size() : end + 1;
+        }
+        end = (std::max)(end, begin);
+        chunks[t].text = body.substr(begin, end - begin);
+        begin = end;
+    }
+
+    parallel_for(uint32_t(threads_count), [&](uint32_t t, size_t)
+                 { parse_lineup_chunk(chunks[t]); });
+
+    // 按顺序合并, 行号从文件开头算, 第一行是文件头
+    size_t total = lineups.Size();
+    for (auto &chunk : chunks)
+        total += chunk.lineups.Size();
+    lineups.Reserve(total);
+
+    int line_offset = 1;
+    for (auto &chunk : chunks)
+    {
+        lineups.Append(chunk.lineups);
+        for (auto &[line, str] : chunk.errors)
+            errors.emplace_back(line_offset + line, std::move(str));
+        line_offset += chunk.lines;
+    }
+
+    return true;
+}
+
+bool LineupFileCrc(const std::wstring &path, uint32_t &crc)
+{
+    std::ifstream ifs(std::filesystem::path(path), std::ios::binary);
+    if (!ifs)
+        return false;
+
+    char buffer[64 * 1024];
+    uLong value = crc32(0L, Z_NULL, 0);
+    while (ifs)
+    {
+        ifs.read(buffer, sizeof(buffer));
+        value = crc32(value, (const Bytef *)buffer, uInt(ifs.gcount()));
+    }
+    crc = uint32_t(value);
+    return true;
+}
+
+LineupCache::LineupCache()
+{
+    file = INVALID_HANDLE_VALUE;
+    mapping = nullptr;
+    view = nullptr;
+    size = 0;
+    header = {};
+    sources = nullptr;
+    entries = nullptr;
+}
+
+LineupCache::~LineupCache()
+{
+    Close();
+}
+
+bool LineupCache::Open(const std::wstring &path)
+{
+    Close();
+
+    file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < LONGLONG(sizeof(LINEUP_CACHE_HEADER)))
+    {
+        Close();
+        return false;
+    }
+    size = uint64_t(file_size.QuadPart);
+
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr)
+        view = (const uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    memcpy(&header, view, sizeof(header));
+    uint64_t tables_end = sizeof(LINEUP_CACHE_HEADER)                                 //
+                          + uint64_t(header.sources_count) * sizeof(LINEUP_CACHE_SOURCE) //
+                          + uint64_t(header.entries_count) * sizeof(LINEUP_CACHE_ENTRY);
+    if (header.magic != LINEUP_CACHE_MAGIC || header.version != LINEUP_CACHE_VERSION //
+        || header.strings_offset != tables_end                                        //
+        || uint64_t(header.strings_offset) + header.strings_size > size)
+    {
+        Close();
+        return false;
+    }
+
+    sources = (const LINEUP_CACHE_SOURCE *)(view + sizeof(LINEUP_CACHE_HEADER));
+    entries = (const LINEUP_CACHE_ENTRY *)(sources + header.sources_count);
+    return true;
+}
+
+void LineupCache::Close()
+{
+    if (view != nullptr)
+        UnmapViewOfFile(view);
+    if (mapping != nullptr)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+
+    file = INVALID_HANDLE_VALUE;
+    mapping = nullptr;
+    view = nullptr;
+    size = 0;
+    header = {};
+    sources = nullptr;
+    entries = nullptr;
+}
+
+std::string_view LineupCache::string_at(uint32_t offset, uint32_t length) const
+{
+    if (uint64_t(offset) + length > header.strings_size)
+        return std::string_view();
+    return std::string_view((const char *)view + header.strings_offset + offset, length);
+}
+
+bool LineupCache::Match(const std::vector<LineupSource> &current) const
+{
+    if (view == nullptr || current.size() != header.sources_count)
+        return false;
+
+    for (size_t i = 0; i < current.size(); i++)
+    {
+        const LINEUP_CACHE_SOURCE &cached = sources[i];
+        std::string_view path = string_at(cached.path, cached.path_len * uint32_t(sizeof(wchar_t)));
+        if (path.size() != current[i].path.size() * sizeof(wchar_t) //
+            || memcmp(path.data(), current[i].path.data(), path.size()) != 0)
+            return false;
+
+        if (cached.size != current[i].size)
+            return false;
+
+        // 复制或者检出会改变修改时间, 内容没变的话缓存仍然有效
+        uint32_t crc;
+        if (cached.mtime != current[i].mtime && (!LineupFileCrc(current[i].path, crc) || crc != cached.crc))
+            return false;
+    }
+
+    return true;
+}
+
+uint32_t LineupCache::Count() const
+{
+    return header.entries_count;
+}
+
+void LineupCache::Load(LineupLibrary &lineups) const
+{
+    lineups.Reserve(lineups.Size() + header.entries_count);
+    for (uint32_t i = 0; i < header.entries_count; i++)
+    {
+        const LINEUP_CACHE_ENTRY &entry = entries[i];
+        size_t index = lineups.Add(string_at(entry.name, entry.name_len), entry.scene, entry.rake_row, entry.items, entry.weight);
+        lineups.SetPadding(index, uint16_t(entry.padding));
+    }
+}
+
+bool LineupCache::Write(const std::wstring &path, const std::vector<LineupSource> &sources, const LineupLibrary &lineups)
+{
+    std::string strings;
+    auto add_string = [&strings](const void *data, size_t length) -> uint32_t
+    {
+        uint32_t offset = uint32_t(strings.size());
+        strings.append((const char *)data, length);
+        return offset;
+    };
+
+    std::vector<LINEUP_CACHE_SOURCE> source_table(sources.size());
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        LINEUP_CACHE_SOURCE &s = source_table[i];
+        s = {};
+        s.size = sources[i].size;
+        s.mtime = sources[i].mtime;
+        s.crc = sources[i].crc;
+        s.path = add_string(sources[i].path.data(), sources[i].path.size() * sizeof(wchar_t));
+        s.path_len = uint32_t(sources[i].path.size());
+    }
+
+    std::vector<LINEUP_CACHE_ENTRY> entry_table(lineups.Size());
+    for (size_t i = 0; i < lineups.Size(); i++)
+    {
+        LINEUP_CACHE_ENTRY &e = entry_table[i];
+        const PackedLineup &packed = lineups[i];
+        std::string_view name = lineups.Name(i);
+        e = {};
+        e.weight = packed.weight;
+        e.name = add_string(name.data(), name.size());
+        e.name_len = uint32_t(name.size());
+        e.padding = packed.padding;
+        memcpy(e.items, packed.items, sizeof(e.items));
+        e.scene = packed.scene;
+        e.rake_row = packed.rake_row;
+    }
+
+    LINEUP_CACHE_HEADER header = {};
+    header.magic = LINEUP_CACHE_MAGIC;
+    header.version = LINEUP_CACHE_VERSION;
+    header.sources_count = uint32_t(source_table.size());
+    header.entries_count = uint32_t(entry_table.size());
+    header.strings_offset = uint32_t(sizeof(LINEUP_CACHE_HEADER)                          //
+                                     + source_table.size() * sizeof(LINEUP_CACHE_SOURCE) //
+                                     + entry_table.size() * sizeof(LINEUP_CACHE_ENTRY));
+    header.strings_size = uint32_t(strings.size());
+
+    // 先写临时文件再替换, 写到一半失败不会留下损坏的缓存
+    std::wstring temp = path + L".tmp";
+    {
+        std::ofstream ofs(std::filesystem::path(temp), std::ios::binary | std::ios::out | std::ios::trunc);
+        if (!ofs)
+            return false;
+        ofs.write((const char *)&header, sizeof(header));
+        ofs.write((const char *)source_table.data(), source_table.size() * sizeof(LINEUP_CACHE_SOURCE));
+        ofs.write((const char *)entry_table.data(), entry_table.size() * sizeof(LINEUP_CACHE_ENTRY));
+        ofs.write(strings.data(), strings.size());
+        if (!ofs)
+            return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(std::filesystem::path(temp), std::filesystem::path(path), ec);
+    return !ec;
+}
+
 } // namespace Pt
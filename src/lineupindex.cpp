@@ -0,0 +1,368 @@
+
+#include "../inc/lineupindex.h"
+
+namespace Pt
+{
+
+// 建索引时每块的阵型数, 64 的倍数
+#define LINEUP_INDEX_BLOCK 256
+
+// 最低位的 1 的位置, 用 De Bruijn 序列查表, 32 位平台上没有 64 位的位扫描指令
+static inline int lowest_bit(uint64_t word)
+{
+    static const int table[64] = {0, 1, 48, 2, 57, 49, 28, 3, 61, 58, 50, 42, 38, 29, 17, 4,        //
+                                  62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12, 5,  //
+                                  63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11, //
+                                  46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19, 9, 13, 8, 7, 6};    //
+    return table[((word & (~word + 1)) * 0x03f79d71b4cb0a89ULL) >> 58];
+}
+
+bool ParseLineupFilter(const std::string &text, LineupFilter &filter)
+{
+    static const struct
+    {
+        const char *name;
+        int column;
+    } names[] = {
+        {"cob", 47},   // 玉米加农炮
+        {"gloom", 42}, // 忧郁菇
+        {"twin", 41},  // 双子向日葵
+        {"melon", 44}, // 冰瓜
+        {"imitater", LINEUP_COL_IMITATER},
+        {"asleep", LINEUP_COL_ASLEEP},
+        {"lily", LINEUP_COL_LILY_PAD},
+        {"pot", LINEUP_COL_FLOWER_POT},
+        {"grave", LINEUP_COL_GRAVE},
+        {"pumpkin", LINEUP_COL_PUMPKIN},
+        {"im_pumpkin", LINEUP_COL_IMITATER_PUMPKIN},
+        {"coffee", LINEUP_COL_COFFEE},
+        {"ladder", LINEUP_COL_LADDER},
+    };
+
+    auto to_int = [](const std::string &str, int &value) -> bool
+    {
+        char *end = nullptr;
+        long v = strtol(str.c_str(), &end, 10);
+        if (str.empty() || *end != '\0' || v < 0 || v > 255)
+            return false;
+        value = int(v);
+        return true;
+    };
+
+    auto to_column = [&](const std::string &name, int &column) -> bool
+    {
+        for (auto &n : names)
+        {
+            if (name == n.name)
+            {
+                column = n.column;
+                return true;
+            }
+        }
+        return name.size() > 1 && name[0] == 'p' && to_int(name.substr(1), column) && column < 48;
+    };
+
+    LineupFilter result;
+    std::istringstream in(text);
+    std::string token;
+    while (in >> token)
+    {
+        if (token == "asc" || token == "desc")
+        {
+            result.descending = token == "desc";
+            continue;
+        }
+
+        size_t op_begin = token.find_first_of("<>=");
+        if (op_begin == std::string::npos || op_begin == 0)
+            return false;
+        size_t op_end = token.find_first_not_of("<>=", op_begin);
+        if (op_end == std::string::npos)
+            return false;
+        std::string name = token.substr(0, op_begin);
+        std::string op = token.substr(op_begin, op_end - op_begin);
+        std::string value = token.substr(op_end);
+
+        if (name == "scene" && op == "=")
+        {
+            result.scenes = 0;
+            std::istringstream list(value);
+            std::string item;
+            while (std::getline(list, item, ','))
+            {
+                int scene;
+                if (!to_int(item, scene) || scene > 5)
+                    return false;
+                result.scenes |= 1u << scene;
+            }
+            if (result.scenes == 0)
+                return false;
+            continue;
+        }
+
+        if (name == "sort" && op == "=")
+        {
+            if (!to_column(value, result.sort_column))
+                return false;
+            continue;
+        }
+
+        LineupCondition condition = {0, 0, GRID};
+        int v;
+        if (!to_column(name, condition.column) || !to_int(value, v))
+            return false;
+        if (op == ">=")
+            condition.min = v;
+        else if (op == "<=")
+            condition.max = v;
+        else if (op == "=")
+            condition.min = condition.max = v;
+        else if (op == ">")
+            condition.min = v + 1;
+        else if (op == "<")
+            condition.max = v - 1;
+        else
+            return false;
+        result.conditions.push_back(condition);
+    }
+
+    filter = result;
+    return true;
+}
+
+LineupIndex::LineupIndex()
+{
+    count = 0;
+    words = 0;
+}
+
+void LineupIndex::Build(const LineupLibrary &lineups)
+{
+    count = lineups.Size();
+    words = (count + 63) / 64;
+    for (auto &bitset : scenes)
+        bitset.assign(words, 0);
+    for (int c = 0; c < LINEUP_COLUMNS; c++)
+    {
+        present[c].assign(words, 0);
+        columns[c].assign(count, 0);
+    }
+
+    // 先按块统计到行存储的临时数组, 再转置写进各列
+    // 各列的数组地址对齐方式相同, 逐个阵型写各列会挤在同一组缓存里
+    uint8_t rows[LINEUP_INDEX_BLOCK][LINEUP_COLUMNS];
+    for (size_t begin = 0; begin < count; begin += LINEUP_INDEX_BLOCK)
+    {
+        size_t n = (std::min)(count - begin, size_t(LINEUP_INDEX_BLOCK));
+        for (size_t j = 0; j < n; j++)
+        {
+            const PackedLineup &packed = lineups[begin + j];
+
+            // 按 Lineup::compress_data 的位布局拆开每一格, 不用分支, 乱序的阵型也不会频繁预测失败
+            uint8_t plants[64] = {0}; // 按植物编号 + 1, 0 为没有植物
+            uint8_t bases[4] = {0};   // 按底座编号, 1 为睡莲, 2 为花盆, 3 为墓碑
+            uint32_t imitater = 0, asleep = 0, pumpkin = 0, imitater_pumpkin = 0, coffee = 0, ladder = 0;
+            for (size_t k = 0; k < GRID; k++)
+            {
+                uint32_t item = packed.items[k];
+                uint32_t plant = item >> 10;
+                uint32_t has_plant = plant != 0 ? 1 : 0;
+                uint32_t has_pumpkin = (item >> 4) & 1;
+                plants[plant]++;
+                bases[(item >> 6) & 0b11]++;
+                imitater += has_plant & (item >> 9);
+                asleep += has_plant & ~(item >> 8);
+                pumpkin += has_pumpkin;
+                imitater_pumpkin += has_pumpkin & (item >> 3);
+                coffee += (item >> 2) & 1;
+                ladder += item & 1;
+            }
+
+            uint8_t *counts = rows[j];
+            memcpy(counts, plants + 1, 48);
+            counts[LINEUP_COL_IMITATER] = uint8_t(imitater);
+            counts[LINEUP_COL_ASLEEP] = uint8_t(asleep);
+            counts[LINEUP_COL_LILY_PAD] = bases[1];
+            counts[LINEUP_COL_FLOWER_POT] = bases[2];
+            counts[LINEUP_COL_GRAVE] = bases[3];
+            counts[LINEUP_COL_PUMPKIN] = uint8_t(pumpkin);
+            counts[LINEUP_COL_IMITATER_PUMPKIN] = uint8_t(imitater_pumpkin);
+            counts[LINEUP_COL_COFFEE] = uint8_t(coffee);
+            counts[LINEUP_COL_LADDER] = uint8_t(ladder);
+
+            if (packed.scene < 6)
+                scenes[packed.scene][(begin + j) / 64] |= 1ULL << ((begin + j) % 64);
+        }
+
+        for (int c = 0; c < LINEUP_COLUMNS; c++)
+        {
+            uint8_t *column = columns[c].data() + begin;
+            for (size_t j0 = 0; j0 < n; j0 += 64)
+            {
+                uint64_t word = 0;
+                size_t m = (std::min)(n - j0, size_t(64));
+                for (size_t j = 0; j < m; j++)
+                {
+                    uint8_t value = rows[j0 + j][c];
+                    column[j0 + j] = value;
+                    word |= uint64_t(value != 0 ? 1 : 0) << j;
+                }
+                present[c][(begin + j0) / 64] = word;
+            }
+        }
+    }
+}
+
+size_t LineupIndex::Size() const
+{
+    return count;
+}
+
+uint8_t LineupIndex::Count(size_t index, int column) const
+{
+    return columns[column][index];
+}
+
+std::vector<uint32_t> LineupIndex::Select(const LineupFilter &filter) const
+{
+    std::vector<uint32_t> result;
+
+    Bitset bits(words, 0);
+    for (int s = 0; s < 6; s++)
+        if (filter.scenes & (1u << s))
+            for (size_t w = 0; w < words; w++)
+                bits[w] |= scenes[s][w];
+
+    // 只需要有或者没有的条件直接用位图, 其余的留到后面比较个数
+    std::vector<LineupCondition> ranges;
+    for (auto &condition : filter.conditions)
+    {
+        if (condition.column < 0 || condition.column >= LINEUP_COLUMNS)
+            continue;
+        int min = (std::max)(condition.min, 0);
+        int max = (std::min)(condition.max, GRID);
+        if (min > max)
+            return result;
+
+        const Bitset &p = present[condition.column];
+        if (max == 0)
+        {
+            for (size_t w = 0; w < words; w++)
+                bits[w] &= ~p[w];
+            continue;
+        }
+        if (min >= 1)
+            for (size_t w = 0; w < words; w++)
+                bits[w] &= p[w];
+        if (min > 1 || max < GRID)
+            ranges.push_back({condition.column, min, max});
+    }
+
+    for (auto &range : ranges)
+    {
+        const uint8_t *column = columns[range.column].data();
+        for (size_t w = 0; w < words; w++)
+        {
+            uint64_t word = bits[w];
+            while (word != 0)
+            {
+                int b = lowest_bit(word);
+                word &= word - 1;
+                uint8_t value = column[w * 64 + b];
+                if (value < range.min || value > range.max)
+                    bits[w] &= ~(1ULL << b);
+            }
+        }
+    }
+
+    for (size_t w = 0; w < words; w++)
+    {
+        uint64_t word = bits[w];
+        while (word != 0)
+        {
+            result.push_back(uint32_t(w * 64 + lowest_bit(word)));
+            word &= word - 1;
+        }
+    }
+
+    if (filter.sort_column < 0 || filter.sort_column >= LINEUP_COLUMNS)
+        return result;
+
+    // 个数只有 0 到 GRID, 用计数排序, 相同的保持原来的顺序
+    const uint8_t *column = columns[filter.sort_column].data();
+    size_t histogram[GRID + 1] = {0};
+    for (uint32_t index : result)
+        histogram[column[index]]++;
+
+    size_t offsets[GRID + 1];
+    size_t total = 0;
+    for (int k = 0; k <= GRID; k++)
+    {
+        int v = filter.descending ? GRID - k : k;
+        offsets[v] = total;
+        total += histogram[v];
+    }
+
+    std::vector<uint32_t> sorted(result.size());
+    for (uint32_t index : result)
+        sorted[offsets[column[index]]++] = index;
+    return sorted;
+}
+
+int LineupQuery(int argc, char **argv)
+{
+    if (argc < 1)
+        return 0xF7;
+
+    std::string text;
+    for (int i = 1; i < argc; i++)
+        text += std::string(argv[i]) + " ";
+    LineupFilter filter;
+    if (!ParseLineupFilter(text, filter))
+    {
+        printf("bad filter: %s\n", text.c_str());
+        return 0xF7;
+    }
+
+    std::ifstream ifs(std::filesystem::path(argv[0]), std::ios::binary);
+    if (!ifs)
+    {
+        printf("cannot open %s\n", argv[0]);
+        return 1;
+    }
+    std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+    LineupLibrary lineups;
+    std::vector<std::tuple<int, std::string>> errors;
+    if (!ParseLineupList(content, lineups, errors))
+    {
+        printf("not a lineup list: %s\n", argv[0]);
+        return 1;
+    }
+
+    LARGE_INTEGER freq, t0, t1, t2;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t0);
+    LineupIndex index;
+    index.Build(lineups);
+    QueryPerformanceCounter(&t1);
+    auto result = index.Select(filter);
+    QueryPerformanceCounter(&t2);
+
+    printf("%zu lineups indexed in %.1f ms, %zu matched in %.2f ms\n", lineups.Size(), //
+           double(t1.QuadPart - t0.QuadPart) * 1000.0 / double(freq.QuadPart),         //
+           result.size(), double(t2.QuadPart - t1.QuadPart) * 1000.0 / double(freq.QuadPart));
+    for (size_t i = 0; i < result.size() && i < 20; i++)
+    {
+        uint32_t k = result[i];
+        std::string name(lineups.Name(k)), code(lineups.Code(k));
+        if (filter.sort_column >= 0)
+            printf("%2zu %2u %s %s\n", i + 1, index.Count(k, filter.sort_column), name.c_str(), code.c_str());
+        else
+            printf("%2zu %s %s\n", i + 1, name.c_str(), code.c_str());
+    }
+
+    return 0;
+}
+
+} // namespace Pt
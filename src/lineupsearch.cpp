@@ -0,0 +1,286 @@
+
+#include "../inc/lineupsearch.h"
+
+namespace Pt
+{
+
+// 上一次的结果多于这个数时, 用倒排表查找比逐个筛选快
+#define SEARCH_FILTER_MAX 1024
+
+static inline char to_lower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+}
+
+// 一到三个字节的键, 最高字节为长度
+static inline uint32_t gram(const char *p, size_t n)
+{
+    uint32_t key = uint32_t(n) << 24;
+    for (size_t i = 0; i < n; i++)
+        key |= uint32_t(uint8_t(p[i])) << (8 * (2 - i));
+    return key;
+}
+
+LineupNameIndex::LineupNameIndex()
+{
+    thread = nullptr;
+    ready = false;
+}
+
+LineupNameIndex::~LineupNameIndex()
+{
+    wait();
+}
+
+void LineupNameIndex::wait()
+{
+    if (thread != nullptr)
+    {
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+        thread = nullptr;
+    }
+}
+
+void LineupNameIndex::Clear()
+{
+    wait();
+    ready = false;
+    names.clear();
+    offsets.assign(1, 0);
+    keys.clear();
+    starts.clear();
+    postings.clear();
+    history.clear();
+}
+
+void LineupNameIndex::Build(const LineupLibrary &lineups)
+{
+    Clear();
+
+    offsets.reserve(lineups.Size() + 1);
+    for (size_t i = 0; i < lineups.Size(); i++)
+    {
+        std::string display = lineups.Display(i);
+        for (char c : display)
+            names.push_back(to_lower(c));
+        names.push_back('\0'); // 分隔, 查询不会跨过两个名称
+        offsets.push_back(uint32_t(names.size()));
+    }
+
+    thread = CreateThread(nullptr, 0, build_proc, this, 0, nullptr);
+    if (thread == nullptr)
+        build_postings();
+}
+
+DWORD WINAPI LineupNameIndex::build_proc(LPVOID lpParam)
+{
+    ((LineupNameIndex *)lpParam)->build_postings();
+    return 0;
+}
+
+void LineupNameIndex::build_postings()
+{
+    // (键, 序号) 排序去重后按键分段
+    std::vector<uint64_t> pairs;
+    pairs.reserve(names.size() * 3);
+    for (uint32_t i = 0; i + 1 < offsets.size(); i++)
+    {
+        std::string_view s = name(i);
+        for (size_t n = 1; n <= 3; n++)
+            for (size_t p = 0; p + n <= s.size(); p++)
+                pairs.push_back((uint64_t(gram(s.data() + p, n)) << 32) | i);
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    postings.resize(pairs.size());
+    for (size_t k = 0; k < pairs.size(); k++)
+    {
+        uint32_t key = uint32_t(pairs[k] >> 32);
+        if (keys.empty() || keys.back() != key)
+        {
+            keys.push_back(key);
+            starts.push_back(uint32_t(k));
+        }
+        postings[k] = uint32_t(pairs[k]);
+    }
+    starts.push_back(uint32_t(pairs.size()));
+
+    ready.store(true, std::memory_order_release);
+}
+
+bool LineupNameIndex::Ready() const
+{
+    return ready.load(std::memory_order_acquire);
+}
+
+size_t LineupNameIndex::Size() const
+{
+    return offsets.empty() ? 0 : offsets.size() - 1;
+}
+
+std::string_view LineupNameIndex::name(uint32_t index) const
+{
+    return std::string_view(names.data() + offsets[index], offsets[index + 1] - offsets[index] - 1);
+}
+
+void LineupNameIndex::scan(std::string_view query, std::vector<uint32_t> &result) const
+{
+    // 在整块名称里找, 找到后跳到下一个名称继续
+    std::string_view all(names);
+    uint32_t i = 0;
+    size_t pos = all.find(query);
+    while (pos != std::string_view::npos)
+    {
+        while (offsets[i + 1] <= pos)
+            i++;
+        result.push_back(i);
+        pos = all.find(query, offsets[i + 1]);
+    }
+}
+
+const uint32_t *LineupNameIndex::postings_of(std::string_view text, const uint32_t *&end) const
+{
+    uint32_t key = gram(text.data(), text.size());
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if (it == keys.end() || *it != key)
+        return end = nullptr;
+    size_t k = it - keys.begin();
+    end = postings.data() + starts[k + 1];
+    return postings.data() + starts[k];
+}
+
+void LineupNameIndex::lookup(std::string_view query, std::string_view known, const std::vector<uint32_t> *base, //
+                             std::vector<uint32_t> &result) const
+{
+    // 不超过三个字节时倒排表就是结果
+    if (query.size() <= 3 && base == nullptr)
+    {
+        const uint32_t *end;
+        const uint32_t *begin = postings_of(query, end);
+        if (begin != nullptr)
+            result.assign(begin, end);
+        return;
+    }
+
+    // 每个三字组的倒排表, 已知查询里有的三字组跳过
+    std::vector<std::pair<const uint32_t *, const uint32_t *>> lists;
+    for (size_t p = 0; p + 3 <= query.size(); p++)
+    {
+        if (known.find(query.substr(p, 3)) != std::string_view::npos)
+            continue;
+        const uint32_t *end;
+        const uint32_t *begin = postings_of(query.substr(p, 3), end);
+        if (begin == nullptr)
+            return;
+        lists.push_back({begin, end});
+    }
+    std::sort(lists.begin(), lists.end(), [](const auto &l1, const auto &l2) { return l1.second - l1.first < l2.second - l2.first; });
+
+    std::vector<uint32_t> candidates;
+    size_t first = 0;
+    if (base != nullptr)
+    {
+        candidates = *base;
+    }
+    else
+    {
+        candidates.assign(lists[0].first, lists[0].second);
+        first = 1;
+    }
+
+    for (size_t l = first; l < lists.size() && !candidates.empty(); l++)
+    {
+        const uint32_t *p = lists[l].first;
+        const uint32_t *end = lists[l].second;
+        size_t kept = 0;
+        if (size_t(end - p) > candidates.size() * 8)
+        {
+            // 倒排表长得多, 二分跳过
+            for (uint32_t c : candidates)
+            {
+                p = std::lower_bound(p, end, c);
+                if (p == end)
+                    break;
+                if (*p == c)
+                    candidates[kept++] = c;
+            }
+        }
+        else
+        {
+            for (uint32_t c : candidates)
+            {
+                while (p != end && *p < c)
+                    p++;
+                if (p == end)
+                    break;
+                if (*p == c)
+                    candidates[kept++] = c;
+            }
+        }
+        candidates.resize(kept);
+    }
+
+    // 只有一个三字组时就是结果, 更长的三字组都有不一定连在一起
+    if (query.size() <= 3)
+    {
+        result = std::move(candidates);
+        return;
+    }
+    for (uint32_t c : candidates)
+        if (name(c).find(query) != std::string_view::npos)
+            result.push_back(c);
+}
+
+const std::vector<uint32_t> &LineupNameIndex::Search(std::string_view text)
+{
+    std::string query;
+    query.reserve(text.size());
+    for (char c : text)
+        query.push_back(to_lower(c));
+
+    // 退回到包含在这次查询里的那一次, 空查询总在最底下
+    while (!history.empty() && query.find(history.back().first) == std::string::npos)
+        history.pop_back();
+    if (!history.empty() && history.back().first == query)
+        return history.back().second;
+
+    std::vector<uint32_t> result;
+    if (history.empty())
+    {
+        // 空查询
+        result.resize(Size());
+        for (uint32_t i = 0; i < result.size(); i++)
+            result[i] = i;
+        history.emplace_back(std::string(), std::move(result));
+        return Search(text);
+    }
+
+    const std::string &known = history.back().first;
+    const std::vector<uint32_t> &last = history.back().second;
+    if (last.size() <= SEARCH_FILTER_MAX)
+    {
+        for (uint32_t i : last)
+            if (name(i).find(query) != std::string_view::npos)
+                result.push_back(i);
+    }
+    else if (!Ready())
+    {
+        scan(query, result);
+    }
+    else if (query.size() <= 3 || known.size() < 3)
+    {
+        lookup(query, std::string_view(), nullptr, result);
+    }
+    else
+    {
+        // 上一次的结果已经满足它的三字组, 只用新的三字组筛选
+        lookup(query, known, &last, result);
+    }
+
+    history.emplace_back(std::move(query), std::move(result));
+    return history.back().second;
+}
+
+} // namespace Pt
@@ -21,6 +21,10 @@
 #include <FL/fl_ask.H>
 #include <FL/x.H>
 
+#include "../inc/lineupindex.h"
+#include "../inc/spawnbench.h"
+#include "../inc/telemetry.h"
+#include "../inc/threat.h"
 #include "../inc/toolkit.h"
 #include "../inc/utils.h"
 
@@ -79,6 +83,30 @@ int main(int argc, char **argv)
     if (argc == 0)
         return -0;
 
+    // 命令行查询共用父进程的控制台
+    if (argc >= 2)
+    {
+        std::string m = argv[1];
+        if (m == "/T" || m == "/S" || m == "/R" || m == "/Q")
+            Pt::AttachParentConsole();
+    }
+
+    // 录像查询 /T 文件 查询名称 [帧区间]
+    if (argc >= 4 && std::string(argv[1]) == "/T")
+        return Pt::TelemetryQuery(argc - 2, argv + 2);
+
+    // 自定义出怪性能对比 /S [次数]
+    if (argc >= 2 && std::string(argv[1]) == "/S")
+        return Pt::SpawnBenchmark(argc - 2, argv + 2);
+
+    // 出怪列表库威胁排名 /R 库文件 [指标]
+    if (argc >= 3 && std::string(argv[1]) == "/R")
+        return Pt::ThreatQuery(argc - 2, argv + 2);
+
+    // 阵型列表查询 /Q 列表文件 [筛选条件]
+    if (argc >= 3 && std::string(argv[1]) == "/Q")
+        return Pt::LineupQuery(argc - 2, argv + 2);
+
     if (argc == 4)
     {
         std::string m = argv[1];
@@ -0,0 +1,133 @@
+
+#include "../inc/parallel.h"
+
+namespace Pt
+{
+
+// 一个线程的任务队列
+// 队列是连续的任务编号, 头尾打包在一个原子变量里, 自己从头取, 别人从尾偷
+struct ParallelQueue
+{
+    std::atomic<uint64_t> range; // 低 32 位 head, 高 32 位 tail
+};
+
+struct ParallelJob
+{
+    std::unique_ptr<ParallelQueue[]> queues;
+    size_t threads_count;
+    const std::function<void(uint32_t, size_t)> *work;
+};
+
+struct ParallelWorker
+{
+    ParallelJob *job;
+    size_t index;
+};
+
+// 取一个, 没有了返回假
+static bool pop(ParallelQueue &queue, uint32_t &task)
+{
+    uint64_t range = queue.range.load();
+    while (true)
+    {
+        uint32_t head = uint32_t(range);
+        uint32_t tail = uint32_t(range >> 32);
+        if (head >= tail)
+            return false;
+        if (queue.range.compare_exchange_weak(range, (uint64_t(tail) << 32) | (head + 1)))
+        {
+            task = head;
+            return true;
+        }
+    }
+}
+
+static bool steal(ParallelQueue &queue, uint32_t &task)
+{
+    uint64_t range = queue.range.load();
+    while (true)
+    {
+        uint32_t head = uint32_t(range);
+        uint32_t tail = uint32_t(range >> 32);
+        if (head >= tail)
+            return false;
+        if (queue.range.compare_exchange_weak(range, (uint64_t(tail - 1) << 32) | head))
+        {
+            task = tail - 1;
+            return true;
+        }
+    }
+}
+
+static void parallel_work(ParallelJob &job, size_t index)
+{
+    while (true)
+    {
+        uint32_t task;
+        bool found = pop(job.queues[index], task);
+
+        // 自己的做完了, 依次从其他线程偷
+        for (size_t k = 1; !found && k < job.threads_count; k++)
+            found = steal(job.queues[(index + k) % job.threads_count], task);
+
+        if (!found)
+            break;
+
+        (*job.work)(task, index);
+    }
+}
+
+static DWORD WINAPI parallel_proc(LPVOID lpParam)
+{
+    ParallelWorker *worker = (ParallelWorker *)lpParam;
+    parallel_work(*worker->job, worker->index);
+    return 0;
+}
+
+size_t parallel_threads(uint32_t count, int threads_count)
+{
+    if (threads_count <= 0)
+    {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        threads_count = (std::max)(int(info.dwNumberOfProcessors), 1);
+    }
+    return size_t((std::max)((std::min)(uint32_t(threads_count), count), 1u));
+}
+
+void parallel_for(uint32_t count, const std::function<void(uint32_t, size_t)> &work, int threads_count)
+{
+    if (count == 0)
+        return;
+
+    ParallelJob job;
+    job.threads_count = parallel_threads(count, threads_count);
+    job.queues.reset(new ParallelQueue[job.threads_count]);
+    job.work = &work;
+
+    // 任务平均分给每个线程
+    std::vector<ParallelWorker> workers(job.threads_count);
+    for (size_t t = 0; t < job.threads_count; t++)
+    {
+        uint64_t head = uint64_t(count) * t / job.threads_count;
+        uint64_t tail = uint64_t(count) * (t + 1) / job.threads_count;
+        job.queues[t].range = (tail << 32) | head;
+        workers[t] = {&job, t};
+    }
+
+    std::vector<HANDLE> threads;
+    for (size_t t = 1; t < job.threads_count; t++)
+    {
+        HANDLE thread = CreateThread(nullptr, 0, parallel_proc, &workers[t], 0, nullptr);
+        if (thread != nullptr)
+            threads.push_back(thread);
+    }
+    parallel_work(job, 0); // 没能创建的线程的任务也会被偷走
+    for (auto thread : threads)
+    {
+        WaitForSingleObject(thread, INFINITE);
+        CloseHandle(thread);
+    }
+}
+
+} // namespace Pt
@@ -13,34 +13,14 @@ Process::Process()
 
 Process::~Process()
 {
-    if (IsValid())
+    if (this->handle != nullptr)
         CloseHandle(this->handle);
 }
 
 bool Process::OpenByWindow(const wchar_t *class_name, const wchar_t *window_name)
 {
-    if (IsValid())
-        CloseHandle(this->handle);
-
-    this->hwnd = nullptr;
-    this->pid = 0;
-    this->handle = nullptr;
-
-    this->hwnd = FindWindowW(class_name, window_name);
-    if (this->hwnd != nullptr)
-    {
-        GetWindowThreadProcessId(this->hwnd, &(this->pid));
-        if (this->pid != 0)
-        {
-            this->handle = OpenProcess(PROCESS_ALL_ACCESS, false, this->pid);
-            if (this->handle != nullptr)
-            {
-                //
-            }
-        }
-    }
-
-    // assert(PROCESS_ALL_ACCESS == 0x001FFFFF);
+    HWND hwnd = FindWindowW(class_name, window_name);
+    OpenByHwnd(hwnd);
 
 #ifdef _DEBUG
     std::wcout << L"查找窗口: " << (class_name == nullptr ? L"nullptr" : class_name)               //
@@ -49,10 +29,52 @@ bool Process::OpenByWindow(const wchar_t *class_name, const wchar_t *window_name
 #endif
 
     // 返回的是窗口有没有找到而不是进程有没有打开
-    return this->hwnd != nullptr;
+    return hwnd != nullptr;
+}
+
+bool Process::OpenByHwnd(HWND hwnd)
+{
+    DWORD pid = 0;
+    HANDLE handle = nullptr;
+    if (hwnd != nullptr)
+    {
+        GetWindowThreadProcessId(hwnd, &pid);
+        if (pid != 0)
+            handle = OpenProcess(PROCESS_ALL_ACCESS, false, pid);
+    }
+
+    // assert(PROCESS_ALL_ACCESS == 0x001FFFFF);
+
+    // 后台线程可能正在用旧句柄读写, 等它们这一轮做完再换
+    MutexLock operation(operation_lock);
+    ExclusiveLock guard(memory_lock);
+
+    if (this->handle != nullptr)
+        CloseHandle(this->handle);
+    this->hwnd = hwnd;
+    this->pid = pid;
+    this->handle = handle;
+
+    return this->handle != nullptr;
+}
+
+DWORD Process::Pid()
+{
+    return this->pid;
 }
 
 bool Process::IsValid()
+{
+    SharedLock guard(memory_lock);
+    return is_valid();
+}
+
+Mutex &Process::OperationLock()
+{
+    return operation_lock;
+}
+
+bool Process::is_valid()
 {
     if (this->handle == nullptr)
         return false;
@@ -69,4 +91,70 @@ bool Process::IsValid()
     return valid;
 }
 
+bool Process::ReadMemoryBlock(void *buff, size_t size, std::initializer_list<uintptr_t> addr)
+{
+    SharedLock guard(memory_lock);
+
+    if (!is_valid())
+        return false;
+
+    uintptr_t offset = 0;
+    for (auto it = addr.begin(); it != addr.end(); it++)
+    {
+        if (it != addr.end() - 1)
+        {
+            unsigned long read_size = 0;
+            int ret = ReadProcessMemory(this->handle, (const void *)(offset + *it), &offset, sizeof(offset), &read_size);
+            if (ret == 0 || sizeof(offset) != read_size)
+                return false;
+        }
+        else
+        {
+            unsigned long read_size = 0;
+            int ret = ReadProcessMemory(this->handle, (const void *)(offset + *it), buff, size, &read_size);
+            if (ret == 0 || size != read_size)
+                return false;
+        }
+    }
+
+#if (defined _DEBUG) && (defined _PZTK_MEMORY_OUTPUT)
+    std::cout << addr_list_to_string(addr) << " --> " << std::dec << size << " bytes" << std::endl;
+#endif
+
+    return true;
+}
+
+bool Process::WriteMemoryBlock(const void *buff, size_t size, std::initializer_list<uintptr_t> addr)
+{
+    ExclusiveLock guard(memory_lock);
+
+    if (!is_valid())
+        return false;
+
+    uintptr_t offset = 0;
+    for (auto it = addr.begin(); it != addr.end(); it++)
+    {
+        if (it != addr.end() - 1)
+        {
+            unsigned long read_size = 0;
+            int ret = ReadProcessMemory(this->handle, (const void *)(offset + *it), &offset, sizeof(offset), &read_size);
+            if (ret == 0 || sizeof(offset) != read_size)
+                return false;
+        }
+        else
+        {
+            unsigned long write_size = 0;
+            int ret = WriteProcessMemory(this->handle, (void *)(offset + *it), buff, size, &write_size);
+            if (ret == 0 || size != write_size)
+                return false;
+        }
+    }
+
+#if (defined _DEBUG) && (defined _PZTK_MEMORY_OUTPUT)
+    std::cout << addr_list_to_string(addr) << " <-- " << std::dec << size << " bytes" << std::endl;
+#endif
+
+    return true;
+}
+
 } // namespace Pt
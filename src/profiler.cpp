@@ -0,0 +1,158 @@
+
+#include "../inc/profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace Pt
+{
+
+StallProfiler::StallProfiler()
+{
+    InitializeCriticalSection(&lock);
+}
+
+StallProfiler::~StallProfiler()
+{
+    DeleteCriticalSection(&lock);
+}
+
+double StallProfiler::Now()
+{
+    static LARGE_INTEGER frequency = {0};
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return double(counter.QuadPart) * 1000.0 / double(frequency.QuadPart);
+}
+
+void StallProfiler::Record(const char *name, const StallSample &sample)
+{
+    EnterCriticalSection(&lock);
+
+    Ring &ring = rings[name];
+    if (ring.samples.size() < WINDOW)
+    {
+        ring.samples.push_back(sample);
+    }
+    else
+    {
+        ring.samples[ring.next] = sample;
+    }
+    ring.next = (ring.next + 1) % WINDOW;
+    ring.count++;
+
+    LeaveCriticalSection(&lock);
+}
+
+// 最近秩法求分位数, 会打乱 v 的顺序
+template <typename T>
+static T percentile(std::vector<T> &v, int p)
+{
+    size_t rank = (v.size() * p + 99) / 100;
+    size_t n = rank == 0 ? 0 : rank - 1;
+    std::nth_element(v.begin(), v.begin() + n, v.end());
+    return v[n];
+}
+
+bool StallProfiler::stats(const Ring &ring, StallStats &s)
+{
+    if (ring.samples.empty())
+        return false;
+
+    std::vector<double> park_ms;
+    std::vector<int> frames_lost;
+    park_ms.reserve(ring.samples.size());
+    frames_lost.reserve(ring.samples.size());
+
+    s.code_size_max = 0;
+    for (auto &sample : ring.samples)
+    {
+        park_ms.push_back(sample.park_ms);
+        frames_lost.push_back(sample.frames_lost);
+        s.code_size_max = (std::max)(s.code_size_max, sample.code_size);
+    }
+
+    s.count = ring.count;
+    s.park_ms_p50 = percentile(park_ms, 50);
+    s.park_ms_p90 = percentile(park_ms, 90);
+    s.park_ms_p99 = percentile(park_ms, 99);
+    s.park_ms_max = *std::max_element(park_ms.begin(), park_ms.end());
+    s.frames_lost_p50 = percentile(frames_lost, 50);
+    s.frames_lost_p90 = percentile(frames_lost, 90);
+    s.frames_lost_p99 = percentile(frames_lost, 99);
+    s.frames_lost_max = *std::max_element(frames_lost.begin(), frames_lost.end());
+
+    return true;
+}
+
+bool StallProfiler::Stats(const char *name, StallStats &s)
+{
+    bool ret = false;
+
+    EnterCriticalSection(&lock);
+    auto it = rings.find(name);
+    if (it != rings.end())
+        ret = stats(it->second, s);
+    LeaveCriticalSection(&lock);
+
+    return ret;
+}
+
+std::string StallProfiler::Report()
+{
+    std::vector<std::pair<std::string, StallStats>> table;
+
+    EnterCriticalSection(&lock);
+    for (auto &ring : rings)
+    {
+        StallStats s;
+        if (stats(ring.second, s))
+            table.push_back({ring.first, s});
+    }
+    LeaveCriticalSection(&lock);
+
+    std::sort(table.begin(), table.end(),
+              [](const std::pair<std::string, StallStats> &a, const std::pair<std::string, StallStats> &b)
+              { return a.second.park_ms_p99 > b.second.park_ms_p99; });
+
+    std::ostringstream out;
+    out << std::left << std::setw(24) << "function" << std::right //
+        << std::setw(8) << "count"                                //
+        << std::setw(10) << "ms p50"                              //
+        << std::setw(10) << "ms p90"                              //
+        << std::setw(10) << "ms p99"                              //
+        << std::setw(10) << "ms max"                              //
+        << std::setw(8) << "f p50"                                //
+        << std::setw(8) << "f p99"                                //
+        << std::setw(8) << "f max"                                //
+        << std::setw(8) << "bytes" << std::endl;
+    out << std::fixed << std::setprecision(2);
+    for (auto &row : table)
+    {
+        auto &s = row.second;
+        out << std::left << std::setw(24) << row.first << std::right //
+            << std::setw(8) << s.count                               //
+            << std::setw(10) << s.park_ms_p50                        //
+            << std::setw(10) << s.park_ms_p90                        //
+            << std::setw(10) << s.park_ms_p99                        //
+            << std::setw(10) << s.park_ms_max                        //
+            << std::setw(8) << s.frames_lost_p50                     //
+            << std::setw(8) << s.frames_lost_p99                     //
+            << std::setw(8) << s.frames_lost_max                     //
+            << std::setw(8) << s.code_size_max << std::endl;
+    }
+
+    return out.str();
+}
+
+void StallProfiler::Reset()
+{
+    EnterCriticalSection(&lock);
+    rings.clear();
+    LeaveCriticalSection(&lock);
+}
+
+} // namespace Pt
@@ -4,29 +4,243 @@
 namespace Pt
 {
 
-PvZ::PvZ()
+PvZ::PvZ() : freezer(this)
 {
     this->cb_find_result = nullptr;
     this->window = nullptr;
+    this->attached = false;
+    this->freeze_sun_id = 0;
+    this->freeze_money_id = 0;
+    this->freeze_endless_rounds_id = 0;
+
+    this->stop_waiting = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+    this->park_count = 0;
+    InitializeCriticalSection(&this->park_lock);
+
+    this->inject_quit = false;
+    InitializeCriticalSection(&this->inject_lock);
+    this->inject_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    this->inject_thread = CreateThread(nullptr, 0, inject_proc, this, 0, nullptr);
 
     // FindPvZ();
 }
 
 PvZ::~PvZ()
 {
+    if (this->inject_thread != nullptr)
+    {
+        // 在锁内设置, 之后的注入不再排队
+        EnterCriticalSection(&this->inject_lock);
+        this->inject_quit = true;
+        LeaveCriticalSection(&this->inject_lock);
+        SetEvent(this->inject_event);
+        WaitForSingleObject(this->inject_thread, INFINITE);
+        CloseHandle(this->inject_thread);
+    }
+    CloseHandle(this->inject_event);
+    DeleteCriticalSection(&this->inject_lock);
+    DeleteCriticalSection(&this->park_lock);
+    CloseHandle(this->stop_waiting);
+#ifdef _DEBUG
+    std::cout << profiler.Report();
+#endif
+}
+
+void PvZ::asm_code_inject(Code &code, const char *name)
+{
+    // 不持有 OperationLock, 排队期间其他线程的读写和注入照常进行
+    // 注入线程没有启动时直接在当前线程注入
+    if (this->inject_thread == nullptr)
+    {
+        inject(code, name);
+        return;
+    }
+
+    InjectJob job;
+    job.code = &code;
+    job.name = name;
+    job.done = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+    EnterCriticalSection(&this->inject_lock);
+    bool quit = this->inject_quit;
+    if (!quit)
+        this->inject_jobs.push_back(&job);
+    LeaveCriticalSection(&this->inject_lock);
+    if (quit)
+    {
+        CloseHandle(job.done);
+        return;
+    }
+    SetEvent(this->inject_event);
+
+    WaitForSingleObject(job.done, INFINITE);
+    CloseHandle(job.done);
 }
 
-void PvZ::asm_code_inject()
+DWORD WINAPI PvZ::inject_proc(LPVOID lpParam)
 {
-    // if (GameOn()) // 其他地方预先判断了, 这里其实不用
+    PvZ *pvz = (PvZ *)lpParam;
+
+    while (WaitForSingleObject(pvz->inject_event, INFINITE) == WAIT_OBJECT_0)
     {
+        while (true)
+        {
+            InjectJob *job = nullptr;
+            EnterCriticalSection(&pvz->inject_lock);
+            if (!pvz->inject_jobs.empty())
+            {
+                job = pvz->inject_jobs.front();
+                pvz->inject_jobs.pop_front();
+            }
+            LeaveCriticalSection(&pvz->inject_lock);
+
+            if (job == nullptr)
+                break;
+
+            // 退出时剩下的注入不再执行, 只通知等待者
+            if (!pvz->inject_quit)
+                pvz->inject(*job->code, job->name);
+            SetEvent(job->done);
+        }
+
+        if (pvz->inject_quit)
+            break;
+    }
+
+    return 0;
+}
+
+void PvZ::inject(Code &code, const char *name)
+{
+    // 在注入线程上不能调用 GameOn, 进程失效时直接丢弃
+    if (!IsValid())
+        return;
+
+    int frame_duration = ReadMemory<int>({data().lawn, data().frame_duration});
+
+    StallSample sample;
+    sample.code_size = code.asm_length();
+    sample.clock_before = ReadMemory<int>({data().lawn, data().board, data().game_clock});
+    double park_time = StallProfiler::Now();
+
+    park_main_loop();
+    {
+        // 注入期间不允许其他线程读写内存
+        ExclusiveLock guard(memory_lock);
+        code.asm_code_inject(this->handle);
+    }
+    resume_main_loop();
+
+    sample.park_ms = StallProfiler::Now() - park_time;
+    sample.clock_after = ReadMemory<int>({data().lawn, data().board, data().game_clock});
+
+    // 这段时间本该走过的帧数减去实际走过的帧数
+    int frames_expected = int(sample.park_ms / (std::max)(frame_duration, 1) + 0.5);
+    int frames_passed = sample.clock_after - sample.clock_before;
+    sample.frames_lost = (std::max)(frames_expected - frames_passed, 0);
+
+    profiler.Record(name, sample);
+}
+
+void PvZ::park_main_loop()
+{
+    // 在锁内等待, 其他线程返回时主循环一定已经停下
+    EnterCriticalSection(&this->park_lock);
+    if (this->park_count++ == 0)
+    {
+        int frame_duration = ReadMemory<int>({data().lawn, data().frame_duration});
         enable_hack(data().block_main_loop, true);
-        Sleep(GetFrameDuration() * 2);
-        Code::asm_code_inject(this->handle);
+        Sleep(frame_duration * 2);
+    }
+    LeaveCriticalSection(&this->park_lock);
+}
+
+void PvZ::resume_main_loop()
+{
+    EnterCriticalSection(&this->park_lock);
+    if (--this->park_count == 0)
         enable_hack(data().block_main_loop, false);
+    LeaveCriticalSection(&this->park_lock);
+}
+
+bool PvZ::WaitGameClock(int clock, HANDLE stop, DWORD timeout)
+{
+    uintptr_t lawn = data().lawn;
+    uintptr_t board = data().board;
+    uintptr_t game_clock = data().game_clock;
+    uintptr_t frame_duration_offset = data().frame_duration;
+
+    HANDLE events[2] = {this->stop_waiting, stop};
+    DWORD event_count = stop != nullptr ? 2 : 1;
+    DWORD start = GetTickCount();
+
+    while (true)
+    {
+        if (!IsValid())
+            return false;
+        int ui = GameUI();
+        if (ui != 2 && ui != 3)
+            return false;
+
+        int now = ReadMemory<int>({lawn, board, game_clock});
+        if (now >= clock)
+            return true;
+
+        // 游戏暂停时时钟不走, 超时返回
+        DWORD elapsed = GetTickCount() - start;
+        if (timeout != INFINITE && elapsed >= timeout)
+            return false;
+
+        // 离目标超过两帧时休眠到前一帧, 游戏卡顿或暂停时会多循环几次
+        int frame_duration = (std::max)(ReadMemory<int>({lawn, frame_duration_offset}), 1);
+        int frames = clock - now;
+        DWORD wait_ms = frames > 2 ? DWORD((frames - 1) * frame_duration) : 0;
+        if (timeout != INFINITE)
+            wait_ms = (std::min)(wait_ms, timeout - elapsed);
+        if (wait_ms > 0)
+        {
+            if (WaitForMultipleObjects(event_count, events, FALSE, wait_ms) != WAIT_TIMEOUT)
+                return false;
+        }
+        else
+        {
+            if (WaitForMultipleObjects(event_count, events, FALSE, 0) != WAIT_TIMEOUT)
+                return false;
+            SwitchToThread();
+        }
+    }
+}
+
+void PvZ::StopWaiting()
+{
+    SetEvent(this->stop_waiting);
+}
+
+void PvZ::SetGamePaused(bool paused)
+{
+    if (!IsValid() || GameUI() != 3)
+        return;
+
+    if (ReadMemory<bool>({data().lawn, data().board, data().game_paused}) != paused)
+    {
+        PostMessage(hwnd, WM_KEYDOWN, VK_SPACE, 0);
+        PostMessage(hwnd, WM_KEYUP, VK_SPACE, 0);
     }
 }
 
+std::string PvZ::StallReport()
+{
+    return profiler.Report();
+}
+
+BoardSnapshot PvZ::GetSnapshot(unsigned int pools)
+{
+    BoardSnapshot snapshot;
+    snapshot.Capture(*this, data(), layouts(), pools);
+    return snapshot;
+}
+
 #ifdef _DEBUG
 
 void PvZ::check_all_hacks()
@@ -112,9 +326,77 @@ void PvZ::callback(cb_func func, void *win)
     this->window = win;
 }
 
+void PvZ::detect_version()
+{
+    auto nth = 0x00400000 + ReadMemory<uintptr_t>({0x00400000 + 0x3c});
+    auto lcd = 0x00400000 + ReadMemory<uintptr_t>({nth + 0xc8});
+    std::string pdb;
+    if (lcd != (0x00400000 + 0))
+        pdb = ReadMemory<std::string>({lcd + ReadMemory<uintptr_t>({lcd}) + 0x18});
+    // std::cout << pdb << std::endl;
+    auto none = std::string::npos;
+    if (pdb.empty()                                                        //
+        || (pdb.find(".pdb") == none)                                      //
+        || (pdb.find("\\Lawn\\") == none && pdb.find("\\lawn\\") == none)) //
+    {
+        // 找到的可能是其他宝开游戏
+        this->find_result = PVZ_NOT_FOUND;
+    }
+    else
+    {
+        this->find_result = PVZ_UNSUPPORTED;
+    }
+
+    // version detection key value
+    std::vector<std::tuple<unsigned int, int>> v = {
+#ifdef _PVZ_BETA_LEAK_SUPPORT
+        {0x49359c21, PVZ_BETA_0_1_1_1014_EN}, //
+        {0x499a6204, PVZ_BETA_0_9_9_1029_EN}, //
+#endif
+        {0x49ecf563, PVZ_1_0_0_1051_EN},               //
+        {0x4a37d6af, PVZ_1_2_0_1065_EN},               //
+        {0x4a5b7963, PVZ_1_0_4_7924_ES},               //
+        {0x4c237519, PVZ_1_0_7_3556_ES},               //
+        {0x4ce4c3d6, PVZ_1_0_7_3467_RU},               //
+        {0x4c2e3453, PVZ_GOTY_1_2_0_1073_EN},          //
+        {0x4d02b058, PVZ_GOTY_1_2_0_1096_EN},          //
+        {0x4ca31baa, PVZ_GOTY_1_2_0_1093_DE_ES_FR_IT}, //
+        {0x4c563de1, PVZ_GOTY_1_1_0_1056_ZH},          //
+        {0x4cc8e5f8, PVZ_GOTY_1_1_0_1056_JA},          //
+        {0x4fcd7be2, PVZ_GOTY_1_1_0_1056_ZH_2012_06},  //
+        {0x5003d437, PVZ_GOTY_1_1_0_1056_ZH_2012_07},  //
+    };
+
+    auto time_compiled = ReadMemory<unsigned int>({nth + 0x08});
+    for (size_t j = 0; j < v.size(); j++)
+    {
+        auto [time_date_stamp, version_name] = v[j];
+        if (time_compiled == time_date_stamp)
+        {
+            this->find_result = version_name;
+            break;
+        }
+    }
+}
+
+// 锁定项的地址和版本相关, 换游戏时清除
+void PvZ::clear_freeze()
+{
+    freezer.Clear();
+    freeze_sun_id = 0;
+    freeze_money_id = 0;
+    freeze_endless_rounds_id = 0;
+    freeze_slot_ids.clear();
+}
+
 bool PvZ::FindPvZ()
 {
+    MutexLock operation(operation_lock);
+
     this->find_result = PVZ_NOT_FOUND;
+    this->attached = false;
+
+    clear_freeze();
 
     std::vector<std::wstring> pvz_titles = {
 #ifdef _PVZ_BETA_LEAK_SUPPORT
@@ -146,55 +428,7 @@ bool PvZ::FindPvZ()
         {
             if (IsValid())
             {
-                auto nth = 0x00400000 + ReadMemory<uintptr_t>({0x00400000 + 0x3c});
-                auto lcd = 0x00400000 + ReadMemory<uintptr_t>({nth + 0xc8});
-                std::string pdb;
-                if (lcd != (0x00400000 + 0))
-                    pdb = ReadMemory<std::string>({lcd + ReadMemory<uintptr_t>({lcd}) + 0x18});
-                // std::cout << pdb << std::endl;
-                auto none = std::string::npos;
-                if (pdb.empty()                                                        //
-                    || (pdb.find(".pdb") == none)                                      //
-                    || (pdb.find("\\Lawn\\") == none && pdb.find("\\lawn\\") == none)) //
-                {
-                    // 找到的可能是其他宝开游戏
-                    this->find_result = PVZ_NOT_FOUND;
-                }
-                else
-                {
-                    this->find_result = PVZ_UNSUPPORTED;
-                }
-
-                // version detection key value
-                std::vector<std::tuple<unsigned int, int>> v = {
-#ifdef _PVZ_BETA_LEAK_SUPPORT
-                    {0x49359c21, PVZ_BETA_0_1_1_1014_EN}, //
-                    {0x499a6204, PVZ_BETA_0_9_9_1029_EN}, //
-#endif
-                    {0x49ecf563, PVZ_1_0_0_1051_EN},               //
-                    {0x4a37d6af, PVZ_1_2_0_1065_EN},               //
-                    {0x4a5b7963, PVZ_1_0_4_7924_ES},               //
-                    {0x4c237519, PVZ_1_0_7_3556_ES},               //
-                    {0x4ce4c3d6, PVZ_1_0_7_3467_RU},               //
-                    {0x4c2e3453, PVZ_GOTY_1_2_0_1073_EN},          //
-                    {0x4d02b058, PVZ_GOTY_1_2_0_1096_EN},          //
-                    {0x4ca31baa, PVZ_GOTY_1_2_0_1093_DE_ES_FR_IT}, //
-                    {0x4c563de1, PVZ_GOTY_1_1_0_1056_ZH},          //
-                    {0x4cc8e5f8, PVZ_GOTY_1_1_0_1056_JA},          //
-                    {0x4fcd7be2, PVZ_GOTY_1_1_0_1056_ZH_2012_06},  //
-                    {0x5003d437, PVZ_GOTY_1_1_0_1056_ZH_2012_07},  //
-                };
-
-                auto time_compiled = ReadMemory<unsigned int>({nth + 0x08});
-                for (size_t j = 0; j < v.size(); j++)
-                {
-                    auto [time_date_stamp, version_name] = v[j];
-                    if (time_compiled == time_date_stamp)
-                    {
-                        this->find_result = version_name;
-                        break;
-                    }
-                }
+                detect_version();
             }
             else // 没权限拿不到进程句柄
             {
@@ -219,13 +453,7 @@ bool PvZ::FindPvZ()
                      && this->find_result != PVZ_UNSUPPORTED;
 
     if (!supported)
-    {
-        if (IsValid())
-            CloseHandle(this->handle);
-        this->hwnd = nullptr;
-        this->pid = 0;
-        this->handle = nullptr;
-    }
+        OpenByHwnd(nullptr); // 关闭句柄
 
 #ifdef _DEBUG
     if (supported)
@@ -241,6 +469,38 @@ bool PvZ::FindPvZ()
     return supported;
 }
 
+bool PvZ::AttachPvZ(HWND hwnd)
+{
+    MutexLock operation(operation_lock);
+
+    this->find_result = PVZ_NOT_FOUND;
+    this->attached = true;
+
+    clear_freeze();
+
+    if (OpenByHwnd(hwnd) && IsValid())
+        detect_version();
+    else
+        this->find_result = PVZ_OPEN_ERROR;
+
+    bool supported = this->find_result != PVZ_NOT_FOUND     //
+                     && this->find_result != PVZ_OPEN_ERROR //
+                     && this->find_result != PVZ_UNSUPPORTED;
+
+    if (!supported)
+        OpenByHwnd(nullptr); // 关闭句柄
+
+    return supported;
+}
+
+// 当前线程是否为后台线程
+static thread_local bool background_thread = false;
+
+void PvZ::BackgroundThread()
+{
+    background_thread = true;
+}
+
 bool PvZ::GameOn()
 {
     bool on = this->find_result != PVZ_NOT_FOUND      //
@@ -254,7 +514,7 @@ bool PvZ::GameOn()
         std::wcout << L"游戏已经打开, 可以修改." << std::endl;
 #endif
     }
-    else
+    else if (!attached && !background_thread)
     {
         on = FindPvZ();
 #ifdef _DEBUG
@@ -293,6 +553,11 @@ int PvZ::GetScene()
 
 void PvZ::SetScene(int scene, bool reset)
 {
+    MutexLock operation(operation_lock);
+
+    // 在跳转到 reset_scene 之前声明, 三段注入共用
+    Code code;
+
     if (scene < 0 || scene > 5)
         return;
 
@@ -333,19 +598,19 @@ void PvZ::SetScene(int scene, bool reset)
     }
 #endif
 
-    asm_init();
-    asm_mov_exx_dword_ptr(Reg::ESI, data().lawn);
-    asm_mov_exx_dword_ptr_exx_add(Reg::ESI, data().board);
-    asm_add_list({0xc7, 0x86});  // mov [esi+0000554C],scene
-    asm_add_dword(data().scene); //
-    asm_add_dword(scene);        //
+    code.asm_init();
+    code.asm_mov_exx_dword_ptr(Reg::ESI, data().lawn);
+    code.asm_mov_exx_dword_ptr_exx_add(Reg::ESI, data().board);
+    code.asm_add_list({0xc7, 0x86});  // mov [esi+0000554C],scene
+    code.asm_add_dword(data().scene); //
+    code.asm_add_dword(scene);        //
 #ifdef _PVZ_BETA_LEAK_SUPPORT
     if (isBETA())
-        asm_mov_exx_exx(Reg::ECX, Reg::ESI);
+        code.asm_mov_exx_exx(Reg::ECX, Reg::ESI);
 #endif
-    asm_call(data().call_pick_background);
-    asm_ret();
-    asm_code_inject();
+    code.asm_call(data().call_pick_background);
+    code.asm_ret();
+    asm_code_inject(code, __func__);
 
 #ifdef _PVZ_BETA_LEAK_SUPPORT
     if (isBETA())
@@ -404,33 +669,30 @@ void PvZ::SetScene(int scene, bool reset)
     // 泳池和雾夜仍然保留水波光
     if (scene != 2 && scene != 3)
     {
-        unsigned int particle_system_struct_size = 0x2c;
-        asm_init();
-        auto particle_system_offset = ReadMemory<uintptr_t>({data().lawn, data().anim, data().unnamed, data().particle_system});
-        auto particle_system_count_max = ReadMemory<uintptr_t>({data().lawn, data().anim, data().unnamed, data().particle_system_count_max});
-        for (size_t i = 0; i < particle_system_count_max; i++)
+        auto snapshot = GetSnapshot(SNAPSHOT_PARTICLE_SYSTEM);
+        auto &particle_systems = snapshot.particle_systems;
+        code.asm_init();
+        for (size_t i = 0; i < particle_systems.alive.size(); i++)
         {
-            auto particle_system_type = ReadMemory<int>({particle_system_offset + data().particle_system_type + particle_system_struct_size * i});
-            auto particle_system_dead = ReadMemory<bool>({particle_system_offset + data().particle_system_dead + particle_system_struct_size * i});
-            if (!particle_system_dead && particle_system_type == 34)
+            if (particle_systems.alive[i] && particle_systems.type[i] == 34)
             {
-                uintptr_t addr = particle_system_offset + particle_system_struct_size * i;
+                uintptr_t addr = snapshot.particle_system_pool.address(i);
 #ifdef _PVZ_BETA_LEAK_SUPPORT
                 if (isBETA())
-                    asm_mov_exx(Reg::ECX, addr);
+                    code.asm_mov_exx(Reg::ECX, addr);
                 else
 #endif
-                    asm_push_dword(addr);
-                asm_call(data().call_delete_particle_system);
+                    code.asm_push_dword(addr);
+                code.asm_call(data().call_delete_particle_system);
             }
         }
-        asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
-        asm_add_list({0xc7, 0x80});                  // mov [eax+00005620],00000000
-        asm_add_dword(data().particle_systems_addr); //
-        asm_add_dword(0);                            //
-        asm_ret();
-        asm_code_inject();
+        code.asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
+        code.asm_add_list({0xc7, 0x80});                  // mov [eax+00005620],00000000
+        code.asm_add_dword(data().particle_systems_addr); //
+        code.asm_add_dword(0);                            //
+        code.asm_ret();
+        asm_code_inject(code, __func__);
     }
 
     SetMusic(music_id);
@@ -438,22 +700,22 @@ void PvZ::SetScene(int scene, bool reset)
 reset_scene:
     if (reset)
     {
-        asm_init();
-        asm_mov_exx_dword_ptr(Reg::EDI, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EDI, data().board);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EDI, data().challenge);
-        asm_add_list({0xff, 0x8f}); // dec [edi+0000006c]
-        asm_add_dword(data().endless_rounds);
+        code.asm_init();
+        code.asm_mov_exx_dword_ptr(Reg::EDI, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EDI, data().board);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EDI, data().challenge);
+        code.asm_add_list({0xff, 0x8f}); // dec [edi+0000006c]
+        code.asm_add_dword(data().endless_rounds);
         if (this->find_result == PVZ_GOTY_1_1_0_1056_ZH || //
             this->find_result == PVZ_GOTY_1_1_0_1056_JA)
-            asm_push_exx(Reg::EDI);
+            code.asm_push_exx(Reg::EDI);
 #ifdef _PVZ_BETA_LEAK_SUPPORT
         if (isBETA())
-            asm_mov_exx_exx(Reg::ECX, Reg::EDI);
+            code.asm_mov_exx_exx(Reg::ECX, Reg::EDI);
 #endif
-        asm_call(data().call_puzzle_next_stage_clear);
-        asm_ret();
-        asm_code_inject();
+        code.asm_call(data().call_puzzle_next_stage_clear);
+        code.asm_ret();
+        asm_code_inject(code, __func__);
     }
 }
 
@@ -467,6 +729,8 @@ int PvZ::GetRowCount()
 
 void PvZ::UnlockTrophy()
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -614,16 +878,16 @@ void PvZ::UnlockTrophy()
     if (adventure_playthrough == 0 && GameUI() == 1)
     {
         // TODO 只能在主界面
-        asm_init();
-        asm_push_byte(1); // 显示 Loading
-        asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().game_selector);
+        Code code;
+        code.asm_push_byte(1); // 显示 Loading
+        code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().game_selector);
         if (this->find_result == PVZ_GOTY_1_1_0_1056_ZH || //
             this->find_result == PVZ_GOTY_1_1_0_1056_JA)
-            asm_mov_exx_exx(Reg::ESI, Reg::ECX);
-        asm_call(data().call_sync_profile);
-        asm_ret();
-        asm_code_inject();
+            code.asm_mov_exx_exx(Reg::ESI, Reg::ECX);
+        code.asm_call(data().call_sync_profile);
+        code.asm_ret();
+        asm_code_inject(code, __func__);
     }
 }
 
@@ -639,52 +903,59 @@ void PvZ::DirectWin(bool brightest_cob_cannon)
     int mode = GameMode();
     bool light_cob = brightest_cob_cannon && 1 <= mode && mode <= 15;
 
+    // 等待期间不持有 OperationLock, 界面轮询和其他线程不会被卡住几秒
+    bool reached = true;
     if (light_cob)
     {
         int game_clock = ReadMemory<int>({data().lawn, data().board, data().game_clock});
         int frame_to_wait = 75 - ((game_clock + 500) % 75);
+
+        // 正常速度下最多等 75 帧, 留出余量, 中途被手动暂停或者回到菜单时不会一直等下去
+        DWORD timeout = DWORD(frame_to_wait * (std::max)(frame_time, 1) * 2 + 1000);
         if (ReadMemory<bool>({data().lawn, data().board, data().game_paused}))
         {
             if (frame_to_wait != 0)
             {
-                // 解除暂停
-                PostMessage(hwnd, WM_KEYDOWN, VK_SPACE, 0);
-                PostMessage(hwnd, WM_KEYUP, VK_SPACE, 0);
-                Sleep(frame_to_wait * frame_time);
-                // 暂停
-                PostMessage(hwnd, WM_KEYDOWN, VK_SPACE, 0);
-                PostMessage(hwnd, WM_KEYUP, VK_SPACE, 0);
+                SetGamePaused(false);
+                reached = WaitGameClock(game_clock + frame_to_wait, nullptr, timeout);
             }
         }
         else
         {
-            Sleep(frame_to_wait * frame_time);
-            // 暂停
-            PostMessage(hwnd, WM_KEYDOWN, VK_SPACE, 0);
-            PostMessage(hwnd, WM_KEYUP, VK_SPACE, 0);
+            reached = WaitGameClock(game_clock + frame_to_wait, nullptr, timeout);
         }
+    }
+
+    // 只在暂停和注入时持有
+    MutexLock operation(operation_lock);
+
+    if (light_cob)
+    {
+        SetGamePaused(true);
+        if (!reached)
+            return;
         Sleep(frame_time);
     }
 
     if (this->find_result == PVZ_GOTY_1_1_0_1056_ZH || //
         this->find_result == PVZ_GOTY_1_1_0_1056_JA)
     {
-        asm_init();
-        asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
-        asm_push_exx(Reg::EAX);
-        asm_call(data().call_fade_out_level);
-        asm_ret();
-        asm_code_inject();
+        Code code;
+        code.asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
+        code.asm_push_exx(Reg::EAX);
+        code.asm_call(data().call_fade_out_level);
+        code.asm_ret();
+        asm_code_inject(code, __func__);
     }
     else
     {
-        asm_init();
-        asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
-        asm_call(data().call_fade_out_level);
-        asm_ret();
-        asm_code_inject();
+        Code code;
+        code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
+        code.asm_call(data().call_fade_out_level);
+        code.asm_ret();
+        asm_code_inject(code, __func__);
     }
 
     if (light_cob)
@@ -739,6 +1010,82 @@ void PvZ::SetMoney(int money)
         WriteMemory<int>(money, {data().lawn, data().user_data, data().money});
 }
 
+// 已经锁定时只修改数值
+static void freeze_toggle(FreezeTable &freezer, int &id, bool on, const FreezeEntry &entry)
+{
+    if (on && id != 0)
+    {
+        freezer.Set(id, entry.value);
+    }
+    else if (on)
+    {
+        id = freezer.Add(entry);
+    }
+    else if (id != 0)
+    {
+        freezer.Remove(id);
+        id = 0;
+    }
+}
+
+void PvZ::FreezeSun(bool on, int sun)
+{
+    MutexLock operation(operation_lock);
+
+    if (!GameOn())
+        return;
+
+    freeze_toggle(freezer, freeze_sun_id, on, {{data().lawn, data().board, data().sun}, FREEZE_INT32, FREEZE_EXACT, double(sun)});
+}
+
+void PvZ::FreezeMoney(bool on, int money)
+{
+    MutexLock operation(operation_lock);
+
+    if (!GameOn())
+        return;
+
+    freeze_toggle(freezer, freeze_money_id, on, {{data().lawn, data().user_data, data().money}, FREEZE_INT32, FREEZE_EXACT, double(money)});
+}
+
+void PvZ::FreezeEndlessRounds(bool on, int level)
+{
+    MutexLock operation(operation_lock);
+
+    if (!GameOn())
+        return;
+
+    freeze_toggle(freezer, freeze_endless_rounds_id, on, {{data().lawn, data().board, data().challenge, data().endless_rounds}, FREEZE_INT32, FREEZE_EXACT, double(level)});
+}
+
+void PvZ::FreezeSlotCooldowns(bool on)
+{
+    MutexLock operation(operation_lock);
+
+    if (!GameOn())
+        return;
+
+    for (auto id : freeze_slot_ids)
+        freezer.Remove(id);
+    freeze_slot_ids.clear();
+
+    if (!on || GameUI() != 3)
+        return;
+
+    // 冷却进度不低于冷却时间, 卡片用掉后下一帧就恢复
+    // 冷却时间每次检查时重新读取, 换卡或者模仿者变身后跟着变
+    unsigned int slot_seed_struct_size = data().slot_seed_struct_size;
+    auto slot_offset = ReadMemory<uintptr_t>({data().lawn, data().board, data().slot});
+    auto slot_count = ReadMemory<uint32_t>({slot_offset + data().slot_count});
+    for (size_t i = 0; i < slot_count && i < 10; i++)
+    {
+        uintptr_t offset = slot_seed_struct_size * i;
+        FreezeEntry entry = {{data().lawn, data().board, data().slot, data().slot_seed_cd_past + offset}, FREEZE_INT32, FREEZE_MIN, 0.0,
+                             {data().lawn, data().board, data().slot, data().slot_seed_cd_total + offset}};
+        freeze_slot_ids.push_back(freezer.Add(entry));
+    }
+}
+
 void PvZ::AutoCollected(bool on)
 {
     if (!GameOn())
@@ -757,6 +1104,8 @@ void PvZ::NotDropLoot(bool on)
 
 void PvZ::FertilizerUnlimited(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -767,6 +1116,8 @@ void PvZ::FertilizerUnlimited(bool on)
 
 void PvZ::BugSprayUnlimited(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -777,6 +1128,8 @@ void PvZ::BugSprayUnlimited(bool on)
 
 void PvZ::ChocolateUnlimited(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -787,6 +1140,8 @@ void PvZ::ChocolateUnlimited(bool on)
 
 void PvZ::TreeFoodUnlimited(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -803,6 +1158,8 @@ void PvZ::TreeFoodUnlimited(bool on)
 
 void PvZ::SetTreeHeight(int height)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -824,35 +1181,35 @@ void PvZ::SetTreeHeight(int height)
             if (this->find_result == PVZ_GOTY_1_1_0_1056_ZH || //
                 this->find_result == PVZ_GOTY_1_1_0_1056_JA)
             {
-                asm_init();
-                asm_mov_exx_dword_ptr(Reg::EBX, data().lawn);
-                asm_mov_exx_dword_ptr_exx_add(Reg::EBX, data().board);
-                asm_mov_exx_dword_ptr_exx_add(Reg::EBX, data().challenge);
-                asm_push_exx(Reg::EBX);
-                asm_call(data().call_wisdom_tree);
-                asm_ret();
-                asm_code_inject();
+                Code code;
+                code.asm_mov_exx_dword_ptr(Reg::EBX, data().lawn);
+                code.asm_mov_exx_dword_ptr_exx_add(Reg::EBX, data().board);
+                code.asm_mov_exx_dword_ptr_exx_add(Reg::EBX, data().challenge);
+                code.asm_push_exx(Reg::EBX);
+                code.asm_call(data().call_wisdom_tree);
+                code.asm_ret();
+                asm_code_inject(code, __func__);
             }
             else if (this->find_result == PVZ_GOTY_1_1_0_1056_ZH_2012_06 || //
                      this->find_result == PVZ_GOTY_1_1_0_1056_ZH_2012_07)
             {
-                asm_init();
-                asm_mov_exx_dword_ptr(Reg::EDI, data().lawn);
-                asm_mov_exx_dword_ptr_exx_add(Reg::EDI, data().board);
-                asm_mov_exx_dword_ptr_exx_add(Reg::EDI, data().challenge);
-                asm_call(data().call_wisdom_tree);
-                asm_ret();
-                asm_code_inject();
+                Code code;
+                code.asm_mov_exx_dword_ptr(Reg::EDI, data().lawn);
+                code.asm_mov_exx_dword_ptr_exx_add(Reg::EDI, data().board);
+                code.asm_mov_exx_dword_ptr_exx_add(Reg::EDI, data().challenge);
+                code.asm_call(data().call_wisdom_tree);
+                code.asm_ret();
+                asm_code_inject(code, __func__);
             }
             else
             {
-                asm_init();
-                asm_mov_exx_dword_ptr(Reg::ESI, data().lawn);
-                asm_mov_exx_dword_ptr_exx_add(Reg::ESI, data().board);
-                asm_mov_exx_dword_ptr_exx_add(Reg::ESI, data().challenge);
-                asm_call(data().call_wisdom_tree);
-                asm_ret();
-                asm_code_inject();
+                Code code;
+                code.asm_mov_exx_dword_ptr(Reg::ESI, data().lawn);
+                code.asm_mov_exx_dword_ptr_exx_add(Reg::ESI, data().board);
+                code.asm_mov_exx_dword_ptr_exx_add(Reg::ESI, data().challenge);
+                code.asm_call(data().call_wisdom_tree);
+                code.asm_ret();
+                asm_code_inject(code, __func__);
             }
         }
         else
@@ -860,22 +1217,22 @@ void PvZ::SetTreeHeight(int height)
 #ifdef _PVZ_BETA_LEAK_SUPPORT
             if (this->find_result == PVZ_BETA_0_9_9_1029_EN)
             {
-                asm_init();
-                asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-                asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
-                asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().challenge);
-                asm_call(data().call_wisdom_tree);
-                asm_ret();
-                asm_code_inject();
+                Code code;
+                code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+                code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
+                code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().challenge);
+                code.asm_call(data().call_wisdom_tree);
+                code.asm_ret();
+                asm_code_inject(code, __func__);
             }
             else
 #endif
             {
-                asm_init();
-                asm_mov_exx(Reg::EDI, data().lawn);
-                asm_call(data().call_wisdom_tree);
-                asm_ret();
-                asm_code_inject();
+                Code code;
+                code.asm_mov_exx(Reg::EDI, data().lawn);
+                code.asm_call(data().call_wisdom_tree);
+                code.asm_ret();
+                asm_code_inject(code, __func__);
             }
         }
     }
@@ -888,6 +1245,8 @@ void PvZ::SetTreeHeight(int height)
 
 void PvZ::FreePlanting(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -896,19 +1255,35 @@ void PvZ::FreePlanting(bool on)
     if (GameUI() != 3)
         return;
 
-    unsigned int slot_seed_struct_size = 0x50;
-
+    // 卡槽按对象池处理, 整块读取后一次写回所有冷却
     auto slot_offset = ReadMemory<uintptr_t>({data().lawn, data().board, data().slot});
     auto slot_count = ReadMemory<uint32_t>({slot_offset + data().slot_count});
+    if (slot_offset == 0 || slot_count > 10)
+        return;
+
+    auto layout = layouts().seed_slot;
+    PoolImage slots;
+    slots.base = slot_offset;
+    slots.count_max = slot_count;
+    slots.stride = layout.size;
+    slots.raw.resize(slots.stride * (slot_count + 1)); // 字段偏移包含卡槽数组之前的部分
+    if (!ReadMemoryBlock(slots.raw.data(), slots.raw.size(), {slots.base}))
+        return;
+
+    auto seeds = slots.view<SeedSlotView>(layout);
     for (size_t i = 0; i < slot_count; i++)
-    {
-        int slot_seed_cd_total = ReadMemory<int>({slot_offset + data().slot_seed_cd_total + slot_seed_struct_size * i});
-        WriteMemory<int>(slot_seed_cd_total, {slot_offset + data().slot_seed_cd_past + slot_seed_struct_size * i});
-    }
+        slots.set<int>(i, layout.cd_past, seeds[i].cd_total());
+
+    // 各卡槽的冷却字段不相接, 暂停主循环后合并成一次写入
+    park_main_loop();
+    slots.commit(*this, SNAPSHOT_PARKED_GAP);
+    resume_main_loop();
 }
 
 void PvZ::PlacedAnywhere(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -927,6 +1302,8 @@ void PvZ::FastBelt(bool on)
 
 void PvZ::LockShovel(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -950,6 +1327,8 @@ void PvZ::LockShovel(bool on)
 
 void PvZ::MixMode(int mode, int level)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
     int ui = GameUI();
@@ -966,6 +1345,8 @@ void PvZ::MixMode(int mode, int level)
 
 void PvZ::EndlessRounds(int level)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
     int ui = GameUI();
@@ -980,73 +1361,74 @@ void PvZ::EndlessRounds(int level)
     }
 }
 
-void PvZ::asm_put_plant(int row, int col, int type, bool imitater, bool iz_style)
+void PvZ::asm_put_plant(Code &code, int row, int col, int type, bool imitater, bool iz_style)
 {
     if (imitater)
     {
-        asm_push_dword(type);
-        asm_push_dword(48);
+        code.asm_push_dword(type);
+        code.asm_push_dword(48);
     }
     else
     {
-        asm_push_dword(-1);
-        asm_push_dword(type);
+        code.asm_push_dword(-1);
+        code.asm_push_dword(type);
     }
 #ifdef _PVZ_BETA_LEAK_SUPPORT
     if (isBETA())
     {
-        asm_push_dword(row);
-        asm_push_dword(col);
-        asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
+        code.asm_push_dword(row);
+        code.asm_push_dword(col);
+        code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
     }
     else
 #endif
     {
-        asm_mov_exx(Reg::EAX, row);
-        asm_push_dword(col);
-        asm_mov_exx_dword_ptr(Reg::EBP, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EBP, data().board);
-        asm_push_exx(Reg::EBP);
+        code.asm_mov_exx(Reg::EAX, row);
+        code.asm_push_dword(col);
+        code.asm_mov_exx_dword_ptr(Reg::EBP, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EBP, data().board);
+        code.asm_push_exx(Reg::EBP);
     }
-    asm_call(data().call_put_plant);
+    code.asm_call(data().call_put_plant);
 
     // 多余的过程是为了让 eax 值为目标植物的地址以供后续的布阵函数使用
 
     if (imitater)
     {
-        asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().plant);
-        asm_mov_exx_dword_ptr(Reg::EBX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EBX, data().board);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EBX, data().plant_next_pos);
-        asm_add_list(0x69, 0xdb, 0x4c, 0x01, 0x00, 0x00); // imul ebx,ebx,plant_struct_size
-        asm_add_list(0x01, 0xd9);                         // add ecx,ebx
-        asm_push_exx(Reg::ECX);
-        asm_mov_exx_exx(Reg::ESI, Reg::EAX);
+        code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().plant);
+        code.asm_mov_exx_dword_ptr(Reg::EBX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EBX, data().board);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EBX, data().plant_next_pos);
+        code.asm_add_list(0x69, 0xdb);                         // imul ebx,ebx,plant_struct_size
+        code.asm_add_dword(data().plant_struct_size);
+        code.asm_add_list(0x01, 0xd9);                         // add ecx,ebx
+        code.asm_push_exx(Reg::ECX);
+        code.asm_mov_exx_exx(Reg::ESI, Reg::EAX);
 #ifdef _PVZ_BETA_LEAK_SUPPORT
         if (isBETA())
-            asm_mov_exx_exx(Reg::ECX, Reg::EAX);
+            code.asm_mov_exx_exx(Reg::ECX, Reg::EAX);
 #endif
-        asm_call(data().call_put_plant_imitater);
-        asm_pop_exx(Reg::ECX);
-        asm_mov_exx_exx(Reg::EAX, Reg::ECX);
+        code.asm_call(data().call_put_plant_imitater);
+        code.asm_pop_exx(Reg::ECX);
+        code.asm_mov_exx_exx(Reg::EAX, Reg::ECX);
     }
 
     if (iz_style)
     {
-        asm_mov_exx_exx(Reg::ESI, Reg::EAX);
-        asm_push_exx(Reg::EAX);
-        asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().challenge);
+        code.asm_mov_exx_exx(Reg::ESI, Reg::EAX);
+        code.asm_push_exx(Reg::EAX);
+        code.asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().challenge);
 #ifdef _PVZ_BETA_LEAK_SUPPORT
         if (isBETA())
-            asm_mov_exx_exx(Reg::ECX, Reg::EAX);
+            code.asm_mov_exx_exx(Reg::ECX, Reg::EAX);
 #endif
-        asm_call(data().call_put_plant_iz_style);
-        asm_mov_exx_exx(Reg::EAX, Reg::ESI);
+        code.asm_call(data().call_put_plant_iz_style);
+        code.asm_mov_exx_exx(Reg::EAX, Reg::ESI);
     }
 }
 
@@ -1063,58 +1445,58 @@ void PvZ::PutPlant(int row, int col, int type, bool imitater)
     int width = (type == 47 ? 2 : 1);     // 玉米加农炮宽度两列
     int mode = GameMode();
     bool iz_style = (mode >= 61 && mode <= 70);
-    asm_init();
+    Code code;
     if (row == -1 && col == -1)
         for (int r = 0; r < row_count; r++)
             for (int c = 0; c < col_count; c += width)
-                asm_put_plant(r, c, type, imitater, iz_style);
+                asm_put_plant(code, r, c, type, imitater, iz_style);
     else if (row != -1 && col == -1)
         for (int c = 0; c < col_count; c += width)
-            asm_put_plant(row, c, type, imitater, iz_style);
+            asm_put_plant(code, row, c, type, imitater, iz_style);
     else if (row == -1 && col != -1)
         for (int r = 0; r < row_count; r++)
-            asm_put_plant(r, col, type, imitater, iz_style);
+            asm_put_plant(code, r, col, type, imitater, iz_style);
     else
-        asm_put_plant(row, col, type, imitater, iz_style);
-    asm_ret();
-    asm_code_inject();
+        asm_put_plant(code, row, col, type, imitater, iz_style);
+    code.asm_ret();
+    asm_code_inject(code, __func__);
 }
 
-void PvZ::asm_put_zombie(int row, int col, int type)
+void PvZ::asm_put_zombie(Code &code, int row, int col, int type)
 {
     if (this->find_result == PVZ_GOTY_1_1_0_1056_ZH || //
         this->find_result == PVZ_GOTY_1_1_0_1056_JA)
     {
-        asm_push_dword(type); // 0x6a byte(type)
-        asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().challenge);
-        asm_push_exx(Reg::ECX);
-        asm_mov_exx(Reg::EAX, row);
-        asm_mov_exx(Reg::ECX, col);
-        asm_call(data().call_put_zombie);
+        code.asm_push_dword(type); // 0x6a byte(type)
+        code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().challenge);
+        code.asm_push_exx(Reg::ECX);
+        code.asm_mov_exx(Reg::EAX, row);
+        code.asm_mov_exx(Reg::ECX, col);
+        code.asm_call(data().call_put_zombie);
     }
 #ifdef _PVZ_BETA_LEAK_SUPPORT
     else if (isBETA())
     {
-        asm_push_dword(row);
-        asm_push_dword(col);
-        asm_push_dword(type);
-        asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().challenge);
-        asm_call(data().call_put_zombie);
+        code.asm_push_dword(row);
+        code.asm_push_dword(col);
+        code.asm_push_dword(type);
+        code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().challenge);
+        code.asm_call(data().call_put_zombie);
     }
 #endif
     else
     {
-        asm_push_dword(col);
-        asm_push_dword(type);
-        asm_mov_exx(Reg::EAX, row);
-        asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().challenge);
-        asm_call(data().call_put_zombie);
+        code.asm_push_dword(col);
+        code.asm_push_dword(type);
+        code.asm_mov_exx(Reg::EAX, row);
+        code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().challenge);
+        code.asm_call(data().call_put_zombie);
     }
 }
 
@@ -1128,80 +1510,80 @@ void PvZ::PutZombie(int row, int col, int type)
 
     if (type == 25) // 僵王
     {
-        asm_init();
+        Code code;
 #ifdef _PVZ_BETA_LEAK_SUPPORT
         if (isBETA())
         {
-            asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-            asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
-            asm_push_dword(0);
-            asm_push_dword(0);
-            asm_push_dword(25);
+            code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+            code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
+            code.asm_push_dword(0);
+            code.asm_push_dword(0);
+            code.asm_push_dword(25);
         }
         else
 #endif
         {
-            asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
-            asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
-            asm_push_dword(0);
-            asm_push_dword(25);
+            code.asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
+            code.asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
+            code.asm_push_dword(0);
+            code.asm_push_dword(25);
         }
-        asm_call(data().call_put_zombie_in_row);
-        asm_ret();
-        asm_code_inject();
+        code.asm_call(data().call_put_zombie_in_row);
+        code.asm_ret();
+        asm_code_inject(code, __func__);
         return;
     }
     int row_count = GetRowCount();
     int col_count = 9;
-    asm_init();
+    Code code;
     if (row == -1 && col == -1)
         for (int r = 0; r < row_count; r++)
             for (int c = 0; c < col_count; c++)
-                asm_put_zombie(r, c, type);
+                asm_put_zombie(code, r, c, type);
     else if (row != -1 && col == -1)
         for (int c = 0; c < col_count; c++)
-            asm_put_zombie(row, c, type);
+            asm_put_zombie(code, row, c, type);
     else if (row == -1 && col != -1)
         for (int r = 0; r < row_count; r++)
-            asm_put_zombie(r, col, type);
+            asm_put_zombie(code, r, col, type);
     else
-        asm_put_zombie(row, col, type);
-    asm_ret();
-    asm_code_inject();
+        asm_put_zombie(code, row, col, type);
+    code.asm_ret();
+    asm_code_inject(code, __func__);
 }
 
-void PvZ::asm_put_grave(int row, int col)
+void PvZ::asm_put_grave(Code &code, int row, int col)
 {
     if (isGOTY())
     {
-        asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().challenge);
-        asm_push_exx(Reg::ECX);
-        asm_mov_exx(Reg::EDI, row);
-        asm_mov_exx(Reg::EBX, col);
-        asm_call(data().call_put_grave);
+        code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().challenge);
+        code.asm_push_exx(Reg::ECX);
+        code.asm_mov_exx(Reg::EDI, row);
+        code.asm_mov_exx(Reg::EBX, col);
+        code.asm_call(data().call_put_grave);
     }
 #ifdef _PVZ_BETA_LEAK_SUPPORT
     else if (isBETA())
     {
-        asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().challenge);
-        asm_push_dword(row);
-        asm_push_dword(col);
-        asm_call(data().call_put_grave);
+        code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().challenge);
+        code.asm_push_dword(row);
+        code.asm_push_dword(col);
+        code.asm_call(data().call_put_grave);
     }
 #endif
     else
     {
-        asm_mov_exx_dword_ptr(Reg::EDX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EDX, data().board);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EDX, data().challenge);
-        asm_push_exx(Reg::EDX);
-        asm_mov_exx(Reg::EDI, row);
-        asm_mov_exx(Reg::EBX, col);
-        asm_call(data().call_put_grave);
+        code.asm_mov_exx_dword_ptr(Reg::EDX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EDX, data().board);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EDX, data().challenge);
+        code.asm_push_exx(Reg::EDX);
+        code.asm_mov_exx(Reg::EDI, row);
+        code.asm_mov_exx(Reg::EBX, col);
+        code.asm_call(data().call_put_grave);
     }
 }
 
@@ -1215,42 +1597,42 @@ void PvZ::PutGrave(int row, int col)
 
     int row_count = GetRowCount();
     int col_count = 9;
-    asm_init();
+    Code code;
     if (row == -1 && col == -1)
         for (int r = 0; r < row_count; r++)
             for (int c = 0; c < col_count; c++)
-                asm_put_grave(r, c);
+                asm_put_grave(code, r, c);
     else if (row != -1 && col == -1)
         for (int c = 0; c < col_count; c++)
-            asm_put_grave(row, c);
+            asm_put_grave(code, row, c);
     else if (row == -1 && col != -1)
         for (int r = 0; r < row_count; r++)
-            asm_put_grave(r, col);
+            asm_put_grave(code, r, col);
     else
-        asm_put_grave(row, col);
-    asm_ret();
-    asm_code_inject();
+        asm_put_grave(code, row, col);
+    code.asm_ret();
+    asm_code_inject(code, __func__);
 }
 
-void PvZ::asm_put_ladder(int row, int col)
+void PvZ::asm_put_ladder(Code &code, int row, int col)
 {
 #ifdef _PVZ_BETA_LEAK_SUPPORT
     if (isBETA())
     {
-        asm_push_dword(row);
-        asm_push_dword(col);
-        asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
-        asm_call(data().call_put_ladder);
+        code.asm_push_dword(row);
+        code.asm_push_dword(col);
+        code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
+        code.asm_call(data().call_put_ladder);
     }
     else
 #endif
     {
-        asm_mov_exx(Reg::EDI, row);
-        asm_push_dword(col);
-        asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
-        asm_call(data().call_put_ladder);
+        code.asm_mov_exx(Reg::EDI, row);
+        code.asm_push_dword(col);
+        code.asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
+        code.asm_call(data().call_put_ladder);
     }
 }
 
@@ -1264,21 +1646,21 @@ void PvZ::PutLadder(int row, int col)
 
     int row_count = GetRowCount();
     int col_count = 9;
-    asm_init();
+    Code code;
     if (row == -1 && col == -1)
         for (int r = 0; r < row_count; r++)
             for (int c = 0; c < col_count; c++)
-                asm_put_ladder(r, c);
+                asm_put_ladder(code, r, c);
     else if (row != -1 && col == -1)
         for (int c = 0; c < col_count; c++)
-            asm_put_ladder(row, c);
+            asm_put_ladder(code, row, c);
     else if (row == -1 && col != -1)
         for (int r = 0; r < row_count; r++)
-            asm_put_ladder(r, col);
+            asm_put_ladder(code, r, col);
     else
-        asm_put_ladder(row, col);
-    asm_ret();
-    asm_code_inject();
+        asm_put_ladder(code, row, col);
+    code.asm_ret();
+    asm_code_inject(code, __func__);
 }
 
 void PvZ::AutoLadder(bool imitater_pumpkin_only = true)
@@ -1291,38 +1673,35 @@ void PvZ::AutoLadder(bool imitater_pumpkin_only = true)
 
     ClearGridItems({3}); // 清空所有梯子
 
-    unsigned int plant_struct_size = 0x14c;
+    auto snapshot = GetSnapshot(SNAPSHOT_PLANT);
+    auto &plants = snapshot.plants;
 
-    auto plant_count_max = ReadMemory<uint32_t>({data().lawn, data().board, data().plant_count_max});
-    auto plant_offset = ReadMemory<uintptr_t>({data().lawn, data().board, data().plant});
+    // 1.草地 2.裸地 3.泳池
+    auto block_types = ReadMemory<int, 6 * 9>({data().lawn, data().board, data().block_type});
 
-    asm_init();
-    for (size_t i = 0; i < plant_count_max; i++)
+    Code code;
+    for (size_t i = 0; i < plants.alive.size(); i++)
     {
-        auto plant_dead = ReadMemory<bool>({plant_offset + data().plant_dead + plant_struct_size * i});
-        auto plant_squished = ReadMemory<bool>({plant_offset + data().plant_squished + plant_struct_size * i});
-        auto plant_type = ReadMemory<uint32_t>({plant_offset + data().plant_type + plant_struct_size * i});
-        if (!plant_dead && !plant_squished && plant_type == 30) // 30 南瓜
+        if (plants.alive[i] && plants.type[i] == 30) // 30 南瓜
         {
-            auto plant_row = ReadMemory<uint32_t>({plant_offset + data().plant_row + plant_struct_size * i});
-            auto plant_col = ReadMemory<uint32_t>({plant_offset + data().plant_col + plant_struct_size * i});
-            auto plant_imitater = //
-                ReadMemory<int>({plant_offset + data().plant_imitater + plant_struct_size * i}) == 48;
-            // 1.草地 2.裸地 3.泳池
-            auto block_type = ReadMemory<int>({data().lawn, data().board,                                 //
-                                               data().block_type + 0x04 * plant_row + 0x18 * plant_col}); //
+            uint32_t plant_row = plants.row[i];
+            uint32_t plant_col = plants.col[i];
+            bool plant_imitater = plants.imitater[i];
+            if (plant_row >= 6 || plant_col >= 9)
+                continue;
+            auto block_type = block_types[plant_row + 6 * plant_col];
             if (plant_col != 0 && block_type == 1                                                         //
                 && (!imitater_pumpkin_only || (imitater_pumpkin_only && plant_imitater)))                 //
             {
 #ifdef _DEBUG
                 std::wcout << L"搭梯: " << (plant_row + 1) << L" " << (plant_col + 1) << std::endl;
 #endif
-                asm_put_ladder(plant_row, plant_col);
+                asm_put_ladder(code, plant_row, plant_col);
             }
         }
     }
-    asm_ret();
-    asm_code_inject();
+    code.asm_ret();
+    asm_code_inject(code, __func__);
 }
 
 void PvZ::asm_put_rake(int row, int col)
@@ -1330,20 +1709,20 @@ void PvZ::asm_put_rake(int row, int col)
     WriteMemory<int>(row, {data().call_put_rake_row + 1});
     WriteMemory<int>(col, {data().call_put_rake_col + 4});
 
-    asm_init();
+    Code code;
     if (isGOTY())
     {
         if (this->find_result == PVZ_GOTY_1_1_0_1056_ZH || //
             this->find_result == PVZ_GOTY_1_1_0_1056_JA)
         {
-            asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-            asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
-            asm_push_exx(Reg::ECX);
+            code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+            code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
+            code.asm_push_exx(Reg::ECX);
         }
         else
         {
-            asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
-            asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
+            code.asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
+            code.asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
         }
     }
     else
@@ -1351,24 +1730,26 @@ void PvZ::asm_put_rake(int row, int col)
 #ifdef _PVZ_BETA_LEAK_SUPPORT
         if (isBETA())
         {
-            asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-            asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
+            code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+            code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
         }
         else
 #endif
         {
-            asm_mov_exx_dword_ptr(Reg::EDX, data().lawn);
-            asm_mov_exx_dword_ptr_exx_add(Reg::EDX, data().board);
-            asm_push_exx(Reg::EDX);
+            code.asm_mov_exx_dword_ptr(Reg::EDX, data().lawn);
+            code.asm_mov_exx_dword_ptr_exx_add(Reg::EDX, data().board);
+            code.asm_push_exx(Reg::EDX);
         }
     }
-    asm_call(data().call_put_rake);
-    asm_ret();
-    asm_code_inject();
+    code.asm_call(data().call_put_rake);
+    code.asm_ret();
+    asm_code_inject(code, "PutRake"); // 按公开的功能名统计
 }
 
 void PvZ::PutRake(int row, int col)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
     int ui = GameUI();
@@ -1424,6 +1805,8 @@ void PvZ::PutRake(int row, int col)
 // 0.启动 1.删除 2.恢复
 void PvZ::SetLawnMowers(int option)
 {
+    MutexLock operation(operation_lock);
+
     // #ifdef _DEBUG
     //     HACK<uint32_t, 1> test_hack = data().lawn_mower_initialize;
     //     assert(ReadMemory<uint32_t>({test_hack.mem_addr}) == test_hack.reset_value[0]);
@@ -1439,10 +1822,8 @@ void PvZ::SetLawnMowers(int option)
     if (GameUI() != 3)
         return;
 
-    unsigned int lawn_mower_struct_size = 0x48;
-
-    auto lawn_mower_count_max = ReadMemory<uint32_t>({data().lawn, data().board, data().lawn_mower_count_max});
-    auto lawn_mower_offset = ReadMemory<uintptr_t>({data().lawn, data().board, data().lawn_mower});
+    auto snapshot = GetSnapshot(SNAPSHOT_LAWN_MOWER);
+    auto &lawn_mowers = snapshot.lawn_mowers;
 
     if (option == 2)
     {
@@ -1450,52 +1831,51 @@ void PvZ::SetLawnMowers(int option)
         enable_hack(data().lawn_mower_initialize, true);
     }
 
-    asm_init();
-    for (size_t i = 0; i < lawn_mower_count_max; i++)
+    Code code;
+    for (size_t i = 0; i < lawn_mowers.alive.size(); i++)
     {
-        auto lawn_mower_dead = ReadMemory<bool>({lawn_mower_offset + data().lawn_mower_dead + lawn_mower_struct_size * i});
-        if (!lawn_mower_dead)
+        if (lawn_mowers.alive[i])
         {
-            uint32_t addr = lawn_mower_offset + lawn_mower_struct_size * i;
+            uint32_t addr = snapshot.lawn_mower_pool.address(i);
             if (option == 0)
             {
                 if (this->find_result == PVZ_GOTY_1_1_0_1056_ZH || //
                     this->find_result == PVZ_GOTY_1_1_0_1056_JA)
-                    asm_mov_exx(Reg::EBX, addr);
+                    code.asm_mov_exx(Reg::EBX, addr);
 #ifdef _PVZ_BETA_LEAK_SUPPORT
                 else if (isBETA())
-                    asm_mov_exx(Reg::ECX, addr);
+                    code.asm_mov_exx(Reg::ECX, addr);
 #endif
                 else
-                    asm_mov_exx(Reg::ESI, addr);
-                asm_call(data().call_start_lawn_mower);
+                    code.asm_mov_exx(Reg::ESI, addr);
+                code.asm_call(data().call_start_lawn_mower);
             }
             else
             {
 #ifdef _PVZ_BETA_LEAK_SUPPORT
                 if (isBETA())
-                    asm_mov_exx(Reg::ECX, addr);
+                    code.asm_mov_exx(Reg::ECX, addr);
                 else
 #endif
-                    asm_mov_exx(Reg::EAX, addr);
-                asm_call(data().call_delete_lawn_mower);
+                    code.asm_mov_exx(Reg::EAX, addr);
+                code.asm_call(data().call_delete_lawn_mower);
             }
         }
     }
     if (option == 2)
     {
-        asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
+        code.asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
 #ifdef _PVZ_BETA_LEAK_SUPPORT
         if (isBETA())
-            asm_mov_exx_exx(Reg::ECX, Reg::EAX);
+            code.asm_mov_exx_exx(Reg::ECX, Reg::EAX);
         else
 #endif
-            asm_push_exx(Reg::EAX);
-        asm_call(data().call_restore_lawn_mower);
+            code.asm_push_exx(Reg::EAX);
+        code.asm_call(data().call_restore_lawn_mower);
     }
-    asm_ret();
-    asm_code_inject();
+    code.asm_ret();
+    asm_code_inject(code, __func__);
 
     if (option == 2)
     {
@@ -1512,30 +1892,26 @@ void PvZ::ClearAllPlants()
     if (ui != 2 && ui != 3)
         return;
 
-    unsigned int plant_struct_size = 0x14c;
+    auto snapshot = GetSnapshot(SNAPSHOT_PLANT);
+    auto &plants = snapshot.plants;
 
-    auto plant_count_max = ReadMemory<uint32_t>({data().lawn, data().board, data().plant_count_max});
-    auto plant_offset = ReadMemory<uintptr_t>({data().lawn, data().board, data().plant});
-
-    asm_init();
-    for (size_t i = 0; i < plant_count_max; i++)
+    Code code;
+    for (size_t i = 0; i < plants.alive.size(); i++)
     {
-        auto plant_dead = ReadMemory<bool>({plant_offset + data().plant_dead + plant_struct_size * i});
-        auto plant_squished = ReadMemory<bool>({plant_offset + data().plant_squished + plant_struct_size * i});
-        if (!plant_dead && !plant_squished)
+        if (plants.alive[i])
         {
-            uint32_t addr = plant_offset + plant_struct_size * i;
+            uint32_t addr = snapshot.plant_pool.address(i);
 #ifdef _PVZ_BETA_LEAK_SUPPORT
             if (isBETA())
-                asm_mov_exx(Reg::ECX, addr);
+                code.asm_mov_exx(Reg::ECX, addr);
             else
 #endif
-                asm_push_dword(addr);
-            asm_call(data().call_delete_plant);
+                code.asm_push_dword(addr);
+            code.asm_call(data().call_delete_plant);
         }
     }
-    asm_ret();
-    asm_code_inject();
+    code.asm_ret();
+    asm_code_inject(code, __func__);
 }
 
 void PvZ::KillAllZombies()
@@ -1546,19 +1922,25 @@ void PvZ::KillAllZombies()
     if (ui != 2 && ui != 3)
         return;
 
-    unsigned int zombie_struct_size = isGOTY() ? 0x168 : 0x15c;
-#ifdef _PVZ_BETA_LEAK_SUPPORT
-    if (this->find_result == PVZ_BETA_0_1_1_1014_EN)
-        zombie_struct_size = 0x160;
-#endif
+    KillZombies(EntityFilter());
+}
 
-    auto zombie_count_max = ReadMemory<uint32_t>({data().lawn, data().board, data().zombie_count_max});
-    auto zombie_offset = ReadMemory<uintptr_t>({data().lawn, data().board, data().zombie});
-    for (size_t i = 0; i < zombie_count_max; i++)
-    {
-        if (!ReadMemory<bool>({zombie_offset + data().zombie_dead + i * zombie_struct_size}))     // 没有消失
-            WriteMemory<int>(3, {zombie_offset + data().zombie_status + i * zombie_struct_size}); // 3 秒杀
-    }
+size_t PvZ::KillZombies(const EntityFilter &filter)
+{
+    MutexLock operation(operation_lock);
+
+    if (!GameOn())
+        return 0;
+    int ui = GameUI();
+    if (ui != 2 && ui != 3)
+        return 0;
+
+    // 暂停主循环后再读取和写回, 各僵尸的状态字段合并成少数几次写入
+    park_main_loop();
+    auto snapshot = GetSnapshot(SNAPSHOT_ZOMBIE);
+    size_t count = MutateZombies(*this, snapshot, filter, {{data().zombie_status, 4, 3}}, SNAPSHOT_PARKED_GAP); // 3 秒杀
+    resume_main_loop();
+    return count;
 }
 
 // 1 墓碑
@@ -1577,38 +1959,32 @@ void PvZ::ClearGridItems(std::vector<int> types)
     if (ui != 2 && ui != 3)
         return;
 
-    unsigned int grid_item_struct_size = 0xec;
-#ifdef _PVZ_BETA_LEAK_SUPPORT
-    if (this->find_result == PVZ_BETA_0_1_1_1014_EN)
-        grid_item_struct_size = 0x8c;
-#endif
-
-    auto grid_item_count_max = ReadMemory<uint32_t>({data().lawn, data().board, data().grid_item_count_max});
-    auto grid_item_offset = ReadMemory<uintptr_t>({data().lawn, data().board, data().grid_item});
+    auto snapshot = GetSnapshot(SNAPSHOT_GRID_ITEM);
+    auto &grid_items = snapshot.grid_items;
 
-    asm_init();
-    for (size_t i = 0; i < grid_item_count_max; i++)
+    Code code;
+    for (size_t i = 0; i < grid_items.alive.size(); i++)
     {
-        auto grid_item_dead = ReadMemory<bool>({grid_item_offset + data().grid_item_dead + grid_item_struct_size * i});
-        auto grid_item_type = ReadMemory<int>({grid_item_offset + data().grid_item_type + grid_item_struct_size * i});
-        if (!grid_item_dead && std::find(types.begin(), types.end(), grid_item_type) != types.end())
+        if (grid_items.alive[i] && std::find(types.begin(), types.end(), grid_items.type[i]) != types.end())
         {
-            int addr = grid_item_offset + grid_item_struct_size * i;
+            int addr = snapshot.grid_item_pool.address(i);
 #ifdef _PVZ_BETA_LEAK_SUPPORT
             if (isBETA())
-                asm_mov_exx(Reg::ECX, addr);
+                code.asm_mov_exx(Reg::ECX, addr);
             else
 #endif
-                asm_mov_exx(Reg::ESI, addr);
-            asm_call(data().call_delete_grid_item);
+                code.asm_mov_exx(Reg::ESI, addr);
+            code.asm_call(data().call_delete_grid_item);
         }
     }
-    asm_ret();
-    asm_code_inject();
+    code.asm_ret();
+    asm_code_inject(code, __func__);
 }
 
 void PvZ::PlantInvincible(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -1644,6 +2020,8 @@ void PvZ::PlantInvincible(bool on)
 
 void PvZ::PlantWeak(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -1674,6 +2052,8 @@ void PvZ::PlantWeak(bool on)
 
 void PvZ::ZombieInvincible(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -1703,6 +2083,8 @@ void PvZ::ZombieInvincible(bool on)
 
 void PvZ::ZombieWeak(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -1725,6 +2107,8 @@ void PvZ::ZombieWeak(bool on)
 
 void PvZ::ReloadInstantly(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -1735,6 +2119,8 @@ void PvZ::ReloadInstantly(bool on)
 
 void PvZ::MushroomsAwake(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -1744,35 +2130,30 @@ void PvZ::MushroomsAwake(bool on)
     if (ui != 2 && ui != 3)
         return;
 
-    unsigned int plant_struct_size = 0x14c;
-
     if (on)
     {
-        auto plant_count_max = ReadMemory<uint32_t>({data().lawn, data().board, data().plant_count_max});
-        auto plant_offset = ReadMemory<uintptr_t>({data().lawn, data().board, data().plant});
-        asm_init();
-        for (size_t i = 0; i < plant_count_max; i++)
+        auto snapshot = GetSnapshot(SNAPSHOT_PLANT);
+        auto &plants = snapshot.plants;
+        Code code;
+        for (size_t i = 0; i < plants.alive.size(); i++)
         {
-            auto plant_dead = ReadMemory<bool>({plant_offset + data().plant_dead + plant_struct_size * i});
-            auto plant_squished = ReadMemory<bool>({plant_offset + data().plant_squished + plant_struct_size * i});
-            auto plant_asleep = ReadMemory<bool>({plant_offset + data().plant_asleep + plant_struct_size * i});
-            if (!plant_dead && !plant_squished && plant_asleep)
+            if (plants.alive[i] && plants.asleep[i])
             {
-                uint32_t addr = plant_offset + plant_struct_size * i;
+                uint32_t addr = snapshot.plant_pool.address(i);
                 if (isGOTY())
-                    asm_mov_exx(Reg::EDI, addr);
+                    code.asm_mov_exx(Reg::EDI, addr);
 #ifdef _PVZ_BETA_LEAK_SUPPORT
                 else if (isBETA())
-                    asm_mov_exx(Reg::ECX, addr);
+                    code.asm_mov_exx(Reg::ECX, addr);
 #endif
                 else
-                    asm_mov_exx(Reg::EAX, addr);
-                asm_push_byte(0);
-                asm_call(data().call_set_plant_sleeping);
+                    code.asm_mov_exx(Reg::EAX, addr);
+                code.asm_push_byte(0);
+                code.asm_call(data().call_set_plant_sleeping);
             }
         }
-        asm_ret();
-        asm_code_inject();
+        code.asm_ret();
+        asm_code_inject(code, __func__);
     }
 }
 
@@ -1810,6 +2191,8 @@ void PvZ::NoCrater(bool on)
 
 void PvZ::NoIceTrail(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -1845,7 +2228,7 @@ int PvZ::GetSlotSeed(int index)
     if (ui != 2 && ui != 3)
         return -1;
 
-    unsigned int slot_seed_struct_size = 0x50;
+    unsigned int slot_seed_struct_size = data().slot_seed_struct_size;
 
     auto slot_offset = ReadMemory<uintptr_t>({data().lawn, data().board, data().slot});
     seed_type = ReadMemory<int>({slot_offset + data().slot_seed_type + index * slot_seed_struct_size});
@@ -1859,13 +2242,15 @@ int PvZ::GetSlotSeed(int index)
 
 void PvZ::SetSlotSeed(int index, int type, bool imitater = false)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
     int ui = GameUI();
     if (ui != 2 && ui != 3)
         return;
 
-    unsigned int slot_seed_struct_size = 0x50;
+    unsigned int slot_seed_struct_size = data().slot_seed_struct_size;
 
     auto slot_offset = ReadMemory<uintptr_t>({data().lawn, data().board, data().slot});
     if (imitater)
@@ -1888,37 +2273,34 @@ void PvZ::LilyPadOnPool(int from_col, int to_col)
     if (ui != 2 && ui != 3)
         return;
 
-    unsigned int plant_struct_size = 0x14c;
-
-    auto plant_count_max = ReadMemory<uint32_t>({data().lawn, data().board, data().plant_count_max});
-    auto plant_offset = ReadMemory<uintptr_t>({data().lawn, data().board, data().plant});
+    auto snapshot = GetSnapshot(SNAPSHOT_PLANT);
+    auto &plants = snapshot.plants;
     bool has_plant[6][9] = {{false}};
 
-    for (size_t i = 0; i < plant_count_max; i++)
+    for (size_t i = 0; i < plants.alive.size(); i++)
     {
-        auto plant_dead = ReadMemory<bool>({plant_offset + data().plant_dead + plant_struct_size * i});
-        auto plant_squished = ReadMemory<bool>({plant_offset + data().plant_squished + plant_struct_size * i});
-        auto plant_row = ReadMemory<uint32_t>({plant_offset + data().plant_row + plant_struct_size * i});
-        auto plant_col = ReadMemory<uint32_t>({plant_offset + data().plant_col + plant_struct_size * i});
-        if (!plant_dead && !plant_squished)
+        uint32_t plant_row = plants.row[i];
+        uint32_t plant_col = plants.col[i];
+        if (plants.alive[i] && plant_row < 6 && plant_col < 9)
             has_plant[plant_row][plant_col] = true;
     }
 
-    asm_init();
+    // 1.草地 2.裸地 3.泳池
+    auto block_types = ReadMemory<int, 6 * 9>({data().lawn, data().board, data().block_type});
+
+    Code code;
     int rows = GetRowCount();
     for (int r = 0; r < rows; r++)
     {
         for (int c = 0; c < 9; c++)
         {
-            // 1.草地 2.裸地 3.泳池
-            auto block_type = ReadMemory<int>({data().lawn, data().board,                 //
-                                               data().block_type + 0x04 * r + 0x18 * c}); //
+            auto block_type = block_types[r + 6 * c];
             if (block_type == 3 && !has_plant[r][c] && from_col - 1 <= c && c <= to_col - 1)
-                asm_put_plant(r, c, 16, false, false); // 16 睡莲
+                asm_put_plant(code, r, c, 16, false, false); // 16 睡莲
         }
     }
-    asm_ret();
-    asm_code_inject();
+    code.asm_ret();
+    asm_code_inject(code, __func__);
 }
 
 void PvZ::FlowerPotOnRoof(int from_col, int to_col)
@@ -1933,29 +2315,25 @@ void PvZ::FlowerPotOnRoof(int from_col, int to_col)
     if (scene != 4 && scene != 5)
         return;
 
-    unsigned int plant_struct_size = 0x14c;
-
-    auto plant_count_max = ReadMemory<uint32_t>({data().lawn, data().board, data().plant_count_max});
-    auto plant_offset = ReadMemory<uintptr_t>({data().lawn, data().board, data().plant});
+    auto snapshot = GetSnapshot(SNAPSHOT_PLANT);
+    auto &plants = snapshot.plants;
     bool has_plant[5][9] = {{false}};
 
-    for (size_t i = 0; i < plant_count_max; i++)
+    for (size_t i = 0; i < plants.alive.size(); i++)
     {
-        auto plant_dead = ReadMemory<bool>({plant_offset + data().plant_dead + plant_struct_size * i});
-        auto plant_squished = ReadMemory<bool>({plant_offset + data().plant_squished + plant_struct_size * i});
-        auto plant_row = ReadMemory<uint32_t>({plant_offset + data().plant_row + plant_struct_size * i});
-        auto plant_col = ReadMemory<uint32_t>({plant_offset + data().plant_col + plant_struct_size * i});
-        if (!plant_dead && !plant_squished)
+        uint32_t plant_row = plants.row[i];
+        uint32_t plant_col = plants.col[i];
+        if (plants.alive[i] && plant_row < 5 && plant_col < 9)
             has_plant[plant_row][plant_col] = true;
     }
 
-    asm_init();
+    Code code;
     for (int r = 0; r < 5; r++)
         for (int c = 0; c < 9; c++)
             if (!has_plant[r][c] && from_col - 1 <= c && c <= to_col - 1)
-                asm_put_plant(r, c, 33, false, false); // 33 花盆
-    asm_ret();
-    asm_code_inject();
+                asm_put_plant(code, r, c, 33, false, false); // 33 花盆
+    code.asm_ret();
+    asm_code_inject(code, __func__);
 }
 
 void PvZ::Screenshot()
@@ -2015,26 +2393,19 @@ Lineup PvZ::GetLineup()
 
     lineup.scene = GetScene();
 
-    unsigned int plant_struct_size = 0x14c;
-    unsigned int grid_item_struct_size = 0xec;
-#ifdef _PVZ_BETA_LEAK_SUPPORT
-    if (this->find_result == PVZ_BETA_0_1_1_1014_EN)
-        grid_item_struct_size = 0x8c;
-#endif
+    auto snapshot = GetSnapshot(SNAPSHOT_PLANT | SNAPSHOT_GRID_ITEM);
+    auto &plants = snapshot.plants;
+    auto &grid_items = snapshot.grid_items;
 
-    auto plant_count_max = ReadMemory<uint32_t>({data().lawn, data().board, data().plant_count_max});
-    auto plant_offset = ReadMemory<uintptr_t>({data().lawn, data().board, data().plant});
-    for (size_t i = 0; i < plant_count_max; i++)
+    for (size_t i = 0; i < plants.alive.size(); i++)
     {
-        auto plant_dead = ReadMemory<bool>({plant_offset + data().plant_dead + plant_struct_size * i});
-        auto plant_squished = ReadMemory<bool>({plant_offset + data().plant_squished + plant_struct_size * i});
-        auto plant_type = ReadMemory<uint32_t>({plant_offset + data().plant_type + plant_struct_size * i});
-        if (!plant_dead && !plant_squished && 0 <= plant_type && plant_type <= 47)
+        uint32_t plant_type = plants.type[i];
+        uint32_t plant_row = plants.row[i];
+        uint32_t plant_col = plants.col[i];
+        if (plants.alive[i] && plant_type <= 47 && plant_row < 6 && plant_col < 9)
         {
-            auto plant_row = ReadMemory<uint32_t>({plant_offset + data().plant_row + plant_struct_size * i});
-            auto plant_col = ReadMemory<uint32_t>({plant_offset + data().plant_col + plant_struct_size * i});
-            auto plant_asleep = ReadMemory<bool>({plant_offset + data().plant_asleep + plant_struct_size * i});
-            auto plant_imitater = ReadMemory<int>({plant_offset + data().plant_imitater + plant_struct_size * i}) == 48;
+            bool plant_asleep = plants.asleep[i];
+            bool plant_imitater = plants.imitater[i];
             if (plant_type == 16 || plant_type == 33) // 睡莲 花盆
             {
                 lineup.base[plant_row * 9 + plant_col] = (plant_type == 16) ? 1 : 2;
@@ -2059,16 +2430,14 @@ Lineup PvZ::GetLineup()
         }
     }
 
-    auto grid_item_count_max = ReadMemory<uint32_t>({data().lawn, data().board, data().grid_item_count_max});
-    auto grid_item_offset = ReadMemory<uintptr_t>({data().lawn, data().board, data().grid_item});
-    for (size_t i = 0; i < grid_item_count_max; i++)
+    for (size_t i = 0; i < grid_items.alive.size(); i++)
     {
-        auto grid_item_dead = ReadMemory<bool>({grid_item_offset + data().grid_item_dead + grid_item_struct_size * i});
-        auto grid_item_type = ReadMemory<int>({grid_item_offset + data().grid_item_type + grid_item_struct_size * i});
-        if (!grid_item_dead && (grid_item_type == 1 || grid_item_type == 3 || grid_item_type == 11))
+        int grid_item_type = grid_items.type[i];
+        uint32_t grid_item_row = grid_items.row[i];
+        uint32_t grid_item_col = grid_items.col[i];
+        if (grid_items.alive[i] && (grid_item_type == 1 || grid_item_type == 3 || grid_item_type == 11) //
+            && grid_item_row < 6 && grid_item_col < 9)                                                  //
         {
-            auto grid_item_row = ReadMemory<uint32_t>({grid_item_offset + data().grid_item_row + grid_item_struct_size * i});
-            auto grid_item_col = ReadMemory<uint32_t>({grid_item_offset + data().grid_item_col + grid_item_struct_size * i});
             if (grid_item_type == 1) // 墓碑
             {
                 lineup.base[grid_item_row * 9 + grid_item_col] = 3;
@@ -2090,6 +2459,8 @@ Lineup PvZ::GetLineup()
 
 void PvZ::SetLineup(Lineup lineup)
 {
+    MutexLock operation(operation_lock);
+
     if (!lineup.OK())
         return;
 
@@ -2118,16 +2489,16 @@ void PvZ::SetLineup(Lineup lineup)
         PutRake(r, c);
     }
 
-    asm_init();
+    Code code;
     // 睡莲 花盆
     for (size_t r = 0; r < 6; r++)
     {
         for (size_t c = 0; c < 9; c++)
         {
             if (lineup.base[r * 9 + c] == 1)
-                asm_put_plant(r, c, 16, lineup.base_im[r * 9 + c] == 1, is_iz);
+                asm_put_plant(code, r, c, 16, lineup.base_im[r * 9 + c] == 1, is_iz);
             else if (lineup.base[r * 9 + c] == 2)
-                asm_put_plant(r, c, 33, lineup.base_im[r * 9 + c] == 1, is_iz);
+                asm_put_plant(code, r, c, 33, lineup.base_im[r * 9 + c] == 1, is_iz);
         }
     }
     // 主要植物
@@ -2147,22 +2518,22 @@ void PvZ::SetLineup(Lineup lineup)
                 || plant_type == 30 || plant_type == 35)
                 continue;
 
-            asm_put_plant(r, c, plant_type, plant_imitater, is_iz);
+            asm_put_plant(code, r, c, plant_type, plant_imitater, is_iz);
 
             // 蘑菇类植物唤醒
             if ((lineup.scene == 0 || lineup.scene == 2 || lineup.scene == 4) //
                 && lineup.may_sleep[plant_type] && !plant_asleep)
             {
-                asm_push_exx(Reg::EAX);
+                code.asm_push_exx(Reg::EAX);
                 if (isGOTY())
-                    asm_mov_exx_exx(Reg::EDI, Reg::EAX);
+                    code.asm_mov_exx_exx(Reg::EDI, Reg::EAX);
 #ifdef _PVZ_BETA_LEAK_SUPPORT
                 else if (isBETA())
-                    asm_mov_exx_exx(Reg::ECX, Reg::EAX);
+                    code.asm_mov_exx_exx(Reg::ECX, Reg::EAX);
 #endif
-                asm_push_byte(0);
-                asm_call(data().call_set_plant_sleeping);
-                asm_pop_exx(Reg::EAX);
+                code.asm_push_byte(0);
+                code.asm_call(data().call_set_plant_sleeping);
+                code.asm_pop_exx(Reg::EAX);
             }
 
             // 土豆雷和阳光菇长大
@@ -2171,11 +2542,11 @@ void PvZ::SetLineup(Lineup lineup)
             {
 #ifdef _PVZ_BETA_LEAK_SUPPORT
                 if (isBETA())
-                    asm_add_list(0xc7, 0x40, 0x5c);
+                    code.asm_add_list(0xc7, 0x40, 0x5c);
                 else
 #endif
-                    asm_add_list(0xc7, 0x40, 0x54);
-                asm_add_dword(1);
+                    code.asm_add_list(0xc7, 0x40, 0x54);
+                code.asm_add_dword(1);
             }
         }
     }
@@ -2185,7 +2556,7 @@ void PvZ::SetLineup(Lineup lineup)
         for (size_t c = 0; c < 9; c++)
         {
             if (lineup.pumpkin[r * 9 + c] == 1)
-                asm_put_plant(r, c, 30, lineup.pumpkin_im[r * 9 + c] == 1, is_iz);
+                asm_put_plant(code, r, c, 30, lineup.pumpkin_im[r * 9 + c] == 1, is_iz);
         }
     }
     // 咖啡豆
@@ -2194,7 +2565,7 @@ void PvZ::SetLineup(Lineup lineup)
         for (size_t c = 0; c < 9; c++)
         {
             if (lineup.coffee[r * 9 + c] == 1)
-                asm_put_plant(r, c, 35, lineup.coffee_im[r * 9 + c] == 1, is_iz);
+                asm_put_plant(code, r, c, 35, lineup.coffee_im[r * 9 + c] == 1, is_iz);
         }
     }
     // 墓碑
@@ -2203,7 +2574,7 @@ void PvZ::SetLineup(Lineup lineup)
         for (size_t c = 0; c < 9; c++)
         {
             if (lineup.base[r * 9 + c] == 3)
-                asm_put_grave(r, c);
+                asm_put_grave(code, r, c);
         }
     }
     // 梯子
@@ -2212,11 +2583,11 @@ void PvZ::SetLineup(Lineup lineup)
         for (size_t c = 0; c < 9; c++)
         {
             if (lineup.ladder[r * 9 + c] == 1)
-                asm_put_ladder(r, c);
+                asm_put_ladder(code, r, c);
         }
     }
-    asm_ret();
-    asm_code_inject();
+    code.asm_ret();
+    asm_code_inject(code, __func__);
 
     Sleep(GetFrameDuration());
 }
@@ -2224,57 +2595,57 @@ void PvZ::SetLineup(Lineup lineup)
 // 根据出怪种类生成出怪列表
 void PvZ::generate_spawn_list()
 {
-    asm_init();
+    Code code;
     if (this->find_result == PVZ_GOTY_1_1_0_1056_ZH || //
         this->find_result == PVZ_GOTY_1_1_0_1056_JA)
     {
-        asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
+        code.asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
     }
     else
     {
 #ifdef _PVZ_BETA_LEAK_SUPPORT
         if (isBETA())
         {
-            asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-            asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
+            code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+            code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().board);
         }
         else
 #endif
         {
-            asm_mov_exx_dword_ptr(Reg::EDI, data().lawn);
-            asm_mov_exx_dword_ptr_exx_add(Reg::EDI, data().board);
+            code.asm_mov_exx_dword_ptr(Reg::EDI, data().lawn);
+            code.asm_mov_exx_dword_ptr_exx_add(Reg::EDI, data().board);
         }
     }
-    asm_call(data().call_pick_zombie_waves);
-    asm_ret();
-    asm_code_inject();
+    code.asm_call(data().call_pick_zombie_waves);
+    code.asm_ret();
+    asm_code_inject(code, __func__);
 }
 
 // 更新选卡界面的出怪预览
 void PvZ::update_spawn_preview()
 {
     enable_hack(data().hack_street_zombies, true);
-    asm_init();
-    asm_mov_exx_dword_ptr(Reg::EBX, data().lawn);
-    asm_mov_exx_dword_ptr_exx_add(Reg::EBX, data().board);
+    Code code;
+    code.asm_mov_exx_dword_ptr(Reg::EBX, data().lawn);
+    code.asm_mov_exx_dword_ptr_exx_add(Reg::EBX, data().board);
 #ifdef _PVZ_BETA_LEAK_SUPPORT
     if (isBETA())
-        asm_mov_exx_exx(Reg::ECX, Reg::EBX);
+        code.asm_mov_exx_exx(Reg::ECX, Reg::EBX);
 #endif
-    asm_call(data().call_remove_cutscene_zombies);
-    asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
-    asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
-    asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().cut_scene);
+    code.asm_call(data().call_remove_cutscene_zombies);
+    code.asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
+    code.asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().board);
+    code.asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().cut_scene);
 #ifdef _PVZ_BETA_LEAK_SUPPORT
     if (isBETA())
-        asm_mov_exx_exx(Reg::ECX, Reg::EAX);
+        code.asm_mov_exx_exx(Reg::ECX, Reg::EAX);
     else
 #endif
-        asm_push_exx(Reg::EAX);
-    asm_call(data().call_place_street_zombies);
-    asm_ret();
-    asm_code_inject();
+        code.asm_push_exx(Reg::EAX);
+    code.asm_call(data().call_place_street_zombies);
+    code.asm_ret();
+    asm_code_inject(code, __func__);
     enable_hack(data().hack_street_zombies, false);
 }
 
@@ -2327,6 +2698,8 @@ std::array<int, 1000> PvZ::GetSpawnList()
 
 void PvZ::SetSpawnList(std::array<int, 1000> zl)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
     int ui = GameUI();
@@ -2341,6 +2714,8 @@ void PvZ::SetSpawnList(std::array<int, 1000> zl)
 
 void PvZ::InternalSpawn(std::array<bool, 33> zombies)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
     int ui = GameUI();
@@ -2358,144 +2733,96 @@ void PvZ::InternalSpawn(std::array<bool, 33> zombies)
         update_spawn_preview();
 }
 
-void PvZ::CustomizeSpawn(std::array<bool, 33> zombies, bool limit_giga, bool simulate, int giga_weight)
+void PvZ::CustomizeSpawn(std::array<bool, 33> zombies, bool limit_giga, bool simulate, int giga_weight, uint32_t seed, size_t index)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
     int ui = GameUI();
     if (ui != 2 && ui != 3)
         return;
 
-    std::array<bool, 20> giga_waves;
-    giga_waves.fill(true);
-    if (limit_giga)
-        for (size_t w = 11; w <= 19; w++)
-            giga_waves[w - 1] = false;
-
-    std::vector<double> weights = {
-        4000, // 普僵
-        0,    // 旗帜
-        4000, // 路障
-        2000, // 撑杆
-        3000, // 铁桶
-        1000, // 读报
-        3500, // 铁门
-        2000, // 橄榄
-        1000, // 舞王
-        0,    // 伴舞
-        0,    // 鸭子
-        2000, // 潜水
-        2000, // 冰车
-        2000, // 雪橇
-        1500, // 海豚
-        1000, // 小丑
-        2000, // 气球
-        1000, // 矿工
-        1000, // 跳跳
-        1,    // 雪人
-        1000, // 蹦极
-        1000, // 扶梯
-        1500, // 投篮
-        1500, // 白眼
-        0,    // 小鬼
-        0,    // 僵博
-        4000, // 豌豆
-        3000, // 坚果
-        1000, // 辣椒
-        2000, // 机枪
-        2000, // 窝瓜
-        2000, // 高墙
-        6000  // 红眼
-    };
-
 #ifdef _DEBUG
     if (this->find_result == PVZ_1_0_0_1051_EN)
         for (size_t i = 0; i < 33; i++)
-            assert(ReadMemory<int>({0x0069da94 + i * 0x1c}) == static_cast<int>(weights[i]));
+            assert(ReadMemory<int>({0x0069da94 + i * 0x1c}) == WaveGenerator::DEFINITIONS[i].weight);
 #endif
 
-    weights[0] = 400;
-    weights[2] = 1000;
-    std::vector<double> weights_flag = weights;
-    weights[32] = giga_weight;
-    std::vector<double> weights_normal = weights;
-    std::discrete_distribution<unsigned int> dist_flag(weights_flag.begin(), weights_flag.end());
-    std::discrete_distribution<unsigned int> dist_normal(weights_normal.begin(), weights_normal.end());
-    auto seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-    std::mt19937 gen(static_cast<unsigned int>(seed));
-
-    // 僵尸列表
-    std::array<int, 1000> zombies_list;
-    zombies_list.fill(-1);
+    auto zombies_lists = CustomSpawner(zombies, limit_giga, simulate, giga_weight).Batch(index + 1, seed);
+
+    WriteMemory(zombies_lists[index], {data().lawn, data().board, data().spawn_list});
+    if (ui == 2)
+        update_spawn_preview();
+}
 
-    bool has_flag = zombies[1];
-    bool has_yeti = zombies[19];
-    bool has_bungee = zombies[20];
-    bool has_giga = zombies[32];
+WaveRules PvZ::GetSpawnRules()
+{
+    WaveRules rules;
+    rules.zombies.fill(false);
 
-    bool limit_flag = true;
-    bool limit_yeti = true;
-    bool limit_bungee = true;
+    if (!GameOn())
+        return rules;
+    int ui = GameUI();
+    if (ui != 2 && ui != 3)
+        return rules;
 
-    int count = 0;
-    for (size_t i = 0; i < 33; i++)
-        if (zombies[i])
-            count++;
+    rules.zombies = ReadMemory<bool, 33>({data().lawn, data().board, data().spawn_type});
 
-    if (count > 0)
+    // 生存模式按轮数计算出怪点数, 普通生存每轮 10 波
+    int mode = GameMode();
+    if (mode >= 1 && mode <= 15)
     {
-        int type = 0;
-        for (size_t i = 0; i < 1000; i++)
-        {
-            do
-            {
-                if (simulate)
-                {
-                    if (((i / 50) % 10) == 9) // 旗帜波
-                        type = dist_flag(gen);
-                    else
-                        type = dist_normal(gen);
-                }
-                else
-                {
-                    type += 1;
-                    type %= 33;
-                }
-            } while ((!zombies[type])                              //
-                     || (has_flag && limit_flag && type == 1)      //
-                     || (has_yeti && limit_yeti && type == 19)     //
-                     || (has_bungee && limit_bungee && type == 20) //
-                     || (has_giga && limit_giga && type == 32 && !giga_waves[(i / 50) % 20])); //
-
-            zombies_list[i] = type;
-        }
+        rules.stage = ReadMemory<int>({data().lawn, data().board, data().challenge, data().endless_rounds});
+        rules.waves = mode <= 5 ? 10 : 20;
+    }
 
-        std::vector<size_t> index_flag = {450,                                       //
-                                          950};                                      //
-        std::vector<size_t> index_zombie = {451, 452, 453, 454, 455, 456, 457, 458,  //
-                                            951, 952, 953, 954, 955, 956, 957, 958}; //
-        std::vector<size_t> index_bungee = {459, 460, 461, 462,                      //
-                                            959, 960, 961, 962};                     //
+    return rules;
+}
 
-        if ((has_flag && limit_flag) || simulate)
-            for (auto i : index_flag)
-                zombies_list[i] = 1;
+std::array<int, 1000> PvZ::PredictSpawnList(uint32_t seed)
+{
+    return WaveGenerator(GetSpawnRules()).Generate(seed);
+}
 
-        if (simulate)
-            for (auto i : index_zombie)
-                zombies_list[i] = 0;
+int PvZ::CheckSpawnList()
+{
+    auto rules = GetSpawnRules();
+    auto zl = GetSpawnList();
+    int wave = WaveGenerator(rules).Check(zl);
 
-        if (has_bungee && limit_bungee)
-            for (auto i : index_bungee)
-                zombies_list[i] = 20;
+#ifdef _DEBUG
+    std::cout << "Spawn check: stage " << std::dec << rules.stage << " wave " << wave << std::endl;
+#endif
 
-        if (has_yeti && limit_yeti)
-            zombies_list[rand() % 1000] = 19;
-    }
+    return wave;
+}
 
-    WriteMemory(zombies_list, {data().lawn, data().board, data().spawn_list});
-    if (ui == 2)
-        update_spawn_preview();
+bool PvZ::SearchSpawnList(SpawnSearch &search, uint32_t count, uint32_t seed, int &violation)
+{
+    if (!GameOn())
+        return false;
+    int ui = GameUI();
+    if (ui != 2 && ui != 3)
+        return false;
+
+    // 没有全部满足的时结果是违反量最小的
+    std::vector<SpawnCandidate> result;
+    search.FindFirst(count, seed, 1, result);
+
+#ifdef _DEBUG
+    std::cout << "Spawn search: " << std::dec << search.Tried() << " tried " << search.Pruned() << " pruned";
+    if (!result.empty())
+        std::cout << " #" << result[0].index << " violation " << result[0].violation;
+    std::cout << std::endl;
+#endif
+
+    if (result.empty())
+        return false;
+
+    violation = result[0].violation;
+    SetSpawnList(result[0].list);
+    return true;
 }
 
 void PvZ::SetMusic(int id)
@@ -2503,24 +2830,24 @@ void PvZ::SetMusic(int id)
     if (!GameOn())
         return;
 
-    asm_init();
+    Code code;
 #ifdef _PVZ_BETA_LEAK_SUPPORT
     if (isBETA())
     {
-        asm_push_dword(id);
-        asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().music);
+        code.asm_push_dword(id);
+        code.asm_mov_exx_dword_ptr(Reg::ECX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::ECX, data().music);
     }
     else
 #endif
     {
-        asm_mov_exx(Reg::EDI, id);
-        asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
-        asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().music);
+        code.asm_mov_exx(Reg::EDI, id);
+        code.asm_mov_exx_dword_ptr(Reg::EAX, data().lawn);
+        code.asm_mov_exx_dword_ptr_exx_add(Reg::EAX, data().music);
     }
-    asm_call(data().call_play_music);
-    asm_ret();
-    asm_code_inject();
+    code.asm_call(data().call_play_music);
+    code.asm_ret();
+    asm_code_inject(code, __func__);
 }
 
 void PvZ::NoFog(bool on)
@@ -2549,6 +2876,8 @@ void PvZ::BackgroundRunning(bool on)
 
 void PvZ::UserdataReadonly(bool on)
 {
+    MutexLock operation(operation_lock);
+
     if (!GameOn())
         return;
 
@@ -0,0 +1,184 @@
+
+#include "../inc/session.h"
+
+namespace Pt
+{
+
+SessionManager::SessionManager()
+{
+}
+
+SessionManager::~SessionManager()
+{
+    for (auto &session : sessions)
+        close(session.get());
+    sessions.clear();
+}
+
+BOOL CALLBACK SessionManager::enum_proc(HWND hwnd, LPARAM lParam)
+{
+    SessionManager *manager = (SessionManager *)lParam;
+
+    wchar_t class_name[32] = {0};
+    GetClassNameW(hwnd, class_name, 32);
+    if (wcscmp(class_name, L"MainWindow") == 0)
+        manager->found.push_back(hwnd);
+
+    return TRUE;
+}
+
+DWORD WINAPI SessionManager::worker_proc(LPVOID lpParam)
+{
+    Session *session = (Session *)lpParam;
+
+    while (WaitForSingleObject(session->wake_event, INFINITE) == WAIT_OBJECT_0)
+    {
+        while (true)
+        {
+            Job *job = nullptr;
+            EnterCriticalSection(&session->lock);
+            if (!session->jobs.empty())
+            {
+                job = session->jobs.front();
+                session->jobs.pop_front();
+            }
+            LeaveCriticalSection(&session->lock);
+
+            if (job == nullptr)
+                break;
+
+            // 退出时剩下的任务不再执行, 只通知等待者
+            if (!session->quit && session->pvz.GameOn())
+                job->func(session->pvz);
+            SetEvent(job->done);
+        }
+
+        if (session->quit)
+            break;
+    }
+
+    return 0;
+}
+
+bool SessionManager::open(HWND hwnd, DWORD pid)
+{
+    std::unique_ptr<Session> session(new Session());
+    if (!session->pvz.AttachPvZ(hwnd))
+        return false;
+
+    session->pid = pid;
+    session->quit = false;
+    session->wake_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    InitializeCriticalSection(&session->lock);
+    session->thread = CreateThread(nullptr, 0, worker_proc, session.get(), 0, nullptr);
+    if (session->thread == nullptr)
+    {
+        CloseHandle(session->wake_event);
+        DeleteCriticalSection(&session->lock);
+        return false;
+    }
+
+    sessions.push_back(std::move(session));
+    return true;
+}
+
+void SessionManager::close(Session *session)
+{
+    // 在锁内设置, 之后不会再有任务排进来
+    EnterCriticalSection(&session->lock);
+    session->quit = true;
+    LeaveCriticalSection(&session->lock);
+    SetEvent(session->wake_event);
+    WaitForSingleObject(session->thread, INFINITE);
+    CloseHandle(session->thread);
+    CloseHandle(session->wake_event);
+    DeleteCriticalSection(&session->lock);
+}
+
+size_t SessionManager::Discover()
+{
+    // 移除已经退出的游戏
+    for (auto it = sessions.begin(); it != sessions.end();)
+    {
+        if ((*it)->pvz.IsValid())
+        {
+            ++it;
+        }
+        else
+        {
+            close(it->get());
+            it = sessions.erase(it);
+        }
+    }
+
+    found.clear();
+    EnumWindows(enum_proc, (LPARAM)this);
+
+    for (auto hwnd : found)
+    {
+        DWORD pid = 0;
+        GetWindowThreadProcessId(hwnd, &pid);
+        if (pid == 0)
+            continue;
+
+        bool known = false;
+        for (auto &session : sessions)
+            known |= session->pid == pid;
+        if (!known)
+            open(hwnd, pid);
+    }
+
+    return sessions.size();
+}
+
+size_t SessionManager::Count()
+{
+    return sessions.size();
+}
+
+PvZ *SessionManager::Get(size_t index)
+{
+    return index < sessions.size() ? &sessions[index]->pvz : nullptr;
+}
+
+DWORD SessionManager::Pid(size_t index)
+{
+    return index < sessions.size() ? sessions[index]->pid : 0;
+}
+
+void SessionManager::Broadcast(const std::function<void(PvZ &)> &func, const std::vector<size_t> &selected)
+{
+    std::vector<size_t> targets = selected;
+    if (targets.empty())
+        for (size_t i = 0; i < sessions.size(); i++)
+            targets.push_back(i);
+
+    std::vector<Job> jobs(targets.size());
+    for (size_t i = 0; i < targets.size(); i++)
+    {
+        jobs[i].func = func;
+        jobs[i].done = nullptr;
+        if (targets[i] >= sessions.size())
+            continue;
+
+        Session *session = sessions[targets[i]].get();
+        jobs[i].done = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        EnterCriticalSection(&session->lock);
+        if (session->quit)
+            SetEvent(jobs[i].done);
+        else
+            session->jobs.push_back(&jobs[i]);
+        LeaveCriticalSection(&session->lock);
+        SetEvent(session->wake_event);
+    }
+
+    for (auto &job : jobs)
+    {
+        if (job.done == nullptr)
+            continue;
+        WaitForSingleObject(job.done, INFINITE);
+        CloseHandle(job.done);
+    }
+}
+
+} // namespace Pt
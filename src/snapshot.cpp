@@ -0,0 +1,309 @@
+
+#include "../inc/snapshot.h"
+
+namespace Pt
+{
+
+BoardSnapshot::BoardSnapshot()
+{
+    this->pools = 0;
+}
+
+BoardSnapshot::~BoardSnapshot()
+{
+}
+
+bool BoardSnapshot::read_pool(Process &process, PoolImage &pool, uint32_t stride,
+                              uintptr_t owner, uintptr_t pool_offset, uintptr_t count_max_offset)
+{
+    pool.base = 0;
+    pool.count_max = 0;
+    pool.stride = stride;
+    pool.raw.clear();
+
+    if (owner == 0)
+        return false;
+
+    pool.base = process.ReadMemory<uintptr_t>({owner + pool_offset});
+    pool.count_max = process.ReadMemory<uint32_t>({owner + count_max_offset});
+
+    // 读到的数据不合理时放弃
+    if (pool.base == 0 || pool.count_max > 0x10000)
+    {
+        pool.count_max = 0;
+        return false;
+    }
+
+    pool.raw.resize(size_t(pool.count_max) * stride);
+    if (pool.raw.empty())
+        return true;
+
+    if (!process.ReadMemoryBlock(pool.raw.data(), pool.raw.size(), {pool.base}))
+    {
+        pool.count_max = 0;
+        pool.raw.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void BoardSnapshot::decode_plants(const LAYOUTS &layouts)
+{
+    auto pool = plant_pool.view<PlantView>(layouts.plant);
+    size_t n = pool.size();
+
+    plants.id.resize(n);
+    plants.alive.resize(n);
+    plants.type.resize(n);
+    plants.row.resize(n);
+    plants.col.resize(n);
+    plants.imitater.resize(n);
+    plants.asleep.resize(n);
+    plants.hp.resize(n);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        PlantView plant = pool[i];
+        plants.id[i] = plant.id();
+        plants.alive[i] = plant.alive();
+        plants.type[i] = plant.type();
+        plants.row[i] = plant.row();
+        plants.col[i] = plant.col();
+        plants.imitater[i] = plant.imitater();
+        plants.asleep[i] = plant.asleep();
+        plants.hp[i] = plant.hp();
+    }
+}
+
+void BoardSnapshot::decode_zombies(const LAYOUTS &layouts)
+{
+    auto pool = zombie_pool.view<ZombieView>(layouts.zombie);
+    size_t n = pool.size();
+
+    zombies.id.resize(n);
+    zombies.alive.resize(n);
+    zombies.status.resize(n);
+    zombies.type.resize(n);
+    zombies.row.resize(n);
+    zombies.x.resize(n);
+    zombies.y.resize(n);
+    zombies.hp.resize(n);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        ZombieView zombie = pool[i];
+        zombies.id[i] = zombie.id();
+        zombies.alive[i] = zombie.alive();
+        zombies.status[i] = zombie.status();
+        zombies.type[i] = zombie.type();
+        zombies.row[i] = zombie.row();
+        zombies.x[i] = zombie.x();
+        zombies.y[i] = zombie.y();
+        zombies.hp[i] = zombie.hp();
+    }
+}
+
+void BoardSnapshot::decode_grid_items(const LAYOUTS &layouts)
+{
+    auto pool = grid_item_pool.view<GridItemView>(layouts.grid_item);
+    size_t n = pool.size();
+
+    grid_items.id.resize(n);
+    grid_items.alive.resize(n);
+    grid_items.type.resize(n);
+    grid_items.row.resize(n);
+    grid_items.col.resize(n);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        GridItemView grid_item = pool[i];
+        grid_items.id[i] = grid_item.id();
+        grid_items.alive[i] = grid_item.alive();
+        grid_items.type[i] = grid_item.type();
+        grid_items.row[i] = grid_item.row();
+        grid_items.col[i] = grid_item.col();
+    }
+}
+
+void BoardSnapshot::decode_lawn_mowers(const LAYOUTS &layouts)
+{
+    auto pool = lawn_mower_pool.view<LawnMowerView>(layouts.lawn_mower);
+    size_t n = pool.size();
+
+    lawn_mowers.alive.resize(n);
+
+    for (size_t i = 0; i < n; i++)
+        lawn_mowers.alive[i] = pool[i].alive();
+}
+
+void BoardSnapshot::decode_particle_systems(const LAYOUTS &layouts)
+{
+    auto pool = particle_system_pool.view<ParticleSystemView>(layouts.particle_system);
+    size_t n = pool.size();
+
+    particle_systems.alive.resize(n);
+    particle_systems.type.resize(n);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        ParticleSystemView particle_system = pool[i];
+        particle_systems.alive[i] = particle_system.alive();
+        particle_systems.type[i] = particle_system.type();
+    }
+}
+
+bool BoardSnapshot::Capture(Process &process, const PVZ_DATA &data, const LAYOUTS &layouts, unsigned int pools)
+{
+    bool ok = true;
+    this->pools = 0;
+
+    if (pools & (SNAPSHOT_PLANT | SNAPSHOT_ZOMBIE | SNAPSHOT_GRID_ITEM | SNAPSHOT_LAWN_MOWER))
+    {
+        auto board = process.ReadMemory<uintptr_t>({data.lawn, data.board});
+
+        if (pools & SNAPSHOT_PLANT)
+        {
+            ok &= read_pool(process, plant_pool, layouts.plant.size, board, data.plant, data.plant_count_max);
+            decode_plants(layouts);
+        }
+        if (pools & SNAPSHOT_ZOMBIE)
+        {
+            ok &= read_pool(process, zombie_pool, layouts.zombie.size, board, data.zombie, data.zombie_count_max);
+            decode_zombies(layouts);
+        }
+        if (pools & SNAPSHOT_GRID_ITEM)
+        {
+            ok &= read_pool(process, grid_item_pool, layouts.grid_item.size, board, data.grid_item, data.grid_item_count_max);
+            decode_grid_items(layouts);
+        }
+        if (pools & SNAPSHOT_LAWN_MOWER)
+        {
+            ok &= read_pool(process, lawn_mower_pool, layouts.lawn_mower.size, board, data.lawn_mower, data.lawn_mower_count_max);
+            decode_lawn_mowers(layouts);
+        }
+    }
+
+    if (pools & SNAPSHOT_PARTICLE_SYSTEM)
+    {
+        auto owner = process.ReadMemory<uintptr_t>({data.lawn, data.anim, data.unnamed});
+        ok &= read_pool(process, particle_system_pool, layouts.particle_system.size, owner, data.particle_system, data.particle_system_count_max);
+        decode_particle_systems(layouts);
+    }
+
+    this->pools = pools;
+    return ok;
+}
+
+bool PoolImage::commit(Process &process, uint32_t max_gap)
+{
+    if (dirty.empty())
+        return true;
+
+    std::sort(dirty.begin(), dirty.end());
+
+    bool ok = true;
+    std::vector<uint8_t> buff;
+    size_t first = 0;
+    while (first < dirty.size())
+    {
+        // 合并相邻区间, contiguous 表示合并后中间没有空隙
+        uint32_t begin = dirty[first].first;
+        uint32_t end = dirty[first].second;
+        bool contiguous = true;
+        size_t last = first + 1;
+        for (; last < dirty.size(); last++)
+        {
+            if (dirty[last].first > end && dirty[last].first - end > max_gap)
+                break;
+            if (dirty[last].first > end)
+                contiguous = false;
+            end = (std::max)(end, dirty[last].second);
+        }
+
+        if (contiguous)
+        {
+            ok &= process.WriteMemoryBlock(raw.data() + begin, end - begin, {base + begin});
+        }
+        else
+        {
+            // 空隙里的字节可能已经被游戏改变, 重新读取后只覆盖修改过的部分
+            buff.resize(end - begin);
+            if (process.ReadMemoryBlock(buff.data(), buff.size(), {base + begin}))
+            {
+                for (size_t i = first; i < last; i++)
+                    memcpy(buff.data() + dirty[i].first - begin, raw.data() + dirty[i].first, dirty[i].second - dirty[i].first);
+                ok &= process.WriteMemoryBlock(buff.data(), buff.size(), {base + begin});
+            }
+            else
+            {
+                ok = false;
+            }
+        }
+
+        first = last;
+    }
+
+    dirty.clear();
+    return ok;
+}
+
+static void apply_writes(PoolImage &pool, size_t i, const std::vector<FieldWrite> &writes)
+{
+    for (auto &w : writes)
+    {
+        if (w.size == 1)
+            pool.set<uint8_t>(i, w.offset, uint8_t(w.value));
+        else
+            pool.set<int32_t>(i, w.offset, w.value);
+    }
+}
+
+size_t MutatePlants(Process &process, BoardSnapshot &snapshot, const EntityFilter &filter, const std::vector<FieldWrite> &writes, uint32_t max_gap)
+{
+    auto &plants = snapshot.plants;
+    size_t count = 0;
+    for (size_t i = 0; i < plants.alive.size(); i++)
+    {
+        if (filter.match(plants.alive[i], plants.type[i], plants.row[i], plants.col[i], plants.hp[i]))
+        {
+            apply_writes(snapshot.plant_pool, i, writes);
+            count++;
+        }
+    }
+    return snapshot.plant_pool.commit(process, max_gap) ? count : 0;
+}
+
+size_t MutateZombies(Process &process, BoardSnapshot &snapshot, const EntityFilter &filter, const std::vector<FieldWrite> &writes, uint32_t max_gap)
+{
+    auto &zombies = snapshot.zombies;
+    size_t count = 0;
+    for (size_t i = 0; i < zombies.alive.size(); i++)
+    {
+        // 僵尸图像左边为 x, 身体大约在 x + 40 处, 格子从 40 开始每列宽 80
+        int col = int(std::floor(zombies.x[i] / 80.0f));
+        if (filter.match(zombies.alive[i], zombies.type[i], zombies.row[i], col, zombies.hp[i]))
+        {
+            apply_writes(snapshot.zombie_pool, i, writes);
+            count++;
+        }
+    }
+    return snapshot.zombie_pool.commit(process, max_gap) ? count : 0;
+}
+
+size_t MutateGridItems(Process &process, BoardSnapshot &snapshot, const EntityFilter &filter, const std::vector<FieldWrite> &writes, uint32_t max_gap)
+{
+    auto &grid_items = snapshot.grid_items;
+    size_t count = 0;
+    for (size_t i = 0; i < grid_items.alive.size(); i++)
+    {
+        if (filter.match(grid_items.alive[i], grid_items.type[i], grid_items.row[i], grid_items.col[i], 0))
+        {
+            apply_writes(snapshot.grid_item_pool, i, writes);
+            count++;
+        }
+    }
+    return snapshot.grid_item_pool.commit(process, max_gap) ? count : 0;
+}
+
+} // namespace Pt
@@ -0,0 +1,88 @@
+
+#include "../inc/spawnbench.h"
+
+namespace Pt
+{
+
+// 原来的实现: 在全部 33 种上抽取, 抽到不允许的种类就重抽
+static void rejection_spawn(const std::array<bool, 33> &zombies, bool limit_giga, int giga_weight,
+                            std::mt19937 &gen, std::array<int, 1000> &list)
+{
+    std::vector<double> weights;
+    for (int t = 0; t < 33; t++)
+        weights.push_back(WaveGenerator::DEFINITIONS[t].weight);
+    weights[ZOMBIE_NORMAL] = 400;
+    weights[ZOMBIE_CONE] = 1000;
+    std::vector<double> weights_flag = weights;
+    weights[ZOMBIE_GIGA] = giga_weight;
+    std::discrete_distribution<unsigned int> dist_flag(weights_flag.begin(), weights_flag.end());
+    std::discrete_distribution<unsigned int> dist_normal(weights.begin(), weights.end());
+
+    list.fill(-1);
+    for (size_t i = 0; i < 1000; i++)
+    {
+        size_t w = i / WAVE_SIZE;
+        int type;
+        do
+        {
+            type = (w % 10 == 9) ? dist_flag(gen) : dist_normal(gen);
+        } while (!zombies[type] || type == ZOMBIE_FLAG || type == ZOMBIE_YETI || type == ZOMBIE_BUNGEE //
+                 || (limit_giga && type == ZOMBIE_GIGA && w >= 10 && w <= 18));
+        list[i] = type;
+    }
+}
+
+int SpawnBenchmark(int argc, char **argv)
+{
+    uint32_t count = argc >= 1 ? uint32_t(strtoul(argv[0], nullptr, 10)) : 0;
+    if (count == 0)
+        count = 10000;
+
+    // 全部种类 / 常见阵容 / 只有低权重的种类
+    std::vector<std::pair<const char *, std::vector<int>>> masks = {
+        {"all", {0, 2, 3, 4, 5, 6, 7, 8, 11, 12, 13, 14, 15, 16, 17, 18, 21, 22, 23, 32}},
+        {"common", {0, 2, 4, 6, 7, 12, 23, 32}},
+        {"rare", {14, 15}},
+    };
+
+    for (auto &m : masks)
+    {
+        std::array<bool, 33> zombies;
+        zombies.fill(false);
+        for (auto t : m.second)
+            zombies[t] = true;
+
+        std::array<int, 1000> list;
+        long long checksum = 0;
+
+        LARGE_INTEGER freq, t0, t1, t2;
+        QueryPerformanceFrequency(&freq);
+
+        QueryPerformanceCounter(&t0);
+        std::mt19937 gen_old(1);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            rejection_spawn(zombies, true, 1000, gen_old, list);
+            checksum += list[i % 1000];
+        }
+
+        QueryPerformanceCounter(&t1);
+        CustomSpawner spawner(zombies, true, true, 1000);
+        std::mt19937 gen_new(1);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            spawner.Generate(gen_new, list);
+            checksum += list[i % 1000];
+        }
+        QueryPerformanceCounter(&t2);
+
+        double ms_old = double(t1.QuadPart - t0.QuadPart) * 1000 / freq.QuadPart;
+        double ms_new = double(t2.QuadPart - t1.QuadPart) * 1000 / freq.QuadPart;
+        printf("%-8s rejection %8.1f us/list  alias %8.1f us/list  x%.1f  (%lld)\n", m.first,
+               ms_old * 1000 / count, ms_new * 1000 / count, ms_old / (std::max)(ms_new, 1e-9), checksum);
+    }
+
+    return 0;
+}
+
+} // namespace Pt
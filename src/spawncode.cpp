@@ -0,0 +1,213 @@
+
+#include "../inc/spawncode.h"
+
+namespace Pt
+{
+
+#define SYMBOL_EMPTY 33
+#define SYMBOL_REPEAT 63
+#define REPEAT_MIN 2
+#define REPEAT_MAX (REPEAT_MIN + 63)
+
+// 版本 + 波数 + 每波(个数 + 每只一个符号) + CRC32
+#define CODE_BYTES_MAX (1 + 1 + (WAVE_COUNT * (1 + WAVE_SIZE) * 6 + 7) / 8 + 4)
+
+static uint32_t code_crc(const uint8_t *data, size_t size)
+{
+    return uint32_t(crc32(crc32(0L, Z_NULL, 0), data, uInt(size)));
+}
+
+// 高位在前写入 6 位一组
+class BitWriter
+{
+  public:
+    explicit BitWriter(std::vector<uint8_t> &out) : out(out), acc(0), bits(0)
+    {
+    }
+
+    void Put(uint32_t value)
+    {
+        acc = (acc << 6) | (value & 0x3f);
+        bits += 6;
+        while (bits >= 8)
+        {
+            bits -= 8;
+            out.push_back(uint8_t(acc >> bits));
+        }
+    }
+
+    void Flush()
+    {
+        if (bits > 0)
+            out.push_back(uint8_t(acc << (8 - bits)));
+        acc = 0;
+        bits = 0;
+    }
+
+  protected:
+    std::vector<uint8_t> &out;
+    uint32_t acc;
+    int bits;
+};
+
+// 64 位缓冲, 每次补满后连续取出多组, 不逐位判断
+class BitReader
+{
+  public:
+    BitReader(const uint8_t *data, size_t size) : data(data), end(data + size), acc(0), bits(0)
+    {
+    }
+
+    // 数据不够时返回假
+    bool Get(uint32_t &value)
+    {
+        if (bits < 6)
+        {
+            while (bits <= 56 && data < end)
+            {
+                acc |= uint64_t(*data++) << (56 - bits);
+                bits += 8;
+            }
+            if (bits < 6)
+                return false;
+        }
+        value = uint32_t(acc >> 58);
+        acc <<= 6;
+        bits -= 6;
+        return true;
+    }
+
+  protected:
+    const uint8_t *data;
+    const uint8_t *end;
+    uint64_t acc;
+    int bits;
+};
+
+static uint32_t to_symbol(int type)
+{
+    return (type >= 0 && type < 33) ? uint32_t(type) : SYMBOL_EMPTY;
+}
+
+std::string EncodeSpawnList(const std::array<int, 1000> &list)
+{
+    // 每波的有效长度
+    int lengths[WAVE_COUNT];
+    int waves = 0;
+    for (int w = 0; w < WAVE_COUNT; w++)
+    {
+        const int *wave = &list[w * WAVE_SIZE];
+        int n = WAVE_SIZE;
+        while (n > 0 && to_symbol(wave[n - 1]) == SYMBOL_EMPTY)
+            n--;
+        lengths[w] = n;
+        if (n > 0)
+            waves = w + 1;
+    }
+
+    std::vector<uint8_t> bytes;
+    bytes.reserve(CODE_BYTES_MAX);
+    bytes.push_back(SPAWN_CODE_VERSION);
+    bytes.push_back(uint8_t(waves));
+
+    BitWriter writer(bytes);
+    for (int w = 0; w < waves; w++)
+    {
+        const int *wave = &list[w * WAVE_SIZE];
+        int n = lengths[w];
+        writer.Put(n);
+        for (int j = 0; j < n;)
+        {
+            uint32_t symbol = to_symbol(wave[j]);
+            writer.Put(symbol);
+            j++;
+
+            int k = 0;
+            while (j + k < n && k < REPEAT_MAX && to_symbol(wave[j + k]) == symbol)
+                k++;
+            if (k >= REPEAT_MIN)
+            {
+                writer.Put(SYMBOL_REPEAT);
+                writer.Put(k - REPEAT_MIN);
+                j += k;
+            }
+        }
+    }
+    writer.Flush();
+
+    uint32_t crc = code_crc(bytes.data(), bytes.size());
+    for (int i = 0; i < 4; i++)
+        bytes.push_back(uint8_t(crc >> (i * 8)));
+
+    std::string code((bytes.size() + 2) / 3 * 4, '\0');
+    code.resize(base64_encode(&code[0], bytes.data(), bytes.size()));
+    return code;
+}
+
+bool DecodeSpawnList(const std::string &str, std::array<int, 1000> &list)
+{
+    // 去掉空白和末尾的 '='
+    std::string code;
+    code.reserve(str.size());
+    for (char c : str)
+        if (c != ' ' && c != '\t' && c != '\r' && c != '\n' && c != '=')
+            code.push_back(c);
+
+    size_t expected = code.size() * 6 / 8;
+    if (code.empty() || expected > CODE_BYTES_MAX)
+        return false;
+
+    uint8_t bytes[CODE_BYTES_MAX + 3];
+    size_t size = base64_decode(bytes, code.c_str(), code.size());
+    if (size != expected || size < 1 + 1 + 4) // 有非法字符时会提前停止
+        return false;
+
+    size -= 4;
+    uint32_t crc = bytes[size] | (bytes[size + 1] << 8) | (bytes[size + 2] << 16) | (uint32_t(bytes[size + 3]) << 24);
+    if (bytes[0] != SPAWN_CODE_VERSION || bytes[1] > WAVE_COUNT || code_crc(bytes, size) != crc)
+        return false;
+
+    std::array<int, 1000> result;
+    result.fill(-1);
+
+    int waves = bytes[1];
+    BitReader reader(bytes + 2, size - 2);
+    for (int w = 0; w < waves; w++)
+    {
+        int *wave = &result[w * WAVE_SIZE];
+        uint32_t n;
+        if (!reader.Get(n) || n > WAVE_SIZE)
+            return false;
+
+        int last = -1;
+        for (uint32_t j = 0; j < n;)
+        {
+            uint32_t symbol;
+            if (!reader.Get(symbol))
+                return false;
+
+            if (symbol == SYMBOL_REPEAT)
+            {
+                uint32_t k;
+                if (j == 0 || !reader.Get(k) || j + k + REPEAT_MIN > n)
+                    return false;
+                std::fill(wave + j, wave + j + k + REPEAT_MIN, last);
+                j += k + REPEAT_MIN;
+            }
+            else if (symbol <= SYMBOL_EMPTY)
+            {
+                last = symbol == SYMBOL_EMPTY ? -1 : int(symbol);
+                wave[j++] = last;
+            }
+            else
+            {
+                return false;
+            }
+        }
+    }
+
+    list = result;
+    return true;
+}
+
+} // namespace Pt
@@ -0,0 +1,352 @@
+
+#include "../inc/spawnlib.h"
+
+namespace Pt
+{
+
+// 每一波编码后最多的字节数
+#define ENCODED_MAX (WAVE_COUNT * (1 + WAVE_SIZE))
+
+static uint32_t lib_crc(const uint8_t *data, uint32_t size)
+{
+    return uint32_t(crc32(crc32(0L, Z_NULL, 0), data, uInt(size)));
+}
+
+// FILETIME 转 Unix 时间戳
+static uint32_t unix_time(const FILETIME &ft)
+{
+    uint64_t t = (uint64_t(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+    const uint64_t EPOCH = 116444736000000000ULL; // 1970-01-01
+    return t > EPOCH ? uint32_t((t - EPOCH) / 10000000) : 0;
+}
+
+// 复制到定长字段, 放不下时在 UTF-8 字符边界截断, 不留下半个字符
+template <size_t N>
+static void copy_utf8(char (&dest)[N], const std::string &src)
+{
+    size_t n = (std::min)(src.size(), N - 1);
+    while (n > 0 && n < src.size() && (uint8_t(src[n]) & 0xc0) == 0x80)
+        n--;
+    strncpy_s(dest, src.substr(0, n).c_str(), _TRUNCATE);
+}
+
+// 编码出怪列表, 每波先写个数(到最后一个有效位置为止), 再逐个写种类, -1 写成 0xff
+// 种类超出一字节能表示的范围时返回假, 不截断
+static bool encode(const std::array<int, 1000> &list, uint8_t *out, uint16_t *counts, uint32_t &size)
+{
+    size = 0;
+    for (int w = 0; w < WAVE_COUNT; w++)
+    {
+        const int *wave = &list[w * WAVE_SIZE];
+        for (int j = 0; j < WAVE_SIZE; j++)
+            if (wave[j] < -1 || wave[j] >= 0xff)
+                return false;
+
+        int n = WAVE_SIZE;
+        while (n > 0 && wave[n - 1] == -1)
+            n--;
+
+        out[size++] = uint8_t(n);
+        for (int j = 0; j < n; j++)
+        {
+            int type = wave[j];
+            out[size++] = type == -1 ? 0xff : uint8_t(type);
+            if (type >= 0 && type < 33)
+                counts[type]++;
+        }
+    }
+    return true;
+}
+
+static bool decode(const uint8_t *data, uint32_t size, std::array<int, 1000> &list)
+{
+    list.fill(-1);
+    uint32_t pos = 0;
+    for (int w = 0; w < WAVE_COUNT; w++)
+    {
+        if (pos >= size)
+            return false;
+        int n = data[pos++];
+        if (n > WAVE_SIZE || pos + n > size)
+            return false;
+        for (int j = 0; j < n; j++)
+        {
+            uint8_t type = data[pos++];
+            list[w * WAVE_SIZE + j] = type == 0xff ? -1 : type;
+        }
+    }
+    return pos == size;
+}
+
+bool ReadZbl(const std::wstring &path, std::array<int, 1000> &list)
+{
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec || size != (1 + 1 + 1 + ZBL_LENGTH + 1) * sizeof(int))
+        return false;
+
+    std::ifstream infile(std::filesystem::path(path), std::ios::binary | std::ios::in);
+    if (!infile)
+        return false;
+
+    int data[1 + 1 + 1 + ZBL_LENGTH + 1] = {0};
+    infile.read(reinterpret_cast<char *>(&data), sizeof(data));
+    if (!infile)
+        return false;
+
+    uint32_t crc = lib_crc((const uint8_t *)data, (3 + ZBL_LENGTH) * sizeof(int));
+    if (uint32_t(data[0]) != ZBL_MAGIC || data[1] != ZBL_VERSION || data[2] != ZBL_LENGTH //
+        || uint32_t(data[3 + ZBL_LENGTH]) != crc)
+        return false;
+
+    for (size_t i = 0; i < 1000; i++)
+        list[i] = data[3 + i];
+    return true;
+}
+
+SpawnLibrary::SpawnLibrary()
+{
+    file = INVALID_HANDLE_VALUE;
+    mapping = nullptr;
+    view = nullptr;
+    size = 0;
+    header = {};
+}
+
+SpawnLibrary::~SpawnLibrary()
+{
+    Close();
+}
+
+bool SpawnLibrary::Open(const std::wstring &path)
+{
+    Close();
+
+    file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size))
+    {
+        Close();
+        return false;
+    }
+
+    // 新文件, 写入文件头和第一个空索引块
+    if (file_size.QuadPart == 0)
+    {
+        header.magic = SPAWN_LIB_MAGIC;
+        header.version = SPAWN_LIB_VERSION;
+        header.count = 0;
+        header.first_block = sizeof(SPAWN_LIB_HEADER);
+
+        std::vector<uint8_t> block(sizeof(SPAWN_LIB_BLOCK), 0);
+        if (!write_at(header.first_block, block.data(), uint32_t(block.size())) //
+            || !write_at(0, &header, sizeof(header)))
+        {
+            Close();
+            return false;
+        }
+    }
+
+    if (!remap())
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void SpawnLibrary::Close()
+{
+    if (view != nullptr)
+        UnmapViewOfFile(view);
+    if (mapping != nullptr)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+
+    file = INVALID_HANDLE_VALUE;
+    mapping = nullptr;
+    view = nullptr;
+    size = 0;
+    header = {};
+    blocks.clear();
+}
+
+bool SpawnLibrary::remap()
+{
+    if (view != nullptr)
+        UnmapViewOfFile(view);
+    if (mapping != nullptr)
+        CloseHandle(mapping);
+    view = nullptr;
+    mapping = nullptr;
+    blocks.clear();
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < LONGLONG(sizeof(SPAWN_LIB_HEADER)))
+        return false;
+    size = uint64_t(file_size.QuadPart);
+
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr)
+        view = (const uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+        return false;
+
+    memcpy(&header, view, sizeof(header));
+    if (header.magic != SPAWN_LIB_MAGIC || header.version != SPAWN_LIB_VERSION)
+        return false;
+
+    // 至少有一个索引块, 之后每满一块多一块
+    uint32_t needed = (std::max)(1u, (header.count + SPAWN_LIB_BLOCK_CAPACITY - 1) / SPAWN_LIB_BLOCK_CAPACITY);
+    uint32_t offset = header.first_block;
+    while (blocks.size() < needed)
+    {
+        if (offset < sizeof(SPAWN_LIB_HEADER) || uint64_t(offset) + sizeof(SPAWN_LIB_BLOCK) > size)
+            return false;
+        blocks.push_back(offset);
+        offset = ((const SPAWN_LIB_BLOCK *)(view + offset))->next;
+    }
+
+    return true;
+}
+
+bool SpawnLibrary::write_at(uint64_t offset, const void *data, uint32_t length)
+{
+    LARGE_INTEGER pos;
+    pos.QuadPart = LONGLONG(offset);
+    DWORD written = 0;
+    return SetFilePointerEx(file, pos, nullptr, FILE_BEGIN)           //
+           && WriteFile(file, data, length, &written, nullptr) == TRUE //
+           && written == length;
+}
+
+uint32_t SpawnLibrary::Count() const
+{
+    return header.count;
+}
+
+const SPAWN_LIB_ENTRY *SpawnLibrary::Entry(uint32_t index) const
+{
+    if (view == nullptr || index >= header.count)
+        return nullptr;
+
+    const SPAWN_LIB_BLOCK *block = (const SPAWN_LIB_BLOCK *)(view + blocks[index / SPAWN_LIB_BLOCK_CAPACITY]);
+    return &block->entries[index % SPAWN_LIB_BLOCK_CAPACITY];
+}
+
+bool SpawnLibrary::List(uint32_t index, std::array<int, 1000> &list) const
+{
+    const SPAWN_LIB_ENTRY *entry = Entry(index);
+    if (entry == nullptr || uint64_t(entry->offset) + entry->size > size)
+        return false;
+
+    const uint8_t *data = view + entry->offset;
+    if (lib_crc(data, entry->size) != entry->crc)
+        return false;
+
+    return decode(data, entry->size, list);
+}
+
+bool SpawnLibrary::append(const std::string &name, const std::string &tags, const std::array<int, 1000> &list, uint32_t time)
+{
+    if (file == INVALID_HANDLE_VALUE || blocks.empty())
+        return false;
+
+    SPAWN_LIB_ENTRY entry = {};
+    uint8_t data[ENCODED_MAX];
+    if (!encode(list, data, entry.counts, entry.size))
+        return false;
+    entry.crc = lib_crc(data, entry.size);
+    entry.time = time;
+    copy_utf8(entry.name, name);
+    copy_utf8(entry.tags, tags);
+
+    uint64_t end = size;
+
+    // 当前索引块满了, 在末尾追加新块再链接到上一块
+    uint32_t index = header.count;
+    bool new_block = index / SPAWN_LIB_BLOCK_CAPACITY >= blocks.size();
+    if (new_block)
+    {
+        uint32_t offset = uint32_t(end);
+        std::vector<uint8_t> block(sizeof(SPAWN_LIB_BLOCK), 0);
+        if (!write_at(offset, block.data(), uint32_t(block.size())) //
+            || !write_at(blocks.back() + offsetof(SPAWN_LIB_BLOCK, next), &offset, sizeof(offset)))
+            return false;
+        blocks.push_back(offset);
+        end += sizeof(SPAWN_LIB_BLOCK);
+    }
+
+    // 列表数据, 索引项, 条数依次写入, 都成功后才推进文件末尾
+    // 中途失败时撤销新加的索引块, 下次追加会覆盖写了一半的内容
+    entry.offset = uint32_t(end);
+    uint64_t entry_offset = blocks[index / SPAWN_LIB_BLOCK_CAPACITY]    //
+                            + offsetof(SPAWN_LIB_BLOCK, entries)        //
+                            + (index % SPAWN_LIB_BLOCK_CAPACITY) * sizeof(SPAWN_LIB_ENTRY);
+    uint32_t count = header.count + 1;
+    if (end + entry.size > UINT32_MAX                             //
+        || !write_at(end, data, entry.size)                       //
+        || !write_at(entry_offset, &entry, sizeof(entry))         //
+        || !write_at(offsetof(SPAWN_LIB_HEADER, count), &count, sizeof(count)))
+    {
+        if (new_block)
+            blocks.pop_back();
+        return false;
+    }
+
+    header.count = count;
+    size = end + entry.size;
+
+    return true;
+}
+
+bool SpawnLibrary::Append(const std::string &name, const std::string &tags, const std::array<int, 1000> &list, uint32_t time)
+{
+    bool ok = append(name, tags, list, time);
+    return remap() && ok;
+}
+
+uint32_t SpawnLibrary::Import(const std::wstring &dir, const std::string &tags)
+{
+    if (file == INVALID_HANDLE_VALUE)
+        return 0;
+
+    // 按文件名排序, 导入顺序稳定
+    std::vector<std::filesystem::path> paths;
+    std::error_code ec;
+    for (auto &item : std::filesystem::directory_iterator(dir, ec))
+        if (item.is_regular_file(ec) && item.path().extension() == L".zbl")
+            paths.push_back(item.path());
+    std::sort(paths.begin(), paths.end());
+
+    uint32_t imported = 0;
+    for (auto &path : paths)
+    {
+        std::array<int, 1000> list;
+        if (!ReadZbl(path.wstring(), list))
+            continue;
+
+        uint32_t time = 0;
+        WIN32_FILE_ATTRIBUTE_DATA attr;
+        if (GetFileAttributesExW(path.wstring().c_str(), GetFileExInfoStandard, &attr))
+            time = unix_time(attr.ftLastWriteTime);
+
+        if (!append(path.stem().u8string(), tags, list, time))
+            break;
+        imported++;
+    }
+
+#ifdef _DEBUG
+    std::wcout << L"导入出怪列表 " << imported << L" / " << paths.size() << std::endl;
+#endif
+
+    remap();
+    return imported;
+}
+
+} // namespace Pt
@@ -0,0 +1,334 @@
+
+#include "../inc/spawnsearch.h"
+
+namespace Pt
+{
+
+// 生成器在某一波(从 0 开始)最多放几只这种僵尸
+// 旗帜和蹦极只在旗帜波的预设部分出现, 雪人整个列表最多一只
+static int max_count(int type, int wave)
+{
+    bool flag_wave = wave % 10 == 9;
+    if (type == ZOMBIE_FLAG)
+        return flag_wave ? 1 : 0;
+    if (type == ZOMBIE_BUNGEE)
+        return flag_wave ? FLAG_BUNGEE_COUNT : 0;
+    if (type == ZOMBIE_YETI)
+        return 1;
+    return WAVE_SIZE;
+}
+
+// 至少约束要求的数量超过生成器的上限时不可能满足
+static bool feasible(const SpawnConstraint &c)
+{
+    if (c.op != SPAWN_AT_LEAST)
+        return true;
+
+    int total = 0;
+    for (int w = 0; w < WAVE_COUNT; w++)
+    {
+        if (!(c.waves & (1u << w)))
+            continue;
+        int n = max_count(c.type, w);
+        if (c.each && n < c.value)
+            return false;
+        total += n;
+    }
+    if (c.type == ZOMBIE_YETI)
+        total = (std::min)(total, 1);
+
+    return c.each || total >= c.value;
+}
+
+bool ParseSpawnConstraint(const std::string &text, SpawnConstraint &constraint)
+{
+    std::istringstream in(text);
+    std::string waves, mode, op;
+    int type = -1;
+    int value = -1;
+    if (!(in >> type >> waves >> mode >> op >> value))
+        return false;
+    if (type < 0 || type >= 33 || value < 0)
+        return false;
+
+    uint32_t mask = 0;
+    if (waves == "all")
+    {
+        mask = (1u << WAVE_COUNT) - 1;
+    }
+    else if (waves == "flag")
+    {
+        mask = (1u << (10 - 1)) | (1u << (20 - 1));
+    }
+    else
+    {
+        int a = 0, b = 0;
+        char dash = 0;
+        std::istringstream range(waves);
+        range >> a;
+        if (range >> dash >> b)
+        {
+            if (dash != '-')
+                return false;
+        }
+        else
+        {
+            b = a;
+        }
+        if (a < 1 || b > WAVE_COUNT || a > b)
+            return false;
+        for (int w = a; w <= b; w++)
+            mask |= 1u << (w - 1);
+    }
+
+    if (mode != "each" && mode != "total")
+        return false;
+    if (op != "min" && op != "max")
+        return false;
+
+    constraint.type = type;
+    constraint.waves = mask;
+    constraint.each = mode == "each";
+    constraint.op = op == "min" ? SPAWN_AT_LEAST : SPAWN_AT_MOST;
+    constraint.value = value;
+    return feasible(constraint);
+}
+
+// 数量为 n 时违反约束的量
+static int violation_of(const SpawnConstraint &c, int n)
+{
+    if (c.op == SPAWN_AT_LEAST)
+        return (std::max)(c.value - n, 0);
+    else
+        return (std::max)(n - c.value, 0);
+}
+
+SpawnSearch::SpawnSearch(const WaveRules &rules)
+    : natural(new WaveGenerator(rules))
+{
+    waves_count = (std::min)((std::max)(rules.waves, 0), WAVE_COUNT);
+    base_violation = 0;
+    count = 0;
+    seed = 0;
+    keep = 0;
+}
+
+SpawnSearch::SpawnSearch(const std::array<bool, 33> &zombies, bool limit_giga, bool simulate, int giga_weight)
+    : custom(new CustomSpawner(zombies, limit_giga, simulate, giga_weight))
+{
+    waves_count = WAVE_COUNT;
+    base_violation = 0;
+    count = 0;
+    seed = 0;
+    keep = 0;
+}
+
+void SpawnSearch::AddConstraint(const SpawnConstraint &constraint)
+{
+    SpawnConstraint c = constraint;
+    c.waves &= (1u << waves_count) - 1;
+
+    // 涉及的波数都不存在时数量总是 0
+    if (c.waves == 0)
+    {
+        base_violation += violation_of(c, 0);
+        return;
+    }
+
+    int last = 0;
+    for (int w = 0; w < waves_count; w++)
+        if (c.waves & (1u << w))
+            last = w;
+
+    constraints.push_back(c);
+    last_wave.push_back(last);
+}
+
+void SpawnSearch::ClearConstraints()
+{
+    constraints.clear();
+    last_wave.clear();
+    base_violation = 0;
+}
+
+uint32_t SpawnSearch::Tried()
+{
+    uint32_t tried = 0;
+    for (auto &worker : workers)
+        tried += worker.tried;
+    return tried;
+}
+
+uint32_t SpawnSearch::Pruned()
+{
+    uint32_t pruned = 0;
+    for (auto &worker : workers)
+        pruned += worker.pruned;
+    return pruned;
+}
+
+int SpawnSearch::check_wave(const std::array<int, 1000> &list, int wave, Progress &progress) const
+{
+    int counts[33] = {0};
+    bool counted = false;
+    int open = 0; // 还没结算的合计约束目前已经超出的量
+
+    for (size_t k = 0; k < constraints.size(); k++)
+    {
+        const SpawnConstraint &c = constraints[k];
+
+        if (c.waves & (1u << wave))
+        {
+            if (!counted)
+            {
+                for (int j = 0; j < WAVE_SIZE; j++)
+                {
+                    int type = list[wave * WAVE_SIZE + j];
+                    if (type < 0 || type >= 33)
+                        break;
+                    counts[type]++;
+                }
+                counted = true;
+            }
+
+            int n = counts[c.type];
+            if (c.each)
+            {
+                progress.settled += violation_of(c, n);
+                continue;
+            }
+            progress.totals[k] += n;
+            if (wave == last_wave[k])
+            {
+                progress.settled += violation_of(c, progress.totals[k]);
+                continue;
+            }
+        }
+
+        // 数量只增不减, 至多约束提前超出的部分一定会计入
+        if (!c.each && c.op == SPAWN_AT_MOST && wave < last_wave[k])
+            open += violation_of(c, progress.totals[k]);
+    }
+
+    return progress.settled + open;
+}
+
+bool SpawnSearch::generate(std::mt19937 &gen, std::array<int, 1000> &list, const std::function<bool(int)> &on_wave) const
+{
+    if (natural)
+        return natural->Generate(gen, list, on_wave);
+    else
+        return custom->Generate(gen, list, on_wave);
+}
+
+// 违反量小的在前, 相同时编号小的在前
+static bool better(const SpawnCandidate &a, const SpawnCandidate &b)
+{
+    if (a.violation != b.violation)
+        return a.violation < b.violation;
+    return a.index < b.index;
+}
+
+void SpawnSearch::work(Worker &worker, uint32_t chunk)
+{
+    SpawnCandidate candidate;
+    Progress progress;
+
+    uint32_t begin = chunk * CHUNK_SIZE;
+    if (begin > first_found)
+        return;
+    uint32_t end = (std::min)(begin + CHUNK_SIZE, count);
+
+    for (uint32_t i = begin; i < end; i++)
+    {
+        if (i > first_found)
+            break;
+
+        // 已经找到满足的之后只找编号更小的满足的, 否则不能比已有的最差的还差
+        int limit = 0;
+        if (first_found == UINT32_MAX)
+            limit = worker.best.size() < keep ? INT_MAX : worker.best.back().violation;
+
+        progress.totals.assign(constraints.size(), 0);
+        progress.settled = base_violation;
+        int bound = base_violation;
+
+        // 每个候选单独设置种子, 放弃与否不影响其他候选
+        std::mt19937 gen(seed + i);
+        worker.tried++;
+        bool complete = bound <= limit && generate(gen, candidate.list, [&](int wave)
+                                                   {
+            bound = check_wave(candidate.list, wave, progress);
+            return bound <= limit; });
+        if (!complete)
+        {
+            worker.pruned++;
+            continue;
+        }
+
+        candidate.violation = bound;
+        candidate.index = i;
+
+        if (bound == 0)
+        {
+            uint32_t found = first_found;
+            while (i < found && !first_found.compare_exchange_weak(found, i))
+                ;
+            if (!worker.found || i < worker.first.index)
+                worker.first = candidate;
+            worker.found = true;
+            break;
+        }
+
+        auto it = std::upper_bound(worker.best.begin(), worker.best.end(), candidate, better);
+        worker.best.insert(it, candidate);
+        if (worker.best.size() > keep)
+            worker.best.pop_back();
+    }
+}
+
+void SpawnSearch::run(uint32_t count, uint32_t seed, size_t keep)
+{
+    this->count = count;
+    this->seed = seed;
+    this->keep = keep;
+    this->first_found = UINT32_MAX;
+
+    uint32_t chunks = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    workers.assign(parallel_threads(chunks), Worker());
+    for (auto &worker : workers)
+    {
+        worker.found = false;
+        worker.tried = 0;
+        worker.pruned = 0;
+    }
+
+    parallel_for(chunks, [&](uint32_t chunk, size_t t)
+                 { work(workers[t], chunk); });
+}
+
+bool SpawnSearch::FindFirst(uint32_t count, uint32_t seed, size_t k, std::vector<SpawnCandidate> &result)
+{
+    result.clear();
+    run(count, seed, (std::max)(k, size_t(1)));
+
+    const SpawnCandidate *first = nullptr;
+    for (auto &worker : workers)
+        if (worker.found && (first == nullptr || worker.first.index < first->index))
+            first = &worker.first;
+    if (first != nullptr)
+    {
+        result.push_back(*first);
+        return true;
+    }
+
+    for (auto &worker : workers)
+        result.insert(result.end(), worker.best.begin(), worker.best.end());
+    std::sort(result.begin(), result.end(), better);
+    if (result.size() > k)
+        result.resize(k);
+
+    return false;
+}
+
+} // namespace Pt
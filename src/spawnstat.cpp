@@ -0,0 +1,138 @@
+
+#include "../inc/spawnstat.h"
+
+namespace Pt
+{
+
+SpawnAnalyzer::SpawnAnalyzer(const WaveRules &rules) : generator(rules)
+{
+    // 旗帜波总会出旗帜和普僵
+    for (int t = 0; t < SPAWN_STAT_TYPES; t++)
+        if (rules.zombies[t] || t == 0 || t == 1)
+            types.push_back(t);
+
+    samples = 0;
+    seed = 0;
+}
+
+void SpawnAnalyzer::sample(Worker &worker, const std::array<int, 1000> &list)
+{
+    uint8_t counts[SPAWN_STAT_TYPES][WAVE_COUNT] = {{0}};
+    int totals[SPAWN_STAT_TYPES] = {0};
+    for (int w = 0; w < WAVE_COUNT; w++)
+        for (int j = 0; j < WAVE_SIZE; j++)
+        {
+            int type = list[w * WAVE_SIZE + j];
+            if (type < 0 || type >= SPAWN_STAT_TYPES)
+                break;
+            counts[type][w]++;
+            totals[type]++;
+        }
+
+    for (int t : types)
+    {
+        uint32_t *hist = &worker.hist[t * WAVE_COUNT * (WAVE_SIZE + 1)];
+        for (int w = 0; w < WAVE_COUNT; w++)
+            hist[w * (WAVE_SIZE + 1) + counts[t][w]]++;
+        worker.hist_total[t * (TOTAL_MAX + 1) + (std::min)(totals[t], TOTAL_MAX)]++;
+    }
+
+    // 第 10-19 波
+    for (int w = 10 - 1; w < 19; w++)
+        if (counts[32][w] > 0)
+        {
+            worker.giga_late++;
+            break;
+        }
+}
+
+void SpawnAnalyzer::work(Worker &worker, uint32_t chunk)
+{
+    // 每块用自己的种子连续生成
+    std::mt19937 gen(seed + chunk);
+    std::array<int, 1000> list;
+    uint32_t begin = chunk * CHUNK_SIZE;
+    uint32_t end = (std::min)(begin + CHUNK_SIZE, samples);
+    for (uint32_t i = begin; i < end; i++)
+    {
+        generator.Generate(gen, list);
+        sample(worker, list);
+    }
+}
+
+// 直方图中累计数量达到比例的最小取值
+static int percentile(const uint32_t *hist, int bins, uint32_t samples, double p)
+{
+    uint64_t target = uint64_t(samples * p + 0.5);
+    uint64_t sum = 0;
+    for (int k = 0; k < bins; k++)
+    {
+        sum += hist[k];
+        if (sum >= target && sum > 0)
+            return k;
+    }
+    return bins - 1;
+}
+
+SpawnStats SpawnAnalyzer::Run(uint32_t samples, uint32_t seed, int threads_count)
+{
+    SpawnStats stats;
+    if (samples == 0)
+        return stats;
+
+    double start = double(GetTickCount());
+    this->samples = samples;
+    this->seed = seed;
+
+    uint32_t chunks = (samples + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<Worker> workers(parallel_threads(chunks, threads_count));
+    for (auto &worker : workers)
+    {
+        worker.hist.assign(SPAWN_STAT_TYPES * WAVE_COUNT * (WAVE_SIZE + 1), 0);
+        worker.hist_total.assign(SPAWN_STAT_TYPES * (TOTAL_MAX + 1), 0);
+        worker.giga_late = 0;
+    }
+
+    parallel_for(chunks, [&](uint32_t chunk, size_t t)
+                 { work(workers[t], chunk); }, threads_count);
+
+    // 合并
+    std::vector<uint32_t> hist(SPAWN_STAT_TYPES * WAVE_COUNT * (WAVE_SIZE + 1), 0);
+    std::vector<uint32_t> hist_total(SPAWN_STAT_TYPES * (TOTAL_MAX + 1), 0);
+    uint32_t giga_late = 0;
+    for (auto &worker : workers)
+    {
+        for (size_t k = 0; k < hist.size(); k++)
+            hist[k] += worker.hist[k];
+        for (size_t k = 0; k < hist_total.size(); k++)
+            hist_total[k] += worker.hist_total[k];
+        giga_late += worker.giga_late;
+    }
+
+    stats.samples = samples;
+    for (int t : types)
+    {
+        for (int c = 0; c < SPAWN_STAT_COLS; c++)
+        {
+            bool is_total = c == SPAWN_STAT_COLS - 1;
+            const uint32_t *h = is_total ? &hist_total[t * (TOTAL_MAX + 1)]
+                                         : &hist[(t * WAVE_COUNT + c) * (WAVE_SIZE + 1)];
+            int bins = is_total ? TOTAL_MAX + 1 : WAVE_SIZE + 1;
+
+            double sum = 0;
+            for (int k = 0; k < bins; k++)
+                sum += double(k) * h[k];
+            stats.mean[t][c] = sum / samples;
+            stats.appear[t][c] = double(samples - h[0]) / samples;
+            stats.p10[t][c] = percentile(h, bins, samples, 0.1);
+            stats.p50[t][c] = percentile(h, bins, samples, 0.5);
+            stats.p90[t][c] = percentile(h, bins, samples, 0.9);
+        }
+    }
+    stats.giga_late = double(giga_late) / samples;
+    stats.elapsed_ms = double(GetTickCount()) - start;
+
+    return stats;
+}
+
+} // namespace Pt
@@ -0,0 +1,831 @@
+
+#include "../inc/telemetry.h"
+
+#include <cstdio>
+#include <filesystem>
+
+namespace Pt
+{
+
+static void put_varint(std::vector<uint8_t> &out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(uint8_t(value));
+}
+
+// 差值用无符号运算, 溢出时也能原样还原
+static void put_delta(std::vector<uint8_t> &out, int32_t prev, int32_t curr)
+{
+    int32_t delta = int32_t(uint32_t(curr) - uint32_t(prev));
+    put_varint(out, (uint32_t(delta) << 1) ^ uint32_t(delta >> 31));
+}
+
+static bool get_varint(const uint8_t *&p, const uint8_t *end, uint32_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (p >= end)
+            return false;
+        uint8_t byte = *p++;
+        value |= uint32_t(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+static bool get_delta(const uint8_t *&p, const uint8_t *end, int32_t &value)
+{
+    uint32_t zigzag;
+    if (!get_varint(p, end, zigzag))
+        return false;
+    uint32_t delta = (zigzag >> 1) ^ (0u - (zigzag & 1));
+    value = int32_t(uint32_t(value) + delta);
+    return true;
+}
+
+// 槽位数, 变化的槽位数, 然后每个变化的槽位: 间隔, 字段掩码, 各字段差值
+static void encode_entities(const std::vector<TelemetryEntity> &prev, const std::vector<TelemetryEntity> &curr, std::vector<uint8_t> &out)
+{
+    static const TelemetryEntity empty = {};
+
+    auto mask_of = [&](size_t i) -> uint8_t
+    {
+        const TelemetryEntity &a = i < prev.size() ? prev[i] : empty;
+        const TelemetryEntity &b = curr[i];
+        uint8_t mask = 0;
+        for (int f = 0; f < TELEMETRY_FIELD_COUNT; f++)
+            if (a.field[f] != b.field[f])
+                mask |= 1 << f;
+        return mask;
+    };
+
+    uint32_t changed = 0;
+    for (size_t i = 0; i < curr.size(); i++)
+        if (mask_of(i) != 0)
+            changed++;
+
+    put_varint(out, uint32_t(curr.size()));
+    put_varint(out, changed);
+
+    size_t next = 0;
+    for (size_t i = 0; i < curr.size(); i++)
+    {
+        uint8_t mask = mask_of(i);
+        if (mask == 0)
+            continue;
+
+        const TelemetryEntity &a = i < prev.size() ? prev[i] : empty;
+        put_varint(out, uint32_t(i - next));
+        out.push_back(mask);
+        for (int f = 0; f < TELEMETRY_FIELD_COUNT; f++)
+            if (mask & (1 << f))
+                put_delta(out, a.field[f], curr[i].field[f]);
+        next = i + 1;
+    }
+}
+
+static bool decode_entities(const uint8_t *&p, const uint8_t *end, std::vector<TelemetryEntity> &state)
+{
+    uint32_t size, changed;
+    if (!get_varint(p, end, size) || !get_varint(p, end, changed))
+        return false;
+    if (size > 0x10000 || changed > size)
+        return false;
+
+    state.resize(size, TelemetryEntity{});
+
+    size_t next = 0;
+    for (uint32_t n = 0; n < changed; n++)
+    {
+        uint32_t gap;
+        if (!get_varint(p, end, gap) || p >= end)
+            return false;
+        size_t i = next + gap;
+        if (i >= size)
+            return false;
+
+        uint8_t mask = *p++;
+        for (int f = 0; f < TELEMETRY_FIELD_COUNT; f++)
+            if (mask & (1 << f))
+                if (!get_delta(p, end, state[i].field[f]))
+                    return false;
+        next = i + 1;
+    }
+
+    return true;
+}
+
+void TelemetryEncode(const TelemetryFrame &prev, const TelemetryFrame &curr, std::vector<uint8_t> &out)
+{
+    put_delta(out, prev.clock, curr.clock);
+    put_delta(out, prev.sun, curr.sun);
+    put_delta(out, prev.wave, curr.wave);
+    encode_entities(prev.plants, curr.plants, out);
+    encode_entities(prev.zombies, curr.zombies, out);
+}
+
+bool TelemetryDecode(const uint8_t *&p, const uint8_t *end, TelemetryFrame &state)
+{
+    return get_delta(p, end, state.clock)           //
+           && get_delta(p, end, state.sun)          //
+           && get_delta(p, end, state.wave)         //
+           && decode_entities(p, end, state.plants) //
+           && decode_entities(p, end, state.zombies);
+}
+
+TelemetryRecorder::TelemetryRecorder(PvZ *pvz)
+    : queue(QUEUE_CHUNKS)
+{
+    this->pvz = pvz;
+    this->interval = 1;
+    this->frame_count = 0;
+    this->queue_event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    this->sampler = nullptr;
+    this->writer = nullptr;
+    this->stopping = false;
+    this->draining = false;
+    this->recording = false;
+    this->frames_written = 0;
+    this->frames_dropped = 0;
+}
+
+TelemetryRecorder::~TelemetryRecorder()
+{
+    Stop();
+    CloseHandle(queue_event);
+}
+
+void TelemetryRecorder::SetInterval(int frames)
+{
+    if (!recording)
+        interval = (std::max)(frames, 1);
+}
+
+bool TelemetryRecorder::Start(const std::wstring &path)
+{
+    if (recording)
+        return false;
+
+    file.open(std::filesystem::path(path), std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!file)
+        return false;
+
+    TELEMETRY_HEADER header = {TELEMETRY_MAGIC, TELEMETRY_VERSION, uint32_t(interval), 0};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    index.clear();
+    chunk.reset();
+    prev_frame = TelemetryFrame();
+    frame_count = 0;
+    frames_written = 0;
+    frames_dropped = 0;
+    stopping = false;
+    draining = false;
+    recording = true;
+
+    writer = CreateThread(nullptr, 0, write_thread, this, 0, nullptr);
+    sampler = CreateThread(nullptr, 0, sample_thread, this, 0, nullptr);
+
+    return true;
+}
+
+void TelemetryRecorder::Stop()
+{
+    if (!recording)
+        return;
+
+    // 先停采样, 采样线程退出前会提交最后一个数据块
+    stopping = true;
+    if (sampler != nullptr)
+    {
+        WaitForSingleObject(sampler, INFINITE);
+        CloseHandle(sampler);
+        sampler = nullptr;
+    }
+
+    draining = true;
+    SetEvent(queue_event);
+    if (writer != nullptr)
+    {
+        WaitForSingleObject(writer, INFINITE);
+        CloseHandle(writer);
+        writer = nullptr;
+    }
+
+    TELEMETRY_FOOTER footer;
+    footer.index_offset = uint64_t(file.tellp());
+    footer.count = uint32_t(index.size());
+    footer.magic = TELEMETRY_INDEX_MAGIC;
+    if (!index.empty())
+        file.write(reinterpret_cast<const char *>(index.data()), index.size() * sizeof(TELEMETRY_INDEX));
+    file.write(reinterpret_cast<const char *>(&footer), sizeof(footer));
+    file.close();
+
+    recording = false;
+}
+
+bool TelemetryRecorder::Recording()
+{
+    return recording;
+}
+
+size_t TelemetryRecorder::FramesWritten()
+{
+    return frames_written;
+}
+
+size_t TelemetryRecorder::FramesDropped()
+{
+    return frames_dropped;
+}
+
+DWORD WINAPI TelemetryRecorder::sample_thread(LPVOID lpParam)
+{
+    ((TelemetryRecorder *)lpParam)->sample();
+    return 0;
+}
+
+DWORD WINAPI TelemetryRecorder::write_thread(LPVOID lpParam)
+{
+    ((TelemetryRecorder *)lpParam)->write();
+    return 0;
+}
+
+void TelemetryRecorder::capture(const BoardSnapshot &snapshot, TelemetryFrame &frame)
+{
+    auto &plants = snapshot.plants;
+    frame.plants.resize(plants.alive.size());
+    for (size_t i = 0; i < plants.alive.size(); i++)
+    {
+        auto &e = frame.plants[i].field;
+        if (plants.alive[i])
+        {
+            e[TELEMETRY_FIELD_ID] = plants.id[i];
+            e[TELEMETRY_FIELD_ALIVE] = 1;
+            e[TELEMETRY_FIELD_TYPE] = plants.type[i] + (plants.imitater[i] ? 48 : 0);
+            e[TELEMETRY_FIELD_ROW] = plants.row[i];
+            e[TELEMETRY_FIELD_POS] = plants.col[i];
+            e[TELEMETRY_FIELD_HP] = plants.hp[i];
+        }
+        else // 空槽位的残留数据没有意义, 清零减少差异
+        {
+            frame.plants[i] = TelemetryEntity{};
+        }
+    }
+
+    auto &zombies = snapshot.zombies;
+    frame.zombies.resize(zombies.alive.size());
+    for (size_t i = 0; i < zombies.alive.size(); i++)
+    {
+        auto &e = frame.zombies[i].field;
+        if (zombies.alive[i])
+        {
+            e[TELEMETRY_FIELD_ID] = zombies.id[i];
+            e[TELEMETRY_FIELD_ALIVE] = 1;
+            e[TELEMETRY_FIELD_TYPE] = zombies.type[i];
+            e[TELEMETRY_FIELD_ROW] = zombies.row[i];
+            e[TELEMETRY_FIELD_POS] = int32_t(zombies.x[i]);
+            e[TELEMETRY_FIELD_HP] = zombies.hp[i];
+        }
+        else
+        {
+            frame.zombies[i] = TelemetryEntity{};
+        }
+    }
+}
+
+void TelemetryRecorder::flush()
+{
+    if (!chunk || chunk->header.frame_count == 0)
+        return;
+
+    uint32_t frames = chunk->header.frame_count;
+    if (queue.Push(std::move(chunk)))
+        SetEvent(queue_event);
+    else
+        frames_dropped += frames;
+
+    // 下一帧开始新的数据块
+    chunk.reset();
+}
+
+void TelemetryRecorder::sample()
+{
+    int last_clock = 0;
+    bool first = true;
+    TelemetryFrame frame;
+
+    // 版本数据拷贝代价不小, 只在离开战斗界面时刷新
+    auto data = pvz->data();
+
+    while (!stopping)
+    {
+        if (!pvz->IsValid() || pvz->GameUI() != 3)
+        {
+            Sleep(100);
+            data = pvz->data();
+            continue;
+        }
+
+        int clock = pvz->ReadMemory<int>({data.lawn, data.board, data.game_clock});
+        int passed = clock - last_clock;
+        if (!first && passed >= 0 && passed < interval)
+        {
+            // 游戏加速时一帧只有 1ms, Sleep 的精度不够, 只能让出时间片
+            int frame_duration = pvz->ReadMemory<int>({data.lawn, data.frame_duration});
+            int wait_ms = (interval - passed) * frame_duration;
+            Sleep(wait_ms >= 2 ? wait_ms - 1 : 0);
+            continue;
+        }
+
+        // 只读不写, 每次读内存各自持有共享锁, 不拿操作锁, 界面线程的修改不用等采样
+        BoardSnapshot snapshot;
+        bool captured = snapshot.Capture(*pvz, data, pvz->layouts(), SNAPSHOT_PLANT | SNAPSHOT_ZOMBIE);
+        if (captured)
+        {
+            frame.sun = pvz->ReadMemory<int>({data.lawn, data.board, data.sun});
+            frame.wave = pvz->ReadMemory<int>({data.lawn, data.board, data.current_wave});
+        }
+
+        if (!captured)
+        {
+            // 读取失败(游戏关闭或者离开战斗)也等一个采样间隔, 不要空转
+            int frame_duration = pvz->ReadMemory<int>({data.lawn, data.frame_duration});
+            Sleep((std::max)(interval * frame_duration, 10));
+            continue;
+        }
+        capture(snapshot, frame);
+        frame.clock = clock;
+
+        if (!chunk)
+        {
+            chunk.reset(new Chunk);
+            chunk->header = {TELEMETRY_CHUNK_MAGIC, frame_count, 0, clock, clock, 0, 0, 0};
+            chunk->raw.reserve(CHUNK_BYTES);
+            prev_frame = TelemetryFrame(); // 关键帧
+        }
+
+        TelemetryEncode(prev_frame, frame, chunk->raw);
+        chunk->header.frame_count++;
+        chunk->header.last_clock = clock;
+        std::swap(prev_frame, frame);
+        frame_count++;
+        last_clock = clock;
+        first = false;
+
+        if (chunk->header.frame_count >= CHUNK_FRAMES || chunk->raw.size() >= CHUNK_BYTES)
+            flush();
+    }
+
+    flush();
+}
+
+void TelemetryRecorder::write()
+{
+    std::unique_ptr<Chunk> c;
+    std::vector<uint8_t> comp;
+
+    while (true)
+    {
+        // 先读标志再取数据, 保证最后一轮能取完
+        bool last = draining;
+
+        while (queue.Pop(c))
+        {
+            uLongf comp_size = compressBound(uLong(c->raw.size()));
+            comp.resize(comp_size);
+            if (compress2(comp.data(), &comp_size, c->raw.data(), uLong(c->raw.size()), Z_BEST_SPEED) != Z_OK)
+            {
+                frames_dropped += c->header.frame_count;
+                continue;
+            }
+
+            c->header.raw_size = uint32_t(c->raw.size());
+            c->header.comp_size = uint32_t(comp_size);
+            c->header.crc = crc32(crc32(0L, Z_NULL, 0), comp.data(), uInt(comp_size));
+
+            TELEMETRY_INDEX entry;
+            entry.offset = uint64_t(file.tellp());
+            entry.first_frame = c->header.first_frame;
+            entry.frame_count = c->header.frame_count;
+            entry.first_clock = c->header.first_clock;
+            entry.last_clock = c->header.last_clock;
+
+            file.write(reinterpret_cast<const char *>(&c->header), sizeof(c->header));
+            file.write(reinterpret_cast<const char *>(comp.data()), comp_size);
+            file.flush();
+
+            index.push_back(entry);
+            frames_written += c->header.frame_count;
+        }
+
+        if (last)
+            break;
+
+        WaitForSingleObject(queue_event, 100);
+    }
+}
+
+TelemetryReader::TelemetryReader()
+{
+    this->file = INVALID_HANDLE_VALUE;
+    this->mapping = nullptr;
+    this->view = nullptr;
+    this->size = 0;
+    this->header = {0, 0, 0, 0};
+}
+
+TelemetryReader::~TelemetryReader()
+{
+    Close();
+}
+
+bool TelemetryReader::Open(const std::wstring &path)
+{
+    Close();
+
+    file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < LONGLONG(sizeof(TELEMETRY_HEADER)))
+    {
+        Close();
+        return false;
+    }
+    size = uint64_t(file_size.QuadPart);
+
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr)
+        view = (const uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    memcpy(&header, view, sizeof(header));
+    if (header.magic != TELEMETRY_MAGIC || header.version != TELEMETRY_VERSION || !load_index())
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void TelemetryReader::Close()
+{
+    if (view != nullptr)
+        UnmapViewOfFile(view);
+    if (mapping != nullptr)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+
+    file = INVALID_HANDLE_VALUE;
+    mapping = nullptr;
+    view = nullptr;
+    size = 0;
+    index.clear();
+}
+
+bool TelemetryReader::load_index()
+{
+    index.clear();
+
+    if (size >= sizeof(TELEMETRY_HEADER) + sizeof(TELEMETRY_FOOTER))
+    {
+        TELEMETRY_FOOTER footer;
+        memcpy(&footer, view + size - sizeof(footer), sizeof(footer));
+        uint64_t index_size = uint64_t(footer.count) * sizeof(TELEMETRY_INDEX);
+        if (footer.magic == TELEMETRY_INDEX_MAGIC                                  //
+            && footer.index_offset >= sizeof(TELEMETRY_HEADER)                     //
+            && footer.index_offset + index_size + sizeof(footer) == size)          //
+        {
+            index.resize(footer.count);
+            if (!index.empty())
+                memcpy(index.data(), view + footer.index_offset, size_t(index_size));
+            return true;
+        }
+    }
+
+    // 没有文件尾, 顺序扫描
+    uint64_t offset = sizeof(TELEMETRY_HEADER);
+    while (offset + sizeof(TELEMETRY_CHUNK) <= size)
+    {
+        TELEMETRY_CHUNK chunk;
+        memcpy(&chunk, view + offset, sizeof(chunk));
+        if (chunk.magic != TELEMETRY_CHUNK_MAGIC || offset + sizeof(chunk) + chunk.comp_size > size)
+            break;
+        index.push_back({offset, chunk.first_frame, chunk.frame_count, chunk.first_clock, chunk.last_clock});
+        offset += sizeof(chunk) + chunk.comp_size;
+    }
+
+    return true;
+}
+
+uint32_t TelemetryReader::Interval()
+{
+    return header.interval;
+}
+
+uint32_t TelemetryReader::FrameCount()
+{
+    if (index.empty())
+        return 0;
+    return index.back().first_frame + index.back().frame_count;
+}
+
+const std::vector<TELEMETRY_INDEX> &TelemetryReader::Index()
+{
+    return index;
+}
+
+bool TelemetryReader::inflate(size_t i, std::vector<uint8_t> &raw)
+{
+    if (i >= index.size())
+        return false;
+
+    uint64_t offset = index[i].offset;
+    if (offset + sizeof(TELEMETRY_CHUNK) > size)
+        return false;
+
+    TELEMETRY_CHUNK chunk;
+    memcpy(&chunk, view + offset, sizeof(chunk));
+    const uint8_t *comp = view + offset + sizeof(chunk);
+    if (chunk.magic != TELEMETRY_CHUNK_MAGIC || offset + sizeof(chunk) + chunk.comp_size > size)
+        return false;
+    if (crc32(crc32(0L, Z_NULL, 0), comp, chunk.comp_size) != chunk.crc)
+        return false;
+
+    raw.resize(chunk.raw_size);
+    uLongf raw_size = chunk.raw_size;
+    if (uncompress(raw.data(), &raw_size, comp, chunk.comp_size) != Z_OK || raw_size != chunk.raw_size)
+        return false;
+
+    return true;
+}
+
+bool TelemetryReader::ForEachFrame(size_t i, const std::function<void(uint32_t, const TelemetryFrame &)> &func)
+{
+    std::vector<uint8_t> raw;
+    if (!inflate(i, raw))
+        return false;
+
+    TelemetryFrame state;
+    const uint8_t *p = raw.data();
+    const uint8_t *end = raw.data() + raw.size();
+    for (uint32_t n = 0; n < index[i].frame_count; n++)
+    {
+        if (!TelemetryDecode(p, end, state))
+            return false;
+        func(index[i].first_frame + n, state);
+    }
+
+    return true;
+}
+
+bool TelemetryReader::FrameAt(uint32_t frame, TelemetryFrame &result)
+{
+    // 找到 first_frame 不大于 frame 的最后一个数据块
+    auto it = std::upper_bound(index.begin(), index.end(), frame,
+                               [](uint32_t f, const TELEMETRY_INDEX &e)
+                               { return f < e.first_frame; });
+    if (it == index.begin())
+        return false;
+    --it;
+    if (frame >= it->first_frame + it->frame_count) // 录制时丢弃的帧
+        return false;
+
+    std::vector<uint8_t> raw;
+    if (!inflate(it - index.begin(), raw))
+        return false;
+
+    TelemetryFrame state;
+    const uint8_t *p = raw.data();
+    const uint8_t *end = raw.data() + raw.size();
+    for (uint32_t f = it->first_frame; f <= frame; f++)
+        if (!TelemetryDecode(p, end, state))
+            return false;
+
+    result = std::move(state);
+    return true;
+}
+
+typedef std::map<std::pair<int32_t, int32_t>, uint32_t> LossMap;
+
+// 前一帧存活而后一帧消失(或者槽位被复用)的植物
+static void count_losses(const TelemetryFrame &a, const TelemetryFrame &b, LossMap &losses)
+{
+    for (size_t i = 0; i < a.plants.size(); i++)
+    {
+        auto &pa = a.plants[i].field;
+        if (!pa[TELEMETRY_FIELD_ALIVE])
+            continue;
+        bool gone = i >= b.plants.size()                                           //
+                    || !b.plants[i].field[TELEMETRY_FIELD_ALIVE]                   //
+                    || b.plants[i].field[TELEMETRY_FIELD_ID] != pa[TELEMETRY_FIELD_ID]; //
+        if (gone)
+            losses[{b.wave, pa[TELEMETRY_FIELD_TYPE]}]++;
+    }
+}
+
+bool TelemetryReader::Analyze(uint32_t bucket_frames, TelemetryStats &stats)
+{
+    struct ChunkResult
+    {
+        bool ok = false;
+        std::map<uint32_t, TelemetryBucket> buckets;
+        LossMap losses;
+        TelemetryFrame first;
+        TelemetryFrame last;
+    };
+
+    bucket_frames = (std::max)(bucket_frames, 1u);
+    std::vector<ChunkResult> results(index.size());
+
+    parallel_for(uint32_t(index.size()), [&](uint32_t i, size_t)
+                 {
+        ChunkResult &r = results[i];
+        TelemetryFrame prev;
+        bool has_prev = false;
+        r.ok = ForEachFrame(i, [&](uint32_t frame, const TelemetryFrame &state)
+                            {
+            uint32_t key = frame / bucket_frames;
+            auto it = r.buckets.find(key);
+            if (it == r.buckets.end())
+            {
+                TelemetryBucket bucket = {frame, state.clock, 0, {0, 0, 0, 0, 0, 0}, 0};
+                it = r.buckets.insert({key, bucket}).first;
+            }
+            TelemetryBucket &b = it->second;
+            b.frames++;
+            b.sun += state.sun;
+            for (auto &z : state.zombies)
+            {
+                int row = z.field[TELEMETRY_FIELD_ROW];
+                if (z.field[TELEMETRY_FIELD_ALIVE] && row >= 0 && row < 6)
+                    b.zombies[row] += 1;
+            }
+
+            if (has_prev)
+                count_losses(prev, state, r.losses);
+            else
+                r.first = state;
+            prev = state;
+            has_prev = true; });
+        r.last = std::move(prev); });
+
+    // 按顺序合并, 数据块之间的损失用前一块最后一帧和后一块第一帧比较
+    std::map<uint32_t, TelemetryBucket> buckets;
+    LossMap losses;
+    bool ok = true;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        ChunkResult &r = results[i];
+        if (!r.ok)
+        {
+            ok = false;
+            continue;
+        }
+
+        for (auto &kv : r.buckets)
+        {
+            auto it = buckets.find(kv.first);
+            if (it == buckets.end())
+            {
+                buckets.insert(kv);
+                continue;
+            }
+            TelemetryBucket &a = it->second;
+            const TelemetryBucket &b = kv.second;
+            if (b.first_frame < a.first_frame)
+            {
+                a.first_frame = b.first_frame;
+                a.clock = b.clock;
+            }
+            a.frames += b.frames;
+            a.sun += b.sun;
+            for (int row = 0; row < 6; row++)
+                a.zombies[row] += b.zombies[row];
+        }
+
+        for (auto &kv : r.losses)
+            losses[kv.first] += kv.second;
+
+        if (i > 0 && results[i - 1].ok && index[i - 1].first_frame + index[i - 1].frame_count == index[i].first_frame)
+            count_losses(results[i - 1].last, r.first, losses);
+    }
+
+    stats.frames = FrameCount();
+    stats.buckets.clear();
+    for (auto &kv : buckets)
+    {
+        TelemetryBucket b = kv.second;
+        b.sun /= b.frames;
+        for (int row = 0; row < 6; row++)
+            b.zombies[row] /= b.frames;
+        stats.buckets.push_back(b);
+    }
+    stats.losses.clear();
+    for (auto &kv : losses)
+        stats.losses.push_back({kv.first.first, kv.first.second, kv.second});
+
+    return ok;
+}
+
+static std::string plant_name(int type)
+{
+    if (type < 0 || type >= 96)
+        return std::to_string(type);
+    return type >= 48 ? std::string(plants[type - 48]) + " (Imitater)" : std::string(plants[type]);
+}
+
+static std::string zombie_name(int type)
+{
+    if (type < 0 || type >= 33)
+        return std::to_string(type);
+    return zombies[type];
+}
+
+int TelemetryQuery(int argc, char **argv)
+{
+    if (argc < 2)
+        return 0xF7;
+
+    TelemetryReader reader;
+    if (!reader.Open(std::filesystem::path(argv[0]).wstring()))
+    {
+        printf("cannot open %s\n", argv[0]);
+        return 1;
+    }
+
+    std::string query = argv[1];
+    uint32_t arg = argc >= 3 ? uint32_t(strtoul(argv[2], nullptr, 10)) : 0;
+
+    if (query == "info")
+    {
+        printf("interval %u\nframes %u\nchunks %u\n", reader.Interval(), reader.FrameCount(), uint32_t(reader.Index().size()));
+        for (auto &e : reader.Index())
+            printf("chunk frame %u-%u clock %d-%d\n", e.first_frame, e.first_frame + e.frame_count - 1, e.first_clock, e.last_clock);
+        return 0;
+    }
+
+    if (query == "frame")
+    {
+        TelemetryFrame frame;
+        if (!reader.FrameAt(arg, frame))
+        {
+            printf("frame %u not recorded\n", arg);
+            return 1;
+        }
+        printf("frame %u clock %d sun %d wave %d\n", arg, frame.clock, frame.sun, frame.wave);
+        for (auto &e : frame.plants)
+            if (e.field[TELEMETRY_FIELD_ALIVE])
+                printf("plant %d %d %s hp %d\n", e.field[TELEMETRY_FIELD_ROW] + 1, e.field[TELEMETRY_FIELD_POS] + 1,
+                       plant_name(e.field[TELEMETRY_FIELD_TYPE]).c_str(), e.field[TELEMETRY_FIELD_HP]);
+        for (auto &e : frame.zombies)
+            if (e.field[TELEMETRY_FIELD_ALIVE])
+                printf("zombie %d x %d %s hp %d\n", e.field[TELEMETRY_FIELD_ROW] + 1, e.field[TELEMETRY_FIELD_POS],
+                       zombie_name(e.field[TELEMETRY_FIELD_TYPE]).c_str(), e.field[TELEMETRY_FIELD_HP]);
+        return 0;
+    }
+
+    if (query != "rows" && query != "sun" && query != "losses")
+        return 0xF7;
+
+    TelemetryStats stats;
+    bool ok = reader.Analyze(arg == 0 ? 100 : arg, stats);
+
+    if (query == "rows")
+    {
+        printf("frame,clock,row1,row2,row3,row4,row5,row6\n");
+        for (auto &b : stats.buckets)
+            printf("%u,%d,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n", b.first_frame, b.clock,
+                   b.zombies[0], b.zombies[1], b.zombies[2], b.zombies[3], b.zombies[4], b.zombies[5]);
+    }
+    else if (query == "sun")
+    {
+        printf("frame,clock,sun\n");
+        for (auto &b : stats.buckets)
+            printf("%u,%d,%.1f\n", b.first_frame, b.clock, b.sun);
+    }
+    else
+    {
+        printf("wave,plant,count\n");
+        for (auto &l : stats.losses)
+            printf("%d,%s,%u\n", l.wave, plant_name(l.type).c_str(), l.count);
+    }
+
+    return ok ? 0 : 2;
+}
+
+} // namespace Pt
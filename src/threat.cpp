@@ -0,0 +1,289 @@
+
+#include "../inc/threat.h"
+
+namespace Pt
+{
+
+// 空位对应的行
+#define EMPTY_ROW 33
+
+const ZombieThreat ThreatAnalyzer::ZOMBIES[33] = {
+    {270, THREAT_SPEED_NORMAL, 0},                       // 普僵
+    {270, THREAT_SPEED_NORMAL, 0},                       // 旗帜
+    {640, THREAT_SPEED_NORMAL, 0},                       // 路障
+    {500, THREAT_SPEED_FAST, THREAT_FLAG_VAULT},         // 撑杆
+    {1370, THREAT_SPEED_NORMAL, 0},                      // 铁桶
+    {420, THREAT_SPEED_NORMAL, 0},                       // 读报
+    {1370, THREAT_SPEED_NORMAL, 0},                      // 铁门
+    {1670, THREAT_SPEED_FAST, 0},                        // 橄榄
+    {500, THREAT_SPEED_NORMAL, 0},                       // 舞王
+    {270, THREAT_SPEED_NORMAL, 0},                       // 伴舞
+    {270, THREAT_SPEED_NORMAL, 0},                       // 鸭子
+    {270, THREAT_SPEED_NORMAL, 0},                       // 潜水
+    {1350, THREAT_SPEED_SLOW, THREAT_FLAG_CRUSH},        // 冰车
+    {1080, THREAT_SPEED_FAST, 0},                        // 雪橇, 四只
+    {500, THREAT_SPEED_FAST, THREAT_FLAG_VAULT},         // 海豚
+    {500, THREAT_SPEED_FAST, THREAT_FLAG_EXPLODE},       // 小丑
+    {290, THREAT_SPEED_NORMAL, THREAT_FLAG_AIR},         // 气球
+    {370, THREAT_SPEED_FAST, THREAT_FLAG_DIG},           // 矿工
+    {500, THREAT_SPEED_FAST, THREAT_FLAG_VAULT},         // 跳跳
+    {1350, THREAT_SPEED_NORMAL, 0},                      // 雪人
+    {450, THREAT_SPEED_NORMAL, 0},                       // 蹦极
+    {1000, THREAT_SPEED_FAST, THREAT_FLAG_LADDER},       // 扶梯
+    {850, THREAT_SPEED_SLOW, THREAT_FLAG_CRUSH},         // 投篮
+    {3000, THREAT_SPEED_SLOW, THREAT_FLAG_CRUSH},        // 白眼
+    {270, THREAT_SPEED_FAST, 0},                         // 小鬼
+    {60000, THREAT_SPEED_SLOW, THREAT_FLAG_CRUSH},       // 僵博
+    {270, THREAT_SPEED_NORMAL, 0},                       // 豌豆
+    {1370, THREAT_SPEED_NORMAL, 0},                      // 坚果
+    {270, THREAT_SPEED_NORMAL, THREAT_FLAG_EXPLODE},     // 辣椒
+    {270, THREAT_SPEED_NORMAL, 0},                       // 机枪
+    {270, THREAT_SPEED_NORMAL, THREAT_FLAG_CRUSH},       // 窝瓜
+    {2470, THREAT_SPEED_NORMAL, 0},                      // 高墙
+    {6000, THREAT_SPEED_SLOW, THREAT_FLAG_CRUSH},        // 红眼
+};
+
+bool ParseThreatMetric(const std::string &text, ThreatMetric &metric)
+{
+    static const char *names[THREAT_FEATURES] = {"hp", "fast", "ladder", "vault", "air", "dig", "crush", "explode"};
+
+    ThreatMetric result;
+    bool custom = false;
+    std::istringstream in(text);
+    std::string token;
+    while (in >> token)
+    {
+        if (token == "total" || token == "peak")
+        {
+            result.peak = token == "peak";
+            continue;
+        }
+
+        size_t eq = token.find('=');
+        if (eq == std::string::npos)
+            return false;
+        std::string name = token.substr(0, eq);
+        int k = 0;
+        while (k < THREAT_FEATURES && name != names[k])
+            k++;
+        if (k == THREAT_FEATURES)
+            return false;
+
+        char *end = nullptr;
+        float weight = strtof(token.c_str() + eq + 1, &end);
+        if (end == token.c_str() + eq + 1 || *end != '\0')
+            return false;
+
+        if (!custom)
+        {
+            std::fill(std::begin(result.weights), std::end(result.weights), 0.0f);
+            custom = true;
+        }
+        result.weights[k] = weight;
+    }
+
+    metric = result;
+    return true;
+}
+
+ThreatAnalyzer::ThreatAnalyzer(const ThreatMetric &metric) : metric(metric)
+{
+    for (int t = 0; t < 33; t++)
+    {
+        const ZombieThreat &z = ZOMBIES[t];
+        float *v = rows[t].v;
+        v[THREAT_HP] = z.hp / 270.0f;
+        v[THREAT_FAST] = z.speed == THREAT_SPEED_FAST ? 1.0f : 0.0f;
+        v[THREAT_LADDER] = (z.flags & THREAT_FLAG_LADDER) ? 1.0f : 0.0f;
+        v[THREAT_VAULT] = (z.flags & THREAT_FLAG_VAULT) ? 1.0f : 0.0f;
+        v[THREAT_AIR] = (z.flags & THREAT_FLAG_AIR) ? 1.0f : 0.0f;
+        v[THREAT_DIG] = (z.flags & THREAT_FLAG_DIG) ? 1.0f : 0.0f;
+        v[THREAT_CRUSH] = (z.flags & THREAT_FLAG_CRUSH) ? 1.0f : 0.0f;
+        v[THREAT_EXPLODE] = (z.flags & THREAT_FLAG_EXPLODE) ? 1.0f : 0.0f;
+    }
+    std::fill(std::begin(rows[EMPTY_ROW].v), std::end(rows[EMPTY_ROW].v), 0.0f);
+
+    for (int t = 0; t < 34; t++)
+    {
+        weighted[t] = 0;
+        for (int k = 0; k < THREAT_FEATURES; k++)
+            weighted[t] += rows[t].v[k] * metric.weights[k];
+    }
+}
+
+// 种类转成表的行号, 不合法的算空位, 不用分支中断循环
+static inline int row_of(int type)
+{
+    return (unsigned(type) < 33u) ? type : EMPTY_ROW;
+}
+
+void ThreatAnalyzer::Waves(const std::array<int, 1000> &list, ThreatVector (&waves)[20]) const
+{
+    for (int w = 0; w < WAVE_COUNT; w++)
+    {
+        const int *wave = &list[w * WAVE_SIZE];
+#ifdef THREAT_SSE2
+        __m128 lo = _mm_setzero_ps();
+        __m128 hi = _mm_setzero_ps();
+        for (int j = 0; j < WAVE_SIZE; j++)
+        {
+            const float *row = rows[row_of(wave[j])].v;
+            lo = _mm_add_ps(lo, _mm_load_ps(row));
+            hi = _mm_add_ps(hi, _mm_load_ps(row + 4));
+        }
+        _mm_store_ps(waves[w].v, lo);
+        _mm_store_ps(waves[w].v + 4, hi);
+#else
+        float acc[THREAT_FEATURES] = {0};
+        for (int j = 0; j < WAVE_SIZE; j++)
+        {
+            const float *row = rows[row_of(wave[j])].v;
+            for (int k = 0; k < THREAT_FEATURES; k++)
+                acc[k] += row[k];
+        }
+        std::copy(std::begin(acc), std::end(acc), waves[w].v);
+#endif
+    }
+}
+
+ThreatVector ThreatAnalyzer::Total(const uint16_t (&counts)[33]) const
+{
+    ThreatVector total;
+    std::fill(std::begin(total.v), std::end(total.v), 0.0f);
+    for (int t = 0; t < 33; t++)
+        for (int k = 0; k < THREAT_FEATURES; k++)
+            total.v[k] += rows[t].v[k] * counts[t];
+    return total;
+}
+
+float ThreatAnalyzer::Score(const std::array<int, 1000> &list) const
+{
+    float best = 0;
+    float sum = 0;
+    for (int w = 0; w < WAVE_COUNT; w++)
+    {
+        const int *wave = &list[w * WAVE_SIZE];
+        float score = 0;
+        for (int j = 0; j < WAVE_SIZE; j++)
+            score += weighted[row_of(wave[j])];
+        best = (std::max)(best, score);
+        sum += score;
+    }
+    return metric.peak ? best : sum;
+}
+
+float ThreatAnalyzer::Score(const uint16_t (&counts)[33]) const
+{
+    float sum = 0;
+    for (int t = 0; t < 33; t++)
+        sum += weighted[t] * counts[t];
+    return sum;
+}
+
+float ThreatAnalyzer::Score(const ThreatVector &threat) const
+{
+    float sum = 0;
+    for (int k = 0; k < THREAT_FEATURES; k++)
+        sum += threat.v[k] * metric.weights[k];
+    return sum;
+}
+
+void ThreatAnalyzer::work(Job &job, uint32_t chunk) const
+{
+    std::array<int, 1000> list;
+    uint32_t begin = chunk * CHUNK_SIZE;
+    uint32_t end = (std::min)(begin + CHUNK_SIZE, job.count);
+
+    for (uint32_t i = begin; i < end; i++)
+    {
+        float score = -1; // 读取失败的排在最后
+        if (job.lists != nullptr)
+            score = Score((*job.lists)[i]);
+        else if (!metric.peak)
+            score = Score(job.library->Entry(i)->counts);
+        else if (job.library->List(i, list))
+            score = Score(list);
+        job.scores[i] = score;
+    }
+}
+
+std::vector<ThreatRank> ThreatAnalyzer::rank(Job &job, size_t k, int threads_count) const
+{
+    job.scores.assign(job.count, 0.0f);
+
+    uint32_t chunks = (job.count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    parallel_for(chunks, [&](uint32_t chunk, size_t)
+                 { work(job, chunk); }, threads_count);
+
+    std::vector<ThreatRank> result(job.count);
+    for (uint32_t i = 0; i < job.count; i++)
+        result[i] = {job.scores[i], i};
+
+    // 得分从高到低, 相同时编号小的在前
+    k = (std::min)(k, result.size());
+    std::partial_sort(result.begin(), result.begin() + k, result.end(), [](const ThreatRank &a, const ThreatRank &b) {
+        return a.score != b.score ? a.score > b.score : a.index < b.index;
+    });
+    result.resize(k);
+    return result;
+}
+
+std::vector<ThreatRank> ThreatAnalyzer::Rank(const SpawnLibrary &library, size_t k, int threads_count) const
+{
+    Job job;
+    job.library = &library;
+    job.lists = nullptr;
+    job.count = library.Count();
+    return rank(job, k, threads_count);
+}
+
+std::vector<ThreatRank> ThreatAnalyzer::Rank(const std::vector<std::array<int, 1000>> &lists, size_t k, int threads_count) const
+{
+    Job job;
+    job.library = nullptr;
+    job.lists = &lists;
+    job.count = uint32_t(lists.size());
+    return rank(job, k, threads_count);
+}
+
+int ThreatQuery(int argc, char **argv)
+{
+    if (argc < 1)
+        return 0xF7;
+
+    std::string text;
+    for (int i = 1; i < argc; i++)
+        text += std::string(argv[i]) + " ";
+    ThreatMetric metric;
+    if (!ParseThreatMetric(text, metric))
+    {
+        printf("bad metric: %s\n", text.c_str());
+        return 0xF7;
+    }
+
+    std::error_code ec;
+    SpawnLibrary library;
+    if (!std::filesystem::exists(std::filesystem::path(argv[0]), ec) || !library.Open(std::filesystem::path(argv[0]).wstring()))
+    {
+        printf("cannot open %s\n", argv[0]);
+        return 1;
+    }
+
+    LARGE_INTEGER freq, t0, t1;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t0);
+    ThreatAnalyzer analyzer(metric);
+    auto ranks = analyzer.Rank(library, 20);
+    QueryPerformanceCounter(&t1);
+
+    printf("%u lists ranked in %.1f ms\n", library.Count(), double(t1.QuadPart - t0.QuadPart) * 1000.0 / double(freq.QuadPart));
+    for (size_t i = 0; i < ranks.size(); i++)
+    {
+        const SPAWN_LIB_ENTRY *entry = library.Entry(ranks[i].index);
+        printf("%2zu %10.1f #%u %s\n", i + 1, ranks[i].score, ranks[i].index, entry->name);
+    }
+
+    return 0;
+}
+
+} // namespace Pt
@@ -0,0 +1,355 @@
+
+#include "../inc/timeline.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace Pt
+{
+
+// 可以在时间轴上开关的功能
+static const struct
+{
+    const char *name;
+    void (PvZ::*func)(bool);
+} timeline_hacks[] = {
+    {"UnlockSunLimit", &PvZ::UnlockSunLimit},
+    {"AutoCollected", &PvZ::AutoCollected},
+    {"NotDropLoot", &PvZ::NotDropLoot},
+    {"FreePlanting", &PvZ::FreePlanting},
+    {"PlacedAnywhere", &PvZ::PlacedAnywhere},
+    {"FastBelt", &PvZ::FastBelt},
+    {"LockShovel", &PvZ::LockShovel},
+    {"PlantInvincible", &PvZ::PlantInvincible},
+    {"PlantWeak", &PvZ::PlantWeak},
+    {"ZombieInvincible", &PvZ::ZombieInvincible},
+    {"ZombieWeak", &PvZ::ZombieWeak},
+    {"ReloadInstantly", &PvZ::ReloadInstantly},
+    {"MushroomsAwake", &PvZ::MushroomsAwake},
+    {"StopSpawning", &PvZ::StopSpawning},
+    {"StopZombies", &PvZ::StopZombies},
+    {"LockButter", &PvZ::LockButter},
+    {"NoCrater", &PvZ::NoCrater},
+    {"NoIceTrail", &PvZ::NoIceTrail},
+    {"ZombieNotExplode", &PvZ::ZombieNotExplode},
+    {"NoFog", &PvZ::NoFog},
+    {"SeeVase", &PvZ::SeeVase},
+};
+
+// 可以在时间轴上修改的数值, 都通过修改功能按各自的指针链写入
+static const struct
+{
+    const char *name;
+    void (PvZ::*func)(int);
+} timeline_writes[] = {
+    {"sun", &PvZ::SetSun},
+    {"money", &PvZ::SetMoney},
+    {"rounds", &PvZ::EndlessRounds},
+    {"tree", &PvZ::SetTreeHeight},
+    {"speed", &PvZ::SetFrameDuration},
+};
+
+Timeline::Timeline(PvZ *pvz)
+{
+    this->pvz = pvz;
+    this->thread = nullptr;
+    this->stop_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    this->running = false;
+    this->executed = 0;
+    this->max_late = 0;
+}
+
+Timeline::~Timeline()
+{
+    Stop();
+    CloseHandle(stop_event);
+}
+
+void Timeline::Clear()
+{
+    if (thread == nullptr)
+        actions.clear();
+}
+
+void Timeline::Add(const TimelineAction &action)
+{
+    if (thread == nullptr)
+        actions.push_back(action);
+}
+
+bool Timeline::HackExists(const std::string &name)
+{
+    for (auto &hack : timeline_hacks)
+        if (name == hack.name)
+            return true;
+    return false;
+}
+
+bool Timeline::WriteExists(const std::string &name)
+{
+    for (auto &write : timeline_writes)
+        if (name == write.name)
+            return true;
+    return false;
+}
+
+int Timeline::Load(const std::wstring &file)
+{
+    if (thread != nullptr)
+        return -1;
+
+    std::ifstream ifs(file.c_str());
+    if (!ifs)
+        return -1;
+
+    std::vector<TimelineAction> loaded;
+    int line = 0;
+    std::string str;
+    while (std::getline(ifs, str))
+    {
+        line++;
+        if (!str.empty() && str.back() == '\r')
+            str.pop_back();
+        size_t begin = str.find_first_not_of(" \t");
+        if (begin == std::string::npos || str[begin] == '#') // 空行或者注释
+            continue;
+
+        std::istringstream iss(str);
+        std::string time, kind;
+        if (!(iss >> time >> kind) || time.empty())
+            return line;
+
+        TimelineAction action = {0, time[0] == '+', 0, {0, 0, 0, 0}, ""};
+        char *end = nullptr;
+        long clock = strtol(time.c_str() + (action.relative ? 1 : 0), &end, 10);
+        if (*end != '\0' || clock < 0)
+            return line;
+        action.clock = int(clock);
+
+        if (kind == "plant")
+        {
+            int row, col, type, imitater = 0;
+            if (!(iss >> row >> col >> type))
+                return line;
+            iss >> imitater;
+            if (row < 1 || row > 6 || col < 1 || col > 9 || type < 0 || type >= 48)
+                return line;
+            action.kind = TIMELINE_PLANT;
+            action.args[0] = row - 1;
+            action.args[1] = col - 1;
+            action.args[2] = type;
+            action.args[3] = imitater != 0;
+        }
+        else if (kind == "zombie")
+        {
+            int row, col, type;
+            if (!(iss >> row >> col >> type))
+                return line;
+            if (row < 1 || row > 6 || col < 1 || col > 9 || type < 0 || type >= 33 || type == 25)
+                return line;
+            action.kind = TIMELINE_ZOMBIE;
+            action.args[0] = row - 1;
+            action.args[1] = col - 1;
+            action.args[2] = type;
+        }
+        else if (kind == "hack")
+        {
+            int on;
+            if (!(iss >> action.name >> on) || !HackExists(action.name))
+                return line;
+            action.kind = TIMELINE_HACK;
+            action.args[0] = on != 0;
+        }
+        else if (kind == "write")
+        {
+            int value;
+            if (!(iss >> action.name >> value) || !WriteExists(action.name))
+                return line;
+            action.kind = TIMELINE_WRITE;
+            action.args[0] = value;
+        }
+        else if (kind == "pause")
+        {
+            action.kind = TIMELINE_PAUSE;
+        }
+        else if (kind == "unpause")
+        {
+            action.kind = TIMELINE_UNPAUSE;
+        }
+        else
+        {
+            return line;
+        }
+
+        loaded.push_back(action);
+    }
+
+    actions = std::move(loaded);
+    return 0;
+}
+
+bool Timeline::Start()
+{
+    if (running)
+        return true;
+
+    Stop(); // 回收已经执行完的线程
+
+    ResetEvent(stop_event);
+    executed = 0;
+    max_late = 0;
+    running = true;
+    thread = CreateThread(nullptr, 0, thread_proc, this, 0, nullptr);
+    if (thread == nullptr)
+        running = false;
+
+    return running;
+}
+
+void Timeline::Stop()
+{
+    if (thread == nullptr)
+        return;
+
+    SetEvent(stop_event);
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+    thread = nullptr;
+    running = false;
+}
+
+bool Timeline::Running()
+{
+    return running;
+}
+
+size_t Timeline::Executed()
+{
+    return executed;
+}
+
+int Timeline::MaxLate()
+{
+    return max_late;
+}
+
+DWORD WINAPI Timeline::thread_proc(LPVOID lpParam)
+{
+    Timeline *timeline = (Timeline *)lpParam;
+    timeline->run();
+    timeline->running = false;
+    return 0;
+}
+
+void Timeline::resolve(int start)
+{
+    schedule.resize(actions.size());
+    int prev = start;
+    for (size_t i = 0; i < actions.size(); i++)
+    {
+        schedule[i] = actions[i].relative ? prev + actions[i].clock : actions[i].clock;
+        prev = schedule[i];
+    }
+
+    order.resize(actions.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [this](size_t a, size_t b)
+                     { return schedule[a] < schedule[b]; });
+}
+
+void Timeline::execute(size_t first, size_t last)
+{
+    // 同一帧的动作作为一次完整操作, 界面线程的修改不会插在中间
+    MutexLock operation(pvz->OperationLock());
+
+    auto data = pvz->data();
+    bool inject = false;
+
+    // 开关功能和数值修改立即生效, 不需要注入
+    for (size_t i = first; i < last; i++)
+    {
+        const TimelineAction &action = actions[order[i]];
+        if (action.kind == TIMELINE_HACK)
+        {
+            for (auto &hack : timeline_hacks)
+                if (action.name == hack.name)
+                    (pvz->*hack.func)(action.args[0] != 0);
+        }
+        else if (action.kind == TIMELINE_WRITE)
+        {
+            for (auto &write : timeline_writes)
+                if (action.name == write.name)
+                    (pvz->*write.func)(action.args[0]);
+        }
+        else if (action.kind == TIMELINE_PLANT || action.kind == TIMELINE_ZOMBIE)
+        {
+            inject = true;
+        }
+    }
+
+    if (inject)
+    {
+        int mode = pvz->ReadMemory<int>({data.lawn, data.game_mode});
+        bool iz_style = (mode >= 61 && mode <= 70);
+
+        Code code;
+        for (size_t i = first; i < last; i++)
+        {
+            const TimelineAction &action = actions[order[i]];
+            if (action.kind == TIMELINE_PLANT)
+                pvz->asm_put_plant(code, action.args[0], action.args[1], action.args[2], action.args[3] != 0, iz_style);
+            else if (action.kind == TIMELINE_ZOMBIE)
+                pvz->asm_put_zombie(code, action.args[0], action.args[1], action.args[2]);
+        }
+        code.asm_ret();
+        pvz->asm_code_inject(code, __func__);
+    }
+
+    // 暂停放在最后, 同一帧的其他动作先完成
+    for (size_t i = first; i < last; i++)
+    {
+        const TimelineAction &action = actions[order[i]];
+        if (action.kind == TIMELINE_PAUSE || action.kind == TIMELINE_UNPAUSE)
+            pvz->SetGamePaused(action.kind == TIMELINE_PAUSE);
+    }
+}
+
+void Timeline::run()
+{
+    // 执行的修改功能会调用 GameOn, 在这个线程上找不到游戏时不去查找
+    PvZ::BackgroundThread();
+
+    if (!pvz->IsValid())
+        return;
+    int ui = pvz->GameUI();
+    if (ui != 2 && ui != 3)
+        return;
+
+    auto data = pvz->data();
+    resolve(pvz->ReadMemory<int>({data.lawn, data.board, data.game_clock}));
+
+    size_t next = 0;
+    while (next < order.size())
+    {
+        if (!pvz->WaitGameClock(schedule[order[next]], stop_event))
+            break;
+
+        // 等待期间可能错过了好几个动作, 一起执行
+        int clock = pvz->ReadMemory<int>({data.lawn, data.board, data.game_clock});
+        size_t last = next;
+        while (last < order.size() && schedule[order[last]] <= clock)
+        {
+            max_late = (std::max)(max_late.load(), clock - schedule[order[last]]);
+            last++;
+        }
+        last = (std::max)(last, next + 1);
+
+        execute(next, last);
+        executed += last - next;
+        next = last;
+    }
+}
+
+} // namespace Pt
@@ -12,6 +12,8 @@ Toolkit::Toolkit(int width, int height, const char *title)
     // 子窗口
 
     window_spawn = new SpawnWindow(0, 0, "");
+    window_lineup = new LineupWindow(0, 0, "");
+    window_library = new SpawnLibraryWindow(0, 0, "");
 
     // 窗口回调函数
 
@@ -23,6 +25,16 @@ Toolkit::Toolkit(int width, int height, const char *title)
 
     window_spawn->callback(cb_on_hide_spawn_details, this);
 
+    button_search_lineup->callback(cb_show_lineup_search, this);
+
+    window_lineup->input_search->callback(cb_search_lineup, this);
+
+    window_lineup->table_lineup->callback(cb_pick_lineup, this);
+
+    window_library->table_library->callback(cb_pick_spawn_library, this);
+
+    window_library->callback(cb_on_hide_spawn_library, this);
+
     // 工作类
 
     pvz = new PvZ();
@@ -31,11 +43,22 @@ Toolkit::Toolkit(int width, int height, const char *title)
 
     pak = new PAK();
 
+    watcher = new BoardWatcher(pvz);
+    watch_subscriber = watcher->Subscribe(4096);
+
+    recorder = new TelemetryRecorder(pvz);
+
+    timeline = new Timeline(pvz);
+
+    sessions = new SessionManager();
+
     // 工作回调函数
 
     check_unlock_sun_limit->callback(cb_unlock_sun_limit, this);
     button_sun->callback(cb_set_sun, this);
     button_money->callback(cb_set_money, this);
+    check_freeze_sun->callback(cb_freeze_sun, this);
+    check_freeze_money->callback(cb_freeze_money, this);
     check_auto_collected->callback(cb_auto_collected, this);
     check_not_drop_loot->callback(cb_not_drop_loot, this);
 
@@ -47,12 +70,14 @@ Toolkit::Toolkit(int width, int height, const char *title)
     button_wisdom_tree->callback(cb_wisdom_tree, this);
 
     check_free_planting->callback(cb_free_planting, this);
+    check_freeze_cooldown->callback(cb_freeze_cooldown, this);
     check_placed_anywhere->callback(cb_placed_anywhere, this);
     check_fast_belt->callback(cb_fast_belt, this);
     check_lock_shovel->callback(cb_lock_shovel, this);
 
     button_mix->callback(cb_mix_mode, this);
     button_level->callback(cb_endless_rounds, this);
+    check_freeze_level->callback(cb_freeze_level, this);
 
     button_unlock->callback(cb_unlock, this);
     button_direct_win->callback(cb_direct_win, this);
@@ -96,6 +121,7 @@ Toolkit::Toolkit(int width, int height, const char *title)
     button_capture->callback(cb_capture, this);
 
     button_set_spawn->callback(cb_set_spawn, this);
+    button_spawn_extra->callback(cb_spawn_seed, this); // 没有单独回调的菜单项
 
     button_music->callback(cb_music, this);
     button_userdata->callback(cb_userdata, this);
@@ -112,6 +138,8 @@ Toolkit::Toolkit(int width, int height, const char *title)
     button_speed->callback(cb_speed, this);
     check_limbo_page->callback(cb_limbo_page, this);
 
+    button_others_extra->callback(cb_others_extra, this);
+
 #ifdef _PTK_CHINESE_UI
     check_tooltips->callback(cb_tooltips, this); // 重载
 #endif
@@ -121,6 +149,17 @@ Toolkit::Toolkit(int width, int height, const char *title)
 
 Toolkit::~Toolkit()
 {
+    if (analyze_thread != nullptr)
+    {
+        WaitForSingleObject(analyze_thread, INFINITE);
+        CloseHandle(analyze_thread);
+    }
+    delete spawn_search;
+    board_watcher(false);
+    delete watcher;
+    delete recorder;
+    delete timeline;
+    delete sessions;
     delete pvz;
     delete pak;
 }
@@ -159,8 +198,15 @@ void Toolkit::cb_tooltips()
 
 void Toolkit::close_all_sub_window()
 {
+    // 后台线程里等待游戏时钟的操作立即返回
+    pvz->StopWaiting();
+
     if (window_spawn->shown() == 1)
         window_spawn->hide();
+    if (window_lineup->shown() == 1)
+        window_lineup->hide();
+    if (window_library->shown() == 1)
+        cb_on_hide_spawn_library();
 }
 
 void Toolkit::cb_show_details(Fl_Widget *, void *w)
@@ -202,6 +248,189 @@ void Toolkit::cb_zombies_list(Fl_Widget *, void *w)
 
 void Toolkit::cb_zombies_list()
 {
+    // 分析
+    if (window_spawn->button_zombies_list->value() == 3)
+    {
+        window_spawn->button_zombies_list->value(0);
+
+        if (analyze_thread != nullptr) // 上一次还没有分析完
+            return;
+
+        // 出怪种类取主窗口勾选的, 在生存模式里时轮数和波数取游戏的
+        if (pvz->GameOn() && pvz->GameMode() >= 1 && pvz->GameMode() <= 15)
+            analyze_rules = pvz->GetSpawnRules();
+        else
+            analyze_rules = WaveRules();
+        analyze_rules.zombies.fill(false);
+        analyze_rules.zombies[ZOMBIE_NORMAL] = true;
+        for (size_t i = 0; i < 20; i++)
+            analyze_rules.zombies[spawn_type[i]] = (check_zombie[i]->value() == 1);
+
+        analyze_thread = CreateThread(nullptr, 0, cb_analyze_spawn_thread, this, 0, nullptr);
+        if (analyze_thread != nullptr)
+        {
+            window_spawn->button_update_details->deactivate();
+            window_spawn->button_zombies_list->deactivate();
+            fl_cursor(FL_CURSOR_WAIT);
+        }
+        return;
+    }
+
+    // 搜索
+    if (window_spawn->button_zombies_list->value() == 6)
+    {
+        window_spawn->button_zombies_list->value(0);
+
+        if (!pvz->GameOn())
+            return;
+        int game_ui = pvz->GameUI();
+        int game_mode = pvz->GameMode();
+        if ((game_ui != 2 && game_ui != 3) || game_mode < 1 || game_mode > 15) // 仅限生存模式
+            return;
+
+        if (analyze_thread != nullptr) // 上一次还没有完成
+            return;
+
+        // 多条约束用分号分隔
+#ifdef _PTK_CHINESE_UI
+        const char *text = fl_input("输入约束 (种类 波数 each|total min|max 数量), 多条用分号分隔:", "32 1-10 total max 0");
+#else
+        const char *text = fl_input("Constraints (type waves each|total min|max count), separated by semicolons:", "32 1-10 total max 0");
+#endif
+        if (text == nullptr)
+            return;
+
+        std::vector<SpawnConstraint> constraints;
+        std::istringstream in(text);
+        std::string item;
+        while (std::getline(in, item, ';'))
+        {
+            if (item.find_first_not_of(' ') == std::string::npos)
+                continue;
+            SpawnConstraint constraint;
+            if (!ParseSpawnConstraint(item, constraint))
+            {
+#ifdef _PTK_CHINESE_UI
+                fl_message_title("搜索失败");
+                fl_message("%s", ("约束格式错误或者不可能满足: " + item).c_str());
+#else
+                fl_message_title("Search Failed");
+                fl_message("%s", ("Invalid or impossible constraint: " + item).c_str());
+#endif
+                return;
+            }
+            constraints.push_back(constraint);
+        }
+        if (constraints.empty())
+            return;
+
+        // 极限和模拟出怪时按当前勾选的种类搜索自定义出怪列表
+        int spawn_mode = button_spawn_mode->value();
+        delete spawn_search;
+        if (spawn_mode == 0)
+        {
+            spawn_search = new SpawnSearch(pvz->GetSpawnRules());
+        }
+        else
+        {
+            std::array<bool, 33> zombies = {false};
+            for (size_t i = 0; i < 20; i++)
+                zombies[spawn_type[i]] = (check_zombie[i]->value() == 1);
+            zombies[0] = true;
+            zombies[1] = true;
+            bool limit_giga = check_giga_limit->value() == 1;
+            bool simulate = spawn_mode == 2;
+            int giga_weight = simulate ? 1000 + 100 * choice_giga_weight->value() : 1000;
+            spawn_search = new SpawnSearch(zombies, limit_giga, simulate, giga_weight);
+        }
+        for (auto &c : constraints)
+            spawn_search->AddConstraint(c);
+
+        analyze_thread = CreateThread(nullptr, 0, cb_search_spawn_thread, this, 0, nullptr);
+        if (analyze_thread != nullptr)
+        {
+            window_spawn->button_update_details->deactivate();
+            window_spawn->button_zombies_list->deactivate();
+            fl_cursor(FL_CURSOR_WAIT);
+        }
+        return;
+    }
+
+    // 切换分析结果显示的统计量
+    if (window_spawn->button_zombies_list->value() == 9)
+    {
+        window_spawn->button_zombies_list->value(0);
+
+        auto table = window_spawn->table_spawn;
+        table->SetStatMode((table->stat_mode + 1) % 5);
+        return;
+    }
+
+    // 预测, 按当前出怪规则在本地生成一份列表显示在表格里, 不修改游戏
+    if (window_spawn->button_zombies_list->value() == 7)
+    {
+        window_spawn->button_zombies_list->value(0);
+
+        if (!pvz->GameOn())
+            return;
+        int game_ui = pvz->GameUI();
+        int game_mode = pvz->GameMode();
+        if ((game_ui != 2 && game_ui != 3) || game_mode < 1 || game_mode > 15) // 仅限生存模式
+            return;
+
+        uint32_t last = spawn_seed_fixed ? spawn_seed : GetTickCount();
+#ifdef _PTK_CHINESE_UI
+        const char *input = fl_input("随机数种子:", std::to_string(last).c_str());
+#else
+        const char *input = fl_input("Random seed:", std::to_string(last).c_str());
+#endif
+        if (input == nullptr)
+            return;
+        uint32_t seed = uint32_t(strtoul(input, nullptr, 10));
+
+        std::array<int, 1000> zombies_list = pvz->PredictSpawnList(seed);
+        if (game_mode <= 5)
+            for (size_t i = 500; i < 1000; i++)
+                zombies_list[i] = -1;
+        window_spawn->UpdateData(zombies_list);
+
+#ifdef _PTK_CHINESE_UI
+        std::string title = "出怪预测 (种子 " + std::to_string(seed) + ")";
+#else
+        std::string title = "Spawning Prediction (Seed " + std::to_string(seed) + ")";
+#endif
+        window_spawn->copy_label(title.c_str());
+        return;
+    }
+
+    // 检查, 结果显示后接着刷新表格
+    if (window_spawn->button_zombies_list->value() == 8)
+    {
+        window_spawn->button_zombies_list->value(0);
+
+        if (!pvz->GameOn())
+            return;
+        int game_ui = pvz->GameUI();
+        int game_mode = pvz->GameMode();
+        if ((game_ui != 2 && game_ui != 3) || game_mode < 1 || game_mode > 15) // 仅限生存模式
+            return;
+
+        int wave = pvz->CheckSpawnList();
+#ifdef _PTK_CHINESE_UI
+        fl_message_title("检查出怪列表");
+        if (wave < 0)
+            fl_message("出怪列表符合当前关卡的出怪规则.");
+        else
+            fl_message("第 %d 波不可能由当前关卡的出怪规则生成.", wave + 1);
+#else
+        fl_message_title("Check Zombies List");
+        if (wave < 0)
+            fl_message("The zombies list matches the spawning rules of this level.");
+        else
+            fl_message("Wave %d cannot be generated by the spawning rules of this level.", wave + 1);
+#endif
+    }
+
     // 加载
     bool import_success = false;
     if (window_spawn->button_zombies_list->value() == 2)
@@ -211,7 +440,7 @@ void Toolkit::cb_zombies_list()
         ZeroMemory(&ofn, sizeof(ofn));
         ofn.lStructSize = sizeof(ofn);
         ofn.hwndOwner = nullptr;
-        ofn.lpstrFilter = L"*.zbl\0*.zbl\0";
+        ofn.lpstrFilter = L"*.zbl\0*.zbl\0*.spl\0*.spl\0";
         ofn.nFilterIndex = 1;
         ofn.lpstrFile = szFileName;
         ofn.lpstrFile[0] = '\0';
@@ -225,32 +454,70 @@ void Toolkit::cb_zombies_list()
 #ifdef _DEBUG
             std::wcout << L"打开文件: " << std::wstring(szFileName) << std::endl;
 #endif
-            auto size = std::filesystem::file_size(szFileName);
-            if (size == (1 + 1 + 1 + 1000 + 1) * sizeof(int))
+            std::array<int, 1000> zl;
+            if (std::filesystem::path(szFileName).extension() == L".spl")
             {
-                std::ifstream infile;
-                infile.open(szFileName, std::ios::binary | std::ios::in);
-                if (infile)
+                // 出怪列表库, 在列表窗口里点选其中一条
+                cb_on_hide_spawn_library();
+                if (spawn_library.Open(szFileName) && spawn_library.Count() > 0)
+                {
+                    window_library->table_library->SetLibrary(&spawn_library);
+#ifdef _PTK_CHINESE_UI
+                    std::string title = "出怪列表库 (" + std::to_string(spawn_library.Count()) + " 条)";
+#else
+                    std::string title = "Zombies List Library (" + std::to_string(spawn_library.Count()) + ")";
+#endif
+                    window_library->copy_label(title.c_str());
+                    window_library->show();
+                }
+                else
                 {
-                    int data[1 + 1 + 1 + 1000 + 1] = {0};
-                    infile.read(reinterpret_cast<char *>(&data), sizeof(data));
-                    unsigned long crc = crc32(0L, Z_NULL, 0);
-                    crc = crc32(crc, (const unsigned char *)data, (3 + 1000) * sizeof(int));
-                    if (data[0] == 0x58434c52 && data[1] == 1 && data[2] == 1000 && data[3 + 1000] == crc)
-                    {
-                        std::array<int, 1000> zl;
-                        zl.fill(-1);
-                        for (size_t i = 0; i < 1000; i++)
-                            zl[i] = data[3 + i];
-                        pvz->SetSpawnList(zl);
-                        import_success = true;
-                    }
+                    spawn_library.Close();
+#ifdef _PTK_CHINESE_UI
+                    fl_message_title("加载失败");
+                    fl_message("出怪列表库为空或者无法打开.");
+#else
+                    fl_message_title("Load Failed");
+                    fl_message("Zombies list library is empty or cannot be opened.");
+#endif
                 }
-                infile.close();
+            }
+            else if (ReadZbl(szFileName, zl))
+            {
+                for_each_game([&](PvZ &game)
+                              { game.SetSpawnList(zl); });
+                import_success = true;
             }
         }
     }
 
+    // 粘贴代码
+    if (window_spawn->button_zombies_list->value() == 5)
+    {
+#ifdef _PTK_CHINESE_UI
+        const char *code = fl_input("粘贴出怪代码:", "");
+#else
+        const char *code = fl_input("Paste zombies list code:", "");
+#endif
+        std::array<int, 1000> zl;
+        if (code != nullptr && DecodeSpawnList(code, zl))
+        {
+            for_each_game([&](PvZ &game)
+                          { game.SetSpawnList(zl); });
+            import_success = true;
+        }
+        else if (code != nullptr)
+        {
+#ifdef _PTK_CHINESE_UI
+            fl_message_title("加载失败");
+            fl_message("出怪代码无效.");
+#else
+            fl_message_title("Load Failed");
+            fl_message("Invalid zombies list code.");
+#endif
+        }
+    }
+
     std::array<int, 1000> zombies_list;
     zombies_list.fill(-1);
 
@@ -287,7 +554,7 @@ void Toolkit::cb_zombies_list()
 
     window_spawn->UpdateData(zombies_list);
 
-    if (window_spawn->button_zombies_list->value() == 2 && import_success)
+    if ((window_spawn->button_zombies_list->value() == 2 || window_spawn->button_zombies_list->value() == 5) && import_success)
     {
 #ifdef _PTK_CHINESE_UI
         fl_message_title("加载成功");
@@ -298,6 +565,20 @@ void Toolkit::cb_zombies_list()
 #endif
     }
 
+    // 复制代码
+    if (window_spawn->button_zombies_list->value() == 4)
+    {
+        std::string code = EncodeSpawnList(zombies_list);
+        Fl::copy(code.c_str(), int(code.size()), 1, Fl::clipboard_plain_text);
+#ifdef _PTK_CHINESE_UI
+        fl_message_title("复制成功");
+        fl_message("出怪代码已经复制到剪贴板.");
+#else
+        fl_message_title("Copied Successfully");
+        fl_message("Zombies list code has been copied to clipboard.");
+#endif
+    }
+
     // 保存
     if (window_spawn->button_zombies_list->value() == 1)
     {
@@ -319,26 +600,39 @@ void Toolkit::cb_zombies_list()
 
         SYSTEMTIME time_now;
         GetLocalTime(&time_now);
-        std::string filename = std::string("zombies")             //
-                               + "\\"                             //
-                               + std::to_string(time_now.wYear)   //
-                               + "."                              //
-                               + std::to_string(time_now.wMonth)  //
-                               + "."                              //
-                               + std::to_string(time_now.wDay)    //
-                               + "_"                              //
-                               + std::to_string(time_now.wHour)   //
-                               + "."                              //
-                               + std::to_string(time_now.wMinute) //
-                               + "."                              //
-                               + std::to_string(time_now.wSecond) //
-                               + ".zbl";                          //
+        std::string name = std::to_string(time_now.wYear)     //
+                           + "."                              //
+                           + std::to_string(time_now.wMonth)  //
+                           + "."                              //
+                           + std::to_string(time_now.wDay)    //
+                           + "_"                              //
+                           + std::to_string(time_now.wHour)   //
+                           + "."                              //
+                           + std::to_string(time_now.wMinute) //
+                           + "."                              //
+                           + std::to_string(time_now.wSecond);
+        std::string filename = std::string("zombies") + "\\" + name + ".zbl";
 
         std::ofstream outfile;
         outfile.open(filename.c_str(), std::ios::binary | std::ios::out | std::ios::trunc);
         if (outfile)
         {
             outfile.write(reinterpret_cast<char *>(&data), sizeof(data));
+
+            outfile.close();
+
+            // 同时追加到出怪列表库, 第一次创建时导入目录里已有的 .zbl 文件(包括刚保存的)
+            // 列表窗口打开着的库不能同时写入, 先关掉
+            if (window_library->shown() == 1)
+                cb_on_hide_spawn_library();
+            SpawnLibrary library;
+            if (library.Open(L"zombies\\zombies.spl"))
+            {
+                if (library.Count() == 0)
+                    library.Import(L"zombies");
+                else
+                    library.Append(name, "", zombies_list, uint32_t(time(nullptr)));
+            }
 #ifdef _PTK_CHINESE_UI
             fl_message_title("保存成功");
             fl_message(std::string("当前出怪列表保存在文件: \n" + filename).c_str());
@@ -353,6 +647,88 @@ void Toolkit::cb_zombies_list()
     window_spawn->button_zombies_list->value(0);
 }
 
+DWORD Toolkit::cb_analyze_spawn_thread(void *w)
+{
+    ((Toolkit *)w)->cb_analyze_spawn_thread();
+    return 0;
+}
+
+void Toolkit::cb_analyze_spawn_thread()
+{
+    analyze_stats = SpawnAnalyzer(analyze_rules).Run(SPAWN_ANALYZE_SAMPLES, GetTickCount());
+    Fl::awake(cb_analyze_spawn_done, this);
+}
+
+void Toolkit::cb_analyze_spawn_done(void *w)
+{
+    ((Toolkit *)w)->cb_analyze_spawn_done();
+}
+
+void Toolkit::cb_analyze_spawn_done()
+{
+    WaitForSingleObject(analyze_thread, INFINITE);
+    CloseHandle(analyze_thread);
+    analyze_thread = nullptr;
+
+    window_spawn->button_update_details->activate();
+    window_spawn->button_zombies_list->activate();
+    fl_cursor(FL_CURSOR_DEFAULT);
+
+#ifdef _DEBUG
+    std::cout << "Spawn analysis: " << std::dec << analyze_stats.samples << " samples " << analyze_stats.elapsed_ms << "ms" << std::endl;
+#endif
+
+    window_spawn->UpdateStats(analyze_stats);
+}
+
+DWORD Toolkit::cb_search_spawn_thread(void *w)
+{
+    ((Toolkit *)w)->cb_search_spawn_thread();
+    return 0;
+}
+
+void Toolkit::cb_search_spawn_thread()
+{
+    search_violation = 0;
+    search_done = pvz->SearchSpawnList(*spawn_search, SPAWN_SEARCH_CANDIDATES, GetTickCount(), search_violation);
+    Fl::awake(cb_search_spawn_done, this);
+}
+
+void Toolkit::cb_search_spawn_done(void *w)
+{
+    ((Toolkit *)w)->cb_search_spawn_done();
+}
+
+void Toolkit::cb_search_spawn_done()
+{
+    WaitForSingleObject(analyze_thread, INFINITE);
+    CloseHandle(analyze_thread);
+    analyze_thread = nullptr;
+
+    window_spawn->button_update_details->activate();
+    window_spawn->button_zombies_list->activate();
+    fl_cursor(FL_CURSOR_DEFAULT);
+
+    if (!search_done)
+        return;
+
+    cb_update_details();
+
+#ifdef _PTK_CHINESE_UI
+    fl_message_title("搜索完成");
+    if (search_violation == 0)
+        fl_message("满足全部约束的出怪列表已经写入游戏.");
+    else
+        fl_message("没有找到满足全部约束的出怪列表, 已经写入最接近的 (违反量 %d).", search_violation);
+#else
+    fl_message_title("Search Finished");
+    if (search_violation == 0)
+        fl_message("A zombies list meeting all constraints has been written into the game.");
+    else
+        fl_message("No zombies list meets all constraints, the closest one (violation %d) has been written.", search_violation);
+#endif
+}
+
 void Toolkit::cb_on_hide_spawn_details(Fl_Widget *, void *w)
 {
     ((Toolkit *)w)->cb_on_hide_spawn_details();
@@ -365,6 +741,154 @@ void Toolkit::cb_on_hide_spawn_details()
     cb_tooltips();
 }
 
+void Toolkit::cb_pick_spawn_library(Fl_Widget *o, void *w)
+{
+    // 只响应点在格子上, 拖滚动条不算
+    if (((SpawnLibraryBrowser *)o)->callback_context() != Fl_Table::CONTEXT_CELL)
+        return;
+    ((Toolkit *)w)->cb_pick_spawn_library();
+}
+
+void Toolkit::cb_pick_spawn_library()
+{
+    int index = window_library->table_library->Selected();
+    if (index < 0)
+        return;
+
+    std::array<int, 1000> zl;
+    if (!spawn_library.List(uint32_t(index), zl))
+    {
+#ifdef _PTK_CHINESE_UI
+        fl_message_title("加载失败");
+        fl_message("数据已损坏.");
+#else
+        fl_message_title("Load Failed");
+        fl_message("Corrupted data.");
+#endif
+        return;
+    }
+
+    for_each_game([&](PvZ &game)
+                  { game.SetSpawnList(zl); });
+    if (window_spawn->shown() == 1)
+        cb_update_details();
+}
+
+void Toolkit::cb_on_hide_spawn_library(Fl_Widget *, void *w)
+{
+    ((Toolkit *)w)->cb_on_hide_spawn_library();
+}
+
+void Toolkit::cb_on_hide_spawn_library()
+{
+    window_library->table_library->SetLibrary(nullptr);
+    window_library->hide();
+    spawn_library.Close();
+}
+
+void Toolkit::cb_show_lineup_search(Fl_Widget *, void *w)
+{
+    ((Toolkit *)w)->cb_show_lineup_search();
+}
+
+void Toolkit::cb_show_lineup_search()
+{
+    // 列表可能重新加载过, 按输入框的内容重新搜索
+    cb_search_lineup();
+    window_lineup->show();
+    window_lineup->input_search->take_focus();
+}
+
+void Toolkit::cb_search_lineup(Fl_Widget *, void *w)
+{
+    ((Toolkit *)w)->cb_search_lineup();
+}
+
+void Toolkit::cb_search_lineup()
+{
+    // 回车选第一个(或者选中的)结果, 其他按键是输入变化
+    if (Fl::event() == FL_KEYBOARD && (Fl::event_key() == FL_Enter || Fl::event_key() == FL_KP_Enter))
+    {
+        cb_pick_lineup();
+        return;
+    }
+
+#ifdef _PTK_CHINESE_UI
+    window_lineup->copy_label("搜索阵型");
+#else
+    window_lineup->copy_label("Search Lineups");
+#endif
+
+    // 带 = < > 的项和 asc desc 是筛选条件, 其余的是名称
+    std::string text = window_lineup->input_search->value();
+    std::string name, filter_text;
+    std::istringstream in(text);
+    std::string token;
+    while (in >> token)
+    {
+        bool is_filter = token.find_first_of("=<>") != std::string::npos || token == "asc" || token == "desc";
+        std::string &part = is_filter ? filter_text : name;
+        part += (part.empty() ? "" : " ") + token;
+    }
+
+    if (filter_text.empty())
+    {
+        const std::vector<uint32_t> &result = lineup_names.Search(text);
+        window_lineup->table_lineup->SetRows(&this->lineups, result);
+        window_lineup->UpdateCount(result.size(), this->lineups.Size());
+        return;
+    }
+
+    // 条件写错时没有结果
+    std::vector<uint32_t> result;
+    LineupFilter filter;
+    if (ParseLineupFilter(filter_text, filter))
+    {
+        result = lineup_index.Select(filter);
+
+        // 按筛选结果的顺序, 只留名称也匹配的
+        if (!name.empty())
+        {
+            std::vector<bool> matched(this->lineups.Size(), false);
+            for (auto index : lineup_names.Search(name))
+                matched[index] = true;
+            auto unmatched = [&matched](uint32_t index)
+            {
+                return !matched[index];
+            };
+            result.erase(std::remove_if(result.begin(), result.end(), unmatched), result.end());
+        }
+    }
+
+    window_lineup->table_lineup->SetRows(&this->lineups, result);
+    window_lineup->UpdateCount(result.size(), this->lineups.Size());
+}
+
+void Toolkit::cb_pick_lineup(Fl_Widget *o, void *w)
+{
+    // 只响应点在格子上, 拖滚动条不算
+    if (((LineupBrowser *)o)->callback_context() != Fl_Table::CONTEXT_CELL)
+        return;
+    ((Toolkit *)w)->cb_pick_lineup();
+}
+
+void Toolkit::cb_pick_lineup()
+{
+    int index = window_lineup->table_lineup->Selected();
+    if (index < 0 || size_t(index) >= this->lineups.Size())
+        return;
+
+    // 菜单按场景分开, 阵型列表按场景排好, 减去前面场景的个数就是菜单里的位置
+    int scene = static_cast<int>(this->lineups[index].scene);
+    int item = index;
+    for (int i = 0; i < scene; i++)
+        item -= lineup_count[i];
+
+    choice_scene->value(scene);
+    choice_lineup_name[scene]->value(item);
+    cb_switch_lineup_scene();
+}
+
 //
 //
 //
@@ -389,6 +913,8 @@ void Toolkit::cb_set_sun(Fl_Widget *, void *w)
 void Toolkit::cb_set_sun()
 {
     pvz->SetSun(static_cast<int>(input_sun->value()));
+    if (check_freeze_sun->value()) // 锁定时同时修改锁定值
+        cb_freeze_sun();
 }
 
 void Toolkit::cb_set_money(Fl_Widget *, void *w)
@@ -399,6 +925,28 @@ void Toolkit::cb_set_money(Fl_Widget *, void *w)
 void Toolkit::cb_set_money()
 {
     pvz->SetMoney(static_cast<int>(input_money->value()));
+    if (check_freeze_money->value())
+        cb_freeze_money();
+}
+
+void Toolkit::cb_freeze_sun(Fl_Widget *, void *w)
+{
+    ((Toolkit *)w)->cb_freeze_sun();
+}
+
+void Toolkit::cb_freeze_sun()
+{
+    pvz->FreezeSun(check_freeze_sun->value(), static_cast<int>(input_sun->value()));
+}
+
+void Toolkit::cb_freeze_money(Fl_Widget *, void *w)
+{
+    ((Toolkit *)w)->cb_freeze_money();
+}
+
+void Toolkit::cb_freeze_money()
+{
+    pvz->FreezeMoney(check_freeze_money->value(), static_cast<int>(input_money->value()));
 }
 
 void Toolkit::cb_auto_collected(Fl_Widget *, void *w)
@@ -481,6 +1029,16 @@ void Toolkit::cb_free_planting()
     pvz->FreePlanting(check_free_planting->value());
 }
 
+void Toolkit::cb_freeze_cooldown(Fl_Widget *, void *w)
+{
+    ((Toolkit *)w)->cb_freeze_cooldown();
+}
+
+void Toolkit::cb_freeze_cooldown()
+{
+    pvz->FreezeSlotCooldowns(check_freeze_cooldown->value());
+}
+
 void Toolkit::cb_placed_anywhere(Fl_Widget *, void *w)
 {
     ((Toolkit *)w)->cb_placed_anywhere();
@@ -535,6 +1093,18 @@ void Toolkit::cb_endless_rounds(Fl_Widget *, void *w)
 void Toolkit::cb_endless_rounds()
 {
     pvz->EndlessRounds(static_cast<int>(input_level->value()));
+    if (check_freeze_level->value())
+        cb_freeze_level();
+}
+
+void Toolkit::cb_freeze_level(Fl_Widget *, void *w)
+{
+    ((Toolkit *)w)->cb_freeze_level();
+}
+
+void Toolkit::cb_freeze_level()
+{
+    pvz->FreezeEndlessRounds(check_freeze_level->value(), static_cast<int>(input_level->value()));
 }
 
 void Toolkit::cb_unlock(Fl_Widget *, void *w)
@@ -1003,6 +1573,48 @@ void Toolkit::cb_get_lineup()
     Lineup lineup = pvz->GetLineup();
     std::string str = lineup.Generate();
     buffer_lineup_string->text(str.c_str());
+
+    if (this->lineups.Empty())
+        return;
+
+    // 在阵型列表里选中和当前场地最相似的阵型
+    uint16_t items[GRID];
+    lineup.Pack(items);
+    auto matches = this->lineups.Nearest(items, lineup.scene, lineup.rake_row, 20);
+
+#ifdef _DEBUG
+    for (auto &match : matches)
+        std::cout << match.distance << " " << this->lineups.Name(match.index) << std::endl;
+#endif
+
+    if (matches.empty() || matches[0].distance >= GRID) // 没有同场景的
+        return;
+
+    // 同场景的相似阵型按距离列在搜索窗口里, 点选其中一个
+    std::vector<uint32_t> nearest;
+    for (auto &match : matches)
+        if (match.distance < GRID)
+            nearest.push_back(match.index);
+    window_lineup->input_search->value("");
+    window_lineup->table_lineup->SetRows(&this->lineups, nearest);
+    window_lineup->UpdateCount(nearest.size(), this->lineups.Size());
+#ifdef _PTK_CHINESE_UI
+    window_lineup->copy_label("相似阵型");
+#else
+    window_lineup->copy_label("Similar Lineups");
+#endif
+    window_lineup->show();
+
+    uint32_t scene = this->lineups[matches[0].index].scene;
+    uint32_t index = matches[0].index;
+    for (uint32_t i = 0; i < scene; i++)
+        index -= lineup_count[i];
+
+    // 切换到对应场景的菜单, 切换时会显示列表里的阵型代码, 之后换回读取到的
+    choice_scene->value(int(scene));
+    choice_lineup_name[scene]->value(int(index));
+    cb_switch_lineup_scene();
+    buffer_lineup_string->text(str.c_str());
 }
 
 void Toolkit::cb_set_lineup(Fl_Widget *, void *w)
@@ -1032,7 +1644,8 @@ void Toolkit::cb_set_lineup()
     }
 
     Lineup lineup(str);
-    pvz->SetLineup(lineup);
+    for_each_game([&](PvZ &game)
+                  { game.SetLineup(lineup); });
 }
 
 void Toolkit::cb_capture(Fl_Widget *, void *w)
@@ -1071,24 +1684,56 @@ void Toolkit::cb_set_spawn()
     int giga_weight = 1000 + 100 * choice_giga_weight->value();
     bool limit_giga = check_giga_limit->value() == 1;
 
+    // 固定种子时依次应用同一个种子的候选列表, 否则每次换一个种子
+    uint32_t seed = spawn_seed_fixed ? spawn_seed : GetTickCount();
+    size_t index = 0;
+    if (spawn_mode != 0)
+    {
+        if (spawn_seed_fixed)
+            index = spawn_seed_index++;
+        spawn_seed = seed;
+    }
+
+#ifdef _DEBUG
+    std::cout << "Spawn seed: " << std::dec << seed << " #" << index << std::endl;
+#endif
+
+    // 在出怪统计窗口标题上显示种子和候选序号, 方便复现
+    std::string seed_text = std::to_string(seed);
+    if (index != 0)
+        seed_text += " #" + std::to_string(index);
+#ifdef _PTK_CHINESE_UI
+    std::string title = "出怪数量统计";
+    if (spawn_mode != 0)
+        title += " (种子 " + seed_text + ")";
+#else
+    std::string title = "Spawning Counting";
+    if (spawn_mode != 0)
+        title += " (Seed " + seed_text + ")";
+#endif
+    window_spawn->copy_label(title.c_str());
+
     switch (spawn_mode)
     {
     case 0: // 自然
         zombies[0] = true;
-        pvz->InternalSpawn(zombies);
+        for_each_game([&](PvZ &game)
+                      { game.InternalSpawn(zombies); });
         break;
 
     case 1: // 极限
     default:
         zombies[0] = true;
         zombies[1] = true;
-        pvz->CustomizeSpawn(zombies, limit_giga, false, 1000);
+        for_each_game([&](PvZ &game)
+                      { game.CustomizeSpawn(zombies, limit_giga, false, 1000, seed, index); });
         break;
 
     case 2: // 模拟
         zombies[0] = true;
         zombies[1] = true;
-        pvz->CustomizeSpawn(zombies, limit_giga, true, giga_weight);
+        for_each_game([&](PvZ &game)
+                      { game.CustomizeSpawn(zombies, limit_giga, true, giga_weight, seed, index); });
         break;
     }
 
@@ -1096,6 +1741,36 @@ void Toolkit::cb_set_spawn()
         cb_update_details();
 }
 
+void Toolkit::cb_spawn_seed(Fl_Widget *, void *w)
+{
+    ((Toolkit *)w)->cb_spawn_seed();
+}
+
+// 留空时每次随机, 否则固定种子并从第一个候选列表开始
+void Toolkit::cb_spawn_seed()
+{
+    button_spawn_extra->value(0);
+
+    std::string last = spawn_seed_fixed || spawn_seed != 0 ? std::to_string(spawn_seed) : "";
+#ifdef _PTK_CHINESE_UI
+    fl_message_title("出怪种子");
+    const char *input = fl_input("极限和模拟出怪的随机数种子, 留空则每次随机:", last.c_str());
+#else
+    fl_message_title("Spawning Seed");
+    const char *input = fl_input("Random seed for extreme and simulated spawning.\nLeave empty for a new seed each time:",
+                                 last.c_str());
+#endif
+    if (input == nullptr)
+        return;
+
+    std::string text = input;
+    text.erase(0, text.find_first_not_of(" \t"));
+    spawn_seed_fixed = !text.empty();
+    spawn_seed_index = 0;
+    if (spawn_seed_fixed)
+        spawn_seed = uint32_t(strtoul(text.c_str(), nullptr, 10));
+}
+
 void Toolkit::cb_music(Fl_Widget *, void *w)
 {
     ((Toolkit *)w)->cb_music();
@@ -1499,4 +2174,266 @@ void Toolkit::cb_limbo_page()
     pvz->UnlockLimboPage(check_limbo_page->value());
 }
 
+void Toolkit::cb_others_extra(Fl_Widget *, void *w)
+{
+    ((Toolkit *)w)->cb_others_extra();
+}
+
+void Toolkit::cb_others_extra()
+{
+    int item = button_others_extra->value();
+    if (item == 0)
+        show_stall_report();
+    else if (item == 1)
+        board_watcher(button_others_extra->mvalue()->value() != 0);
+    else if (item == 2)
+        telemetry_record(button_others_extra->mvalue()->value() != 0);
+    else if (item == 3)
+        timeline_run(button_others_extra->mvalue()->value() != 0);
+    else if (item == 4)
+        select_sessions();
+}
+
+void Toolkit::show_stall_report()
+{
+    std::string report = pvz->StallReport();
+    if (report.empty())
+        return;
+
+    // 保存一份, 方便附在问题反馈里
+    std::filesystem::current_path(this->current_path);
+    std::ofstream outfile("stall.txt", std::ios::out | std::ios::trunc);
+    if (outfile)
+        outfile << report;
+
+    // 表格需要等宽字体
+    extern Fl_Font ms_font;
+    fl_message_font(ms_font, 13);
+#ifdef _PTK_CHINESE_UI
+    fl_message_title("注入卡顿统计");
+#else
+    fl_message_title("Injection Stall Report");
+#endif
+    fl_message("%s", report.c_str());
+#ifdef _PTK_CHINESE_UI
+    extern Fl_Font ui_font;
+    fl_message_font(ui_font, 13);
+#endif
+}
+
+void Toolkit::board_watcher(bool on)
+{
+    if (on == watcher->Running())
+        return;
+
+    if (on)
+    {
+        std::filesystem::current_path(this->current_path);
+        watch_log.open("watch.log", std::ios::out | std::ios::app);
+        if (!watch_log || !watcher->Start())
+        {
+            watch_log.close();
+            button_others_extra->mode(1, FL_MENU_TOGGLE); // 取消勾选
+            return;
+        }
+        watch_log << "clock,action,entity,field,id,type,value,old" << std::endl;
+        Fl::add_timeout(0.1, cb_watch_poll, this);
+    }
+    else
+    {
+        Fl::remove_timeout(cb_watch_poll, this);
+        watcher->Stop();
+        cb_watch_poll(); // 取出剩下的事件
+        watch_log.close();
+    }
+}
+
+void Toolkit::cb_watch_poll(void *w)
+{
+    ((Toolkit *)w)->cb_watch_poll();
+    Fl::repeat_timeout(0.1, cb_watch_poll, w);
+}
+
+void Toolkit::cb_watch_poll()
+{
+    WatchEvent event;
+    while (watcher->Poll(watch_subscriber, event))
+        watch_log << event.clock << "," << int(event.action) << "," << int(event.entity) << "," //
+                  << event.field << "," << event.id << "," << event.type << ","                //
+                  << event.value << "," << event.old << "\n";
+    watch_log.flush();
+}
+
+void Toolkit::telemetry_record(bool on)
+{
+    if (on == recorder->Recording())
+        return;
+
+    if (on)
+    {
+        SYSTEMTIME time_now;
+        GetLocalTime(&time_now);
+        std::string name = std::to_string(time_now.wYear)     //
+                           + "."                              //
+                           + std::to_string(time_now.wMonth)  //
+                           + "."                              //
+                           + std::to_string(time_now.wDay)    //
+                           + "_"                              //
+                           + std::to_string(time_now.wHour)   //
+                           + "."                              //
+                           + std::to_string(time_now.wMinute) //
+                           + "."                              //
+                           + std::to_string(time_now.wSecond);
+
+        std::error_code ec;
+        std::filesystem::create_directory(this->current_path / "telemetry", ec);
+        record_file = this->current_path / "telemetry" / (name + ".ptkt");
+        if (!recorder->Start(record_file.wstring()))
+        {
+            button_others_extra->mode(2, FL_MENU_TOGGLE); // 取消勾选
+#ifdef _PTK_CHINESE_UI
+            fl_message_title("录像失败");
+            fl_message("无法创建录像文件.");
+#else
+            fl_message_title("Recording Failed");
+            fl_message("Unable to create the recording file.");
+#endif
+        }
+    }
+    else
+    {
+        recorder->Stop();
+#ifdef _PTK_CHINESE_UI
+        fl_message_title("录像完成");
+        fl_message("已保存 %zu 帧(丢弃 %zu 帧)到\n%s", recorder->FramesWritten(), recorder->FramesDropped(),
+                   record_file.u8string().c_str());
+#else
+        fl_message_title("Recording Finished");
+        fl_message("Saved %zu frames (%zu dropped) to\n%s", recorder->FramesWritten(), recorder->FramesDropped(),
+                   record_file.u8string().c_str());
+#endif
+    }
+}
+
+void Toolkit::timeline_run(bool on)
+{
+    if (!on)
+    {
+        // 执行完的时间轴也在这里回收线程
+        timeline->Stop();
+#ifdef _PTK_CHINESE_UI
+        fl_message_title("时间轴");
+        fl_message("已执行 %zu 个动作, 最多延迟 %d 帧.", timeline->Executed(), timeline->MaxLate());
+#else
+        fl_message_title("Timeline");
+        fl_message("Executed %zu actions, at most %d frames late.", timeline->Executed(), timeline->MaxLate());
+#endif
+        return;
+    }
+
+    TCHAR szFileName[MAX_PATH];
+    OPENFILENAME ofn;
+    ZeroMemory(&ofn, sizeof(ofn));
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = nullptr;
+    ofn.lpstrFilter = L"*.txt\0*.txt\0*.*\0*.*\0";
+    ofn.nFilterIndex = 1;
+    ofn.lpstrFile = szFileName;
+    ofn.lpstrFile[0] = '\0';
+    ofn.nMaxFile = sizeof(szFileName);
+    ofn.lpstrFileTitle = nullptr;
+    ofn.nMaxFileTitle = 0;
+    ofn.lpstrInitialDir = nullptr;
+    ofn.Flags = OFN_PATHMUSTEXIST | OFN_FILEMUSTEXIST;
+    if (GetOpenFileNameW(&ofn) != TRUE)
+    {
+        button_others_extra->mode(3, FL_MENU_TOGGLE); // 取消勾选
+        return;
+    }
+
+    int line = timeline->Load(szFileName);
+    if (line != 0 || !pvz->GameOn() || !timeline->Start())
+    {
+        button_others_extra->mode(3, FL_MENU_TOGGLE);
+#ifdef _PTK_CHINESE_UI
+        fl_message_title("时间轴");
+        if (line > 0)
+            fl_message("第 %d 行格式错误.", line);
+        else if (line < 0)
+            fl_message("无法打开文件.");
+        else
+            fl_message("游戏没有打开.");
+#else
+        fl_message_title("Timeline");
+        if (line > 0)
+            fl_message("Invalid action at line %d.", line);
+        else if (line < 0)
+            fl_message("Unable to open the file.");
+        else
+            fl_message("The game is not running.");
+#endif
+    }
+}
+
+void Toolkit::for_each_game(const std::function<void(PvZ &)> &func)
+{
+    if (selected_pids.empty())
+    {
+        func(*pvz);
+        return;
+    }
+
+    sessions->Discover();
+    std::vector<size_t> targets;
+    for (size_t i = 0; i < sessions->Count(); i++)
+        if (std::find(selected_pids.begin(), selected_pids.end(), sessions->Pid(i)) != selected_pids.end())
+            targets.push_back(i);
+
+    // 选中的游戏都已经退出时修改当前游戏
+    if (targets.empty())
+        func(*pvz);
+    else
+        sessions->Broadcast(func, targets);
+}
+
+void Toolkit::select_sessions()
+{
+    size_t count = sessions->Discover();
+
+    std::string list, selected;
+    for (size_t i = 0; i < count; i++)
+    {
+        DWORD pid = sessions->Pid(i);
+        bool is_selected = std::find(selected_pids.begin(), selected_pids.end(), pid) != selected_pids.end();
+        list += "[" + std::to_string(i + 1) + "] PID " + std::to_string(pid);
+        if (pid == pvz->Pid())
+#ifdef _PTK_CHINESE_UI
+            list += " (当前)";
+#else
+            list += " (current)";
+#endif
+        list += "\n";
+        if (is_selected)
+            selected += (selected.empty() ? "" : " ") + std::to_string(i + 1);
+    }
+
+#ifdef _PTK_CHINESE_UI
+    fl_message_title("多开同步");
+    const char *input = fl_input("%s\n输入要同步修改的序号, 用空格分隔, 留空只修改当前游戏:", selected.c_str(), list.c_str());
+#else
+    fl_message_title("Sync Games");
+    const char *input = fl_input("%s\nEnter the indices to modify together, separated by spaces.\nLeave empty to modify the current game only:",
+                                 selected.c_str(), list.c_str());
+#endif
+    if (input == nullptr)
+        return;
+
+    selected_pids.clear();
+    std::istringstream iss(input);
+    size_t index;
+    while (iss >> index)
+        if (index >= 1 && index <= count)
+            selected_pids.push_back(sessions->Pid(index - 1));
+}
+
 } // namespace Pt
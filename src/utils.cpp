@@ -1,6 +1,8 @@
 
 #include "../inc/utils.h"
 
+#include <cstdio>
+
 namespace Pt
 {
 
@@ -283,4 +285,16 @@ bool VerifyFileHash(LPCWSTR file_name, const char *file_md5)
     return false;
 }
 
+void AttachParentConsole()
+{
+    // 界面程序没有控制台, 输出没有被重定向时使用父进程的控制台
+    HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+    if (out == nullptr || out == INVALID_HANDLE_VALUE)
+    {
+        FILE *fp = nullptr;
+        if (AttachConsole(ATTACH_PARENT_PROCESS))
+            freopen_s(&fp, "CONOUT$", "w", stdout);
+    }
+}
+
 } // namespace Pt
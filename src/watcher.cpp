@@ -0,0 +1,245 @@
+
+#include "../inc/watcher.h"
+
+namespace Pt
+{
+
+BoardWatcher::BoardWatcher(PvZ *pvz)
+{
+    this->pvz = pvz;
+    this->interval_min = 1;
+    this->interval_max = 30;
+    this->budget = 0.05;
+    this->pools = SNAPSHOT_PLANT | SNAPSHOT_ZOMBIE | SNAPSHOT_GRID_ITEM;
+    this->thread = nullptr;
+    this->stop_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    this->running = false;
+}
+
+BoardWatcher::~BoardWatcher()
+{
+    Stop();
+    CloseHandle(stop_event);
+}
+
+void BoardWatcher::SetInterval(int frames_min, int frames_max)
+{
+    interval_min = (std::max)(frames_min, 1);
+    interval_max = (std::max)(frames_max, interval_min);
+}
+
+void BoardWatcher::SetBudget(double ratio)
+{
+    budget = (std::min)((std::max)(ratio, 0.001), 1.0);
+}
+
+void BoardWatcher::SetPools(unsigned int pools)
+{
+    this->pools = pools & (SNAPSHOT_PLANT | SNAPSHOT_ZOMBIE | SNAPSHOT_GRID_ITEM);
+}
+
+int BoardWatcher::Subscribe(size_t capacity)
+{
+    if (running)
+        return -1;
+
+    subscribers.emplace_back(new Subscriber(capacity));
+    return int(subscribers.size()) - 1;
+}
+
+bool BoardWatcher::Poll(int id, WatchEvent &event)
+{
+    if (id < 0 || id >= int(subscribers.size()))
+        return false;
+
+    return subscribers[id]->queue.Pop(event);
+}
+
+size_t BoardWatcher::Dropped(int id)
+{
+    if (id < 0 || id >= int(subscribers.size()))
+        return 0;
+
+    return subscribers[id]->dropped.load();
+}
+
+bool BoardWatcher::Start()
+{
+    if (running)
+        return true;
+
+    ResetEvent(stop_event);
+    running = true;
+    thread = CreateThread(nullptr, 0, thread_proc, this, 0, nullptr);
+    if (thread == nullptr)
+        running = false;
+
+    return running;
+}
+
+void BoardWatcher::Stop()
+{
+    if (!running)
+        return;
+
+    SetEvent(stop_event);
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+    thread = nullptr;
+    running = false;
+}
+
+bool BoardWatcher::Running()
+{
+    return running;
+}
+
+DWORD WINAPI BoardWatcher::thread_proc(LPVOID lpParam)
+{
+    BoardWatcher *watcher = (BoardWatcher *)lpParam;
+    watcher->run();
+    return 0;
+}
+
+void BoardWatcher::publish(const WatchEvent &event)
+{
+    for (auto &subscriber : subscribers)
+        if (!subscriber->queue.Push(event))
+            subscriber->dropped++;
+}
+
+// 同一槽位前后 ID 不同说明对象被回收后又复用了
+size_t BoardWatcher::diff(const BoardSnapshot &prev, const BoardSnapshot &curr, int clock)
+{
+    size_t count = 0;
+
+    auto emit = [&](uint8_t action, uint8_t entity, uint16_t field, uint32_t id, int32_t type, int32_t value, int32_t old)
+    {
+        WatchEvent event = {action, entity, field, id, clock, type, value, old};
+        publish(event);
+        count++;
+    };
+
+    // 增删: 遍历两次快照的并集槽位
+    auto added_removed = [&](uint8_t entity,
+                             const std::vector<uint32_t> &prev_id, const std::vector<uint8_t> &prev_alive, const std::vector<int32_t> &prev_type,
+                             const std::vector<uint32_t> &curr_id, const std::vector<uint8_t> &curr_alive, const std::vector<int32_t> &curr_type,
+                             const std::vector<int32_t> &curr_row, const std::vector<int32_t> *curr_col, size_t i) -> bool
+    {
+        bool was = i < prev_alive.size() && prev_alive[i];
+        bool now = i < curr_alive.size() && curr_alive[i];
+        bool same = was && now && prev_id[i] == curr_id[i];
+        if (was && !same)
+            emit(WATCH_REMOVE, entity, WATCH_FIELD_NONE, prev_id[i], prev_type[i], 0, 0);
+        if (now && !same)
+            emit(WATCH_ADD, entity, WATCH_FIELD_NONE, curr_id[i], curr_type[i], curr_row[i], curr_col ? (*curr_col)[i] : 0);
+        return same;
+    };
+
+    auto changed = [&](uint8_t entity, uint16_t field, uint32_t id, int32_t type, int32_t old, int32_t value)
+    {
+        if (old != value)
+            emit(WATCH_CHANGE, entity, field, id, type, value, old);
+    };
+
+    if (pools & SNAPSHOT_PLANT)
+    {
+        auto &p = prev.plants;
+        auto &c = curr.plants;
+        size_t n = (std::max)(p.alive.size(), c.alive.size());
+        for (size_t i = 0; i < n; i++)
+        {
+            if (added_removed(SNAPSHOT_PLANT, p.id, p.alive, p.type, c.id, c.alive, c.type, c.row, &c.col, i))
+            {
+                changed(SNAPSHOT_PLANT, WATCH_FIELD_HP, c.id[i], c.type[i], p.hp[i], c.hp[i]);
+                changed(SNAPSHOT_PLANT, WATCH_FIELD_ASLEEP, c.id[i], c.type[i], p.asleep[i], c.asleep[i]);
+            }
+        }
+    }
+
+    if (pools & SNAPSHOT_ZOMBIE)
+    {
+        auto &p = prev.zombies;
+        auto &c = curr.zombies;
+        size_t n = (std::max)(p.alive.size(), c.alive.size());
+        for (size_t i = 0; i < n; i++)
+        {
+            if (added_removed(SNAPSHOT_ZOMBIE, p.id, p.alive, p.type, c.id, c.alive, c.type, c.row, nullptr, i))
+            {
+                changed(SNAPSHOT_ZOMBIE, WATCH_FIELD_HP, c.id[i], c.type[i], p.hp[i], c.hp[i]);
+                changed(SNAPSHOT_ZOMBIE, WATCH_FIELD_ROW, c.id[i], c.type[i], p.row[i], c.row[i]);
+                changed(SNAPSHOT_ZOMBIE, WATCH_FIELD_STATUS, c.id[i], c.type[i], p.status[i], c.status[i]);
+            }
+        }
+    }
+
+    if (pools & SNAPSHOT_GRID_ITEM)
+    {
+        auto &p = prev.grid_items;
+        auto &c = curr.grid_items;
+        size_t n = (std::max)(p.alive.size(), c.alive.size());
+        for (size_t i = 0; i < n; i++)
+            added_removed(SNAPSHOT_GRID_ITEM, p.id, p.alive, p.type, c.id, c.alive, c.type, c.row, &c.col, i);
+    }
+
+    return count;
+}
+
+void BoardWatcher::run()
+{
+    BoardSnapshot prev;
+    int prev_clock = -1;
+    double interval = interval_min;
+    DWORD sleep_ms = 0;
+
+    while (WaitForSingleObject(stop_event, sleep_ms) == WAIT_TIMEOUT)
+    {
+        double begin = StallProfiler::Now();
+        size_t events = 0;
+
+        // 这里不能调用 GameOn, 它找不到游戏时会回调界面
+        bool valid = pvz->IsValid();
+        auto data = pvz->data();
+        int ui = valid ? pvz->GameUI() : 0;
+        if (ui == 2 || ui == 3)
+        {
+            // 只读不写, 不拿操作锁, 每次读内存各自持有共享锁
+            int clock = pvz->ReadMemory<int>({data.lawn, data.board, data.game_clock});
+            if (clock != prev_clock) // 暂停时不必读取
+            {
+                // 读取失败时保留上一次的快照, 避免误报大量移除
+                BoardSnapshot curr;
+                if (curr.Capture(*pvz, data, pvz->layouts(), pools))
+                {
+                    events = diff(prev, curr, clock);
+                    prev = std::move(curr);
+                    prev_clock = clock;
+                }
+            }
+        }
+        else if (prev_clock != -1)
+        {
+            // 离开场地, 所有对象都视为移除
+            events = diff(prev, BoardSnapshot(), prev_clock);
+            prev = BoardSnapshot();
+            prev_clock = -1;
+        }
+
+        // 有变化时恢复最短间隔, 平静时逐渐放宽
+        if (events > 0)
+            interval = interval_min;
+        else
+            interval = (std::min)(interval * 1.5, double(interval_max));
+
+        int frame_duration = valid ? pvz->ReadMemory<int>({data.lawn, data.frame_duration}) : 10;
+        frame_duration = (std::max)(frame_duration, 1);
+        double work_ms = StallProfiler::Now() - begin;
+        double wait_ms = interval * frame_duration;
+
+        // 工作时间占比不超过预算
+        wait_ms = (std::max)(wait_ms, work_ms * (1.0 - budget) / budget);
+        sleep_ms = DWORD(wait_ms + 0.5);
+    }
+}
+
+} // namespace Pt
@@ -0,0 +1,480 @@
+
+#include "../inc/wavegen.h"
+
+namespace Pt
+{
+
+const ZombieDefinition WaveGenerator::DEFINITIONS[33] = {
+    {1, 0, 4000},  // 普僵
+    {1, 0, 0},     // 旗帜
+    {2, 0, 4000},  // 路障
+    {2, 4, 2000},  // 撑杆
+    {4, 0, 3000},  // 铁桶
+    {2, 0, 1000},  // 读报
+    {4, 4, 3500},  // 铁门
+    {7, 4, 2000},  // 橄榄
+    {5, 4, 1000},  // 舞王
+    {1, 0, 0},     // 伴舞
+    {1, 4, 0},     // 鸭子
+    {3, 9, 2000},  // 潜水
+    {7, 9, 2000},  // 冰车
+    {3, 9, 2000},  // 雪橇
+    {3, 9, 1500},  // 海豚
+    {3, 9, 1000},  // 小丑
+    {2, 9, 2000},  // 气球
+    {4, 9, 1000},  // 矿工
+    {4, 9, 1000},  // 跳跳
+    {4, 0, 1},     // 雪人
+    {3, 9, 1000},  // 蹦极
+    {4, 9, 1000},  // 扶梯
+    {5, 9, 1500},  // 投篮
+    {10, 14, 1500}, // 白眼
+    {10, 0, 0},    // 小鬼
+    {10, 0, 0},    // 僵博
+    {1, 0, 4000},  // 豌豆
+    {4, 0, 3000},  // 坚果
+    {3, 9, 1000},  // 辣椒
+    {3, 9, 2000},  // 机枪
+    {3, 9, 2000},  // 窝瓜
+    {4, 9, 2000},  // 高墙
+    {10, 47, 6000} // 红眼
+};
+
+// 在 [from, to] 之间线性插值, 超出范围取端点
+static int animate(int from, int to, int t, int value_from, int value_to)
+{
+    if (t <= from)
+        return value_from;
+    if (t >= to)
+        return value_to;
+    return value_from + (value_to - value_from) * (t - from) / (to - from);
+}
+
+WaveGenerator::WaveGenerator(const WaveRules &rules) : rules(rules)
+{
+    if (this->rules.waves > WAVE_COUNT)
+        this->rules.waves = WAVE_COUNT;
+    if (this->rules.waves < 0)
+        this->rules.waves = 0;
+    if (this->rules.flag_interval <= 0)
+        this->rules.flag_interval = 10;
+
+    candidates.resize(this->rules.waves);
+    affordable.resize(this->rules.waves);
+    cumulative.resize(this->rules.waves);
+    for (int w = 0; w < this->rules.waves; w++)
+    {
+        // 累计波数, 无尽模式下随轮数增加
+        int total_wave = this->rules.stage * this->rules.waves + w;
+        bool giga_wave = !this->rules.limit_giga || w < 10 || w == this->rules.waves - 1;
+
+        for (int t = 0; t < 33; t++)
+        {
+            const ZombieDefinition &def = DEFINITIONS[t];
+            if (!this->rules.zombies[t])
+                continue;
+            if (t == ZOMBIE_FLAG || t == ZOMBIE_BUNGEE) // 只在旗帜波的预设部分出现
+                continue;
+            if (t == ZOMBIE_GIGA && !giga_wave)
+                continue;
+            if (total_wave < def.first_wave)
+                continue;
+
+            // 普僵和路障的权重随波数降低
+            int weight = def.weight;
+            if (t == ZOMBIE_NORMAL)
+                weight = animate(10, 50, total_wave, 4000, 400);
+            else if (t == ZOMBIE_CONE)
+                weight = animate(10, 50, total_wave, 4000, 1000);
+            if (weight <= 0)
+                continue;
+
+            candidates[w].push_back({t, def.value, weight});
+        }
+
+        std::stable_sort(candidates[w].begin(), candidates[w].end(),
+                         [](const Candidate &a, const Candidate &b) { return a.value < b.value; });
+
+        int sum = 0;
+        for (auto &c : candidates[w])
+        {
+            sum += c.weight;
+            cumulative[w].push_back(sum);
+        }
+        for (int points = 0; points <= VALUE_MAX; points++)
+        {
+            int n = 0;
+            while (n < int(candidates[w].size()) && candidates[w][n].value <= points)
+                n++;
+            affordable[w][points] = n;
+        }
+    }
+}
+
+int WaveGenerator::WavePoints(int wave) const
+{
+    return (rules.stage * rules.waves + wave + 10) * 2 / 5 + 1;
+}
+
+bool WaveGenerator::IsFlagWave(int wave) const
+{
+    return wave % rules.flag_interval == rules.flag_interval - 1;
+}
+
+int WaveGenerator::prefix(int wave, std::vector<int> &list) const
+{
+    int points = WavePoints(wave);
+    if (!IsFlagWave(wave))
+        return points;
+
+    // 旗帜波点数乘以 2.5, 先出旗帜和若干普僵, 有蹦极时再出一组蹦极
+    int normal_count = (std::min)(points, FLAG_NORMAL_MAX);
+    points = int(points * 2.5f);
+
+    list.push_back(ZOMBIE_FLAG);
+    points -= DEFINITIONS[ZOMBIE_FLAG].value;
+    for (int i = 0; i < normal_count; i++)
+    {
+        list.push_back(ZOMBIE_NORMAL);
+        points -= DEFINITIONS[ZOMBIE_NORMAL].value;
+    }
+    if (rules.zombies[ZOMBIE_BUNGEE] && rules.stage * rules.waves + wave >= DEFINITIONS[ZOMBIE_BUNGEE].first_wave)
+        for (int i = 0; i < FLAG_BUNGEE_COUNT; i++)
+        {
+            list.push_back(ZOMBIE_BUNGEE);
+            points -= DEFINITIONS[ZOMBIE_BUNGEE].value;
+        }
+
+    return points;
+}
+
+int WaveGenerator::total_weight(int wave, int points) const
+{
+    int n = points > VALUE_MAX ? int(candidates[wave].size()) : affordable[wave][(std::max)(points, 0)];
+    return n == 0 ? 0 : cumulative[wave][n - 1];
+}
+
+std::array<int, 1000> WaveGenerator::Generate(uint32_t seed) const
+{
+    std::array<int, 1000> list;
+    std::mt19937 gen(seed);
+    Generate(gen, list);
+    return list;
+}
+
+void WaveGenerator::Generate(std::mt19937 &gen, std::array<int, 1000> &list) const
+{
+    Generate(gen, list, nullptr);
+}
+
+bool WaveGenerator::Generate(std::mt19937 &gen, std::array<int, 1000> &list, const std::function<bool(int)> &on_wave) const
+{
+    list.fill(-1);
+    int yeti_count = 0;
+
+    int wave_list[WAVE_SIZE + FLAG_NORMAL_MAX + FLAG_BUNGEE_COUNT + 1];
+    std::vector<int> wave_prefix;
+    for (int w = 0; w < rules.waves; w++)
+    {
+        wave_prefix.clear();
+        int points = prefix(w, wave_prefix);
+        int count = int(wave_prefix.size());
+        std::copy(wave_prefix.begin(), wave_prefix.end(), wave_list);
+
+        const auto &c = candidates[w];
+        while (points > 0 && count < WAVE_SIZE)
+        {
+            int total = total_weight(w, points);
+
+            // 雪人已满时跳过
+            int skip = -1;
+            if (yeti_count >= rules.max_yeti)
+            {
+                int n = points > VALUE_MAX ? int(c.size()) : affordable[w][points];
+                for (int i = 0; i < n; i++)
+                    if (c[i].type == ZOMBIE_YETI)
+                    {
+                        skip = i;
+                        total -= c[i].weight;
+                        break;
+                    }
+            }
+            if (total <= 0)
+                break;
+
+            // 直接取模而不用 uniform_int_distribution, 保证不同编译器结果一致
+            int r = int(gen() % uint32_t(total));
+            for (int i = 0; i < int(c.size()); i++)
+            {
+                if (i == skip)
+                    continue;
+                if (r < c[i].weight)
+                {
+                    wave_list[count++] = c[i].type;
+                    points -= c[i].value;
+                    if (c[i].type == ZOMBIE_YETI)
+                        yeti_count++;
+                    break;
+                }
+                r -= c[i].weight;
+            }
+        }
+
+        int n = (std::min)(count, WAVE_SIZE);
+        for (int i = 0; i < n; i++)
+            list[w * WAVE_SIZE + i] = wave_list[i];
+
+        if (on_wave && !on_wave(w))
+            return false;
+    }
+
+    return true;
+}
+
+int WaveGenerator::Check(const std::array<int, 1000> &list) const
+{
+    int yeti_count = 0;
+
+    std::vector<int> expected;
+    for (int w = 0; w < rules.waves; w++)
+    {
+        const int *wave_list = &list[w * WAVE_SIZE];
+
+        // 预设部分必须完全一致
+        expected.clear();
+        int points = prefix(w, expected);
+        size_t i = 0;
+        for (; i < expected.size() && i < WAVE_SIZE; i++)
+            if (wave_list[i] != expected[i])
+                return w;
+
+        // 其余部分逐个抽取: 抽取时还有点数, 种类可以出现且点数够用
+        for (; i < WAVE_SIZE && wave_list[i] != -1; i++)
+        {
+            int type = wave_list[i];
+            if (points <= 0)
+                return w;
+            if (type == ZOMBIE_YETI && yeti_count >= rules.max_yeti)
+                return w;
+
+            bool found = false;
+            for (auto &c : candidates[w])
+                if (c.type == type)
+                {
+                    found = c.value <= points;
+                    break;
+                }
+            if (!found)
+                return w;
+
+            points -= DEFINITIONS[type].value;
+            if (type == ZOMBIE_YETI)
+                yeti_count++;
+        }
+
+        // 没有满 50 个时, 结束的原因必须是点数用完或者没有点数够用的种类
+        if (i < WAVE_SIZE && points > 0)
+        {
+            int total = total_weight(w, points);
+            if (yeti_count >= rules.max_yeti)
+                for (auto &c : candidates[w])
+                    if (c.type == ZOMBIE_YETI && c.value <= points)
+                        total -= c.weight;
+            if (total > 0)
+                return w;
+        }
+    }
+
+    return -1;
+}
+
+AliasTable::AliasTable()
+{
+}
+
+AliasTable::AliasTable(const std::vector<double> &weights)
+{
+    size_t n = weights.size();
+    prob.assign(n, 1.0);
+    alias.assign(n, 0);
+    if (n == 0)
+        return;
+
+    double sum = 0;
+    for (auto w : weights)
+        sum += w;
+
+    // 缩放到平均为 1, 小于 1 的和大于 1 的配对
+    std::vector<double> scaled(n);
+    std::vector<uint32_t> small, large;
+    for (size_t i = 0; i < n; i++)
+    {
+        scaled[i] = sum > 0 ? weights[i] * n / sum : 1.0;
+        if (scaled[i] < 1.0)
+            small.push_back(uint32_t(i));
+        else
+            large.push_back(uint32_t(i));
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        uint32_t s = small.back();
+        small.pop_back();
+        uint32_t l = large.back();
+
+        prob[s] = scaled[s];
+        alias[s] = l;
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0)
+        {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // 剩下的因为浮点误差略偏离 1, 按 1 处理
+    for (auto i : small)
+        prob[i] = 1.0;
+    for (auto i : large)
+        prob[i] = 1.0;
+}
+
+size_t AliasTable::size() const
+{
+    return prob.size();
+}
+
+size_t AliasTable::Sample(std::mt19937 &gen) const
+{
+    size_t i = gen() % uint32_t(prob.size());
+    double u = gen() * (1.0 / 4294967296.0);
+    return u < prob[i] ? i : alias[i];
+}
+
+CustomSpawner::CustomSpawner(const std::array<bool, 33> &zombies, bool limit_giga, bool simulate, int giga_weight)
+    : zombies(zombies), limit_giga(limit_giga), simulate(simulate)
+{
+    empty = std::find(zombies.begin(), zombies.end(), true) == zombies.end();
+
+    for (int kind = KIND_FLAG; kind <= KIND_LIMITED; kind++)
+    {
+        std::vector<double> weights;
+        for (int t = 0; t < 33; t++)
+        {
+            // 旗帜/雪人/蹦极单独放置
+            if (!zombies[t] || t == ZOMBIE_FLAG || t == ZOMBIE_YETI || t == ZOMBIE_BUNGEE)
+                continue;
+            if (t == ZOMBIE_GIGA && kind == KIND_LIMITED)
+                continue;
+
+            // 模拟后期的权重, 普通波的红眼权重可调
+            double weight = WaveGenerator::DEFINITIONS[t].weight;
+            if (t == ZOMBIE_NORMAL)
+                weight = 400;
+            else if (t == ZOMBIE_CONE)
+                weight = 1000;
+            else if (t == ZOMBIE_GIGA && kind != KIND_FLAG)
+                weight = giga_weight;
+
+            types[kind].push_back(t);
+            weights.push_back(weight);
+        }
+        tables[kind] = AliasTable(weights);
+    }
+}
+
+int CustomSpawner::wave_kind(int wave) const
+{
+    if (wave % 10 == 9)
+        return KIND_FLAG;
+    if (limit_giga && wave >= 11 - 1 && wave <= 19 - 1)
+        return KIND_LIMITED;
+    return KIND_NORMAL;
+}
+
+std::array<int, 1000> CustomSpawner::Generate(uint32_t seed) const
+{
+    std::array<int, 1000> list;
+    std::mt19937 gen(seed);
+    Generate(gen, list);
+    return list;
+}
+
+void CustomSpawner::Generate(std::mt19937 &gen, std::array<int, 1000> &list) const
+{
+    Generate(gen, list, nullptr);
+}
+
+bool CustomSpawner::Generate(std::mt19937 &gen, std::array<int, 1000> &list, const std::function<bool(int)> &on_wave) const
+{
+    list.fill(-1);
+
+    // 雪人的位置不回调时最后抽取, 和一次生成整个列表时的抽取顺序一致, 同一个种子结果不变
+    // 逐波回调时要先定下来才能放在所在的那一波, 所以先抽取, 同一个种子的结果和不回调时不同
+    bool yeti = !empty && zombies[ZOMBIE_YETI];
+    size_t yeti_index = (yeti && on_wave) ? gen() % 1000 : 1000;
+
+    int type = 0;
+    for (int w = 0; w < WAVE_COUNT; w++)
+    {
+        int kind = wave_kind(w);
+        size_t base = w * WAVE_SIZE;
+
+        for (size_t i = base; i < base + WAVE_SIZE && !empty; i++)
+        {
+            if (simulate)
+            {
+                if (tables[kind].size() > 0)
+                    list[i] = types[kind][tables[kind].Sample(gen)];
+                continue;
+            }
+
+            // 依次轮流填入允许的种类
+            for (int k = 0; k < 33; k++)
+            {
+                type = (type + 1) % 33;
+                if (!zombies[type] || type == ZOMBIE_FLAG || type == ZOMBIE_YETI || type == ZOMBIE_BUNGEE)
+                    continue;
+                if (kind == KIND_LIMITED && type == ZOMBIE_GIGA)
+                    continue;
+                list[i] = type;
+                break;
+            }
+        }
+
+        // 旗帜波开头依次是旗帜, 8 只普僵, 4 只蹦极
+        if (kind == KIND_FLAG && !empty)
+        {
+            if (zombies[ZOMBIE_FLAG] || simulate)
+                list[base] = ZOMBIE_FLAG;
+            if (simulate)
+                for (size_t j = 1; j <= FLAG_NORMAL_MAX; j++)
+                    list[base + j] = ZOMBIE_NORMAL;
+            if (zombies[ZOMBIE_BUNGEE])
+                for (size_t j = 1 + FLAG_NORMAL_MAX; j <= FLAG_NORMAL_MAX + FLAG_BUNGEE_COUNT; j++)
+                    list[base + j] = ZOMBIE_BUNGEE;
+        }
+
+        if (yeti_index / WAVE_SIZE == size_t(w))
+            list[yeti_index] = ZOMBIE_YETI;
+
+        if (on_wave && !on_wave(w))
+            return false;
+    }
+
+    if (yeti && !on_wave)
+        list[gen() % 1000] = ZOMBIE_YETI;
+
+    return true;
+}
+
+std::vector<std::array<int, 1000>> CustomSpawner::Batch(size_t count, uint32_t seed) const
+{
+    std::vector<std::array<int, 1000>> lists(count);
+    std::mt19937 gen(seed);
+    for (auto &list : lists)
+        Generate(gen, list);
+    return lists;
+}
+
+} // namespace Pt
@@ -450,9 +450,9 @@ SpawnTable::SpawnTable(int X, int Y, int W, int H, const char *L = 0)
     : Fl_Table(X, Y, W, H, L)
 {
     // 宽: 75 + 35 * 20 + (35 + 25) + 2 = 837
-    // 高: (18 + 3) + 18 * 33       + 2 = 617
+    // 高: (18 + 3) + 18 * (33 + 1) + 2 = 635
 
-    rows(ROWS);
+    rows(ROWS + 1);
     row_header(1);
 #ifdef _PTK_CHINESE_UI
     row_header_width(75);
@@ -471,6 +471,9 @@ SpawnTable::SpawnTable(int X, int Y, int W, int H, const char *L = 0)
 
     box(FL_NO_BOX); // 无边框
 
+    for (int c = 0; c < COLS - 1; c++)
+        col_labels[c] = "w" + std::to_string(c + 1);
+
     end();
 }
 
@@ -478,42 +481,165 @@ SpawnTable::~SpawnTable()
 {
 }
 
-void SpawnTable::UpdateData(std::array<int, 1000> zombies_list)
+bool SpawnTable::UpdateData(const std::array<int, 1000> &zombies_list)
 {
-    for (size_t r = 0; r < ROWS; r++)
-        for (size_t c = 0; c < COLS; c++)
-            data[r][c] = 0;
-    total = 0;
+    // 定时刷新时列表多数时候不变, 和上次的列表逐项比较
+    if (list_valid && !analyzed && zombies_list == last_list)
+        return false;
 
+    int counts[ROWS][COLS] = {{0}};
+    int sum = 0;
     for (size_t i = 0; i < 20; i++)
     {
         for (size_t j = 0; j < 50; j++)
         {
             if (zombies_list[i * 50 + j] >= 33 || zombies_list[i * 50 + j] < 0)
                 continue;
-            data[zombies_list[i * 50 + j]][i] += 1;
-            data[zombies_list[i * 50 + j]][20 + 1 - 1] += 1;
-            total += 1;
+            counts[zombies_list[i * 50 + j]][i] += 1;
+            counts[zombies_list[i * 50 + j]][20 + 1 - 1] += 1;
+            sum += 1;
         }
     }
 
+    // 显示的种类, 总数或者显示方式变了要整体重画, 否则只重画变化的格子
+    bool rows_changed = !list_valid;
+    for (int r = 0; r < ROWS && !rows_changed; r++)
+        if ((counts[r][20 + 1 - 1] == 0) != (data[r][20 + 1 - 1] == 0))
+            rows_changed = true;
+    bool layout_changed = rows_changed || analyzed || sum != total;
+
+    int top = ROWS, bottom = -1, left = COLS, right = -1;
+    for (int r = 0; r < ROWS; r++)
+        for (int c = 0; c < COLS; c++)
+            if (counts[r][c] != data[r][c])
+            {
+                top = (std::min)(top, r);
+                bottom = (std::max)(bottom, r);
+                left = (std::min)(left, c);
+                right = (std::max)(right, c);
+            }
+
+    memcpy(data, counts, sizeof(data));
+    total = sum;
+    analyzed = false;
+    last_list = zombies_list;
+    list_valid = true;
+    threat.Waves(zombies_list, threat_waves);
+    update_layout();
+
+    // 数量变化的波的威胁也跟着变
+    if (layout_changed)
+        this->redraw();
+    else if (bottom >= 0)
+        this->redraw_range(top, THREAT_ROW, left, right);
+
+    return rows_changed;
+}
+
+void SpawnTable::UpdateStats(const SpawnStats &stats)
+{
+    this->stats = stats;
+    for (size_t r = 0; r < ROWS; r++)
+        for (size_t c = 0; c < COLS; c++)
+        {
+            // 只要出现过就保留这一行, 不至于因为平均数太小而隐藏
+            data[r][c] = stats.appear[r][c] > 0 ? (std::max)(int(stats.mean[r][c] + 0.5), 1) : 0;
+        }
+    total = stats.samples;
+    analyzed = true;
+    list_valid = false;
+    update_layout();
+
+    this->redraw();
+}
+
+void SpawnTable::SetStatMode(int mode)
+{
+    stat_mode = mode;
+    if (!analyzed)
+        return;
+
+    update_layout();
     this->redraw();
 }
 
+void SpawnTable::update_layout()
+{
+    int Ys = 0;
+    for (int r = 0; r < ROWS; r++)
+    {
+        offset[r] = Ys;
+        if (data[r][20 + 1 - 1] == 0)
+            Ys += 18;
+    }
+    offset[THREAT_ROW] = Ys;
+
+    for (int r = 0; r < ROWS; r++)
+    {
+        if (data[r][20 + 1 - 1] == 0)
+        {
+            row_labels[r].clear();
+            continue;
+        }
+#ifdef _PTK_CHINESE_UI
+        row_labels[r] = "[" + std::to_string(r) + "]" + " " + zombies_zh[r] + "  ";
+#else
+        row_labels[r] = "[" + std::to_string(r) + "]" + " " + zombies_s[r] + "  ";
+#endif
+    }
+
+    // 最后一列显示总数, 分析结果显示的是所选的统计量
+    const char *stat_labels[] = {"(avg)", "(p10)", "(p50)", "(p90)", "(%)"};
+    col_labels[COLS - 1] = analyzed ? stat_labels[stat_mode] : "(" + std::to_string(total) + ")";
+
+    for (int r = 0; r < ROWS; r++)
+        for (int c = 0; c < COLS; c++)
+        {
+            if (data[r][c] == 0) // 某波某种僵尸数量为 0 干脆不显示
+                cells[r][c][0] = '\0';
+            else if (!analyzed)
+                sprintf_s(cells[r][c], "%i", data[r][c]);
+            else if (stat_mode == 1)
+                sprintf_s(cells[r][c], "%i", stats.p10[r][c]);
+            else if (stat_mode == 2)
+                sprintf_s(cells[r][c], "%i", stats.p50[r][c]);
+            else if (stat_mode == 3)
+                sprintf_s(cells[r][c], "%i", stats.p90[r][c]);
+            else if (stat_mode == 4)
+                sprintf_s(cells[r][c], "%.0f%%", stats.appear[r][c] * 100);
+            else
+                sprintf_s(cells[r][c], "%.1f", stats.mean[r][c]);
+        }
+
+    float threat_total = 0;
+    for (int c = 0; c < COLS - 1; c++)
+    {
+        float score = threat.Score(threat_waves[c]);
+        threat_total += score;
+        if (analyzed || total == 0)
+            threat_cells[c][0] = '\0';
+        else
+            sprintf_s(threat_cells[c], "%.0f", score);
+    }
+    if (analyzed || total == 0)
+        threat_cells[COLS - 1][0] = '\0';
+    else
+        sprintf_s(threat_cells[COLS - 1], "%.0f", threat_total);
+}
+
 void SpawnTable::draw_cell(TableContext context, int ROW = 0, int COL = 0, //
                            int X = 0, int Y = 0, int W = 0, int H = 0)
 {
-    static char s[100]; // 缓冲
-
     // 单波某种僵尸一般不超过 20 只，单轮某种僵尸一般不超过 300 只
-    Fl_Color c_n = 0xffffff00u - 0x01000100u * (std::min(data[ROW][COL], 20) * 0xffu / 30);   // 背景颜色
-    Fl_Color c_t = 0xffffff00u - 0x01010100u * (std::min(data[ROW][COL], 300) * 0xffu / 500); // 背景颜色(总数)
+    // 分析结果按平均数量着色, 威胁行不着色
+    double v = 0;
+    if (ROW < ROWS)
+        v = analyzed ? stats.mean[ROW][COL] : double(data[ROW][COL]);
+    Fl_Color c_n = 0xffffff00u - 0x01000100u * unsigned(std::min(v, 20.0) * 0xff / 30);   // 背景颜色
+    Fl_Color c_t = 0xffffff00u - 0x01010100u * unsigned(std::min(v, 300.0) * 0xff / 500); // 背景颜色(总数)
     Fl_Color c_f = 0xcccccc00u;                                                               // 旗帜波边框
 
-    int Ys = 0; // 因为不画缺少的种类造成的纵向偏移
-    for (int r = 0; r < ROW; r++)
-        if (data[r][20 + 1 - 1] == 0)
-            Ys += 18;
+    int Ys = offset[ROW];
 
     switch (context)
     {
@@ -530,39 +656,48 @@ void SpawnTable::draw_cell(TableContext context, int ROW = 0, int COL = 0, //
         if (total == 0) // 僵尸列表为空时不画波数表头
             break;
 
-        if (COL == (20 + 1 - 1)) // 最后一列改为显示总数
-            sprintf_s(s, "%s", std::string("(" + std::to_string(total) + ")").c_str());
-        else
-            sprintf_s(s, "w%i", COL + 1);
-
         fl_push_clip(X, Y, W, H);
         {
             fl_draw_box(FL_THIN_UP_BOX, X, Y, W, H, col_header_color());
             fl_color(FL_BLACK);
-            fl_draw(s, X, Y, W, H, FL_ALIGN_CENTER);
+            fl_draw(col_labels[COL].c_str(), X, Y, W, H, FL_ALIGN_CENTER);
         }
         fl_pop_clip();
 
         return;
 
     case CONTEXT_ROW_HEADER:
-        if (data[ROW][20 + 1 - 1] == 0) // 不画不出的僵尸种类
-            break;
+        if (ROW == THREAT_ROW)
+        {
+            if (threat_cells[COLS - 1][0] == '\0')
+                break;
 
+            fl_push_clip(X, Y - Ys, W, H);
+            {
+                fl_draw_box(FL_THIN_UP_BOX, X, Y - Ys, W, H, row_header_color());
+                fl_color(FL_BLACK);
 #ifdef _PTK_CHINESE_UI
-        sprintf_s(s, "%s", std::string("[" + std::to_string(ROW) + "]" + " " + zombies_zh[ROW] + "  ").c_str());
+                fl_draw("威胁  ", X, Y - Ys, W, H, FL_ALIGN_RIGHT);
 #else
-        sprintf_s(s, "%s", std::string("[" + std::to_string(ROW) + "]" + " " + zombies_s[ROW] + "  ").c_str());
+                fl_draw("Threat  ", X, Y - Ys, W, H, FL_ALIGN_LEFT);
 #endif
+            }
+            fl_pop_clip();
+
+            return;
+        }
+
+        if (data[ROW][20 + 1 - 1] == 0) // 不画不出的僵尸种类
+            break;
 
         fl_push_clip(X, Y - Ys, W, H);
         {
             fl_draw_box(FL_THIN_UP_BOX, X, Y - Ys, W, H, row_header_color());
             fl_color(FL_BLACK);
 #ifdef _PTK_CHINESE_UI
-            fl_draw(s, X, Y - Ys, W, H, FL_ALIGN_RIGHT);
+            fl_draw(row_labels[ROW].c_str(), X, Y - Ys, W, H, FL_ALIGN_RIGHT);
 #else
-            fl_draw(s, X, Y - Ys, W, H, FL_ALIGN_LEFT);
+            fl_draw(row_labels[ROW].c_str(), X, Y - Ys, W, H, FL_ALIGN_LEFT);
 #endif
         }
         fl_pop_clip();
@@ -570,14 +705,28 @@ void SpawnTable::draw_cell(TableContext context, int ROW = 0, int COL = 0, //
         return;
 
     case CONTEXT_CELL:
+        if (ROW == THREAT_ROW)
+        {
+            if (threat_cells[COLS - 1][0] == '\0')
+                break;
+
+            fl_push_clip(X, Y - Ys, W, H);
+            {
+                fl_color(row_header_color());
+                fl_rectf(X, Y - Ys, W, H);
+                fl_color(FL_GRAY0);
+                fl_draw(threat_cells[COL], X, Y - Ys, W, H, FL_ALIGN_CENTER);
+                fl_color((COL == (10 - 1) || COL == (20 - 1)) ? c_f : color());
+                fl_rect(X, Y - Ys, W, H);
+            }
+            fl_pop_clip();
+
+            return;
+        }
+
         if (data[ROW][20 + 1 - 1] == 0) // 不画不出的僵尸种类
             break;
 
-        if (data[ROW][COL] == 0) // 某波某种僵尸数量为 0 干脆不显示
-            sprintf_s(s, "");
-        else
-            sprintf_s(s, "%i", data[ROW][COL]);
-
         fl_push_clip(X, Y - Ys, W, H);
         {
             // 背景
@@ -585,7 +734,7 @@ void SpawnTable::draw_cell(TableContext context, int ROW = 0, int COL = 0, //
             fl_rectf(X, Y - Ys, W, H);
             // 数据
             fl_color(FL_GRAY0);
-            fl_draw(s, X, Y - Ys, W, H, FL_ALIGN_CENTER);
+            fl_draw(cells[ROW][COL], X, Y - Ys, W, H, FL_ALIGN_CENTER);
             // 边框
             fl_color((COL == (10 - 1) || COL == (20 - 1)) ? c_f : color());
             fl_rect(X, Y - Ys, W, H);
@@ -612,19 +761,19 @@ SpawnWindow::SpawnWindow(int width, int height, const char *title)
 #endif
 
 // 设置窗口大小
-// 表格大小 837 x 617
+// 表格大小 837 x 635
 #ifdef _PTK_CHINESE_UI
     const int m = 5;
     const int b = 7;
     const int tw = 837;
-    const int th = 617;
+    const int th = 635;
     const int rhw = 75;
     const int chh = 18 + 3;
 #else
     const int m = 5;
     const int b = 7;
     const int tw = 937;
-    const int th = 617;
+    const int th = 635;
     const int rhw = 175;
     const int chh = 18 + 3;
 #endif
@@ -644,10 +793,24 @@ SpawnWindow::SpawnWindow(int width, int height, const char *title)
     button_zombies_list->add("[刷新]");
     button_zombies_list->add("[保存]");
     button_zombies_list->add("[加载]");
+    button_zombies_list->add("[分析]");
+    button_zombies_list->add("[复制代码]");
+    button_zombies_list->add("[粘贴代码]");
+    button_zombies_list->add("[搜索]");
+    button_zombies_list->add("[预测]");
+    button_zombies_list->add("[检查]");
+    button_zombies_list->add("[切换统计]");
 #else
     button_zombies_list->add("[ Refresh ]");
     button_zombies_list->add("[ Save ]");
     button_zombies_list->add("[ Load ]");
+    button_zombies_list->add("[ Analyze ]");
+    button_zombies_list->add("[ Copy Code ]");
+    button_zombies_list->add("[ Paste Code ]");
+    button_zombies_list->add("[ Search ]");
+    button_zombies_list->add("[ Predict ]");
+    button_zombies_list->add("[ Check ]");
+    button_zombies_list->add("[ Statistic ]");
 #endif
     button_zombies_list->type(Fl_Menu_Button::POPUP3);
     button_zombies_list->value(0);
@@ -660,6 +823,9 @@ SpawnWindow::SpawnWindow(int width, int height, const char *title)
     button_zombies_list->replace(0, EMOJI("🔄", "[刷新]"));
     button_zombies_list->replace(1, EMOJI("💾", "[保存]"));
     button_zombies_list->replace(2, EMOJI("🔖", "[加载]"));
+    button_zombies_list->replace(3, EMOJI("📊", "[分析]"));
+    button_zombies_list->replace(4, EMOJI("📋", "[复制代码]"));
+    button_zombies_list->replace(5, EMOJI("📥", "[粘贴代码]"));
 #else
     button_update_details->copy_tooltip("Refresh");
 #endif
@@ -671,28 +837,51 @@ SpawnWindow::~SpawnWindow()
 
 void SpawnWindow::UpdateData(std::array<int, 1000> zombies_list)
 {
-    table_spawn->UpdateData(zombies_list);
+    bool rows_changed = table_spawn->UpdateData(zombies_list);
 
-    int zombies_count[33] = {0};
-    for (size_t i = 0; i < 20; i++)
-    {
-        for (size_t j = 0; j < 50; j++)
-        {
-            if (zombies_list[i * 50 + j] >= 33 || zombies_list[i * 50 + j] < 0)
-                continue;
-            zombies_count[zombies_list[i * 50 + j]] += 1;
-        }
-    }
+#ifdef _PTK_CHINESE_UI
+    const char *title = this->on ? "Spawning Counting" : "出怪数量统计";
+#else
+    const char *title = "Spawning Counting";
+#endif
+    if (this->label() == nullptr || strcmp(this->label(), title) != 0)
+        this->copy_label(title);
+
+    // 显示的种类不变时窗口大小不变, 交给表格自己重画变化的格子
+    if (rows_changed)
+        fit_rows();
+}
+
+void SpawnWindow::UpdateStats(const SpawnStats &stats)
+{
+    table_spawn->UpdateStats(stats);
+
+    char s[200];
+#ifdef _PTK_CHINESE_UI
+    if (this->on)
+        sprintf_s(s, "Spawning Distribution (%u samples, giga in w10-w19: %.1f%%)", stats.samples, stats.giga_late * 100);
+    else
+        sprintf_s(s, "出怪分布 (%u 次, 第 10-19 波出红眼: %.1f%%)", stats.samples, stats.giga_late * 100);
+#else
+    sprintf_s(s, "Spawning Distribution (%u samples, giga in w10-w19: %.1f%%)", stats.samples, stats.giga_late * 100);
+#endif
+    this->copy_label(s);
+
+    fit_rows();
+}
+
+void SpawnWindow::fit_rows()
+{
     int deleted_rows = 0;
     for (int r = 0; r < 33; r++)
-        if (zombies_count[r] == 0)
+        if (table_spawn->data[r][20 + 1 - 1] == 0)
             deleted_rows += 1;
 
     if (this->on)
     {
         std::string zs;
         for (int r = 0; r < 33; r++)
-            if (zombies_count[r] != 0)
+            if (table_spawn->data[r][20 + 1 - 1] != 0)
 #ifdef _PTK_CHINESE_UI
                 zs += std::string("[" + std::to_string(r) + "]" + "  " + zombies[r] + "\n");
         box_mask_spawn_types->copy_tooltip(zs.c_str());
@@ -712,7 +901,9 @@ void SpawnWindow::UpdateData(std::array<int, 1000> zombies_list)
 #else
     int w = deleted_rows == 33 ? 450 : 5 + 937 + 5;
 #endif
-    int h = 5 + 617 + 7 - deleted_rows * 18;
+    int h = 5 + 635 + 7 - deleted_rows * 18;
+    if (deleted_rows == 33 || table_spawn->analyzed) // 不画威胁行
+        h -= 18;
     this->ww = w;
     this->hh = h;
     this->size(w, h);
@@ -748,6 +939,332 @@ void SpawnWindow::tooltips(bool on)
     this->on = on;
 }
 
+LineupBrowser::LineupBrowser(int X, int Y, int W, int H, const char *L = 0)
+    : Fl_Table_Row(X, Y, W, H, L)
+{
+    type(SELECT_SINGLE);
+
+    rows(0);
+    row_header(0);
+    row_height_all(20);
+    row_resize(0);
+
+    cols(2);
+    col_header(0);
+    col_width(0, 60);
+    col_width(1, W - 60 - Fl::scrollbar_size() - 2);
+    col_resize(0);
+
+    end();
+}
+
+LineupBrowser::~LineupBrowser()
+{
+}
+
+void LineupBrowser::SetRows(const LineupLibrary *lineups, const std::vector<uint32_t> &result)
+{
+    library = lineups;
+    indices.assign(result.begin(), result.end());
+
+    // 表格只按行数算滚动条, 十万行也只画看得见的几十行
+    select_all_rows(0);
+    rows(int(indices.size()));
+    row_position(0);
+    redraw();
+}
+
+int LineupBrowser::Selected()
+{
+    if (indices.empty())
+        return -1;
+    for (int r = 0; r < rows(); r++)
+        if (row_selected(r))
+            return int(indices[r]);
+    return int(indices[0]);
+}
+
+void LineupBrowser::draw_cell(TableContext context, int ROW = 0, int COL = 0, //
+                              int X = 0, int Y = 0, int W = 0, int H = 0)
+{
+#ifdef _PTK_CHINESE_UI
+    static const char *scenes[6] = {"白天", "黑夜", "泳池", "雾夜", "屋顶", "月夜"};
+#else
+    static const char *scenes[6] = {"Day", "Night", "Pool", "Fog", "Roof", "Moon"};
+#endif
+
+    switch (context)
+    {
+    case CONTEXT_STARTPAGE:
+        extern Fl_Font ui_font;
+#ifdef _PTK_CHINESE_UI
+        fl_font(ui_font, 13);
+#else
+        fl_font(ui_font, 12);
+#endif
+        return;
+
+    case CONTEXT_CELL:
+    {
+        if (library == nullptr || ROW >= int(indices.size()))
+            return;
+
+        uint32_t index = indices[ROW];
+        if (index >= library->Size()) // 列表重新加载过
+            return;
+        std::string text;
+        if (COL == 0)
+            text = scenes[static_cast<uint32_t>((*library)[index].scene) % 6];
+        else
+            text = std::string(library->Display(index));
+
+        fl_push_clip(X, Y, W, H);
+        {
+            fl_color(row_selected(ROW) ? selection_color() : FL_WHITE);
+            fl_rectf(X, Y, W, H);
+            fl_color(row_selected(ROW) ? fl_contrast(FL_BLACK, selection_color()) : FL_BLACK);
+            fl_draw(text.c_str(), X + 4, Y, W - 8, H, FL_ALIGN_LEFT);
+        }
+        fl_pop_clip();
+
+        return;
+    }
+
+    default:
+        return;
+    }
+}
+
+void LineupBrowser::resize(int X, int Y, int W, int H)
+{
+    Fl_Table_Row::resize(X, Y, W, H);
+    col_width(1, W - col_width(0) - Fl::scrollbar_size() - 2);
+}
+
+LineupWindow::LineupWindow(int width, int height, const char *title)
+    : Fl_Double_Window(width, height, title)
+{
+    // 参数 width height title 均被忽略
+
+#ifdef _PTK_CHINESE_UI
+    this->copy_label("搜索阵型");
+#else
+    this->copy_label("Search Lineups");
+#endif
+
+    const int m = 5;
+    const int ih = 25;
+    const int w = 480;
+    const int h = 520;
+    this->size(w, h);
+
+    input_search = new Fl_Input(m, m, w - m * 2 - 120, ih, "");
+    box_count = new Fl_Box(w - m - 120, m, 120, ih, "");
+    table_lineup = new LineupBrowser(m, m + ih + m, w - m * 2, h - m * 3 - ih);
+    this->end();
+
+    input_search->when(FL_WHEN_CHANGED | FL_WHEN_ENTER_KEY);
+#ifdef _PTK_CHINESE_UI
+    input_search->tooltip("名称, 可以加上筛选条件, 例如 scene=2 cob>=8 ladder=0 sort=cob");
+#else
+    input_search->tooltip("Name, optionally with filters, e.g. scene=2 cob>=8 ladder=0 sort=cob");
+#endif
+    box_count->align(FL_ALIGN_RIGHT | FL_ALIGN_INSIDE);
+    table_lineup->when(FL_WHEN_RELEASE);
+
+    extern Fl_Font ui_font;
+    input_search->textfont(ui_font);
+    box_count->labelfont(ui_font);
+
+    this->resizable(table_lineup);
+    this->size_range(w / 2, h / 2);
+}
+
+LineupWindow::~LineupWindow()
+{
+}
+
+void LineupWindow::UpdateCount(size_t found, size_t total)
+{
+    std::string count = std::to_string(found) + " / " + std::to_string(total);
+    box_count->copy_label(count.c_str());
+}
+
+SpawnLibraryBrowser::SpawnLibraryBrowser(int X, int Y, int W, int H, const char *L = 0)
+    : Fl_Table_Row(X, Y, W, H, L)
+{
+    type(SELECT_SINGLE);
+
+    rows(0);
+    row_header(0);
+    row_height_all(20);
+    row_resize(0);
+
+    // 序号, 名称, 标签, 数量最多的几种僵尸
+    cols(4);
+    col_header(1);
+    col_header_height(20);
+    col_width(0, 50);
+    col_width(1, 150);
+    col_width(2, 100);
+    col_width(3, W - 50 - 150 - 100 - Fl::scrollbar_size() - 2);
+    col_resize(0);
+
+    end();
+}
+
+SpawnLibraryBrowser::~SpawnLibraryBrowser()
+{
+}
+
+void SpawnLibraryBrowser::SetLibrary(const SpawnLibrary *spawns)
+{
+    library = spawns;
+    count = library != nullptr ? library->Count() : 0;
+
+    select_all_rows(0);
+    rows(int(count));
+    row_position(0);
+    redraw();
+}
+
+int SpawnLibraryBrowser::Selected()
+{
+    if (count == 0)
+        return -1;
+    for (int r = 0; r < rows(); r++)
+        if (row_selected(r))
+            return int(count - 1 - r);
+    return int(count - 1);
+}
+
+void SpawnLibraryBrowser::draw_cell(TableContext context, int ROW = 0, int COL = 0, //
+                                    int X = 0, int Y = 0, int W = 0, int H = 0)
+{
+#ifdef _PTK_CHINESE_UI
+    static const char *headers[4] = {"序号", "名称", "标签", "数量"};
+#else
+    static const char *headers[4] = {"Index", "Name", "Tags", "Counts"};
+#endif
+
+    switch (context)
+    {
+    case CONTEXT_STARTPAGE:
+        extern Fl_Font ui_font;
+#ifdef _PTK_CHINESE_UI
+        fl_font(ui_font, 13);
+#else
+        fl_font(ui_font, 12);
+#endif
+        return;
+
+    case CONTEXT_COL_HEADER:
+        fl_push_clip(X, Y, W, H);
+        {
+            fl_draw_box(FL_THIN_UP_BOX, X, Y, W, H, col_header_color());
+            fl_color(FL_BLACK);
+            fl_draw(headers[COL], X + 4, Y, W - 8, H, FL_ALIGN_LEFT);
+        }
+        fl_pop_clip();
+        return;
+
+    case CONTEXT_CELL:
+    {
+        if (library == nullptr || ROW >= int(count))
+            return;
+
+        uint32_t index = count - 1 - ROW;
+        const SPAWN_LIB_ENTRY *entry = library->Entry(index);
+        if (entry == nullptr)
+            return;
+
+        std::string text;
+        if (COL == 0)
+        {
+            text = std::to_string(index + 1);
+        }
+        else if (COL == 1)
+        {
+            text.assign(entry->name, strnlen(entry->name, sizeof(entry->name)));
+        }
+        else if (COL == 2)
+        {
+            text.assign(entry->tags, strnlen(entry->tags, sizeof(entry->tags)));
+        }
+        else
+        {
+            // 数量从多到少, 放不下的被裁掉
+            std::vector<int> types;
+            for (int t = 0; t < 33; t++)
+                if (entry->counts[t] > 0)
+                    types.push_back(t);
+            std::stable_sort(types.begin(), types.end(), [&](int a, int b)
+                             { return entry->counts[a] > entry->counts[b]; });
+            for (int t : types)
+#ifdef _PTK_CHINESE_UI
+                text += std::string(zombies_zh[t]) + " " + std::to_string(entry->counts[t]) + "  ";
+#else
+                text += std::string(zombies_s[t]) + " " + std::to_string(entry->counts[t]) + "  ";
+#endif
+        }
+
+        fl_push_clip(X, Y, W, H);
+        {
+            fl_color(row_selected(ROW) ? selection_color() : FL_WHITE);
+            fl_rectf(X, Y, W, H);
+            fl_color(row_selected(ROW) ? fl_contrast(FL_BLACK, selection_color()) : FL_BLACK);
+            fl_draw(text.c_str(), X + 4, Y, W - 8, H, FL_ALIGN_LEFT);
+        }
+        fl_pop_clip();
+
+        return;
+    }
+
+    default:
+        return;
+    }
+}
+
+void SpawnLibraryBrowser::resize(int X, int Y, int W, int H)
+{
+    Fl_Table_Row::resize(X, Y, W, H);
+    col_width(3, W - col_width(0) - col_width(1) - col_width(2) - Fl::scrollbar_size() - 2);
+}
+
+SpawnLibraryWindow::SpawnLibraryWindow(int width, int height, const char *title)
+    : Fl_Double_Window(width, height, title)
+{
+    // 参数 width height title 均被忽略
+
+#ifdef _PTK_CHINESE_UI
+    this->copy_label("出怪列表库");
+#else
+    this->copy_label("Zombies List Library");
+#endif
+
+    const int m = 5;
+    const int w = 640;
+    const int h = 480;
+    this->size(w, h);
+
+    table_library = new SpawnLibraryBrowser(m, m, w - m * 2, h - m * 2);
+    this->end();
+
+    table_library->when(FL_WHEN_RELEASE);
+#ifdef _PTK_CHINESE_UI
+    table_library->tooltip("点击一行导入到游戏中");
+#else
+    table_library->tooltip("Click a row to import it into the game");
+#endif
+
+    this->resizable(table_library);
+    this->size_range(w / 2, h / 2);
+}
+
+SpawnLibraryWindow::~SpawnLibraryWindow()
+{
+}
+
 Window::Window(int width, int height, const char *title)
     : Fl_Double_Window(width, height, title)
 {
@@ -826,9 +1343,11 @@ Window::Window(int width, int height, const char *title)
                 check_unlock_sun_limit = new Fl_Round_Button(c(1) + 8, r(1), iw - 76, ih, "");
                 input_sun = new Fl_Value_Input(c(1) + 45, r(1), iw - 15, ih, "");
                 button_sun = new Fl_Button(c(2) + 40 - 10, r(1), iw - 45, ih, "阳光");
+                check_freeze_sun = new Fl_Check_Button(c(2) + iw - 12, r(1), 18, ih, "");
                 box_money = new Fl_Box(c(1) + 8, r(2), iw - 76, ih, "钱包");
                 input_money = new Fl_Value_Input(c(1) + 45, r(2), iw - 15, ih, "");
                 button_money = new Fl_Button(c(2) + 40 - 10, r(2), iw - 45, ih, "金币");
+                check_freeze_money = new Fl_Check_Button(c(2) + iw - 12, r(2), 18, ih, "");
                 check_auto_collected = new Fl_Check_Button(c(3), r(3), iw - 15, ih, "自动收集");
                 check_not_drop_loot = new Fl_Check_Button(c(4), r(3), iw, ih, "不掉战利品");
                 check_fertilizer = new Fl_Check_Button(c(3), r(1), iw - 15, ih, "花肥无限");
@@ -839,13 +1358,15 @@ Window::Window(int width, int height, const char *title)
                 input_wisdom_tree = new Fl_Value_Input(c(1) + 45, r(3), iw - 15, ih, "");
                 button_wisdom_tree = new Fl_Button(c(2) + 40 - 10, r(3), iw - 45, ih, "英尺");
                 check_free_planting = new Fl_Check_Button(c(1), r(4), iw - 15, ih, "免费用卡");
+                check_freeze_cooldown = new Fl_Check_Button(c(1) + iw - 13, r(4), 18, ih, "");
                 check_placed_anywhere = new Fl_Check_Button(c(2), r(4), iw - 15, ih, "随意放置");
                 check_fast_belt = new Fl_Check_Button(c(3), r(4), iw - 15, ih, "无缝传送");
                 check_lock_shovel = new Fl_Check_Button(c(4), r(4), iw - 15, ih, "连续铲子");
                 choice_mode = new Fl_Choice_(c(1), r(5), iw + m + iw + 20, ih, "");
                 choice_adventure = new Fl_Choice_(c(3) + 20, r(5), iw - 20 + 15, ih, "");
                 button_mix = new Fl_Button(c(4) + 15, r(5), iw - 15, ih, "混乱关卡");
-                input_level = new Fl_Value_Input(c(3) + 20, r(6), iw - 20 + 15, ih, "");
+                check_freeze_level = new Fl_Check_Button(c(3) + 20, r(6), 18, ih, "");
+                input_level = new Fl_Value_Input(c(3) + 20 + 20, r(6), iw - 20 - 20 + 15, ih, "");
                 button_level = new Fl_Button(c(4) + 15, r(6), iw - 15, ih, "无尽轮数");
                 button_unlock = new Fl_Button(c(1), r(6), iw + 8, ih, "通关存档");
                 check_brightest_cob_cannon = new Fl_Check_Button(c(2) + 14, r(6), 18, ih, "");
@@ -906,12 +1427,13 @@ Window::Window(int width, int height, const char *title)
                 button_reset = new Fl_Button(c(1), r(3), iw + 12, ih, "重置场地");
                 choice_scene = new Fl_Choice_(c(2) + 12, r(3), iw - 12, ih, "");
                 button_load_lineup = new Fl_Button(c(3), r(3), iw * 2 + 10, ih, "加载阵型列表文件 (***.yml)");
-                choice_lineup_name[0] = new Fl_Choice_(c(3), r(3), iw * 2 + 10, ih, "");
-                choice_lineup_name[1] = new Fl_Choice_(c(3), r(3), iw * 2 + 10, ih, "");
-                choice_lineup_name[2] = new Fl_Choice_(c(3), r(3), iw * 2 + 10, ih, "");
-                choice_lineup_name[3] = new Fl_Choice_(c(3), r(3), iw * 2 + 10, ih, "");
-                choice_lineup_name[4] = new Fl_Choice_(c(3), r(3), iw * 2 + 10, ih, "");
-                choice_lineup_name[5] = new Fl_Choice_(c(3), r(3), iw * 2 + 10, ih, "");
+                choice_lineup_name[0] = new Fl_Choice_(c(3), r(3), iw * 2 + 10 - ih, ih, "");
+                choice_lineup_name[1] = new Fl_Choice_(c(3), r(3), iw * 2 + 10 - ih, ih, "");
+                choice_lineup_name[2] = new Fl_Choice_(c(3), r(3), iw * 2 + 10 - ih, ih, "");
+                choice_lineup_name[3] = new Fl_Choice_(c(3), r(3), iw * 2 + 10 - ih, ih, "");
+                choice_lineup_name[4] = new Fl_Choice_(c(3), r(3), iw * 2 + 10 - ih, ih, "");
+                choice_lineup_name[5] = new Fl_Choice_(c(3), r(3), iw * 2 + 10 - ih, ih, "");
+                button_search_lineup = new Fl_Button(c(3) + iw * 2 + 10 - ih, r(3), ih, ih, "@search");
                 buffer_lineup_string = new Fl_Text_Buffer();
                 editor_lineup_string = new Fl_Text_Editor(c(1), r(4), iw * 4 + 10 * 3, ih * 2 + 10 + 2, "");
                 button_get_lineup = new Fl_Button(c(1), r(6), iw - 15, ih, "获取代码");
@@ -951,6 +1473,7 @@ Window::Window(int width, int height, const char *title)
 
             group_others = new Fl_Group(m, m + th, w - m * 2, h - m * 2 - th, "杂项");
             {
+                button_others_extra = new Fl_Menu_Button(m, m + th, w - m * 2, h - m * 2 - th, nullptr); // 右键菜单, 放在最底层
                 choice_music = new Fl_Choice_(c(1), r(1), iw + m + iw - 15, ih, "");
                 button_music = new Fl_Button(c(3) - 15, r(1), iw, ih, "背景音乐");
                 button_userdata = new Fl_Button(c(4) - 15, r(1), iw + 15, ih, "存档文件夹");
@@ -999,10 +1522,12 @@ Window::Window(int width, int height, const char *title)
             {
                 box_sun = new Fl_Box(c(1), r(1), iw - 40, ih, "Sunlight");
                 input_sun = new Fl_Value_Input(c(1) + iw - 40 + m, r(1), 40 + 45 - m, ih, "");
-                button_sun = new Fl_Button(c(2) + 45, r(1), iw - 45 - 5, ih, "Value");
+                button_sun = new Fl_Button(c(2) + 45, r(1), iw - 45 - 5 - 20, ih, "Value");
+                check_freeze_sun = new Fl_Check_Button(c(2) + iw - 22, r(1), 18, ih, "");
                 box_money = new Fl_Box(c(1), r(2), iw - 40, ih, "Wallet (x10)");
                 input_money = new Fl_Value_Input(c(1) + iw - 40 + m, r(2), 40 + 45 - m, ih, "");
-                button_money = new Fl_Button(c(2) + 45, r(2), iw - 45 - 5, ih, "Coins");
+                button_money = new Fl_Button(c(2) + 45, r(2), iw - 45 - 5 - 20, ih, "Coins");
+                check_freeze_money = new Fl_Check_Button(c(2) + iw - 22, r(2), 18, ih, "");
                 box_wisdom_tree = new Fl_Box(c(1), r(3), iw - 40, ih, "Wisdom Tree");
                 input_wisdom_tree = new Fl_Value_Input(c(1) + iw - 40 + m, r(3), 40 + 45 - m, ih, "");
                 button_wisdom_tree = new Fl_Button(c(2) + 45, r(3), iw - 45 - 5, ih, "Feet");
@@ -1013,7 +1538,8 @@ Window::Window(int width, int height, const char *title)
                 check_chocolate = new Fl_Check_Button(c(4), r(3), iw, ih, "Infinite Chocolate");
                 check_auto_collected = new Fl_Check_Button(c(1), r(4), iw, ih, "Auto Collected");
                 check_not_drop_loot = new Fl_Check_Button(c(2), r(4), iw, ih, "Don\'t Drop Loot");
-                check_free_planting = new Fl_Check_Button(c(3), r(4), iw, ih, "Free Planting");
+                check_free_planting = new Fl_Check_Button(c(3), r(4), iw - 20, ih, "Free Planting");
+                check_freeze_cooldown = new Fl_Check_Button(c(3) + iw - 18, r(4), 18, ih, "");
                 check_placed_anywhere = new Fl_Check_Button(c(4), r(4), iw, ih, "Place Anywhere");
                 button_unlock = new Fl_Button(c(1), r(5), iw + m + iw - 18 - 40 - 12, ih, "Get Gold Sunflower Trophy");
                 check_fast_belt = new Fl_Check_Button(c(3) - 18 - 40, r(5), iw + 40, ih, "Seamless Conveyor Belt");
@@ -1023,7 +1549,8 @@ Window::Window(int width, int height, const char *title)
                 button_mix = new Fl_Button(c(4), r(6), iw, ih, "Modify Mode");
                 button_direct_win = new Fl_Button(c(1), r(7), iw - 5, ih, "Level Complete");
                 check_brightest_cob_cannon = new Fl_Check_Button(c(2) - 5, r(7), iw + 5 + 20, ih, "End with Brightest Cob");
-                input_level = new Fl_Value_Input(c(3) + 20, r(7), iw - 20, ih, "");
+                check_freeze_level = new Fl_Check_Button(c(3) + 20, r(7), 18, ih, "");
+                input_level = new Fl_Value_Input(c(3) + 20 + 20, r(7), iw - 20 - 20, ih, "");
                 button_level = new Fl_Button(c(4), r(7), iw, ih, "Endless Rounds");
             }
             group_resource->end();
@@ -1085,12 +1612,13 @@ Window::Window(int width, int height, const char *title)
                 button_reset = new Fl_Button(c(1), r(3), iw - 10, ih, "Reset Scene");
                 choice_scene = new Fl_Choice_(c(2) - 10, r(3), iw - 10, ih, "");
                 button_load_lineup = new Fl_Button(c(3) - 10 - 10, r(3), iw * 2 + m + 10 + 10, ih, "Load Lineup List File (***.yml)");
-                choice_lineup_name[0] = new Fl_Choice_(c(3) - 10 - 10, r(3), iw * 2 + m + 10 + 10, ih, "");
-                choice_lineup_name[1] = new Fl_Choice_(c(3) - 10 - 10, r(3), iw * 2 + m + 10 + 10, ih, "");
-                choice_lineup_name[2] = new Fl_Choice_(c(3) - 10 - 10, r(3), iw * 2 + m + 10 + 10, ih, "");
-                choice_lineup_name[3] = new Fl_Choice_(c(3) - 10 - 10, r(3), iw * 2 + m + 10 + 10, ih, "");
-                choice_lineup_name[4] = new Fl_Choice_(c(3) - 10 - 10, r(3), iw * 2 + m + 10 + 10, ih, "");
-                choice_lineup_name[5] = new Fl_Choice_(c(3) - 10 - 10, r(3), iw * 2 + m + 10 + 10, ih, "");
+                choice_lineup_name[0] = new Fl_Choice_(c(3) - 10 - 10, r(3), iw * 2 + m + 10 + 10 - ih, ih, "");
+                choice_lineup_name[1] = new Fl_Choice_(c(3) - 10 - 10, r(3), iw * 2 + m + 10 + 10 - ih, ih, "");
+                choice_lineup_name[2] = new Fl_Choice_(c(3) - 10 - 10, r(3), iw * 2 + m + 10 + 10 - ih, ih, "");
+                choice_lineup_name[3] = new Fl_Choice_(c(3) - 10 - 10, r(3), iw * 2 + m + 10 + 10 - ih, ih, "");
+                choice_lineup_name[4] = new Fl_Choice_(c(3) - 10 - 10, r(3), iw * 2 + m + 10 + 10 - ih, ih, "");
+                choice_lineup_name[5] = new Fl_Choice_(c(3) - 10 - 10, r(3), iw * 2 + m + 10 + 10 - ih, ih, "");
+                button_search_lineup = new Fl_Button(c(3) - 10 - 10 + iw * 2 + m + 10 + 10 - ih, r(3), ih, ih, "@search");
                 buffer_lineup_string = new Fl_Text_Buffer();
                 editor_lineup_string = new Fl_Text_Editor(c(1), r(4), iw * 4 + m * 3, ih * 2 + m * 1, "");
                 button_get_lineup = new Fl_Button(c(1), r(6), iw + 60, ih, "Get Lineup Code");
@@ -1125,6 +1653,7 @@ Window::Window(int width, int height, const char *title)
 
             group_others = new Fl_Group(m, m + th, w - m * 2, h - m * 2 - th, "Others");
             {
+                button_others_extra = new Fl_Menu_Button(m, m + th, w - m * 2, h - m * 2 - th, nullptr); // 右键菜单, 放在最底层
                 choice_music = new Fl_Choice_(c(1), r(1), iw + 50, ih, "");
                 button_music = new Fl_Button(c(2) + 50, r(1), iw + 15, ih, "Background Music");
                 button_userdata = new Fl_Button(c(3) + 50 + 15, r(1), iw + m + iw - 50 - 15, ih, "Open Userdata Folder");
@@ -1366,7 +1895,7 @@ Window::Window(int width, int height, const char *title)
 
     choice_scene->value(2); // 泳池
 
-    lineups.clear();
+    lineups.Clear();
     lineup_count[0] = 0;
     lineup_count[1] = 0;
     lineup_count[2] = 0;
@@ -1380,6 +1909,7 @@ Window::Window(int width, int height, const char *title)
     choice_lineup_name[3]->hide();
     choice_lineup_name[4]->hide();
     choice_lineup_name[5]->hide();
+    button_search_lineup->hide();
 
     editor_lineup_string->buffer(buffer_lineup_string);
     editor_lineup_string->wrap_mode(Fl_Text_Editor::WRAP_AT_BOUNDS, 0);
@@ -1406,9 +1936,11 @@ Window::Window(int width, int height, const char *title)
     button_spawn_extra->add("[清空已选]", 0, cb_clear_checked_zombies, this);
     button_spawn_extra->add("[取消限制]", 0, cb_disable_limit_species, this);
     button_spawn_extra->add("[切换布局]", 0, cb_switch_layout_xwz, this);
+    button_spawn_extra->add("[出怪种子]");
 #else
     button_spawn_extra->add("[ Clear Checked Zombies ]", 0, cb_clear_checked_zombies, this);
     button_spawn_extra->add("[ Disable Species Limit ]", 0, cb_disable_limit_species, this);
+    button_spawn_extra->add("[ Spawning Seed ]");
 #endif
     button_spawn_extra->type(Fl_Menu_Button::POPUP3);
     button_spawn_extra->value(0);
@@ -1425,6 +1957,22 @@ Window::Window(int width, int height, const char *title)
     button_spawn_mode->type(Fl_Menu_Button::POPUP3);
     button_spawn_mode->value(1); // 默认极限刷怪
 
+#ifdef _PTK_CHINESE_UI
+    button_others_extra->add("[卡顿统计]");
+    button_others_extra->add("[场地监视]", 0, nullptr, nullptr, FL_MENU_TOGGLE);
+    button_others_extra->add("[场地录像]", 0, nullptr, nullptr, FL_MENU_TOGGLE);
+    button_others_extra->add("[时间轴]", 0, nullptr, nullptr, FL_MENU_TOGGLE);
+    button_others_extra->add("[多开同步]");
+#else
+    button_others_extra->add("[ Stall Report ]");
+    button_others_extra->add("[ Board Watcher ]", 0, nullptr, nullptr, FL_MENU_TOGGLE);
+    button_others_extra->add("[ Record Board ]", 0, nullptr, nullptr, FL_MENU_TOGGLE);
+    button_others_extra->add("[ Run Timeline ]", 0, nullptr, nullptr, FL_MENU_TOGGLE);
+    button_others_extra->add("[ Sync Games ]");
+#endif
+    button_others_extra->type(Fl_Menu_Button::POPUP3);
+    button_others_extra->value(0);
+
     choice_music->add("[1] Grasswalk");
     choice_music->add("[2] Moongrains");
     choice_music->add("[3] Watery Graves");
@@ -1588,6 +2136,7 @@ Window::Window(int width, int height, const char *title)
             choice_giga_weight->textfont(ui_font);
             button_spawn_extra->textfont(ui_font);
             button_spawn_mode->textfont(ui_font);
+            button_others_extra->textfont(ui_font);
         }
         {
             for (int i = 0; i < group_others->children(); i++)
@@ -1664,6 +2213,7 @@ Window::Window(int width, int height, const char *title)
             choice_giga_weight->textsize(font_size);
             button_spawn_extra->textsize(font_size);
             button_spawn_mode->textsize(font_size);
+            button_others_extra->textsize(font_size);
         }
         {
             for (int i = 0; i < group_others->children(); i++)
@@ -1705,6 +2255,13 @@ Window::Window(int width, int height, const char *title)
     button_spawn_extra->replace(0, EMOJI("❌", "[清空已选]"));
     button_spawn_extra->replace(1, EMOJI("❎", "[取消限制]"));
     button_spawn_extra->replace(2, EMOJI("🔀", "[切换布局]"));
+    button_spawn_extra->replace(3, EMOJI("🎲", "[出怪种子]"));
+
+    button_others_extra->replace(0, EMOJI("⏱", "[卡顿统计]"));
+    button_others_extra->replace(1, EMOJI("👀", "[场地监视]"));
+    button_others_extra->replace(2, EMOJI("🎥", "[场地录像]"));
+    button_others_extra->replace(3, EMOJI("⏩", "[时间轴]"));
+    button_others_extra->replace(4, EMOJI("🔗", "[多开同步]"));
 
     button_show_details->copy_label(EMOJI("📈", "查看详情"));
 
@@ -2430,9 +2987,13 @@ void Window::keep_selected_feature()
         check_tree_food,
         check_chocolate,
         check_free_planting,
+        check_freeze_cooldown,
         check_placed_anywhere,
         check_fast_belt,
         check_lock_shovel,
+        check_freeze_sun,
+        check_freeze_money,
+        check_freeze_level,
         check_plant_invincible,
         check_plant_weak,
         check_zombie_invincible,
@@ -2490,6 +3051,9 @@ void Window::cb_load_lineup()
 
 void Window::import_lineup_list(bool automatic)
 {
+    std::vector<LineupSource> sources;
+    bool cacheable = false;
+
     if (automatic)
     {
         wchar_t find_path[MAX_PATH] = {0};
@@ -2508,12 +3072,53 @@ void Window::import_lineup_list(bool automatic)
                 std::wstring ext = name.substr(name.find_last_of(L".") + 1);
                 if (ext == L"yml")
                 {
-                    import_lineup_list_file(name);
-                    // std::wcout << L"导入阵型列表: " << name << std::endl;
+                    LineupSource source;
+                    source.path = name;
+                    source.size = (uint64_t(ffd.nFileSizeHigh) << 32) | ffd.nFileSizeLow;
+                    source.mtime = (uint64_t(ffd.ftLastWriteTime.dwHighDateTime) << 32) | ffd.ftLastWriteTime.dwLowDateTime;
+                    source.crc = 0;
+                    sources.push_back(source);
                 }
             } while (FindNextFileW(hf, &ffd) != 0);
             FindClose(hf);
         }
+
+        // 列表文件都没变的话直接从缓存恢复, 不用再解析和排序
+        LineupCache cache;
+        if (!sources.empty() && cache.Open(LINEUP_CACHE_FILE) && cache.Match(sources))
+        {
+            cache.Load(this->lineups);
+            cache.Close();
+            for (size_t i = 0; i < this->lineups.Size(); i++)
+            {
+                uint32_t scene = static_cast<uint32_t>(this->lineups[i].scene);
+                choice_lineup_name[scene]->add(std::string(this->lineups.Display(i)).c_str());
+                lineup_count[scene]++;
+            }
+
+            if (!this->lineups.Empty())
+            {
+                for (size_t i = 0; i < 6; i++)
+                    if (choice_lineup_name[i]->size() > 0)
+                        choice_lineup_name[i]->value(0);
+
+                button_load_lineup->hide();
+                button_search_lineup->show();
+                lineup_names.Build(this->lineups);
+                lineup_index.Build(this->lineups);
+                cb_switch_lineup_scene();
+            }
+            return;
+        }
+
+        // 有格式错误的文件不缓存, 下次启动仍然提示
+        cacheable = !sources.empty();
+        for (auto &source : sources)
+        {
+            if (!import_lineup_list_file(source.path, &source.crc))
+                cacheable = false;
+            // std::wcout << L"导入阵型列表: " << source.path << std::endl;
+        }
     }
     else
     {
@@ -2540,88 +3145,76 @@ void Window::import_lineup_list(bool automatic)
         }
     }
 
-    if (this->lineups.empty())
+    if (this->lineups.Empty())
         return;
 
+    // 内容相同的阵型只留第一个
+    this->lineups.Dedup();
+
     // 排序
-    auto LessThan = [&](const Lineup &l1, const Lineup &l2)
-    {
-        return l1.weight < l2.weight;
-    };
-    std::sort(this->lineups.begin(), this->lineups.end(), LessThan);
+    this->lineups.Sort();
 
     // 插入
-    for (size_t i = 0; i < this->lineups.size(); i++)
+    std::unordered_set<std::string> used[6];
+    for (size_t i = 0; i < 6; i++)
+        for (int k = 0; k < choice_lineup_name[i]->size(); k++)
+            if (choice_lineup_name[i]->text(k) != nullptr)
+                used[i].insert(choice_lineup_name[i]->text(k));
+    for (size_t i = 0; i < this->lineups.Size(); i++)
     {
         uint32_t scene = static_cast<uint32_t>(this->lineups[i].scene);
-        std::string name = this->lineups[i].lineup_name;
+        std::string name(this->lineups.Name(i));
 
-        while (choice_lineup_name[scene]->find_index(name.c_str()) != -1)
+        uint16_t padding = 0;
+        while (!used[scene].insert(name).second)
+        {
             name += " "; // 相同名字的在后面补空格
+            padding++;
+        }
 
         choice_lineup_name[scene]->add(name.c_str());
         lineup_count[scene]++;
+        this->lineups.SetPadding(i, padding);
     }
 
+    if (cacheable)
+        LineupCache::Write(LINEUP_CACHE_FILE, sources, this->lineups);
+
     for (size_t i = 0; i < 6; i++)
         if (choice_lineup_name[i]->size() > 0)
             choice_lineup_name[i]->value(0);
 
     button_load_lineup->hide();
+    button_search_lineup->show();
+    lineup_names.Build(this->lineups);
+    lineup_index.Build(this->lineups);
     cb_switch_lineup_scene();
 }
 
-void Window::import_lineup_list_file(std::wstring file)
+bool Window::import_lineup_list_file(std::wstring file, uint32_t *crc)
 {
-    std::ifstream ifs(file.c_str());
+    std::ifstream ifs(file.c_str(), std::ios::binary);
     if (!ifs)
-        return;
+        return false;
+
+    // 取不到大小或者没读完整的不导入
+    std::string content;
+    ifs.seekg(0, std::ios::end);
+    std::streamoff length = ifs.tellg();
+    if (length < 0)
+        return false;
+    content.resize(size_t(length));
+    ifs.seekg(0, std::ios::beg);
+    ifs.read(&content[0], content.size());
+    if (!ifs)
+        return false;
+    ifs.close();
 
-    std::vector<std::tuple<int, std::string>> err_lst;
+    if (crc != nullptr)
+        *crc = uint32_t(crc32(crc32(0L, Z_NULL, 0), (const Bytef *)content.data(), uInt(content.size())));
 
-    int line = 0;
-    std::string str;
-    while (std::getline(ifs, str))
-    {
-        line++;
-        if (line == 1) // 第一行
-        {
-            if (str != "#! pvztoolkit")
-                break;
-        }
-        else
-        {
-            if (str.empty() || str[0] == '#') // 空行或者注释
-            {
-                continue;
-            }
-            else
-            {
-                std::regex re("\".*\": ([a-zA-Z0-9+/=]{1,}|[a-zA-Z0-9-_=]{1,})");
-                if (std::regex_match(str, re))
-                {
-                    size_t p = str.find_last_of(": ");
-                    std::string name = str.substr(0 + 1, p - 3);
-                    std::string code = str.substr(p + 1);
-                    Lineup lineup(name, code);
-                    if (lineup.OK())
-                    {
-                        this->lineups.push_back(lineup);
-                    }
-                    else
-                    {
-                        std::tuple err = {line, str};
-                        err_lst.push_back(err);
-                    }
-                }
-                else
-                {
-                    std::tuple err = {line, str};
-                    err_lst.push_back(err);
-                }
-            }
-        }
-    }
+    std::vector<std::tuple<int, std::string>> err_lst;
+    ParseLineupList(content, this->lineups, err_lst);
 
     if (err_lst.size() > 0)
     {
@@ -2660,6 +3253,8 @@ void Window::import_lineup_list_file(std::wstring file)
         fl_message_title(utf8_encode(title).c_str());
         fl_message(utf8_encode(text).c_str());
     }
+
+    return err_lst.empty();
 }
 
 void Window::cb_switch_lineup_scene(Fl_Widget *, void *w)
@@ -2669,7 +3264,7 @@ void Window::cb_switch_lineup_scene(Fl_Widget *, void *w)
 
 void Window::cb_switch_lineup_scene()
 {
-    if (this->lineups.empty())
+    if (this->lineups.Empty())
         return;
 
     for (size_t i = 0; i < 6; i++)
@@ -2703,10 +3298,10 @@ void Window::cb_show_lineup_string()
     index += choice_lineup_name[choice_scene->value()]->value();
 
 #ifdef _DEBUG
-    std::cout << index << " " << this->lineups[index].lineup_name << std::endl;
+    std::cout << index << " " << this->lineups.Name(index) << std::endl;
 #endif
 
-    buffer_lineup_string->text(this->lineups[index].lineup_code.c_str());
+    buffer_lineup_string->text(std::string(this->lineups.Code(index)).c_str());
 }
 
 void Window::cb_copy_lineup(Fl_Widget *, void *w)
@@ -3203,6 +3798,10 @@ void Window::cb_tooltips()
     button_unlock->copy_tooltip(on ? "Get Gold Sunflower Trophy" : "解锁黄金向日葵奖杯");
     button_direct_win->copy_tooltip(on ? "Level Complete" : nullptr);
     check_brightest_cob_cannon->copy_tooltip(on ? "End with Brightest Cob" : "结束时炮最亮");
+    check_freeze_sun->copy_tooltip(on ? "Lock Sun" : "锁定阳光");
+    check_freeze_money->copy_tooltip(on ? "Lock Coins" : "锁定金币");
+    check_freeze_level->copy_tooltip(on ? "Lock Endless Rounds" : "锁定无尽轮数");
+    check_freeze_cooldown->copy_tooltip(on ? "Lock Slot Cooldowns" : "锁定卡槽冷却");
 
     choice_row->copy_tooltip(on ? vstr_rows[choice_row->value()].c_str() : nullptr);
     choice_col->copy_tooltip(on ? vstr_cols[choice_col->value()].c_str() : nullptr);
@@ -3248,6 +3847,7 @@ void Window::cb_tooltips()
     button_load_lineup->copy_tooltip(on ? "Load Lineup List File (***.yml)" : nullptr);
     for (size_t i = 0; i < 6; i++)
         choice_lineup_name[i]->copy_tooltip(on ? "(Lineup Name)" : nullptr);
+    button_search_lineup->copy_tooltip(on ? "Search Lineups" : "搜索阵型");
     button_get_lineup->copy_tooltip(on ? "Get Lineup Code" : nullptr);
     button_copy_lineup->copy_tooltip(on ? "Copy (Export)" : nullptr);
     button_paste_lineup->copy_tooltip(on ? "Paste (Import)" : nullptr);
@@ -3326,9 +3926,14 @@ void Window::cb_tooltips()
     input_money->copy_tooltip("0 ~ 99999");
     input_wisdom_tree->copy_tooltip("0 ~ 1000");
     input_level->copy_tooltip("0 ~ 999999");
+    check_freeze_sun->copy_tooltip("Lock Sun");
+    check_freeze_money->copy_tooltip("Lock Coins");
+    check_freeze_level->copy_tooltip("Lock Endless Rounds");
+    check_freeze_cooldown->copy_tooltip("Lock Slot Cooldowns");
 
     for (size_t i = 0; i < 6; i++)
         choice_lineup_name[i]->copy_tooltip("(Lineup Name)");
+    button_search_lineup->copy_tooltip("Search Lineups");
 
     editor_lineup_string->copy_tooltip("(Lineup Code)");
 